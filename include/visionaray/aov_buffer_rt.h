@@ -0,0 +1,106 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_AOV_BUFFER_RT_H
+#define VSNRAY_AOV_BUFFER_RT_H 1
+
+#include "math/matrix.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+#include "pixel_traits.h"
+#include "render_target.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Render target with buffers for color, depth and the attributes of the first hit
+// (AOVs) that the builtin kernels return: normal, albedo, primitive and geometry ids
+// and motion vectors. All buffers are written in the same pass as color, with
+// conversion to the buffer's pixel format. Buffers with format PF_UNSPECIFIED are
+// not allocated. With blending pixel samplers, only color is blended, the other
+// buffers store the values of the last sample.
+//
+// Motion vectors require the camera of the previous frame: call set_prev_camera()
+// before each frame, for the first frame with the current camera (motion vectors
+// are then 0). Does NOT implement display_color_buffer()
+//
+
+template <
+    pixel_format ColorFormat,
+    pixel_format DepthFormat  = PF_DEPTH32F,
+    pixel_format NormalFormat = PF_RGB32F,
+    pixel_format AlbedoFormat = PF_RGB32F,
+    pixel_format IdFormat     = PF_R32I,
+    pixel_format MotionFormat = PF_RG32F
+    >
+class aov_buffer_rt : public render_target
+{
+public:
+
+    using color_type    = typename pixel_traits<ColorFormat>::type;
+    using depth_type    = typename pixel_traits<DepthFormat>::type;
+    using normal_type   = typename pixel_traits<NormalFormat>::type;
+    using albedo_type   = typename pixel_traits<AlbedoFormat>::type;
+    using id_type       = typename pixel_traits<IdFormat>::type;
+    using motion_type   = typename pixel_traits<MotionFormat>::type;
+
+    using ref_type      = aov_render_target_ref<
+            ColorFormat,
+            DepthFormat,
+            NormalFormat,
+            AlbedoFormat,
+            IdFormat,
+            MotionFormat
+            >;
+
+public:
+
+    color_type*  color()   { return color_buffer.data(); }
+    depth_type*  depth()   { return depth_buffer.data(); }
+    normal_type* normal()  { return normal_buffer.data(); }
+    albedo_type* albedo()  { return albedo_buffer.data(); }
+    id_type*     prim_id() { return prim_id_buffer.data(); }
+    id_type*     geom_id() { return geom_id_buffer.data(); }
+    motion_type* motion()  { return motion_buffer.data(); }
+
+    color_type const*  color() const   { return color_buffer.data(); }
+    depth_type const*  depth() const   { return depth_buffer.data(); }
+    normal_type const* normal() const  { return normal_buffer.data(); }
+    albedo_type const* albedo() const  { return albedo_buffer.data(); }
+    id_type const*     prim_id() const { return prim_id_buffer.data(); }
+    id_type const*     geom_id() const { return geom_id_buffer.data(); }
+    motion_type const* motion() const  { return motion_buffer.data(); }
+
+    ref_type ref();
+
+    // View and projection matrix of the camera used to render the previous frame
+    void set_prev_camera(mat4 const& view, mat4 const& proj);
+
+    void clear_color_buffer(vec4 const& color = vec4(0.0f));
+    void clear_depth_buffer(float depth = 1.0f);
+    void begin_frame();
+    void end_frame();
+    void resize(int w, int h);
+
+private:
+
+    aligned_vector<color_type>  color_buffer;
+    aligned_vector<depth_type>  depth_buffer;
+    aligned_vector<normal_type> normal_buffer;
+    aligned_vector<albedo_type> albedo_buffer;
+    aligned_vector<id_type>     prim_id_buffer;
+    aligned_vector<id_type>     geom_id_buffer;
+    aligned_vector<motion_type> motion_buffer;
+
+    mat4 prev_view_proj = mat4::identity();
+
+};
+
+} // visionaray
+
+#include "detail/aov_buffer_rt.inl"
+
+#endif // VSNRAY_AOV_BUFFER_RT_H
@@ -9,8 +9,10 @@
 #include <cstddef>
 
 #include "detail/macros.h"
+#include "math/intersect.h"
 #include "math/vector.h"
 #include "array.h"
+#include "get_normal.h"
 
 namespace visionaray
 {
@@ -18,15 +20,21 @@ namespace visionaray
 template <typename Geometry>
 class area_light
 {
+public:
+
+    using geometry_type = Geometry;
+    using color_type    = vector<3, float>;
+
 public:
 
     area_light() = default;
     area_light(Geometry geometry);
 
-    // Evaluate the light intensity at pos.
+    // Evaluate the light intensity at pos (emitted radiance, the same for all positions).
     template <typename T>
     VSNRAY_FUNC vector<3, T> intensity(vector<3, T> const& pos) const;
 
+    // Get a single sampled position on the surface, pdf is w.r.t. surface area.
     template <typename T, typename Sampler>
     VSNRAY_FUNC vector<3, T> sample(T& pdf, Sampler& samp) const;
 
@@ -38,9 +46,28 @@ public:
             Sampler& samp
             ) const;
 
+    // Surface normal at a position on the light.
+    template <typename T>
+    VSNRAY_FUNC vector<3, T> normal(vector<3, T> const& pos) const;
+
+    // Surface area of the light.
+    VSNRAY_FUNC float area() const;
+
+    VSNRAY_FUNC color_type cl() const;
+    VSNRAY_FUNC float kl() const;
+
+    VSNRAY_FUNC Geometry& geometry();
+    VSNRAY_FUNC Geometry const& geometry() const;
+
+    VSNRAY_FUNC void set_cl(color_type const& cl);
+    VSNRAY_FUNC void set_kl(float kl);
+
 private:
 
-    Geometry geometry_;
+    Geometry    geometry_;
+
+    color_type  cl_ = color_type(1.0f);
+    float       kl_ = 1.0f;
 
 };
 
@@ -0,0 +1,140 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_ATROUS_DENOISER_H
+#define VSNRAY_ATROUS_DENOISER_H 1
+
+#include <functional>
+#include <memory>
+
+#include "detail/thread_pool.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// atrous_denoiser
+//
+// Edge-avoiding a-trous wavelet filter for noisy (e.g. path traced) images, see:
+// Dammertz et al. (2010): Edge-avoiding a-trous wavelet transform for fast global
+// illumination filtering, and the spatial part of Schied et al. (2017): Spatiotemporal
+// variance-guided filtering (SVGF).
+//
+// The color is demodulated by the albedo, the irradiance is then filtered with a 5x5
+// B3 spline kernel whose footprint is doubled with each iteration. The filter weights
+// are attenuated by the differences of the normals, depths and luminances (relative
+// to a spatial estimate of the luminance variance) of the pixels. The filtered
+// irradiance is finally multiplied by the albedo again.
+//
+// Pixels with a normal of length 0 (i.e. no hit) are not filtered. The input buffers
+// are not modified, the result is stored in an internal buffer (color()).
+//
+// Rows of pixels are distributed over the threads of a thread pool that may be
+// shared with a scheduler, the pixels of a row are filtered in SIMD groups
+//
+
+class atrous_denoiser
+{
+public:
+
+    // Create a denoiser with its own thread pool
+    explicit atrous_denoiser(unsigned num_threads);
+
+    // Create a denoiser that submits its jobs to a shared thread pool
+    explicit atrous_denoiser(std::shared_ptr<thread_pool> pool, int priority = thread_pool::Interactive);
+
+    // Filter the image, blocks until done. normal, depth and albedo are the
+    // attributes of the first hit, depth is expected in [0..1] (e.g. PF_DEPTH32F)
+    void frame(
+            vec4 const*     color,
+            vec3 const*     normal,
+            float const*    depth,
+            vec3 const*     albedo,
+            int             width,
+            int             height
+            );
+
+    // Filter the color buffer of an aov_buffer_rt with (at least) the
+    // default formats PF_RGBA32F, PF_DEPTH32F, PF_RGB32F and PF_RGB32F
+    template <typename RenderTarget>
+    void frame(RenderTarget const& rt);
+
+    // The filtered image
+    vec4 const* color() const;
+
+    int width() const;
+    int height() const;
+
+    // Number of a-trous iterations, the filter footprint is (4 * 2^(n-1) + 1)^2 pixels
+    void set_iterations(unsigned iterations);
+    unsigned iterations() const;
+
+    // Edge-stopping parameters, larger values blur more across edges
+    void set_sigma_luminance(float sigma);
+    float sigma_luminance() const;
+
+    void set_sigma_depth(float sigma);
+    float sigma_depth() const;
+
+    // Exponent for the normal weights, larger values blur *less* across edges
+    void set_sigma_normal(float sigma);
+    float sigma_normal() const;
+
+    // Wall clock time of the last call to frame() in milliseconds
+    double last_frame_time() const;
+
+private:
+
+    std::shared_ptr<thread_pool> pool_;
+    int priority_;
+
+    unsigned iterations_     = 4;
+    float sigma_luminance_   = 4.0f;
+    float sigma_depth_       = 1.0f;
+    float sigma_normal_      = 128.0f;
+
+    double last_frame_time_  = 0.0;
+
+    int width_  = 0;
+    int height_ = 0;
+
+    // Per-pixel planes (structure of arrays), rows are padded to a multiple
+    // of the SIMD width. Irradiance and variance are ping-ponged
+    int pitch_ = 0;
+
+    aligned_vector<float, 64> irradiance_[2][3];
+    aligned_vector<float, 64> variance_[2];
+    aligned_vector<float, 64> normal_[3];
+    aligned_vector<float, 64> depth_;
+    aligned_vector<float, 64> depth_gradient_;
+
+    aligned_vector<vec4> result_;
+
+    void resize(int width, int height);
+
+    // Process rows [0..height) on the thread pool, blocks until done
+    void parallel_rows(std::function<void(int)> const& func);
+
+    // Demodulate and set up the guide planes
+    void prepare(vec4 const* color, vec3 const* normal, float const* depth, vec3 const* albedo, int y);
+
+    // Spatial luminance variance, 3x3 neighborhood
+    void estimate_variance(int y);
+
+    // One a-trous iteration, from planes [src] to [1 - src]
+    void filter(int src, int step, int y);
+
+    // Multiply with the albedo again
+    void remodulate(int src, vec4 const* color, vec3 const* normal, vec3 const* albedo, int y);
+
+};
+
+} // visionaray
+
+#include "detail/atrous_denoiser.inl"
+
+#endif // VSNRAY_ATROUS_DENOISER_H
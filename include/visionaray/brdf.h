@@ -6,15 +6,27 @@
 #ifndef VSNRAY_BRDF_H
 #define VSNRAY_BRDF_H 1
 
+#include <cstddef>
+
 #include "math/constants.h"
 #include "math/vector.h"
 #include "fresnel.h"
+#include "hero_wavelengths.h"
 #include "sampling.h"
 #include "spectrum.h"
 
 namespace visionaray
 {
 
+//-------------------------------------------------------------------------------------------------
+// BRDFs
+//
+// f() and sample_f() return spectra, or the samples at the hero wavelengths wl of a path
+// (see hero_wavelengths.h) if wl is passed. The latter evaluate the spectral parameters
+// at the wavelengths only
+//
+
+
 //-------------------------------------------------------------------------------------------------
 // Lambertian reflection
 //
@@ -42,10 +54,54 @@ public:
         return spectrum<U>( cd * kd * constants::inv_pi<T>() );
     }
 
+    template <typename U, size_t N>
+    VSNRAY_FUNC
+    vector<N, U> f(
+            vector<3, U> const&             n,
+            vector<3, U> const&             wo,
+            vector<3, U> const&             wi,
+            hero_wavelengths<U, N> const&   wl
+            ) const
+    {
+        VSNRAY_UNUSED(n);
+        VSNRAY_UNUSED(wi);
+        VSNRAY_UNUSED(wo);
+
+        return from_spectrum(cd, wl) * (kd * constants::inv_pi<T>());
+    }
+
     template <typename U, typename S /* sampler */>
     VSNRAY_FUNC
     spectrum<U> sample_f(vector<3, T> const& n, vector<3, U> const& wo, vector<3, U>& wi, U& pdf, S& sampler) const
     {
+        sample_wi(n, wo, wi, pdf, sampler);
+
+        return f(n, wo, wi);
+    }
+
+    template <typename U, typename S /* sampler */, size_t N>
+    VSNRAY_FUNC
+    vector<N, U> sample_f(
+            vector<3, T> const&             n,
+            vector<3, U> const&             wo,
+            vector<3, U>&                   wi,
+            U&                              pdf,
+            S&                              sampler,
+            hero_wavelengths<U, N> const&   wl
+            ) const
+    {
+        sample_wi(n, wo, wi, pdf, sampler);
+
+        return f(n, wo, wi, wl);
+    }
+
+    // Sample wi without evaluating f()
+    template <typename U, typename S /* sampler */>
+    VSNRAY_FUNC
+    void sample_wi(vector<3, T> const& n, vector<3, U> const& wo, vector<3, U>& wi, U& pdf, S& sampler) const
+    {
+        VSNRAY_UNUSED(wo);
+
         auto w = n;
         auto v = select(
                 abs(w.x) > abs(w.y),
@@ -58,8 +114,15 @@ public:
         wi      = normalize( sp.x * u + sp.y * v + sp.z * w );
 
         pdf     = dot(n, wi) * constants::inv_pi<U>();
+    }
 
-        return f(n, wo, wi);
+    template <typename U>
+    VSNRAY_FUNC
+    U pdf(vector<3, U> const& n, vector<3, U> const& wo, vector<3, U> const& wi) const
+    {
+        VSNRAY_UNUSED(wo);
+
+        return max( U(0.0), dot(n, wi) ) * constants::inv_pi<U>();
     }
 
 };
@@ -116,19 +179,50 @@ public:
     VSNRAY_FUNC
     spectrum<U> f(vector<3, U> const& n, vector<3, U> const& wo, vector<3, U> const& wi) const
     {
-        auto h = normalize(wo + wi);
-        auto hdotn = max( U(0.0), dot(h, n) );
-
-        auto spec = cs * ks;
-        auto schlick = spec + (U(1.0) - spec) * pow(U(1.0) - saturate(dot(wi, h)), U(5.0));
-        auto nfactor = ((exp + U(2.0)) / (U(8.0) * constants::pi<U>()));
+        return spectrum<U>( f_impl(cs * ks, n, wo, wi) );
+    }
 
-        return spectrum<U>(schlick * nfactor * pow(hdotn, exp) );
+    template <typename U, size_t N>
+    VSNRAY_FUNC
+    vector<N, U> f(
+            vector<3, U> const&             n,
+            vector<3, U> const&             wo,
+            vector<3, U> const&             wi,
+            hero_wavelengths<U, N> const&   wl
+            ) const
+    {
+        return f_impl(from_spectrum(cs, wl) * ks, n, wo, wi);
     }
 
     template <typename U, typename S /* sampler */>
     VSNRAY_FUNC
     spectrum<U> sample_f(vector<3, U> const& n, vector<3, U> const& wo, vector<3, U>& wi, U& pdf, S& sampler) const
+    {
+        sample_wi(n, wo, wi, pdf, sampler);
+
+        return f(n, wo, wi);
+    }
+
+    template <typename U, typename S /* sampler */, size_t N>
+    VSNRAY_FUNC
+    vector<N, U> sample_f(
+            vector<3, U> const&             n,
+            vector<3, U> const&             wo,
+            vector<3, U>&                   wi,
+            U&                              pdf,
+            S&                              sampler,
+            hero_wavelengths<U, N> const&   wl
+            ) const
+    {
+        sample_wi(n, wo, wi, pdf, sampler);
+
+        return f(n, wo, wi, wl);
+    }
+
+    // Sample wi without evaluating f()
+    template <typename U, typename S /* sampler */>
+    VSNRAY_FUNC
+    void sample_wi(vector<3, U> const& n, vector<3, U> const& wo, vector<3, U>& wi, U& pdf, S& sampler) const
     {
         auto u1 = sampler.next();
         auto u2 = sampler.next();
@@ -151,9 +245,39 @@ public:
 
         auto vdoth = dot(wo, h);
         pdf = ( ((exp + U(1.0)) * pow(costheta, exp)) / (U(2.0) * constants::pi<U>() * U(4.0) * vdoth) );
+    }
 
-        return f(n, wo, wi);
+    template <typename U>
+    VSNRAY_FUNC
+    U pdf(vector<3, U> const& n, vector<3, U> const& wo, vector<3, U> const& wi) const
+    {
+        auto h = normalize(wo + wi);
+        auto costheta = max( U(0.0), dot(n, h) );
+        auto vdoth = dot(wo, h);
+
+        return select(
+                vdoth > U(0.0),
+                ((exp + U(1.0)) * pow(costheta, exp)) / (U(2.0) * constants::pi<U>() * U(4.0) * vdoth),
+                U(0.0)
+                );
+    }
+
+private:
+
+    // C is a spectrum or a vector of samples
+    template <typename C, typename U>
+    VSNRAY_FUNC
+    C f_impl(C const& spec, vector<3, U> const& n, vector<3, U> const& wo, vector<3, U> const& wi) const
+    {
+        auto h = normalize(wo + wi);
+        auto hdotn = max( U(0.0), dot(h, n) );
+
+        auto schlick = spec + (U(1.0) - spec) * pow(U(1.0) - saturate(dot(wi, h)), U(5.0));
+        auto nfactor = ((exp + U(2.0)) / (U(8.0) * constants::pi<U>()));
+
+        return schlick * nfactor * pow(hdotn, exp);
     }
+
 };
 
 
@@ -186,6 +310,23 @@ public:
         return spectrum<U>(0.0);
     }
 
+    template <typename U, size_t N>
+    VSNRAY_FUNC
+    vector<N, U> f(
+            vector<3, U> const&             n,
+            vector<3, U> const&             wo,
+            vector<3, U> const&             wi,
+            hero_wavelengths<U, N> const&   wl
+            ) const
+    {
+        VSNRAY_UNUSED(n);
+        VSNRAY_UNUSED(wi);
+        VSNRAY_UNUSED(wo);
+        VSNRAY_UNUSED(wl);
+
+        return vector<N, U>(0.0);
+    }
+
     template <typename U, typename Sampler>
     VSNRAY_FUNC
     spectrum<U> sample_f(
@@ -209,6 +350,42 @@ public:
                 ) * spectrum<U>(cr * kr) / abs( dot(n, wi) );
     }
 
+    template <typename U, typename Sampler, size_t N>
+    VSNRAY_FUNC
+    vector<N, U> sample_f(
+            vector<3, U> const&             n,
+            vector<3, U> const&             wo,
+            vector<3, U>&                   wi,
+            U&                              pdf,
+            Sampler&                        sampler,
+            hero_wavelengths<U, N> const&   wl
+            ) const
+    {
+        VSNRAY_UNUSED(sampler);
+
+        wi = reflect(wo, n);
+        pdf = U(1.0);
+
+        return fresnel_reflectance(
+                conductor_tag(),
+                from_spectrum(ior, wl),
+                from_spectrum(absorption, wl),
+                abs( dot(n, wo) )
+                ) * from_spectrum(cr, wl) * (kr / abs( dot(n, wi) ));
+    }
+
+    // Delta distribution, the probability to sample a given direction is 0
+    template <typename U>
+    VSNRAY_FUNC
+    U pdf(vector<3, U> const& n, vector<3, U> const& wo, vector<3, U> const& wi) const
+    {
+        VSNRAY_UNUSED(n);
+        VSNRAY_UNUSED(wo);
+        VSNRAY_UNUSED(wi);
+
+        return U(0.0);
+    }
+
 };
 
 } // visionaray
@@ -14,6 +14,8 @@
 namespace visionaray
 {
 
+class thread_pool;
+
 template <pixel_format ColorFormat, pixel_format DepthFormat>
 class cpu_buffer_rt : public render_target
 {
@@ -27,6 +29,13 @@ public:
 public:
 
     cpu_buffer_rt();
+
+    // Render target for frames that are rendered on the given thread pool.
+    // If the pool's workers are pinned to several NUMA nodes, resize() places
+    // the pages of the buffers on the nodes that render the respective tiles.
+    // The tile size must match the scheduler's (tiled_sched: 16x16)
+    explicit cpu_buffer_rt(std::shared_ptr<thread_pool> pool, int tile_width = 16, int tile_height = 16);
+
    ~cpu_buffer_rt();
 
     color_type* color();
@@ -0,0 +1,292 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_AMBIENT_OCCLUSION_INL
+#define VSNRAY_DETAIL_AMBIENT_OCCLUSION_INL 1
+
+#include <cstddef>
+#include <type_traits>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/vector.h>
+#include <visionaray/get_surface.h>
+#include <visionaray/result_record.h>
+#include <visionaray/sampling.h>
+#include <visionaray/traverse.h>
+
+#include "macros.h"
+#include "ray_stream.h"
+
+namespace visionaray
+{
+namespace ambient_occlusion
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Sample directions
+//
+// All lanes of a ray packet use the same stratified sample directions in their
+// local (tangent) frames. The directions are thus computed once per packet and
+// not per lane, and the occlusion rays of neighboring pixels remain coherent.
+// The random offset of the strata changes from frame to frame
+//
+
+VSNRAY_FUNC
+inline float first_lane(float x)
+{
+    return x;
+}
+
+template <typename S, typename = typename std::enable_if<simd::is_simd_vector<S>::value>::type>
+inline float first_lane(S const& x)
+{
+    simd::aligned_array_t<S> arr;
+    store(arr, x);
+    return arr[0];
+}
+
+VSNRAY_FUNC
+inline vector<3, float> sample_direction(unsigned i, unsigned num_samples, float r1, float r2)
+{
+    // Stratified in u1 (radius), u2 (angle) is a golden ratio sequence
+    float u1 = (static_cast<float>(i) + r1) / static_cast<float>(num_samples);
+    float u2 = r2 + static_cast<float>(i) * 0.618034f;
+    u2 -= floor(u2);
+
+    return cosine_sample_hemisphere(u1, u2);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Occlusion rays
+//
+// occlusion() returns the fraction of the occlusion rays that hit a primitive
+// closer than params.ao_radius:
+//
+//  - ray stream: ray packets on the CPU collect the occlusion rays of all lanes
+//    and samples in a ray_stream that walks the BVH only once
+//
+//  - otherwise one occlusion ray (packet) is traced per sample
+//
+
+struct trace_per_sample_tag {};
+struct ray_stream_tag {};
+
+template <typename S>
+struct occlusion_tag
+{
+    using type = typename std::conditional<
+            VSNRAY_CPU_MODE && simd::is_simd_vector<S>::value,
+            ray_stream_tag,
+            trace_per_sample_tag
+            >::type;
+};
+
+
+// Fall-through: trace an occlusion ray for each sample
+template <typename Params, typename V, typename M, typename Intersector>
+VSNRAY_FUNC
+inline typename V::value_type occlusion(
+        Params const&   params,
+        V const&        isect_pos,
+        V const&        u,
+        V const&        v,
+        V const&        w,
+        M const&        hit,
+        float           r1,
+        float           r2,
+        Intersector&    isect,
+        trace_per_sample_tag
+        )
+{
+    using S = typename V::value_type;
+
+    S result(0.0);
+
+    for (unsigned i = 0; i < params.ao_samples; ++i)
+    {
+        auto sp = sample_direction(i, params.ao_samples, r1, r2);
+        auto dir = normalize( S(sp.x) * u + S(sp.y) * v + S(sp.z) * w );
+
+        basic_ray<S> ao_ray(isect_pos + dir * S(params.epsilon), dir);
+
+        auto ao_rec = any_hit(
+                ao_ray,
+                params.prims.begin,
+                params.prims.end,
+                S(params.ao_radius),
+                isect
+                );
+
+        result += select( hit & ao_rec.hit, S(1.0), S(0.0) );
+    }
+
+    return result / S(static_cast<float>(params.ao_samples));
+}
+
+// Ray stream, ray packets only
+template <typename Params, typename T, typename M, typename Intersector>
+inline T occlusion(
+        Params const&       params,
+        vector<3, T> const& isect_pos,
+        vector<3, T> const& u,
+        vector<3, T> const& v,
+        vector<3, T> const& w,
+        M const&            hit,
+        float               r1,
+        float               r2,
+        Intersector&        isect,
+        ray_stream_tag
+        )
+{
+    using float_array = simd::aligned_array_t<T>;
+
+    enum { N = simd::num_elements<T>::value };
+
+    static thread_local visionaray::detail::ray_stream stream;
+    stream.clear();
+
+    float_array active;
+    store(active, select(hit, T(1.0), T(0.0)));
+
+    // Occlusion rays of the active lanes, in the order samples x lanes
+    for (unsigned s = 0; s < params.ao_samples; ++s)
+    {
+        auto sp = sample_direction(s, params.ao_samples, r1, r2);
+        auto dir = normalize( T(sp.x) * u + T(sp.y) * v + T(sp.z) * w );
+
+        auto origins = simd::unpack(isect_pos + dir * T(params.epsilon));
+        auto dirs    = simd::unpack(dir);
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (active[i] != 0.0f)
+            {
+                stream.push_back(basic_ray<float>(origins[i], dirs[i]), params.ao_radius);
+            }
+        }
+    }
+
+    stream.any_hit(params.prims.begin, params.prims.end, isect);
+
+    float_array occluded = {};
+    size_t index = 0;
+
+    for (unsigned s = 0; s < params.ao_samples; ++s)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            // Only active lanes have an occlusion ray in the stream
+            if (active[i] != 0.0f && stream.occluded(index++))
+            {
+                occluded[i] += 1.0f;
+            }
+        }
+    }
+
+    return T(occluded) / T(static_cast<float>(params.ao_samples));
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Ambient occlusion kernel
+//
+// Shades primary hits with the fraction of the hemisphere around the geometric normal
+// that is not occluded within a distance of params.ao_radius. params.ao_samples
+// cosine distributed occlusion rays are traced per pixel. Use with an accumulating
+// pixel sampler (e.g. jittered_blend_type) to converge to the noise-free result
+//
+
+template <typename Params>
+struct kernel
+{
+
+    Params params;
+
+    template <typename Intersector, typename R, typename Sampler>
+    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(
+            Intersector& isect,
+            R ray,
+            Sampler& s
+            ) const
+    {
+        using S = typename R::scalar_type;
+        using I = typename result_record<S>::int_type;
+        using V = typename result_record<S>::vec_type;
+        using C = typename result_record<S>::color_type;
+
+        result_record<S> result;
+
+        auto hit_rec = closest_hit(ray, params.prims.begin, params.prims.end, isect);
+
+        // Also consume the random numbers for packets that miss, so
+        // that the sequence does not depend on the scene
+        float r1 = detail::first_lane(s.next());
+        float r2 = detail::first_lane(s.next());
+
+        if (any(hit_rec.hit))
+        {
+            hit_rec.isect_pos = ray.ori + ray.dir * hit_rec.t;
+
+            auto surf = get_surface(hit_rec, params);
+
+            V u;
+            V v;
+            V w = faceforward( surf.geometric_normal, -ray.dir, surf.geometric_normal );
+            make_orthonormal_basis(u, v, w);
+
+            // AOVs
+            auto n = faceforward( surf.shading_normal, -ray.dir, surf.geometric_normal );
+            result.normal       = select( hit_rec.hit, n, V(0.0) );
+            result.albedo       = select( hit_rec.hit, to_rgb(surf.albedo()), V(0.0) );
+            result.prim_id      = select( hit_rec.hit, hit_rec.prim_id, I(-1) );
+            result.geom_id      = select( hit_rec.hit, hit_rec.geom_id, I(-1) );
+
+            auto occ = detail::occlusion(
+                    params,
+                    hit_rec.isect_pos,
+                    u,
+                    v,
+                    w,
+                    hit_rec.hit,
+                    r1,
+                    r2,
+                    isect,
+                    typename detail::occlusion_tag<S>::type{}
+                    );
+
+            auto vis = S(1.0) - occ;
+
+            result.color        = select( hit_rec.hit, C(vis, vis, vis, S(1.0)), C(params.bg_color) );
+            result.isect_pos    = hit_rec.isect_pos;
+        }
+        else
+        {
+            result.color = C(params.bg_color);
+        }
+
+        result.hit = hit_rec.hit;
+        return result;
+    }
+
+    template <typename R, typename Sampler>
+    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(
+            R ray,
+            Sampler& s
+            ) const
+    {
+        default_intersector ignore;
+        return (*this)(ignore, ray, s);
+    }
+};
+
+} // ambient_occlusion
+} // visionaray
+
+#endif // VSNRAY_DETAIL_AMBIENT_OCCLUSION_INL
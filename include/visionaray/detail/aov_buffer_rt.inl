@@ -0,0 +1,168 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Interface
+//
+
+template <
+    pixel_format ColorFormat,
+    pixel_format DepthFormat,
+    pixel_format NormalFormat,
+    pixel_format AlbedoFormat,
+    pixel_format IdFormat,
+    pixel_format MotionFormat
+    >
+typename aov_buffer_rt<ColorFormat, DepthFormat, NormalFormat, AlbedoFormat, IdFormat, MotionFormat>::ref_type
+aov_buffer_rt<ColorFormat, DepthFormat, NormalFormat, AlbedoFormat, IdFormat, MotionFormat>::ref()
+{
+    return {
+        color(),
+        depth(),
+        normal(),
+        albedo(),
+        prim_id(),
+        geom_id(),
+        motion(),
+        prev_view_proj,
+        width(),
+        height()
+        };
+}
+
+template <
+    pixel_format ColorFormat,
+    pixel_format DepthFormat,
+    pixel_format NormalFormat,
+    pixel_format AlbedoFormat,
+    pixel_format IdFormat,
+    pixel_format MotionFormat
+    >
+void aov_buffer_rt<ColorFormat, DepthFormat, NormalFormat, AlbedoFormat, IdFormat, MotionFormat>::set_prev_camera(
+        mat4 const& view,
+        mat4 const& proj
+        )
+{
+    prev_view_proj = proj * view;
+}
+
+template <
+    pixel_format ColorFormat,
+    pixel_format DepthFormat,
+    pixel_format NormalFormat,
+    pixel_format AlbedoFormat,
+    pixel_format IdFormat,
+    pixel_format MotionFormat
+    >
+void aov_buffer_rt<ColorFormat, DepthFormat, NormalFormat, AlbedoFormat, IdFormat, MotionFormat>::clear_color_buffer(
+        vec4 const& c
+        )
+{
+    // Convert from RGBA32F to internal color format
+    color_type cc;
+    convert(
+        pixel_format_constant<ColorFormat>{},
+        pixel_format_constant<PF_RGBA32F>{},
+        cc,
+        c
+        );
+
+    std::fill(color_buffer.begin(), color_buffer.end(), cc);
+}
+
+template <
+    pixel_format ColorFormat,
+    pixel_format DepthFormat,
+    pixel_format NormalFormat,
+    pixel_format AlbedoFormat,
+    pixel_format IdFormat,
+    pixel_format MotionFormat
+    >
+void aov_buffer_rt<ColorFormat, DepthFormat, NormalFormat, AlbedoFormat, IdFormat, MotionFormat>::clear_depth_buffer(
+        float d
+        )
+{
+    // Convert from DEPTH32F to internal depth format
+    depth_type dd;
+    convert(
+        pixel_format_constant<DepthFormat>{},
+        pixel_format_constant<PF_DEPTH32F>{},
+        dd,
+        d
+        );
+
+    std::fill(depth_buffer.begin(), depth_buffer.end(), dd);
+}
+
+template <
+    pixel_format ColorFormat,
+    pixel_format DepthFormat,
+    pixel_format NormalFormat,
+    pixel_format AlbedoFormat,
+    pixel_format IdFormat,
+    pixel_format MotionFormat
+    >
+void aov_buffer_rt<ColorFormat, DepthFormat, NormalFormat, AlbedoFormat, IdFormat, MotionFormat>::begin_frame()
+{
+}
+
+template <
+    pixel_format ColorFormat,
+    pixel_format DepthFormat,
+    pixel_format NormalFormat,
+    pixel_format AlbedoFormat,
+    pixel_format IdFormat,
+    pixel_format MotionFormat
+    >
+void aov_buffer_rt<ColorFormat, DepthFormat, NormalFormat, AlbedoFormat, IdFormat, MotionFormat>::end_frame()
+{
+}
+
+template <
+    pixel_format ColorFormat,
+    pixel_format DepthFormat,
+    pixel_format NormalFormat,
+    pixel_format AlbedoFormat,
+    pixel_format IdFormat,
+    pixel_format MotionFormat
+    >
+void aov_buffer_rt<ColorFormat, DepthFormat, NormalFormat, AlbedoFormat, IdFormat, MotionFormat>::resize(int w, int h)
+{
+    render_target::resize(w, h);
+
+
+    color_buffer.resize(w * h);
+
+    if (DepthFormat != PF_UNSPECIFIED)
+    {
+        depth_buffer.resize(w * h);
+    }
+
+    if (NormalFormat != PF_UNSPECIFIED)
+    {
+        normal_buffer.resize(w * h);
+    }
+
+    if (AlbedoFormat != PF_UNSPECIFIED)
+    {
+        albedo_buffer.resize(w * h);
+    }
+
+    if (IdFormat != PF_UNSPECIFIED)
+    {
+        prim_id_buffer.resize(w * h);
+        geom_id_buffer.resize(w * h);
+    }
+
+    if (MotionFormat != PF_UNSPECIFIED)
+    {
+        motion_buffer.resize(w * h);
+    }
+}
+
+} // visionaray
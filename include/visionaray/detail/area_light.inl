@@ -19,6 +19,9 @@ template <typename T>
 VSNRAY_FUNC
 inline vector<3, T> area_light<Geometry>::intensity(vector<3, T> const& pos) const
 {
+    VSNRAY_UNUSED(pos);
+
+    return vector<3, T>(cl_ * kl_);
 }
 
 template <typename Geometry>
@@ -44,4 +47,64 @@ inline void area_light<Geometry>::sample(
     }
 }
 
+template <typename Geometry>
+template <typename T>
+VSNRAY_FUNC
+inline vector<3, T> area_light<Geometry>::normal(vector<3, T> const& pos) const
+{
+    hit_record<basic_ray<T>, primitive<unsigned>> hr;
+    hr.isect_pos = pos;
+
+    return vector<3, T>(get_normal(hr, geometry_));
+}
+
+template <typename Geometry>
+VSNRAY_FUNC
+inline float area_light<Geometry>::area() const
+{
+    return visionaray::area(geometry_);
+}
+
+template <typename Geometry>
+VSNRAY_FUNC
+inline typename area_light<Geometry>::color_type area_light<Geometry>::cl() const
+{
+    return cl_;
+}
+
+template <typename Geometry>
+VSNRAY_FUNC
+inline float area_light<Geometry>::kl() const
+{
+    return kl_;
+}
+
+template <typename Geometry>
+VSNRAY_FUNC
+inline Geometry& area_light<Geometry>::geometry()
+{
+    return geometry_;
+}
+
+template <typename Geometry>
+VSNRAY_FUNC
+inline Geometry const& area_light<Geometry>::geometry() const
+{
+    return geometry_;
+}
+
+template <typename Geometry>
+VSNRAY_FUNC
+inline void area_light<Geometry>::set_cl(color_type const& cl)
+{
+    cl_ = cl;
+}
+
+template <typename Geometry>
+VSNRAY_FUNC
+inline void area_light<Geometry>::set_kl(float kl)
+{
+    kl_ = kl;
+}
+
 } // visionaray
@@ -0,0 +1,562 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/math.h>
+
+#include "color_conversion.h"
+#include "macros.h"
+
+namespace visionaray
+{
+namespace detail
+{
+namespace atrous
+{
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+using float_type = simd::float16;
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+using float_type = simd::float8;
+#else
+using float_type = simd::float4;
+#endif
+
+enum { Width = simd::num_elements<float_type>::value };
+
+// B3 spline
+static const float kernel_weights[5] = { 1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+// Keep exp() in a range that the SIMD implementation handles
+static const float max_exponent = 80.0f;
+
+
+//-------------------------------------------------------------------------------------------------
+// Load from arbitrarily aligned addresses
+//
+// Uses the native unaligned loads, copying to an aligned array first makes
+// the wide loads wait for the narrower stores to retire
+//
+
+inline float load(float const* ptr, float /* */)
+{
+    return *ptr;
+}
+
+template <typename T>
+inline T load_via_array(float const* ptr)
+{
+    simd::aligned_array_t<T> arr;
+    std::memcpy(arr, ptr, sizeof(arr));
+    return T(arr);
+}
+
+inline simd::float4 load(float const* ptr, simd::float4 /* */)
+{
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_SSE2)
+    return simd::load_unaligned(ptr);
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_NEON_FP)
+    return simd::load(ptr);
+#else
+    return load_via_array<simd::float4>(ptr);
+#endif
+}
+
+inline simd::float8 load(float const* ptr, simd::float8 /* */)
+{
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    return _mm256_loadu_ps(ptr);
+#else
+    return load_via_array<simd::float8>(ptr);
+#endif
+}
+
+inline simd::float16 load(float const* ptr, simd::float16 /* */)
+{
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+    return _mm512_loadu_ps(ptr);
+#else
+    return load_via_array<simd::float16>(ptr);
+#endif
+}
+
+template <typename T>
+inline T load(float const* ptr)
+{
+    return load(ptr, T{});
+}
+
+inline void store_aligned(float* ptr, float value)
+{
+    *ptr = value;
+}
+
+template <typename T>
+inline void store_aligned(float* ptr, T const& value)
+{
+    store(ptr, value);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Albedo used for demodulation, channels that are (almost) 0 are not demodulated
+//
+
+inline vec3 demodulation_factor(vec3 const& albedo)
+{
+    return vec3(
+            albedo.x > 1E-3f ? albedo.x : 1.0f,
+            albedo.y > 1E-3f ? albedo.y : 1.0f,
+            albedo.z > 1E-3f ? albedo.z : 1.0f
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Filter the pixels [x..x+num_elements<T>) of row y
+//
+// CheckX: test if the horizontal neighbors are inside the image. Without the
+// test, all neighbors must be inside
+//
+
+struct planes
+{
+    float const* irradiance_in[3];
+    float const* variance_in;
+    float*       irradiance_out[3];
+    float*       variance_out;
+    float const* normal[3];
+    float const* depth;
+    float const* depth_gradient;
+};
+
+template <typename T, bool CheckX>
+inline void filter_pixels(
+        planes const&   p,
+        int             x,
+        int             y,
+        int             width,
+        int             height,
+        int             pitch,
+        int             step,
+        float           sigma_luminance,
+        float           sigma_depth,
+        float           sigma_normal
+        )
+{
+    using M = simd::mask_type_t<T>;
+
+    int index = y * pitch + x;
+
+    vector<3, T> irr(
+            load<T>(p.irradiance_in[0] + index),
+            load<T>(p.irradiance_in[1] + index),
+            load<T>(p.irradiance_in[2] + index)
+            );
+
+    vector<3, T> n(
+            load<T>(p.normal[0] + index),
+            load<T>(p.normal[1] + index),
+            load<T>(p.normal[2] + index)
+            );
+
+    T var = load<T>(p.variance_in + index);
+    T z   = load<T>(p.depth + index);
+    T dz  = load<T>(p.depth_gradient + index);
+    T lum = rgb_to_luminance(irr);
+
+    // Reciprocal edge-stopping scales, no divisions in the inner loop
+    T inv_sl = T(1.0) / (T(sigma_luminance) * sqrt(max(var, T(0.0))) + T(1E-4f));
+    T inv_sz = T(1.0) / (T(sigma_depth) * dz + T(1E-6f));
+
+    T center_weight(kernel_weights[2] * kernel_weights[2]);
+
+    T sum_w = center_weight;
+    vector<3, T> sum_irr = irr * center_weight;
+    T sum_var = var * center_weight * center_weight;
+
+    for (int dy = -2; dy <= 2; ++dy)
+    {
+        int yy = y + dy * step;
+
+        if (yy < 0 || yy >= height)
+        {
+            continue;
+        }
+
+        for (int dx = -2; dx <= 2; ++dx)
+        {
+            if (dx == 0 && dy == 0)
+            {
+                continue;
+            }
+
+            int xx = x + dx * step;
+
+            if (CheckX && (xx < 0 || xx >= width))
+            {
+                continue;
+            }
+
+            int i = yy * pitch + xx;
+
+            vector<3, T> irr_q(
+                    load<T>(p.irradiance_in[0] + i),
+                    load<T>(p.irradiance_in[1] + i),
+                    load<T>(p.irradiance_in[2] + i)
+                    );
+
+            vector<3, T> n_q(
+                    load<T>(p.normal[0] + i),
+                    load<T>(p.normal[1] + i),
+                    load<T>(p.normal[2] + i)
+                    );
+
+            T var_q = load<T>(p.variance_in + i);
+            T z_q   = load<T>(p.depth + i);
+
+            float inv_dist = 1.0f / (static_cast<float>(step) * std::sqrt(static_cast<float>(dx * dx + dy * dy)));
+
+            T e = abs(z - z_q) * inv_sz * T(inv_dist)
+                + T(sigma_normal) * (T(1.0) - dot(n, n_q))
+                + abs(lum - rgb_to_luminance(irr_q)) * inv_sl;
+
+            T w = T(kernel_weights[dx + 2] * kernel_weights[dy + 2]) * exp(-min(e, T(max_exponent)));
+
+            sum_w   += w;
+            sum_irr += irr_q * w;
+            sum_var += var_q * w * w;
+        }
+    }
+
+    // Pixels without a hit are copied
+    M hit = dot(n, n) > T(0.0);
+
+    irr = select(hit, sum_irr / sum_w, irr);
+    var = select(hit, sum_var / (sum_w * sum_w), var);
+
+    store_aligned(p.irradiance_out[0] + index, irr.x);
+    store_aligned(p.irradiance_out[1] + index, irr.y);
+    store_aligned(p.irradiance_out[2] + index, irr.z);
+    store_aligned(p.variance_out + index, var);
+}
+
+} // atrous
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// atrous_denoiser members
+//
+
+inline atrous_denoiser::atrous_denoiser(unsigned num_threads)
+    : pool_(std::make_shared<thread_pool>(num_threads))
+    , priority_(thread_pool::Normal)
+{
+}
+
+inline atrous_denoiser::atrous_denoiser(std::shared_ptr<thread_pool> pool, int priority)
+    : pool_(pool)
+    , priority_(priority)
+{
+}
+
+inline void atrous_denoiser::frame(
+        vec4 const*     color,
+        vec3 const*     normal,
+        float const*    depth,
+        vec3 const*     albedo,
+        int             width,
+        int             height
+        )
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    resize(width, height);
+
+    parallel_rows([&](int y) { prepare(color, normal, depth, albedo, y); });
+
+    parallel_rows([&](int y) { estimate_variance(y); });
+
+    int src = 0;
+
+    for (unsigned i = 0; i < iterations_; ++i)
+    {
+        int step = 1 << i;
+        parallel_rows([&](int y) { filter(src, step, y); });
+        src = 1 - src;
+    }
+
+    parallel_rows([&](int y) { remodulate(src, color, normal, albedo, y); });
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    last_frame_time_ = elapsed.count();
+}
+
+template <typename RenderTarget>
+inline void atrous_denoiser::frame(RenderTarget const& rt)
+{
+    static_assert(std::is_same<typename RenderTarget::color_type, vec4>::value, "Color format must be PF_RGBA32F");
+    static_assert(std::is_same<typename RenderTarget::depth_type, float>::value, "Depth format must be PF_DEPTH32F");
+    static_assert(std::is_same<typename RenderTarget::normal_type, vec3>::value, "Normal format must be PF_RGB32F");
+    static_assert(std::is_same<typename RenderTarget::albedo_type, vec3>::value, "Albedo format must be PF_RGB32F");
+
+    frame(rt.color(), rt.normal(), rt.depth(), rt.albedo(), rt.width(), rt.height());
+}
+
+inline vec4 const* atrous_denoiser::color() const
+{
+    return result_.data();
+}
+
+inline int atrous_denoiser::width() const
+{
+    return width_;
+}
+
+inline int atrous_denoiser::height() const
+{
+    return height_;
+}
+
+inline void atrous_denoiser::set_iterations(unsigned iterations)
+{
+    iterations_ = iterations;
+}
+
+inline unsigned atrous_denoiser::iterations() const
+{
+    return iterations_;
+}
+
+inline void atrous_denoiser::set_sigma_luminance(float sigma)
+{
+    sigma_luminance_ = sigma;
+}
+
+inline float atrous_denoiser::sigma_luminance() const
+{
+    return sigma_luminance_;
+}
+
+inline void atrous_denoiser::set_sigma_depth(float sigma)
+{
+    sigma_depth_ = sigma;
+}
+
+inline float atrous_denoiser::sigma_depth() const
+{
+    return sigma_depth_;
+}
+
+inline void atrous_denoiser::set_sigma_normal(float sigma)
+{
+    sigma_normal_ = sigma;
+}
+
+inline float atrous_denoiser::sigma_normal() const
+{
+    return sigma_normal_;
+}
+
+inline double atrous_denoiser::last_frame_time() const
+{
+    return last_frame_time_;
+}
+
+inline void atrous_denoiser::resize(int width, int height)
+{
+    if (width == width_ && height == height_)
+    {
+        return;
+    }
+
+    width_  = width;
+    height_ = height;
+    pitch_  = div_up(width, static_cast<int>(detail::atrous::Width)) * detail::atrous::Width;
+
+    size_t size = static_cast<size_t>(pitch_) * height;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        irradiance_[0][i].assign(size, 0.0f);
+        irradiance_[1][i].assign(size, 0.0f);
+        normal_[i].assign(size, 0.0f);
+    }
+
+    variance_[0].assign(size, 0.0f);
+    variance_[1].assign(size, 0.0f);
+    depth_.assign(size, 0.0f);
+    depth_gradient_.assign(size, 0.0f);
+
+    result_.resize(static_cast<size_t>(width) * height);
+}
+
+inline void atrous_denoiser::parallel_rows(std::function<void(int)> const& func)
+{
+    if (height_ <= 0)
+    {
+        return;
+    }
+
+    auto j = std::make_shared<thread_pool::job>(height_, priority_);
+
+    j->process_item = [&func](long y)
+    {
+        func(static_cast<int>(y));
+    };
+
+    auto done = j->done.get_future();
+    pool_->submit(j);
+    done.wait();
+}
+
+inline void atrous_denoiser::prepare(
+        vec4 const*     color,
+        vec3 const*     normal,
+        float const*    depth,
+        vec3 const*     albedo,
+        int             y
+        )
+{
+    auto z = [&](int x, int y) { return depth[y * width_ + x]; };
+
+    for (int x = 0; x < width_; ++x)
+    {
+        int i = y * pitch_ + x;
+        int p = y * width_ + x;
+
+        vec3 n = normal[p];
+
+        if (dot(n, n) > 0.0f)
+        {
+            n = normalize(n);
+        }
+
+        vec3 irr = color[p].xyz() / detail::atrous::demodulation_factor(albedo[p]);
+
+        irradiance_[0][0][i] = irr.x;
+        irradiance_[0][1][i] = irr.y;
+        irradiance_[0][2][i] = irr.z;
+
+        normal_[0][i] = n.x;
+        normal_[1][i] = n.y;
+        normal_[2][i] = n.z;
+
+        // Smaller one of the one-sided differences, so that the
+        // gradient does not become large at depth discontinuities
+        int x0 = std::max(x - 1, 0);
+        int x1 = std::min(x + 1, width_ - 1);
+        int y0 = std::max(y - 1, 0);
+        int y1 = std::min(y + 1, height_ - 1);
+
+        float dzx = std::min(std::abs(z(x1, y) - z(x, y)), std::abs(z(x, y) - z(x0, y)));
+        float dzy = std::min(std::abs(z(x, y1) - z(x, y)), std::abs(z(x, y) - z(x, y0)));
+
+        depth_[i] = z(x, y);
+        depth_gradient_[i] = std::max(dzx, dzy);
+    }
+}
+
+inline void atrous_denoiser::estimate_variance(int y)
+{
+    auto lum = [&](int x, int y)
+    {
+        int i = y * pitch_ + x;
+        return rgb_to_luminance(vec3(irradiance_[0][0][i], irradiance_[0][1][i], irradiance_[0][2][i]));
+    };
+
+    for (int x = 0; x < width_; ++x)
+    {
+        float sum = 0.0f;
+        float sum2 = 0.0f;
+        int count = 0;
+
+        for (int yy = std::max(y - 1, 0); yy <= std::min(y + 1, height_ - 1); ++yy)
+        {
+            for (int xx = std::max(x - 1, 0); xx <= std::min(x + 1, width_ - 1); ++xx)
+            {
+                float l = lum(xx, yy);
+                sum += l;
+                sum2 += l * l;
+                ++count;
+            }
+        }
+
+        float mean = sum / count;
+        variance_[0][y * pitch_ + x] = std::max(0.0f, sum2 / count - mean * mean);
+    }
+}
+
+inline void atrous_denoiser::filter(int src, int step, int y)
+{
+    using namespace detail::atrous;
+
+    int dst = 1 - src;
+
+    planes p = {
+        { irradiance_[src][0].data(), irradiance_[src][1].data(), irradiance_[src][2].data() },
+        variance_[src].data(),
+        { irradiance_[dst][0].data(), irradiance_[dst][1].data(), irradiance_[dst][2].data() },
+        variance_[dst].data(),
+        { normal_[0].data(), normal_[1].data(), normal_[2].data() },
+        depth_.data(),
+        depth_gradient_.data()
+        };
+
+    for (int x = 0; x < width_; x += Width)
+    {
+        bool inside = x - 2 * step >= 0 && x + Width - 1 + 2 * step < width_;
+
+        if (inside)
+        {
+            filter_pixels<float_type, false>(
+                    p, x, y, width_, height_, pitch_, step,
+                    sigma_luminance_, sigma_depth_, sigma_normal_
+                    );
+        }
+        else
+        {
+            for (int xx = x; xx < std::min(x + static_cast<int>(Width), width_); ++xx)
+            {
+                filter_pixels<float, true>(
+                        p, xx, y, width_, height_, pitch_, step,
+                        sigma_luminance_, sigma_depth_, sigma_normal_
+                        );
+            }
+        }
+    }
+}
+
+inline void atrous_denoiser::remodulate(
+        int             src,
+        vec4 const*     color,
+        vec3 const*     normal,
+        vec3 const*     albedo,
+        int             y
+        )
+{
+    for (int x = 0; x < width_; ++x)
+    {
+        int i = y * pitch_ + x;
+        int p = y * width_ + x;
+
+        if (dot(normal[p], normal[p]) > 0.0f)
+        {
+            vec3 irr(irradiance_[src][0][i], irradiance_[src][1][i], irradiance_[src][2][i]);
+            result_[p] = vec4(irr * detail::atrous::demodulation_factor(albedo[p]), color[p].w);
+        }
+        else
+        {
+            result_[p] = color[p];
+        }
+    }
+}
+
+} // visionaray
@@ -2,16 +2,104 @@
 // See the LICENSE file for details.
 
 #include <algorithm>
+#include <cstddef>
 #include <cstring>
+#include <new>
+#include <vector>
 
 #include <visionaray/gl/compositing.h>
+#include <visionaray/math/detail/math.h> // div_up
 #include <visionaray/aligned_vector.h>
 
 #include "color_conversion.h"
+#include "thread_pool.h"
 
 
 namespace visionaray
 {
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Aligned allocator that default-initializes elements, vector::resize() thus
+// doesn't write to (and place) the pages of trivial types
+//
+
+template <typename T>
+class default_init_allocator : public aligned_allocator<T, 16>
+{
+public:
+
+    default_init_allocator() = default;
+
+    template <typename U>
+    default_init_allocator(default_init_allocator<U> const& /* rhs */)
+    {
+    }
+
+    template <typename U>
+    struct rebind
+    {
+        typedef default_init_allocator<U> other;
+    };
+
+    using aligned_allocator<T, 16>::construct;
+
+    template <typename U>
+    void construct(U* p)
+    {
+        ::new(static_cast<void*>(p)) U;
+    }
+};
+
+// Resize to w x h elements, new elements are set to value. With a pool that is
+// pinned to several NUMA nodes, all elements are reset to value, each tile by the
+// node that renders it (tiles are numbered row-major, like the items of tiled_sched)
+template <typename T>
+void resize_buffer(
+        std::vector<T, default_init_allocator<T>>&  buffer,
+        int                                         w,
+        int                                         h,
+        T const&                                    value,
+        thread_pool*                                pool,
+        int                                         tile_width,
+        int                                         tile_height
+        )
+{
+    size_t count = static_cast<size_t>(w) * h;
+
+    if (pool == nullptr || pool->num_nodes() <= 1)
+    {
+        buffer.resize(count, value);
+        return;
+    }
+
+    // Fresh storage, elements are not copied (and touched) by this thread
+    std::vector<T, default_init_allocator<T>> tmp;
+    tmp.resize(count);
+
+    T* data = tmp.data();
+    int numtilesx = div_up(w, tile_width);
+    int numtilesy = div_up(h, tile_height);
+
+    pool->first_touch(static_cast<long>(numtilesx) * numtilesy, [=](long tile_idx)
+    {
+        int x0 = static_cast<int>(tile_idx % numtilesx) * tile_width;
+        int y0 = static_cast<int>(tile_idx / numtilesx) * tile_height;
+        int x1 = std::min(x0 + tile_width, w);
+        int y1 = std::min(y0 + tile_height, h);
+
+        for (int y = y0; y < y1; ++y)
+        {
+            std::fill(data + y * w + x0, data + y * w + x1, value);
+        }
+    });
+
+    buffer.swap(tmp);
+}
+
+} // detail
+
 
 //-------------------------------------------------------------------------------------------------
 // Private implementation
@@ -20,12 +108,16 @@ namespace visionaray
 template <pixel_format ColorFormat, pixel_format DepthFormat>
 struct cpu_buffer_rt<ColorFormat, DepthFormat>::impl
 {
-    impl() : compositor(nullptr) {}
+    impl() : compositor(nullptr), tile_width(16), tile_height(16) {}
 
     std::unique_ptr<gl::depth_compositor>   compositor;
 
-    aligned_vector<color_type>              color_buffer;
-    aligned_vector<depth_type>              depth_buffer;
+    std::shared_ptr<thread_pool>            pool;
+    int                                     tile_width;
+    int                                     tile_height;
+
+    std::vector<color_type, detail::default_init_allocator<color_type>> color_buffer;
+    std::vector<depth_type, detail::default_init_allocator<depth_type>> depth_buffer;
 };
 
 
@@ -39,6 +131,19 @@ cpu_buffer_rt<ColorFormat, DepthFormat>::cpu_buffer_rt()
 {
 }
 
+template <pixel_format ColorFormat, pixel_format DepthFormat>
+cpu_buffer_rt<ColorFormat, DepthFormat>::cpu_buffer_rt(
+        std::shared_ptr<thread_pool>    pool,
+        int                             tile_width,
+        int                             tile_height
+        )
+    : impl_(new impl)
+{
+    impl_->pool = pool;
+    impl_->tile_width = tile_width;
+    impl_->tile_height = tile_height;
+}
+
 template <pixel_format ColorFormat, pixel_format DepthFormat>
 cpu_buffer_rt<ColorFormat, DepthFormat>::~cpu_buffer_rt()
 {
@@ -122,11 +227,27 @@ void cpu_buffer_rt<ColorFormat, DepthFormat>::resize(int w, int h)
 
     // Allocate storage
 
-    impl_->color_buffer.resize(w * h);
+    detail::resize_buffer(
+            impl_->color_buffer,
+            w,
+            h,
+            color_type(),
+            impl_->pool.get(),
+            impl_->tile_width,
+            impl_->tile_height
+            );
 
     if (DepthFormat != PF_UNSPECIFIED)
     {
-        impl_->depth_buffer.resize(w * h);
+        detail::resize_buffer(
+                impl_->depth_buffer,
+                w,
+                h,
+                depth_type(),
+                impl_->pool.get(),
+                impl_->tile_width,
+                impl_->tile_height
+                );
     }
 
     if (!impl_->compositor)
@@ -0,0 +1,291 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_CPU_TOPOLOGY_H
+#define VSNRAY_DETAIL_CPU_TOPOLOGY_H 1
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "platform.h"
+
+#if defined(VSNRAY_OS_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Logical CPU as reported by the operating system
+//
+
+struct cpu_info
+{
+    int cpu;        // logical cpu id
+    int package;    // socket
+    int core;       // physical core id (unique per package)
+    int node;       // NUMA node
+    int smt_rank;   // 0 for the first hardware thread of a physical core, 1 for its sibling, ...
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Parse cpu lists like "0-3,8,10-11"
+//
+
+inline std::vector<int> parse_cpu_list(std::string const& str)
+{
+    std::vector<int> result;
+
+    std::stringstream ss(str);
+    std::string range;
+
+    while (std::getline(ss, range, ','))
+    {
+        if (range.empty() || range[0] == '\n')
+        {
+            continue;
+        }
+
+        int first = 0;
+        int last = 0;
+        char dash = 0;
+
+        std::stringstream rs(range);
+        rs >> first;
+        last = first;
+
+        if (rs >> dash && dash == '-')
+        {
+            rs >> last;
+        }
+
+        for (int i = first; i <= last; ++i)
+        {
+            result.push_back(i);
+        }
+    }
+
+    return result;
+}
+
+inline bool read_sysfs(std::string const& filename, std::string& str)
+{
+    std::ifstream file(filename);
+
+    if (!file.good())
+    {
+        return false;
+    }
+
+    std::getline(file, str);
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Query the topology of the cpus the process may run on (e.g. restricted with
+// taskset or by a batch system). On Linux, sysfs is used. On other platforms,
+// or if sysfs is not available, all cpus are reported as separate cores on a
+// single NUMA node
+//
+
+inline std::vector<cpu_info> query_cpu_topology()
+{
+    std::vector<cpu_info> result;
+
+#if defined(VSNRAY_OS_LINUX)
+    std::string str;
+
+    cpu_set_t allowed;
+    bool have_allowed = sched_getaffinity(0, sizeof(cpu_set_t), &allowed) == 0;
+
+    if (read_sysfs("/sys/devices/system/cpu/online", str))
+    {
+        std::string sys = "/sys/devices/system/";
+
+        for (int cpu : parse_cpu_list(str))
+        {
+            if (have_allowed && (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)))
+            {
+                continue;
+            }
+
+            std::string topo = sys + "cpu/cpu" + std::to_string(cpu) + "/topology/";
+
+            cpu_info info = { cpu, 0, cpu, 0, 0 };
+
+            if (read_sysfs(topo + "physical_package_id", str))
+            {
+                info.package = std::max(0, std::stoi(str));
+            }
+
+            if (read_sysfs(topo + "core_id", str))
+            {
+                info.core = std::stoi(str);
+            }
+
+            info.node = info.package;
+
+            result.push_back(info);
+        }
+
+        // Assign NUMA nodes, fall back to packages if there's no NUMA info.
+        // Node ids need not be contiguous (e.g. with memory-only nodes)
+        std::vector<int> nodes;
+
+        if (read_sysfs(sys + "node/online", str))
+        {
+            nodes = parse_cpu_list(str);
+        }
+
+        for (int node : nodes)
+        {
+            if (!read_sysfs(sys + "node/node" + std::to_string(node) + "/cpulist", str))
+            {
+                continue;
+            }
+
+            for (int cpu : parse_cpu_list(str))
+            {
+                for (auto& info : result)
+                {
+                    if (info.cpu == cpu)
+                    {
+                        info.node = node;
+                    }
+                }
+            }
+        }
+    }
+#endif
+
+    if (result.empty())
+    {
+        int num_cpus = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+
+        for (int cpu = 0; cpu < num_cpus; ++cpu)
+        {
+            cpu_info info = { cpu, 0, cpu, 0, 0 };
+            result.push_back(info);
+        }
+    }
+
+    // Rank hardware threads that share a physical core
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+        for (size_t j = 0; j < i; ++j)
+        {
+            if (result[j].package == result[i].package && result[j].core == result[i].core)
+            {
+                ++result[i].smt_rank;
+            }
+        }
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Order cpus so that threads are first distributed over physical cores and
+// only then over SMT siblings.
+//
+// compact: fill up the cores of one NUMA node before moving to the next
+// scatter: distribute round-robin over the NUMA nodes
+//
+
+inline std::vector<cpu_info> order_cpus(std::vector<cpu_info> cpus, bool scatter)
+{
+    if (!scatter)
+    {
+        std::sort(
+                cpus.begin(),
+                cpus.end(),
+                [](cpu_info const& a, cpu_info const& b)
+                {
+                    return std::make_tuple(a.node, a.smt_rank, a.package, a.core, a.cpu)
+                         < std::make_tuple(b.node, b.smt_rank, b.package, b.core, b.cpu);
+                }
+                );
+
+        return cpus;
+    }
+
+    // Rank of each cpu among the cpus with the same node and smt rank
+    std::vector<int> rank(cpus.size(), 0);
+
+    for (size_t i = 0; i < cpus.size(); ++i)
+    {
+        for (size_t j = 0; j < cpus.size(); ++j)
+        {
+            if (cpus[j].node == cpus[i].node && cpus[j].smt_rank == cpus[i].smt_rank
+             && std::make_tuple(cpus[j].package, cpus[j].core, cpus[j].cpu)
+              < std::make_tuple(cpus[i].package, cpus[i].core, cpus[i].cpu))
+            {
+                ++rank[i];
+            }
+        }
+    }
+
+    std::vector<size_t> indices(cpus.size());
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        indices[i] = i;
+    }
+
+    std::sort(
+            indices.begin(),
+            indices.end(),
+            [&](size_t a, size_t b)
+            {
+                return std::make_tuple(cpus[a].smt_rank, rank[a], cpus[a].node)
+                     < std::make_tuple(cpus[b].smt_rank, rank[b], cpus[b].node);
+            }
+            );
+
+    std::vector<cpu_info> result;
+
+    for (auto i : indices)
+    {
+        result.push_back(cpus[i]);
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Pin the calling thread to a logical cpu, returns false if not supported
+//
+
+inline bool pin_this_thread(int cpu)
+{
+#if defined(VSNRAY_OS_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+#else
+    static_cast<void>(cpu);
+    return false;
+#endif
+}
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_DETAIL_CPU_TOPOLOGY_H
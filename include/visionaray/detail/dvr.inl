@@ -0,0 +1,425 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_DVR_INL
+#define VSNRAY_DETAIL_DVR_INL 1
+
+#include <cstddef>
+#include <type_traits>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/intersect.h>
+#include <visionaray/math/limits.h>
+#include <visionaray/math/ray.h>
+#include <visionaray/math/vector.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/macrocell_grid.h>
+#include <visionaray/result_record.h>
+
+#include "macros.h"
+
+namespace visionaray
+{
+namespace dvr
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Next interval of non-empty macrocells, per lane. Only lanes in mask are updated
+//
+
+VSNRAY_FUNC
+inline void next_interval(
+        macrocell_grid_ref const&   grid,
+        basic_ray<float> const&     ray,
+        float                       tmin,
+        float                       tmax,
+        bool                        mask,
+        float&                      t0,
+        float&                      t1
+        )
+{
+    if (mask)
+    {
+        grid.next_interval(ray, tmin, tmax, t0, t1);
+    }
+}
+
+template <typename S, typename = typename std::enable_if<simd::is_simd_vector<S>::value>::type>
+inline void next_interval(
+        macrocell_grid_ref const&   grid,
+        basic_ray<S> const&         ray,
+        S const&                    tmin,
+        S const&                    tmax,
+        simd::mask_type_t<S> const& mask,
+        S&                          t0,
+        S&                          t1
+        )
+{
+    using float_array = simd::aligned_array_t<S>;
+
+    auto rays = simd::unpack(ray);
+
+    float_array tmins;
+    float_array tmaxs;
+    float_array t0s;
+    float_array t1s;
+    float_array masks;
+
+    store(tmins, tmin);
+    store(tmaxs, tmax);
+    store(t0s, t0);
+    store(t1s, t1);
+    store(masks, select(mask, S(1.0), S(0.0)));
+
+    for (size_t i = 0; i < simd::num_elements<S>::value; ++i)
+    {
+        if (masks[i] != 0.0f)
+        {
+            grid.next_interval(rays[i], tmins[i], tmaxs[i], t0s[i], t1s[i]);
+        }
+    }
+
+    t0 = S(t0s);
+    t1 = S(t1s);
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Adaptive ray marching integrator
+//
+// Front-to-back integration of post-classified samples along a ray in texture space (the
+// volume is [0..1)^3). Can be reused by custom kernels, works with float and SIMD rays.
+//
+// The step after a sample is chosen from the rate of change of the scalar value along the
+// ray (the directional derivative, estimated from the last step) and the opacity of the
+// sample:
+//
+//      h = clamp( min(max_value_change / 2 / |ds/dt|, h(max_step_opacity), 2 * h_prev), min_delta, max_delta )
+//
+// Steps that change the scalar value by more than max_value_change are rejected and taken
+// again with a shorter step, so that thin features of the transfer function are not missed
+// when entering a region from a homogeneous one. The first step is min_delta, the last step
+// ends at tmax. Transfer function opacities refer to steps of length delta_ref and are
+// corrected for the step length: alpha' = 1 - (1 - alpha)^(h / delta_ref).
+//
+// Lanes of ray packets adapt their steps independently. Lanes that leave [tmin..tmax) or
+// whose opacity reaches opacity_threshold are masked out, the loop ends when no lane is
+// active anymore
+//
+
+template <typename Volume, typename TransFunc>
+struct adaptive_integrator
+{
+    Volume volume;
+    TransFunc transfunc;
+
+    // Step length that the opacities of the transfer function refer to
+    float delta_ref;
+
+    float min_delta;
+    float max_delta;
+
+    // Change of the scalar value (transfer function coordinates) per step,
+    // the default is one texel of the transfer function
+    float max_value_change;
+
+    // Opacity of a single step
+    float max_step_opacity;
+
+    float opacity_threshold;
+
+    // Integrate the ray over [tmin..tmax) for the lanes in mask and composite
+    // the result (premultiplied alpha) with dst
+    template <typename R, typename M>
+    VSNRAY_FUNC void integrate(
+            R const&                                    tex_ray,
+            typename R::scalar_type const&              tmin,
+            typename R::scalar_type const&              tmax,
+            M                                           mask,
+            vector<4, typename R::scalar_type>&         dst
+            ) const
+    {
+        using S = typename R::scalar_type;
+        using C = vector<4, S>;
+
+        // Keep exp() in a range that the SIMD implementation handles
+        S max_exponent(80.0);
+
+        S tau_max(-log(1.0f - max_step_opacity));
+
+        auto active = mask & (tmin < tmax) & (dst.w < S(opacity_threshold));
+
+        if (!any(active))
+        {
+            return;
+        }
+
+        // Front of the current step
+        S t0   = tmin;
+        S s0   = tex3D(volume, tex_ray.ori + tex_ray.dir * t0);
+        C rgba = tex1D(transfunc, s0);
+
+        S h(min_delta);
+
+        while (any(active))
+        {
+            h = min( h, tmax - t0 );
+
+            S t1 = t0 + h;
+            S s1 = tex3D(volume, tex_ray.ori + tex_ray.dir * t1);
+
+            // Rate of change of the scalar value along the ray
+            S change = abs(s1 - s0);
+            S rate = change / h;
+
+            // Steps should change the value by half the maximum
+            S h_value = S(0.5f * max_value_change) / max(rate, S(1E-6));
+
+            // Reject steps that change the value too much, retry with a shorter step
+            auto reject = active & (change > S(max_value_change)) & (h > S(min_delta));
+            auto accept = active & !reject;
+
+            // Extinction per reference step, opacity correction for the step length
+            S tau = -log( max(S(1.0) - rgba.w, S(1E-6)) );
+            S alpha = S(1.0) - exp( max(-tau * h / S(delta_ref), -max_exponent) );
+
+            // front-to-back alpha compositing, the front sample represents the step
+            C color(rgba.xyz() * alpha, alpha);
+            dst += select( accept, color * (S(1.0) - dst.w), C(0.0) );
+
+            // Next step, limited by the opacity of the sample at its front
+            C rgba1 = tex1D(transfunc, s1);
+            S tau1  = -log( max(S(1.0) - rgba1.w, S(1E-6)) );
+
+            S h_opacity = S(delta_ref) * tau_max / max(tau1, S(1E-6));
+            S h_next = clamp( min(min(h_value, h_opacity), h * S(2.0)), S(min_delta), S(max_delta) );
+            S h_retry = max( min(h_value, h * S(0.5)), S(min_delta) );
+
+            t0   = select( accept, t1, t0 );
+            s0   = select( accept, s1, s0 );
+            rgba = select( accept, rgba1, rgba );
+            h    = select( accept, h_next, select(reject, h_retry, h) );
+
+            active &= (t0 < tmax) & (dst.w < S(opacity_threshold));
+        }
+    }
+};
+
+template <typename Volume, typename TransFunc>
+VSNRAY_FUNC
+inline adaptive_integrator<Volume, TransFunc> make_adaptive_integrator(
+        Volume const&       volume,
+        TransFunc const&    transfunc,
+        float               delta_ref
+        )
+{
+    return {
+        volume,
+        transfunc,
+        delta_ref,
+        delta_ref * 0.25f,
+        delta_ref * 8.0f,
+        1.0f / transfunc.width(),
+        0.1f,
+        0.999f
+        };
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Direct volume rendering kernel
+//
+// Ray marching with post-classification and front-to-back compositing. Samples are
+// taken at a distance of params.delta, starting at the entry point of the bounding
+// box. If params.grid is set, intervals along a ray that fall into macrocells with
+// zero opacity are skipped; lanes of ray packets skip independently of each other.
+// Samples remain on the same positions along the ray with and without skipping.
+//
+// If params.preintegrated is set, the segments between two consecutive samples are
+// classified with params.preintegration_table instead. The segments start at the entry
+// point, when skipping, the scalar value at the front of the first segment of an
+// interval is sampled again, and the last segment extends into the empty cells.
+//
+// If params.adaptive is set, each interval is integrated with an adaptive_integrator,
+// step lengths are in the range params.delta * params.adaptive_range
+//
+
+template <typename Params>
+struct kernel
+{
+
+    Params params;
+
+    template <typename R>
+    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(R ray) const
+    {
+        using S = typename R::scalar_type;
+        using V = vector<3, S>;
+        using C = vector<4, S>;
+
+        result_record<S> result;
+        result.color = C(0.0);
+
+        auto hit_rec = intersect(ray, params.bbox);
+
+        // Ray in texture coordinates, t is the same in both spaces
+        V size(params.bbox.max - params.bbox.min);
+
+        R tex_ray;
+        tex_ray.ori = (ray.ori - V(params.bbox.min)) / size;
+        tex_ray.dir = ray.dir / size;
+
+        S delta(params.delta);
+        S tnear = max(hit_rec.tnear, S(0.0));
+        S tfar  = hit_rec.tfar;
+
+        auto active = hit_rec.hit & (tnear < tfar);
+
+        bool skip = !params.grid.empty();
+
+        if (params.adaptive)
+        {
+            result.color = integrate_adaptive(tex_ray, tnear, tfar, active, skip);
+            result.hit   = hit_rec.hit;
+            return result;
+        }
+
+        // With pre-integration, each sample terminates the segment [t - delta..t)
+        bool preintegrated = params.preintegrated;
+        S t = preintegrated ? tnear + delta : tnear;
+        S reach = preintegrated ? delta : S(0.0);
+
+        // End of the current interval of non-empty cells
+        S tend = skip ? tnear : tfar;
+
+        // Scalar value at the front of the current segment
+        S sf(0.0);
+
+        if (preintegrated && !skip)
+        {
+            sf = tex3D(params.volume, tex_ray.ori + tex_ray.dir * tnear);
+        }
+
+        C dst(0.0);
+
+        while (any(active))
+        {
+            if (skip)
+            {
+                auto lookup = active & (t >= tend + reach);
+
+                if (any(lookup))
+                {
+                    S t0 = tfar;
+                    S t1 = tfar;
+                    detail::next_interval(params.grid, tex_ray, t, tfar, lookup, t0, t1);
+
+                    // Continue with the first sample inside the interval
+                    S k = ceil( (t0 - tnear) / delta );
+                    t    = select( lookup, max(t, tnear + k * delta), t );
+                    tend = select( lookup, t1, tend );
+
+                    if (preintegrated)
+                    {
+                        S front = tex3D(params.volume, tex_ray.ori + tex_ray.dir * (t - delta));
+                        sf = select( lookup, front, sf );
+                    }
+                }
+            }
+
+            active &= t < tfar;
+
+            auto inside = active & (t < tend + reach);
+
+            if (any(inside))
+            {
+                auto coord = tex_ray.ori + tex_ray.dir * t;
+
+                auto voxel = tex3D(params.volume, coord);
+                C color;
+
+                if (preintegrated)
+                {
+                    // classify the segment, premultiplied alpha
+                    color = tex2D(params.preintegration_table, vector<2, S>(sf, voxel));
+                    sf = voxel;
+                }
+                else
+                {
+                    // post-classification
+                    color = tex1D(params.transfunc, voxel);
+
+                    // premultiplied alpha
+                    color.xyz() *= color.w;
+                }
+
+                // front-to-back alpha compositing
+                dst += select( inside, color * (S(1.0) - dst.w), C(0.0) );
+
+                // early ray termination
+                active &= dst.w < S(params.opacity_threshold);
+            }
+
+            t = select( inside, t + delta, t );
+        }
+
+        result.color = dst;
+        result.hit   = hit_rec.hit;
+        return result;
+    }
+
+private:
+
+    template <typename R, typename M>
+    VSNRAY_FUNC vector<4, typename R::scalar_type> integrate_adaptive(
+            R const&                        tex_ray,
+            typename R::scalar_type const&  tnear,
+            typename R::scalar_type const&  tfar,
+            M                               active,
+            bool                            skip
+            ) const
+    {
+        using S = typename R::scalar_type;
+        using C = vector<4, S>;
+
+        auto integrator = make_adaptive_integrator(params.volume, params.transfunc, params.delta);
+        integrator.min_delta = params.delta * params.adaptive_range.x;
+        integrator.max_delta = params.delta * params.adaptive_range.y;
+        integrator.opacity_threshold = params.opacity_threshold;
+
+        C dst(0.0);
+
+        if (!skip)
+        {
+            integrator.integrate(tex_ray, tnear, tfar, active, dst);
+            return dst;
+        }
+
+        S t = tnear;
+
+        while (any(active))
+        {
+            S t0 = tfar;
+            S t1 = tfar;
+            detail::next_interval(params.grid, tex_ray, t, tfar, active, t0, t1);
+
+            integrator.integrate(tex_ray, t0, t1, active, dst);
+
+            t = select( active, t1, t );
+            active &= (t < tfar) & (dst.w < S(params.opacity_threshold));
+        }
+
+        return dst;
+    }
+};
+
+} // dvr
+} // visionaray
+
+#endif // VSNRAY_DETAIL_DVR_INL
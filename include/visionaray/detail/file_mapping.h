@@ -0,0 +1,57 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_FILE_MAPPING_H
+#define VSNRAY_DETAIL_FILE_MAPPING_H 1
+
+#include <cstddef>
+#include <string>
+
+#include <visionaray/export.h>
+
+#include "platform.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Read-only memory mapping of a whole file
+//
+// Pages are read on first access and shared with other processes that map the same file
+//
+
+class VSNRAY_EXPORT file_mapping
+{
+public:
+
+    // Map a file, throws std::runtime_error if that fails
+    explicit file_mapping(std::string const& filename);
+
+   ~file_mapping();
+
+    file_mapping(file_mapping const&) = delete;
+    file_mapping& operator=(file_mapping const&) = delete;
+
+    char const* data() const;
+    size_t size() const;
+
+private:
+
+    void* data_ = nullptr;
+    size_t size_ = 0;
+
+#if defined(VSNRAY_OS_WIN32)
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+
+};
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_DETAIL_FILE_MAPPING_H
@@ -34,10 +34,17 @@ inline spectrum<typename T::scalar_type> generic_material<T, Ts...>::ambient() c
     return apply_visitor( ambient_visitor(), *this );
 }
 
+template <typename T, typename ...Ts>
+VSNRAY_FUNC
+inline spectrum<typename T::scalar_type> generic_material<T, Ts...>::albedo() const
+{
+    return apply_visitor( albedo_visitor(), *this );
+}
+
 template <typename T, typename ...Ts>
 template <typename SR>
 VSNRAY_FUNC
-inline spectrum<typename SR::scalar_type> generic_material<T, Ts...>::shade(SR const& sr) const
+inline shade_color_t<SR> generic_material<T, Ts...>::shade(SR const& sr) const
 {
     return apply_visitor( shade_visitor<SR>(sr), *this );
 }
@@ -45,7 +52,7 @@ inline spectrum<typename SR::scalar_type> generic_material<T, Ts...>::shade(SR c
 template <typename T, typename ...Ts>
 template <typename SR, typename U, typename Sampler>
 VSNRAY_FUNC
-inline spectrum<U> generic_material<T, Ts...>::sample(
+inline shade_color_t<SR> generic_material<T, Ts...>::sample(
         SR const&       sr,
         vector<3, U>&   refl_dir,
         U&              pdf,
@@ -55,6 +62,14 @@ inline spectrum<U> generic_material<T, Ts...>::sample(
     return apply_visitor( sample_visitor<SR, U, Sampler>(sr, refl_dir, pdf, sampler), *this );
 }
 
+template <typename T, typename ...Ts>
+template <typename SR>
+VSNRAY_FUNC
+inline typename SR::scalar_type generic_material<T, Ts...>::pdf(SR const& sr) const
+{
+    return apply_visitor( pdf_visitor<SR>(sr), *this );
+}
+
 
 //-------------------------------------------------------------------------------------------------
 // Private variant visitors
@@ -94,11 +109,25 @@ struct generic_material<T, Ts...>::ambient_visitor
     }
 };
 
+template <typename T, typename ...Ts>
+struct generic_material<T, Ts...>::albedo_visitor
+{
+    using Base = generic_material<T, Ts...>;
+    using return_type = spectrum<typename Base::scalar_type>;
+
+    template <typename X>
+    VSNRAY_FUNC
+    return_type operator()(X const& ref) const
+    {
+        return ref.albedo();
+    }
+};
+
 template <typename T, typename ...Ts>
 template <typename SR>
 struct generic_material<T, Ts...>::shade_visitor
 {
-    using return_type = spectrum<typename SR::scalar_type>;
+    using return_type = shade_color_t<SR>;
 
     VSNRAY_FUNC
     shade_visitor(SR const& sr) : sr_(sr) {}
@@ -117,7 +146,7 @@ template <typename T, typename ...Ts>
 template <typename SR, typename U, typename Sampler>
 struct generic_material<T, Ts...>::sample_visitor
 {
-    using return_type = spectrum<typename SR::scalar_type>;
+    using return_type = shade_color_t<SR>;
 
     VSNRAY_FUNC
     sample_visitor(SR const& sr, vector<3, U>& refl_dir, U& pdf, Sampler& sampler)
@@ -141,6 +170,25 @@ struct generic_material<T, Ts...>::sample_visitor
     Sampler&        sampler_;
 };
 
+template <typename T, typename ...Ts>
+template <typename SR>
+struct generic_material<T, Ts...>::pdf_visitor
+{
+    using return_type = typename SR::scalar_type;
+
+    VSNRAY_FUNC
+    pdf_visitor(SR const& sr) : sr_(sr) {}
+
+    template <typename X>
+    VSNRAY_FUNC
+    return_type operator()(X const& ref) const
+    {
+        return ref.pdf(sr_);
+    }
+
+    SR const& sr_;
+};
+
 
 namespace simd
 {
@@ -206,53 +254,308 @@ public:
         return pack(amb);
     }
 
+    VSNRAY_FUNC
+    spectrum<scalar_type> albedo() const
+    {
+        array<spectrum<float>, N> alb;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            alb[i] = mats_[i].albedo();
+        }
+
+        return pack(alb);
+    }
+
+
+    // shade(), sample() and pdf() group the lanes by material type. The materials
+    // of a group that covers at least three quarters of the packet are packed into
+    // a SIMD material (e.g. plastic<float4>) that is evaluated for the whole packet,
+    // the results are then blended into the lanes of the group. The lanes of smaller
+    // groups are evaluated one by one, a SIMD material is not cheaper than that.
+    // Packets whose lanes were sorted by material type (cf. wavefront_queue::
+    // sort_by_material()) are thus mostly evaluated with a single vectorized call.
+    // Only sorted input benefits: the packets of pathtracing::kernel and other
+    // megakernels are in pixel order and rarely have such a group unless the scene
+    // has few materials. Mixed packets without such a group only pay for counting
+    // the types, they are evaluated one lane at a time without masking
 
     template <typename SR>
     VSNRAY_FUNC
-    spectrum<scalar_type> shade(SR const& sr) const
+    shade_color_t<SR> shade(SR const& sr) const
     {
-        auto srs = unpack(sr);
+        using C = shade_color_t<SR>;
+        using scalar_color = decltype(mats_[0].shade(unpack(sr)[0]));
 
-        array<spectrum<float>, N> shaded;
+        C result(0.0);
 
-        for (size_t i = 0; i < N; ++i)
+        auto groups = make_groups();
+
+        if (groups.num_scalar_lanes < N)
         {
-            shaded[i] = mats_[i].shade(srs[i]);
+            for_each_group(shade_group<SR>{ sr, result }, groups, visionaray::detail::type_index<1>{});
         }
 
-        return pack(shaded);
+        if (groups.num_scalar_lanes > 0)
+        {
+            auto srs = unpack(sr);
+
+            array<scalar_color, N> shaded;
+
+            for (size_t i = 0; i < N; ++i)
+            {
+                shaded[i] = groups.scalar_lanes[i] ? mats_[i].shade(srs[i]) : scalar_color(0.0);
+            }
+
+            result = groups.num_scalar_lanes == N
+                   ? pack(shaded)
+                   : select( mask_type(groups.scalar_lanes), pack(shaded), result );
+        }
+
+        return result;
     }
 
     template <typename SR, typename S /* sampler */>
     VSNRAY_FUNC
-    spectrum<scalar_type> sample(
+    shade_color_t<SR> sample(
             SR const&               sr,
             vector<3, scalar_type>& refl_dir,
             scalar_type&            pdf,
             S&                      samp
             ) const
     {
-        using float_array = aligned_array_t<scalar_type>;
+        using C = shade_color_t<SR>;
+        using scalar_color = decltype(mats_[0].shade(unpack(sr)[0]));
 
-        auto srs = unpack(sr);
-        auto& s = samp.get_sampler();
+        C result(0.0);
+        refl_dir = vector<3, scalar_type>(0.0);
+        pdf = scalar_type(0.0);
 
-        array<vector<3, float>, N> rds;
-        float_array                     pdfs;
-        array<spectrum<float>, N>  sampled;
+        auto groups = make_groups();
 
-        for (size_t i = 0; i < N; ++i)
+        if (groups.num_scalar_lanes < N)
+        {
+            for_each_group(sample_group<SR, S>{ sr, refl_dir, pdf, samp, result }, groups, visionaray::detail::type_index<1>{});
+        }
+
+        if (groups.num_scalar_lanes > 0)
+        {
+            using float_array = aligned_array_t<scalar_type>;
+
+            auto srs = unpack(sr);
+            auto& s = samp.get_sampler();
+
+            array<vector<3, float>, N> rds;
+            float_array                pdfs;
+            array<scalar_color, N>     sampled;
+
+            for (size_t i = 0; i < N; ++i)
+            {
+                rds[i]     = vector<3, float>(0.0f);
+                pdfs[i]    = 0.0f;
+                sampled[i] = groups.scalar_lanes[i] ? mats_[i].sample(srs[i], rds[i], pdfs[i], s) : scalar_color(0.0);
+            }
+
+            if (groups.num_scalar_lanes == N)
+            {
+                refl_dir = pack(rds);
+                pdf      = scalar_type(pdfs);
+                result   = pack(sampled);
+            }
+            else
+            {
+                mask_type m(groups.scalar_lanes);
+                refl_dir = select( m, pack(rds), refl_dir );
+                pdf      = select( m, scalar_type(pdfs), pdf );
+                result   = select( m, pack(sampled), result );
+            }
+        }
+
+        return result;
+    }
+
+    template <typename SR>
+    VSNRAY_FUNC
+    scalar_type pdf(SR const& sr) const
+    {
+        scalar_type result(0.0);
+
+        auto groups = make_groups();
+
+        if (groups.num_scalar_lanes < N)
         {
-            sampled[i] = mats_[i].sample(srs[i], rds[i], pdfs[i], s);
+            for_each_group(pdf_group<SR>{ sr, result }, groups, visionaray::detail::type_index<1>{});
         }
 
-        refl_dir = pack(rds);
-        pdf = scalar_type(pdfs);
-        return pack(sampled);
+        if (groups.num_scalar_lanes > 0)
+        {
+            using float_array = aligned_array_t<scalar_type>;
+
+            auto srs = unpack(sr);
+
+            float_array pdfs;
+
+            for (size_t i = 0; i < N; ++i)
+            {
+                pdfs[i] = groups.scalar_lanes[i] ? mats_[i].pdf(srs[i]) : 0.0f;
+            }
+
+            result = groups.num_scalar_lanes == N
+                   ? scalar_type(pdfs)
+                   : select( mask_type(groups.scalar_lanes), scalar_type(pdfs), result );
+        }
+
+        return result;
     }
 
 private:
 
+    using mask_type  = mask_type_t<scalar_type>;
+    using mask_array = aligned_array_t<mask_type>;
+
+    template <typename SR>
+    struct shade_group
+    {
+        SR const&               sr;
+        shade_color_t<SR>&      result;
+
+        template <typename M>
+        void operator()(M const& mat, mask_type const& mask) const
+        {
+            result = select( mask, mat.shade(sr), result );
+        }
+    };
+
+    template <typename SR, typename S>
+    struct sample_group
+    {
+        SR const&               sr;
+        vector<3, scalar_type>& refl_dir;
+        scalar_type&            pdf;
+        S&                      samp;
+        shade_color_t<SR>&      result;
+
+        template <typename M>
+        void operator()(M const& mat, mask_type const& mask) const
+        {
+            vector<3, scalar_type> rd(0.0);
+            scalar_type p(0.0);
+            auto sampled = mat.sample(sr, rd, p, samp);
+
+            refl_dir = select( mask, rd, refl_dir );
+            pdf      = select( mask, p, pdf );
+            result   = select( mask, sampled, result );
+        }
+    };
+
+    template <typename SR>
+    struct pdf_group
+    {
+        SR const&       sr;
+        scalar_type&    result;
+
+        template <typename M>
+        void operator()(M const& mat, mask_type const& mask) const
+        {
+            result = select( mask, mat.pdf(sr), result );
+        }
+    };
+
+    // Lanes grouped by material type. Groups that cover at least three quarters
+    // of the packet are evaluated vectorized, the other lanes are marked in
+    // scalar_lanes. If there is no such group, all lanes are scalar lanes and
+    // the type counts are not needed
+    struct lane_groups
+    {
+        unsigned    type[N];
+        unsigned    count[sizeof...(Ts)];
+        mask_array  scalar_lanes;
+        unsigned    num_scalar_lanes;
+    };
+
+    lane_groups make_groups() const
+    {
+        lane_groups result;
+
+        for (size_t t = 0; t < sizeof...(Ts); ++t)
+        {
+            result.count[t] = 0;
+        }
+
+        unsigned max_count = 0;
+
+        // Lanes without a valid material (e.g. default constructed for
+        // inactive lanes) are passed on to the scalar variant visitors
+        for (size_t i = 0; i < N; ++i)
+        {
+            result.type[i] = mats_[i].which();
+
+            if (result.type[i] < sizeof...(Ts))
+            {
+                unsigned c = ++result.count[result.type[i]];
+                max_count = c > max_count ? c : max_count;
+            }
+        }
+
+        // Early-out for mixed packets
+        if (max_count * 4 < N * 3)
+        {
+            for (size_t i = 0; i < N; ++i)
+            {
+                result.scalar_lanes[i] = true;
+            }
+
+            result.num_scalar_lanes = N;
+            return result;
+        }
+
+        result.num_scalar_lanes = 0;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            result.scalar_lanes[i] = result.type[i] >= sizeof...(Ts) || result.count[result.type[i]] * 4 < N * 3;
+            result.num_scalar_lanes += result.scalar_lanes[i] ? 1 : 0;
+        }
+
+        return result;
+    }
+
+    // Call func(M, mask) for each vectorized group, M is the SIMD material
+    template <typename Func, unsigned I>
+    void for_each_group(Func const& func, lane_groups const& groups, visionaray::detail::type_index<I>) const
+    {
+        using M = visionaray::detail::type_at<I, Ts...>;
+
+        if (groups.count[I - 1] * 4 >= N * 3)
+        {
+            mask_array mask;
+            size_t first = N;
+
+            for (size_t i = 0; i < N; ++i)
+            {
+                mask[i] = groups.type[i] == I - 1;
+                first = mask[i] && first == N ? i : first;
+            }
+
+            // Lanes of other types get a copy of the first material of this type
+            array<M, N> group;
+
+            for (size_t i = 0; i < N; ++i)
+            {
+                group[i] = *mats_[mask[i] ? i : first].template as<M>();
+            }
+
+            func(pack(group), mask_type(mask));
+        }
+
+        for_each_group(func, groups, visionaray::detail::type_index<I + 1>{});
+    }
+
+    template <typename Func>
+    void for_each_group(Func const&, lane_groups const&, visionaray::detail::type_index<sizeof...(Ts) + 1>) const
+    {
+    }
+
     array<single_material, N> mats_;
 
 };
@@ -300,7 +603,7 @@ inline generic_material<16, Ts...> pack(array<visionaray::generic_material<Ts...
 template <typename ...Ts>
 inline array<visionaray::generic_material<Ts...>, 16> unpack(generic_material<16, Ts...> const& m16)
 {
-    return array<visionaray::generic_material<Ts...>, 8>{{
+    return array<visionaray::generic_material<Ts...>, 16>{{
             m16.get( 0), m16.get( 1), m16.get( 2), m16.get( 3),
             m16.get( 4), m16.get( 5), m16.get( 6), m16.get( 7),
             m16.get( 8), m16.get( 9), m16.get(10), m16.get(11),
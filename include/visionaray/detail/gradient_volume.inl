@@ -0,0 +1,174 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include <visionaray/math/math.h>
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// gradient_volume members
+//
+
+inline gradient_volume::gradient_volume(unsigned num_threads)
+    : pool_(std::make_shared<thread_pool>(num_threads))
+    , priority_(thread_pool::Normal)
+{
+}
+
+inline gradient_volume::gradient_volume(std::shared_ptr<thread_pool> pool, int priority)
+    : pool_(pool)
+    , priority_(priority)
+{
+}
+
+template <typename Volume>
+inline void gradient_volume::build(Volume const& volume)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    int w = static_cast<int>(volume.width());
+    int h = static_cast<int>(volume.height());
+    int d = static_cast<int>(volume.depth());
+
+    size_ = vec3i(w, h, d);
+    data_.resize(static_cast<size_t>(w) * h * d);
+
+    auto voxels = volume.data();
+
+    auto value = [&](int x, int y, int z)
+    {
+        return static_cast<float>(voxels[(static_cast<size_t>(z) * h + y) * w + x]);
+    };
+
+    // Central differences, one-sided at the borders
+    auto gradient = [&](int x, int y, int z)
+    {
+        int x0 = std::max(x - 1, 0);
+        int y0 = std::max(y - 1, 0);
+        int z0 = std::max(z - 1, 0);
+        int x1 = std::min(x + 1, w - 1);
+        int y1 = std::min(y + 1, h - 1);
+        int z1 = std::min(z + 1, d - 1);
+
+        // Distances in texture coordinates
+        return vec3(
+                x1 > x0 ? (value(x1, y, z) - value(x0, y, z)) * w / (x1 - x0) : 0.0f,
+                y1 > y0 ? (value(x, y1, z) - value(x, y0, z)) * h / (y1 - y0) : 0.0f,
+                z1 > z0 ? (value(x, y, z1) - value(x, y, z0)) * d / (z1 - z0) : 0.0f
+                );
+    };
+
+    // Magnitudes are stored relative to the largest magnitude, take two passes
+    std::vector<float> slice_max(d, 0.0f);
+
+    parallel_slices([&](int z)
+    {
+        for (int y = 0; y < h; ++y)
+        {
+            for (int x = 0; x < w; ++x)
+            {
+                slice_max[z] = std::max(slice_max[z], length(gradient(x, y, z)));
+            }
+        }
+    });
+
+    max_magnitude_ = d > 0 ? *std::max_element(slice_max.begin(), slice_max.end()) : 0.0f;
+
+    float scale = max_magnitude_ > 0.0f ? 1.0f / max_magnitude_ : 0.0f;
+
+    parallel_slices([&](int z)
+    {
+        for (int y = 0; y < h; ++y)
+        {
+            for (int x = 0; x < w; ++x)
+            {
+                vec3 g = gradient(x, y, z);
+                float m = length(g);
+                vec3 n = m > 0.0f ? g / m : vec3(0.0f);
+
+                data_[(static_cast<size_t>(z) * h + y) * w + x] = texel_type(vec4(n * 0.5f + vec3(0.5f), m * scale));
+            }
+        }
+    });
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    last_build_time_ = elapsed.count();
+}
+
+inline texture_ref<gradient_volume::texel_type, 3> gradient_volume::ref() const
+{
+    texture_ref<texel_type, 3> result(size_.x, size_.y, size_.z);
+    result.reset(data_.data());
+    result.set_filter_mode(Linear);
+    result.set_address_mode(Clamp);
+    return result;
+}
+
+inline vec3i gradient_volume::size() const
+{
+    return size_;
+}
+
+inline float gradient_volume::max_magnitude() const
+{
+    return max_magnitude_;
+}
+
+inline gradient_volume::texel_type const& gradient_volume::operator()(int x, int y, int z) const
+{
+    return data_[(static_cast<size_t>(z) * size_.y + y) * size_.x + x];
+}
+
+inline double gradient_volume::last_build_time() const
+{
+    return last_build_time_;
+}
+
+inline void gradient_volume::parallel_slices(std::function<void(int)> const& func)
+{
+    if (size_.z <= 0)
+    {
+        return;
+    }
+
+    auto j = std::make_shared<thread_pool::job>(size_.z, priority_);
+
+    j->process_item = [&func](long z)
+    {
+        func(static_cast<int>(z));
+    };
+
+    auto done = j->done.get_future();
+    pool_->submit(j);
+    done.wait();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Decoding
+//
+
+template <typename T>
+VSNRAY_FUNC
+inline vector<3, T> decode_gradient(vector<4, T> const& texel, float max_magnitude)
+{
+    return decode_normal(texel) * (texel.w * T(max_magnitude));
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline vector<3, T> decode_normal(vector<4, T> const& texel)
+{
+    // Filtering shortens the directions
+    vector<3, T> n = texel.xyz() * T(2.0) - vector<3, T>(T(1.0));
+    T len = length(n);
+    return select( len > T(0.0), n / len, vector<3, T>(T(0.0)) );
+}
+
+} // visionaray
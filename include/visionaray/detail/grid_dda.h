@@ -0,0 +1,139 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_GRID_DDA_H
+#define VSNRAY_DETAIL_GRID_DDA_H 1
+
+#include <type_traits>
+
+#include <visionaray/math/simd/gather.h>
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/limits.h>
+#include <visionaray/math/ray.h>
+#include <visionaray/math/vector.h>
+
+#include "macros.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// 3D DDA over the cells of a uniform grid, lanes of ray packets advance independently,
+// see: Amanatides and Woo (1987): A fast voxel traversal algorithm
+//
+// Cells are addressed with (float) linear indices in x-major order, use load_cell() to
+// read per cell data. Positions and rays are in units of the grid, i.e. cell (i,j,k)
+// covers [i..i+1) * cell_extent in x and so on
+//
+
+template <typename S>
+struct grid_dda
+{
+    using V = vector<3, S>;
+
+    VSNRAY_FUNC grid_dda(vec3i const& grid_dims, vec3 const& cell_extent, basic_ray<S> const& ray, S const& t)
+    {
+        dims = V(
+                S(static_cast<float>(grid_dims.x)),
+                S(static_cast<float>(grid_dims.y)),
+                S(static_cast<float>(grid_dims.z))
+                );
+
+        V ext(cell_extent);
+
+        // Start position in cell units
+        V p = (ray.ori + ray.dir * t) / ext;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            cell[i] = clamp(floor(p[i]), S(0.0), dims[i] - S(1.0));
+
+            S dir = ray.dir[i] / ext[i];
+            S inv = S(1.0) / dir;
+
+            step[i]    = select(dir > S(0.0), S(1.0), select(dir < S(0.0), S(-1.0), S(0.0)));
+            t_delta[i] = select(dir != S(0.0), abs(inv), numeric_limits<S>::max());
+            t_next[i]  = select(
+                    dir > S(0.0),
+                    t + (cell[i] + S(1.0) - p[i]) * inv,
+                    select(dir < S(0.0), t + (cell[i] - p[i]) * inv, numeric_limits<S>::max())
+                    );
+        }
+    }
+
+    // Distance where the ray leaves the current cell
+    VSNRAY_FUNC S exit() const
+    {
+        return min(t_next.x, min(t_next.y, t_next.z));
+    }
+
+    // Linear index of the current cell
+    VSNRAY_FUNC S cell_index() const
+    {
+        // Cells may be outside the grid due to round-off
+        V c(
+            clamp(cell.x, S(0.0), dims.x - S(1.0)),
+            clamp(cell.y, S(0.0), dims.y - S(1.0)),
+            clamp(cell.z, S(0.0), dims.z - S(1.0))
+            );
+
+        return (c.z * dims.y + c.y) * dims.x + c.x;
+    }
+
+    // Advance the lanes in mask to the next cell
+    template <typename M>
+    VSNRAY_FUNC void next(M const& mask)
+    {
+        S t = exit();
+
+        auto mx = mask & (t_next.x == t);
+        auto my = mask & !mx & (t_next.y == t);
+        auto mz = mask & !mx & !my;
+
+        cell.x   = select(mx, cell.x + step.x, cell.x);
+        cell.y   = select(my, cell.y + step.y, cell.y);
+        cell.z   = select(mz, cell.z + step.z, cell.z);
+
+        t_next.x = select(mx, t_next.x + t_delta.x, t_next.x);
+        t_next.y = select(my, t_next.y + t_delta.y, t_next.y);
+        t_next.z = select(mz, t_next.z + t_delta.z, t_next.z);
+    }
+
+    V dims;
+    V cell;
+    V step;
+    V t_delta;
+    V t_next;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Per cell data at (float) linear indices
+//
+
+template <typename T>
+VSNRAY_FUNC
+inline T load_cell(T const* data, float index)
+{
+    return data[static_cast<int>(index)];
+}
+
+template <
+    typename T,
+    typename S,
+    typename = typename std::enable_if<simd::is_simd_vector<S>::value>::type
+    >
+inline auto load_cell(T const* data, S const& index)
+    -> decltype(gather(data, convert_to_int(index)))
+{
+    return gather(data, convert_to_int(index));
+}
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_DETAIL_GRID_DDA_H
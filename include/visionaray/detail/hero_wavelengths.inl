@@ -0,0 +1,251 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <type_traits>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/array.h>
+
+#include "color_conversion.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Evaluate an SPD (functor: float lambda (nm) -> float) per lane
+//
+
+template <typename SPD>
+VSNRAY_FUNC
+inline float eval_spd(SPD const& spd, float lambda)
+{
+    return spd(lambda);
+}
+
+template <
+    typename SPD,
+    typename T,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type
+    >
+inline T eval_spd(SPD const& spd, T const& lambda)
+{
+    using float_array = simd::aligned_array_t<T>;
+
+    float_array lambdas;
+    store(lambdas, lambda);
+
+    float_array result;
+
+    for (size_t i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        result[i] = spd(lambdas[i]);
+    }
+
+    return T(result);
+}
+
+// Sampled spectra may store different SPDs per lane
+template <typename T, typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+inline T eval_spd(spectrum<T> const& spe, T const& lambda)
+{
+    using float_array = simd::aligned_array_t<T>;
+
+    float_array lambdas;
+    store(lambdas, lambda);
+
+    float_array result;
+
+    for (size_t i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        float_array values;
+        store(values, spe(lambdas[i]));
+        result[i] = values[i];
+    }
+
+    return T(result);
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T smoothstep(float e0, float e1, T const& x)
+{
+    T t = clamp( (x - T(e0)) / T(e1 - e0), T(0.0), T(1.0) );
+    return t * t * (T(3.0) - T(2.0) * t);
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// hero_wavelengths members
+//
+
+template <typename T, size_t N>
+VSNRAY_FUNC
+inline hero_wavelengths<T, N>::hero_wavelengths(T const& u)
+{
+    float lmin = lambda_min;
+    float lmax = lambda_max;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        T f = u + T(static_cast<float>(i) / N);
+        f = select( f >= T(1.0), f - T(1.0), f );
+
+        lambdas_[i] = T(lmin) + f * T(lmax - lmin);
+    }
+}
+
+template <typename T, size_t N>
+VSNRAY_FUNC
+inline hero_wavelengths<T, N>::hero_wavelengths(vector<N, T> const& lambdas)
+    : lambdas_(lambdas)
+{
+}
+
+template <typename T, size_t N>
+VSNRAY_FUNC
+inline T hero_wavelengths<T, N>::pdf() const
+{
+    float lmin = lambda_min;
+    float lmax = lambda_max;
+
+    return T(1.0f / (lmax - lmin));
+}
+
+
+namespace simd
+{
+
+//-------------------------------------------------------------------------------------------------
+// Unpack SIMD wavelengths
+//
+
+template <
+    typename T,
+    size_t N,
+    typename = typename std::enable_if<is_simd_vector<T>::value>::type
+    >
+inline array<hero_wavelengths<float, N>, num_elements<T>::value> unpack(hero_wavelengths<T, N> const& wl)
+{
+    auto lambdas = unpack(wl.lambdas());
+
+    array<hero_wavelengths<float, N>, num_elements<T>::value> result;
+
+    for (size_t i = 0; i < num_elements<T>::value; ++i)
+    {
+        result[i] = hero_wavelengths<float, N>(lambdas[i]);
+    }
+
+    return result;
+}
+
+} // simd
+
+
+//-------------------------------------------------------------------------------------------------
+// Conversions
+//
+
+// SPD -> samples
+
+template <typename SPD, typename T, size_t N>
+VSNRAY_FUNC
+inline vector<N, T> from_spd(SPD const& spd, hero_wavelengths<T, N> const& wl)
+{
+    vector<N, T> result;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        result[i] = detail::eval_spd(spd, wl[i]);
+    }
+
+    return result;
+}
+
+// RGB -> samples
+//
+// Linear upsampling with smooth, non-negative basis spectra for blue, green and red
+// that sum up to 1. White (1,1,1) maps to a constant spectrum of 1, and converting
+// the samples back with to_rgb() reproduces the primaries within about 3%. Because
+// the upsampling is linear, RGB products (e.g. BRDF * light intensity) can be
+// upsampled after multiplication
+
+template <typename T, size_t N>
+VSNRAY_FUNC
+inline vector<N, T> from_rgb(vector<3, T> const& rgb, hero_wavelengths<T, N> const& wl)
+{
+    vector<N, T> result;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        T b = T(1.0) - detail::smoothstep(445.0f, 535.0f, wl[i]);
+        T r = detail::smoothstep(575.0f, 605.0f, wl[i]);
+        T g = T(1.0) - b - r;
+
+        result[i] = rgb.x * r + rgb.y * g + rgb.z * b;
+    }
+
+    return result;
+}
+
+// spectrum -> samples
+
+template <typename T, size_t N>
+VSNRAY_FUNC
+inline vector<N, T> from_spectrum(spectrum<T> const& s, hero_wavelengths<T, N> const& wl)
+{
+#if VSNRAY_SPECTRUM_RGB
+    return from_rgb(s.samples(), wl);
+#else
+    return from_spd(s, wl);
+#endif
+}
+
+// samples -> CIE XYZ
+//
+// Monte Carlo estimate of the integrals over the color matching functions, normalized
+// like spd_to_rgb() so that a constant spectrum of 1 has luminance Y = 1
+
+template <typename T, size_t N>
+VSNRAY_FUNC
+inline vector<3, T> to_xyz(vector<N, T> const& samples, hero_wavelengths<T, N> const& wl)
+{
+    // Integral of cie_y() over [lambda_min..lambda_max)
+    float const y_integral = 106.88126f;
+
+    vector<3, T> result(0.0);
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        result.x += samples[i] * cie_x(wl[i]);
+        result.y += samples[i] * cie_y(wl[i]);
+        result.z += samples[i] * cie_z(wl[i]);
+    }
+
+    return result / (wl.pdf() * T(N * y_integral));
+}
+
+// samples -> RGB
+//
+// sRGB, white balanced such that a constant spectrum of 1 maps to (1,1,1)
+
+template <typename T, size_t N>
+VSNRAY_FUNC
+inline vector<3, T> to_rgb(vector<N, T> const& samples, hero_wavelengths<T, N> const& wl)
+{
+    vector<3, T> white_balance(0.83407331f, 1.05194390f, 1.10731316f);
+
+    return xyz_to_rgb( to_xyz(samples, wl) ) * white_balance;
+}
+
+template <typename T, size_t N>
+VSNRAY_FUNC
+inline vector<4, T> to_rgba(vector<N, T> const& samples, hero_wavelengths<T, N> const& wl)
+{
+    return vector<4, T>( to_rgb(samples, wl), T(1.0) );
+}
+
+} // visionaray
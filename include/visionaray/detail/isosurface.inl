@@ -0,0 +1,282 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_ISOSURFACE_INL
+#define VSNRAY_DETAIL_ISOSURFACE_INL 1
+
+#include <type_traits>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/intersect.h>
+#include <visionaray/math/ray.h>
+#include <visionaray/math/vector.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/macrocell_grid.h>
+#include <visionaray/result_record.h>
+
+#include "grid_dda.h"
+#include "macros.h"
+
+namespace visionaray
+{
+namespace isosurface
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Gradient of the scalar field in texture space, central differences over one voxel
+//
+
+template <typename Volume, typename S>
+VSNRAY_FUNC
+inline vector<3, S> gradient(Volume const& volume, vector<3, S> const& coord, vec3 const& texel)
+{
+    using V = vector<3, S>;
+
+    V dx(S(texel.x), S(0.0), S(0.0));
+    V dy(S(0.0), S(texel.y), S(0.0));
+    V dz(S(0.0), S(0.0), S(texel.z));
+
+    S gx = S(tex3D(volume, coord + dx)) - S(tex3D(volume, coord - dx));
+    S gy = S(tex3D(volume, coord + dy)) - S(tex3D(volume, coord - dy));
+    S gz = S(tex3D(volume, coord + dz)) - S(tex3D(volume, coord - dz));
+
+    return V(gx, gy, gz) / V(texel * 2.0f);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Whether the current cell of the DDA cannot contain the surface
+//
+
+VSNRAY_FUNC
+inline bool is_empty(macrocell_grid_ref const& grid, visionaray::detail::grid_dda<float> const& dda)
+{
+    return visionaray::detail::load_cell(grid.data(), dda.cell_index()) != 0;
+}
+
+template <typename S, typename = typename std::enable_if<simd::is_simd_vector<S>::value>::type>
+inline simd::mask_type_t<S> is_empty(macrocell_grid_ref const& grid, visionaray::detail::grid_dda<S> const& dda)
+{
+    return convert_to_float(visionaray::detail::load_cell(grid.data(), dda.cell_index())) != S(0.0);
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Isosurface ray casting kernel
+//
+// Samples the volume at a distance of params.delta along the ray and reports the first
+// surface crossing, i.e. the first pair of consecutive samples on different sides of
+// params.isovalue. The intersection is refined with params.refinement_steps secant steps
+// that keep the surface bracketed (regula falsi). Crossings inside a single step (thin
+// features) can be missed, as with any sampling based approach.
+//
+// If params.grid is set, the kernel traverses the macrocells with a 3D DDA and skips the
+// cells whose value range does not contain the isovalue; lanes of ray packets traverse
+// the grid in lockstep but skip independently of each other. Steps end at the exit
+// points of the cells, marching restarts at the entry point of the next non-empty cell.
+//
+// Normals are the normalized negative gradients of the scalar field (pointing towards
+// lower values) in world space. The color is params.color, shaded with a headlight
+//
+
+template <typename Params>
+struct kernel
+{
+
+    Params params;
+
+    template <typename R>
+    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(R ray) const
+    {
+        using S = typename R::scalar_type;
+        using V = vector<3, S>;
+        using C = vector<4, S>;
+
+        result_record<S> result;
+        result.color = C(0.0);
+
+        auto hit_rec = intersect(ray, params.bbox);
+
+        // Ray in texture coordinates, t is the same in both spaces
+        V size(params.bbox.max - params.bbox.min);
+
+        R tex_ray;
+        tex_ray.ori = (ray.ori - V(params.bbox.min)) / size;
+        tex_ray.dir = ray.dir / size;
+
+        S delta(params.delta);
+        S isovalue(params.isovalue);
+        S tnear = max(hit_rec.tnear, S(0.0));
+        S tfar  = hit_rec.tfar;
+
+        auto active = hit_rec.hit & (tnear < tfar);
+
+        bool skip = !params.grid.empty();
+
+        // Without a grid, the whole volume is a single cell
+        auto const& grid = params.grid;
+        vec3i dims = skip ? grid.dims() : vec3i(1);
+        vec3 cell_extent = skip ? grid.cell_extent() : vec3(1.0f);
+
+        visionaray::detail::grid_dda<S> dda(dims, cell_extent, tex_ray, tnear);
+
+        // Front of the current step, value relative to the isovalue. f is valid for
+        // lanes that have not skipped a cell since they took their last sample
+        S t = tnear;
+        S f(0.0);
+        simd::mask_type_t<S> valid(false);
+
+        // Steps that enclose the surface
+        simd::mask_type_t<S> found(false);
+        S ta(0.0);
+        S tb(0.0);
+        S fa(0.0);
+        S fb(0.0);
+
+        while (any(active))
+        {
+            S texit = skip ? min(dda.exit(), tfar) : tfar;
+
+            auto march = active;
+
+            if (skip)
+            {
+                march &= !detail::is_empty(grid, dda);
+            }
+
+            // Lanes in cells that cannot contain the surface continue at the next cell
+            auto skipped = active & !march;
+            t = select( skipped, texit, t );
+            valid &= !skipped;
+
+            auto resample = march & !valid;
+
+            if (any(resample))
+            {
+                f = select( resample, sample(tex_ray, t) - isovalue, f );
+                valid |= resample;
+            }
+
+            if (any(march))
+            {
+                // The last step in a cell ends at its exit point
+                S tn = min( t + delta, texit );
+                S fn = sample(tex_ray, tn) - isovalue;
+
+                auto crossing = march & (f * fn <= S(0.0));
+
+                found |= crossing;
+                ta = select( crossing, t, ta );
+                tb = select( crossing, tn, tb );
+                fa = select( crossing, f, fa );
+                fb = select( crossing, fn, fb );
+
+                active &= !crossing;
+
+                auto moved = march & !crossing;
+                t = select( moved, tn, t );
+                f = select( moved, fn, f );
+            }
+
+            if (skip)
+            {
+                dda.next(active & (t >= texit));
+            }
+
+            active &= t < tfar;
+        }
+
+        if (!any(found))
+        {
+            return result;
+        }
+
+        S thit = refine(tex_ray, isovalue, found, ta, tb, fa, fb);
+
+        // Shading
+        V coord = tex_ray.ori + tex_ray.dir * thit;
+
+        vec3 texel(
+                1.0f / params.volume.width(),
+                1.0f / params.volume.height(),
+                1.0f / params.volume.depth()
+                );
+
+        // Chain rule: texture coordinates are (pos - bbox.min) / size
+        V n = -detail::gradient(params.volume, coord, texel) / size;
+        S len = length(n);
+        n = select( len > S(0.0), n / len, V(0.0) );
+
+        S ndotv = abs( dot(n, normalize(ray.dir)) );
+
+        C color(params.color);
+        color.xyz() *= ndotv;
+
+        result.hit       = found;
+        result.color     = select( found, color, C(0.0) );
+        result.isect_pos = ray.ori + ray.dir * thit;
+        result.normal    = select( found, n, V(0.0) );
+        result.albedo    = select( found, V(params.color.xyz()), V(0.0) );
+        return result;
+    }
+
+private:
+
+    template <typename R>
+    VSNRAY_FUNC typename R::scalar_type sample(R const& tex_ray, typename R::scalar_type const& t) const
+    {
+        using S = typename R::scalar_type;
+
+        return S(tex3D(params.volume, tex_ray.ori + tex_ray.dir * t));
+    }
+
+    // Secant steps that keep the surface in [ta..tb]
+    template <typename R, typename M>
+    VSNRAY_FUNC typename R::scalar_type refine(
+            R const&                        tex_ray,
+            typename R::scalar_type const&  isovalue,
+            M const&                        mask,
+            typename R::scalar_type         ta,
+            typename R::scalar_type         tb,
+            typename R::scalar_type         fa,
+            typename R::scalar_type         fb
+            ) const
+    {
+        using S = typename R::scalar_type;
+
+        for (int i = 0; i < params.refinement_steps; ++i)
+        {
+            S tm = secant(ta, tb, fa, fb);
+            S fm = sample(tex_ray, tm) - isovalue;
+
+            auto front = mask & (fa * fm <= S(0.0));
+            auto back  = mask & !front;
+
+            tb = select( front, tm, tb );
+            fb = select( front, fm, fb );
+            ta = select( back, tm, ta );
+            fa = select( back, fm, fa );
+        }
+
+        return secant(ta, tb, fa, fb);
+    }
+
+    // Root of the line through (ta, fa) and (tb, fb)
+    template <typename S>
+    VSNRAY_FUNC static S secant(S const& ta, S const& tb, S const& fa, S const& fb)
+    {
+        S denom = fa - fb;
+        return select( denom != S(0.0), ta + (tb - ta) * fa / denom, (ta + tb) * S(0.5) );
+    }
+};
+
+} // isosurface
+} // visionaray
+
+#endif // VSNRAY_DETAIL_ISOSURFACE_INL
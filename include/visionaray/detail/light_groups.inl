@@ -0,0 +1,76 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// light_groups_ref
+//
+
+template <typename Light>
+inline light_groups_ref<Light, typename std::enable_if<is_light_group_type<Light>::value>::type>::light_groups_ref(
+        group_type const*   groups,
+        size_t              num_lights
+        )
+    : groups_(groups)
+    , num_lights_(num_lights)
+{
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// light_groups
+//
+
+template <typename Light>
+template <typename Lights>
+inline light_groups<Light>::light_groups(Lights first, Lights last)
+{
+    reset(first, last);
+}
+
+template <typename Light>
+template <typename Lights>
+inline void light_groups<Light>::reset(Lights first, Lights last)
+{
+    num_lights_ = static_cast<size_t>(last - first);
+
+    groups_.resize((num_lights_ + group_size - 1) / group_size);
+
+    for (size_t g = 0; g < groups_.size(); ++g)
+    {
+        size_t begin = g * group_size;
+        size_t count = num_lights_ - begin < size_t(group_size) ? num_lights_ - begin : size_t(group_size);
+
+        array<Light, group_size> lights;
+
+        for (size_t i = 0; i < group_size; ++i)
+        {
+            // Pad the last group
+            lights[i] = first[begin + (i < count ? i : 0)];
+        }
+
+        groups_[g] = simd::pack(lights);
+    }
+}
+
+template <typename Light>
+inline light_groups_ref<Light> light_groups<Light>::ref() const
+{
+    return light_groups_ref<Light>(groups_.data(), num_lights_);
+}
+
+template <typename Light>
+inline size_t light_groups<Light>::num_groups() const
+{
+    return groups_.size();
+}
+
+template <typename Light>
+inline size_t light_groups<Light>::num_lights() const
+{
+    return num_lights_;
+}
+
+} // visionaray
@@ -0,0 +1,128 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_LIGHT_SAMPLING_H
+#define VSNRAY_DETAIL_LIGHT_SAMPLING_H 1
+
+#include <visionaray/math/intersect.h>
+#include <visionaray/math/vector.h>
+#include <visionaray/area_light.h>
+
+#include "macros.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Sample on a light source, as seen from a reference point
+//
+
+template <typename T>
+struct light_sample
+{
+    vector<3, T> dir;       // normalized direction from the reference point to the sample
+    T            dist;      // distance from the reference point to the sample
+    T            pdf;       // w.r.t. solid angle, 1 for delta lights
+    bool         delta;     // point and spot lights cannot be hit by rays
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Sample a light source as seen from ref_point
+//
+
+// Lights with a single position (point_light, spot_light)
+template <typename L, typename T, typename Sampler>
+VSNRAY_FUNC
+inline light_sample<T> sample_light(L const& light, vector<3, T> const& ref_point, Sampler& samp)
+{
+    light_sample<T> result;
+
+    T pdf(0.0);
+    auto pos = light.sample(pdf, samp);
+
+    result.dir   = pos - ref_point;
+    result.dist  = length(result.dir);
+    result.dir  /= result.dist;
+    result.pdf   = T(1.0);
+    result.delta = true;
+
+    return result;
+}
+
+template <typename Geometry, typename T, typename Sampler>
+VSNRAY_FUNC
+inline light_sample<T> sample_light(area_light<Geometry> const& light, vector<3, T> const& ref_point, Sampler& samp)
+{
+    light_sample<T> result;
+
+    T pdf(0.0);
+    auto pos = light.sample(pdf, samp);
+
+    result.dir   = pos - ref_point;
+    result.dist  = length(result.dir);
+    result.dir  /= result.dist;
+
+    // Area lights emit on both sides
+    auto cosl    = abs( dot(light.normal(pos), result.dir) );
+
+    result.pdf   = select( cosl > T(0.0), pdf * result.dist * result.dist / cosl, T(0.0) );
+    result.delta = false;
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Solid angle pdf that sample_light() generates the direction of ray, when the
+// closest intersection of ray is at distance t
+//
+
+template <typename L, typename R>
+VSNRAY_FUNC
+inline typename R::scalar_type light_pdf(L const& light, R const& ray, typename R::scalar_type const& t)
+{
+    using T = typename R::scalar_type;
+
+    VSNRAY_UNUSED(light);
+    VSNRAY_UNUSED(ray);
+    VSNRAY_UNUSED(t);
+
+    return T(0.0);
+}
+
+template <typename Geometry, typename R>
+VSNRAY_FUNC
+inline typename R::scalar_type light_pdf(area_light<Geometry> const& light, R const& ray, typename R::scalar_type const& t)
+{
+    using T = typename R::scalar_type;
+
+    auto hr = intersect(ray, light.geometry());
+
+    // The light must be the surface that was hit
+    auto on_light = hr.hit && hr.t > T(0.0) && abs(hr.t - t) <= t * T(1E-4);
+
+    if (!any(on_light))
+    {
+        return T(0.0);
+    }
+
+    auto len  = length(ray.dir);
+    auto dist = t * len;
+    auto cosl = abs( dot(light.normal(ray.ori + ray.dir * t), ray.dir / len) );
+
+    return select(
+            on_light && cosl > T(0.0),
+            dist * dist / (cosl * T(light.area())),
+            T(0.0)
+            );
+}
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_DETAIL_LIGHT_SAMPLING_H
@@ -0,0 +1,569 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include <visionaray/math/constants.h>
+
+#include "stack.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+inline float light_power(vector<3, float> const& cl, float kl)
+{
+    return (cl.x + cl.y + cl.z) * kl / 3.0f;
+}
+
+inline float safe_acos(float x)
+{
+    return std::acos( std::max(-1.0f, std::min(1.0f, x)) );
+}
+
+// Smallest cone that contains the cones (a, cos_a) and (b, cos_b)
+inline void combine_cones(
+        vector<3, float> const& a,
+        float                   cos_a,
+        vector<3, float> const& b,
+        float                   cos_b,
+        vector<3, float>&       axis,
+        float&                  cos_theta
+        )
+{
+    float pi = constants::pi<float>();
+
+    float theta_a = safe_acos(cos_a);
+    float theta_b = safe_acos(cos_b);
+    float theta_d = safe_acos(dot(a, b));
+
+    if (std::min(theta_d + theta_b, pi) <= theta_a)
+    {
+        axis = a;
+        cos_theta = cos_a;
+        return;
+    }
+
+    if (std::min(theta_d + theta_a, pi) <= theta_b)
+    {
+        axis = b;
+        cos_theta = cos_b;
+        return;
+    }
+
+    float theta_o = (theta_a + theta_d + theta_b) / 2.0f;
+
+    auto k = cross(a, b);
+
+    if (theta_o >= pi || dot(k, k) == 0.0f)
+    {
+        // All directions
+        axis = a;
+        cos_theta = -1.0f;
+        return;
+    }
+
+    // Rotate a towards b
+    float theta_r = theta_o - theta_a;
+    k = normalize(k);
+
+    axis = normalize( a * std::cos(theta_r) + cross(k, a) * std::sin(theta_r) );
+    cos_theta = std::cos(theta_o);
+}
+
+// cos(max(0, theta_a - theta_b))
+template <typename T>
+VSNRAY_FUNC
+inline T cos_sub_clamped(T const& sin_a, T const& cos_a, T const& sin_b, T const& cos_b)
+{
+    return select( cos_a > cos_b, T(1.0), cos_a * cos_b + sin_a * sin_b );
+}
+
+// sin(max(0, theta_a - theta_b))
+template <typename T>
+VSNRAY_FUNC
+inline T sin_sub_clamped(T const& sin_a, T const& cos_a, T const& sin_b, T const& cos_b)
+{
+    return select( cos_a > cos_b, T(0.0), sin_a * cos_b - cos_a * sin_b );
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T sin_from_cos(T const& cos_theta)
+{
+    return sqrt( max(T(1.0) - cos_theta * cos_theta, T(0.0)) );
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T light_importance(
+        light_bounds const&     lb,
+        vector<3, T> const&     p,
+        vector<3, T> const*     n
+        )
+{
+    using V = vector<3, T>;
+
+    V center( lb.bbox.center() );
+    auto diag = lb.bbox.max - lb.bbox.min;
+    T radius2( dot(diag, diag) * 0.25f );
+
+    V wi = p - center;
+    T d2 = dot(wi, wi);
+    T dist = sqrt(d2);
+    wi = wi / max(dist, T(1E-20f));
+
+    // Angle between the cone axis and the direction to p
+    T cos_theta_w = dot(V(lb.axis), wi);
+    T sin_theta_w = sin_from_cos(cos_theta_w);
+
+    // Angle subtended by the bounding sphere of the lights
+    T cos_theta_b = select( d2 <= radius2, T(-1.0), sqrt(max(T(1.0) - radius2 / d2, T(0.0))) );
+    T sin_theta_b = sin_from_cos(cos_theta_b);
+
+    // Smallest angle between the emission cone and p
+    T cos_theta_o(lb.cos_theta_o);
+    T sin_theta_o(sin_from_cos(lb.cos_theta_o));
+    T cos_theta_x = cos_sub_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+    T sin_theta_x = sin_sub_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+    T cos_theta_p = cos_sub_clamped(sin_theta_x, cos_theta_x, sin_theta_b, cos_theta_b);
+
+    // Lights are not closer than the bounding sphere
+    d2 = max(d2, radius2);
+    dist = sqrt(d2);
+
+    T att = T(lb.constant_attenuation)
+          + T(lb.linear_attenuation) * dist
+          + T(lb.quadratic_attenuation) * d2;
+
+    T result = select(
+            cos_theta_p >= T(lb.cos_theta_e),
+            T(lb.power) * cos_theta_p / max(att, T(1E-6f)),
+            T(0.0)
+            );
+
+    if (n != nullptr)
+    {
+        // Angle between the surface normal and the direction to the lights
+        T cos_theta_i = -dot(wi, *n);
+        T sin_theta_i = sin_from_cos(cos_theta_i);
+        T cos_theta_pi = cos_sub_clamped(sin_theta_i, cos_theta_i, sin_theta_b, cos_theta_b);
+
+        result *= max(cos_theta_pi, T(0.0));
+    }
+
+    return result;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// light_bounds
+//
+
+template <typename T>
+inline light_bounds get_light_bounds(point_light<T> const& light)
+{
+    light_bounds result;
+
+    result.bbox                  = aabb(vec3(light.position()), vec3(light.position()));
+    result.axis                  = vec3(0.0f, 0.0f, 1.0f);
+    result.cos_theta_o           = -1.0f; // all directions
+    result.cos_theta_e           = 0.0f;
+    result.power                 = detail::light_power(vec3(light.cl()), light.kl());
+    result.constant_attenuation  = light.constant_attenuation();
+    result.linear_attenuation    = light.linear_attenuation();
+    result.quadratic_attenuation = light.quadratic_attenuation();
+
+    return result;
+}
+
+template <typename T>
+inline light_bounds get_light_bounds(spot_light<T> const& light)
+{
+    light_bounds result;
+
+    result.bbox                  = aabb(vec3(light.position()), vec3(light.position()));
+    result.axis                  = vec3(light.spot_direction());
+    result.cos_theta_o           = std::cos(static_cast<float>(light.spot_cutoff()));
+    result.cos_theta_e           = 1.0f; // no emission outside the cutoff angle
+    result.power                 = detail::light_power(vec3(light.cl()), light.kl());
+    result.constant_attenuation  = light.constant_attenuation();
+    result.linear_attenuation    = light.linear_attenuation();
+    result.quadratic_attenuation = light.quadratic_attenuation();
+
+    return result;
+}
+
+template <typename Geometry>
+inline light_bounds get_light_bounds(area_light<Geometry> const& light)
+{
+    light_bounds result;
+
+    // Area lights emit on both sides
+    result.bbox                  = get_bounds(light.geometry());
+    result.axis                  = vec3(0.0f, 0.0f, 1.0f);
+    result.cos_theta_o           = -1.0f;
+    result.cos_theta_e           = 0.0f;
+    result.power                 = detail::light_power(light.cl(), light.kl()) * light.area();
+    result.constant_attenuation  = 0.0f;
+    result.linear_attenuation    = 0.0f;
+    result.quadratic_attenuation = 1.0f;
+
+    return result;
+}
+
+inline light_bounds combine(light_bounds const& a, light_bounds const& b)
+{
+    light_bounds result;
+
+    result.bbox = combine(a.bbox, b.bbox);
+
+    detail::combine_cones(a.axis, a.cos_theta_o, b.axis, b.cos_theta_o, result.axis, result.cos_theta_o);
+
+    result.cos_theta_e           = std::min(a.cos_theta_e, b.cos_theta_e);
+    result.power                 = a.power + b.power;
+    result.constant_attenuation  = std::min(a.constant_attenuation, b.constant_attenuation);
+    result.linear_attenuation    = std::min(a.linear_attenuation, b.linear_attenuation);
+    result.quadratic_attenuation = std::min(a.quadratic_attenuation, b.quadratic_attenuation);
+
+    return result;
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T light_importance(light_bounds const& lb, vector<3, T> const& p)
+{
+    return detail::light_importance(lb, p, static_cast<vector<3, T> const*>(nullptr));
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T light_importance(light_bounds const& lb, vector<3, T> const& p, vector<3, T> const& n)
+{
+    return detail::light_importance(lb, p, &n);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// light_tree_ref
+//
+
+inline light_tree_ref::light_tree_ref(light_tree_node const* nodes, uint64_t const* trails, size_t num_nodes)
+    : nodes_(nodes)
+    , trails_(trails)
+    , num_nodes_(num_nodes)
+{
+}
+
+VSNRAY_FUNC
+inline int light_tree_ref::sample(vector<3, float> const& p, float u, float& pmf) const
+{
+    pmf = 0.0f;
+
+    if (num_nodes_ == 0)
+    {
+        return -1;
+    }
+
+    float prob = 1.0f;
+    unsigned index = 0;
+
+    while (nodes_[index].is_inner())
+    {
+        unsigned first = nodes_[index].first;
+
+        float i0 = light_importance(nodes_[first].bounds, p);
+        float i1 = light_importance(nodes_[first + 1].bounds, p);
+
+        if (!(i0 + i1 > 0.0f))
+        {
+            return -1;
+        }
+
+        float p0 = i0 / (i0 + i1);
+
+        // Reuse u for the next decision
+        if (u < p0)
+        {
+            index = first;
+            prob *= p0;
+            u = min(u / p0, 0.99999994f);
+        }
+        else
+        {
+            index = first + 1;
+            prob *= 1.0f - p0;
+            u = min((u - p0) / (1.0f - p0), 0.99999994f);
+        }
+    }
+
+    pmf = prob;
+    return static_cast<int>(nodes_[index].first);
+}
+
+VSNRAY_FUNC
+inline float light_tree_ref::pmf(vector<3, float> const& p, unsigned light_index) const
+{
+    if (num_nodes_ == 0)
+    {
+        return 0.0f;
+    }
+
+    uint64_t trail = trails_[light_index];
+    float prob = 1.0f;
+    unsigned index = 0;
+
+    while (nodes_[index].is_inner())
+    {
+        unsigned first = nodes_[index].first;
+
+        float i0 = light_importance(nodes_[first].bounds, p);
+        float i1 = light_importance(nodes_[first + 1].bounds, p);
+
+        if (!(i0 + i1 > 0.0f))
+        {
+            return 0.0f;
+        }
+
+        unsigned right = static_cast<unsigned>(trail & 1);
+
+        prob *= (right ? i1 : i0) / (i0 + i1);
+        index = first + right;
+        trail >>= 1;
+    }
+
+    return prob;
+}
+
+template <typename T, typename Func>
+VSNRAY_FUNC
+inline void light_tree_ref::cut(
+        vector<3, T> const&         p,
+        vector<3, T> const&         n,
+        simd::mask_type_t<T> const& active,
+        float                       threshold,
+        Func                        f
+        ) const
+{
+    if (num_nodes_ == 0)
+    {
+        return;
+    }
+
+    T min_importance = T(threshold) * light_importance(nodes_[0].bounds, p, n);
+
+    // The tree is balanced, its depth is at most 32
+    detail::stack<64> st;
+    st.push(0);
+
+    while (!st.empty())
+    {
+        auto const& node = nodes_[st.pop()];
+
+        T imp = light_importance(node.bounds, p, n);
+
+        auto contributes = active && imp > T(0.0);
+
+        if (!any(contributes))
+        {
+            continue;
+        }
+
+        if (node.is_leaf())
+        {
+            f(node.first, 1.0f);
+        }
+        else if (!any(contributes && imp >= min_importance))
+        {
+            f(node.representative, node.representative_scale);
+        }
+        else
+        {
+            st.push(node.first);
+            st.push(node.first + 1);
+        }
+    }
+}
+
+template <typename Func>
+VSNRAY_FUNC
+inline void light_tree_ref::for_each_light_at(vector<3, float> const& p, float eps, Func f) const
+{
+    if (num_nodes_ == 0)
+    {
+        return;
+    }
+
+    detail::stack<64> st;
+    st.push(0);
+
+    while (!st.empty())
+    {
+        auto const& node = nodes_[st.pop()];
+        auto const& box  = node.bounds.bbox;
+
+        if (p.x < box.min.x - eps || p.y < box.min.y - eps || p.z < box.min.z - eps
+         || p.x > box.max.x + eps || p.y > box.max.y + eps || p.z > box.max.z + eps)
+        {
+            continue;
+        }
+
+        if (node.is_leaf())
+        {
+            f(node.first);
+        }
+        else
+        {
+            st.push(node.first);
+            st.push(node.first + 1);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// light_tree
+//
+
+template <typename Lights>
+inline light_tree::light_tree(Lights first, Lights last)
+{
+    build(first, last);
+}
+
+template <typename Lights>
+inline void light_tree::build(Lights first, Lights last)
+{
+    aligned_vector<build_light> lights;
+
+    unsigned index = 0;
+
+    for (auto it = first; it != last; ++it)
+    {
+        lights.push_back({ get_light_bounds(*it), index++ });
+    }
+
+    nodes_.clear();
+    trails_.assign(lights.size(), 0);
+
+    if (lights.empty())
+    {
+        return;
+    }
+
+    aligned_vector<float> powers(lights.size());
+
+    for (auto const& l : lights)
+    {
+        powers[l.index] = l.bounds.power;
+    }
+
+    nodes_.reserve(2 * lights.size() - 1);
+    nodes_.emplace_back();
+
+    build_recursive(lights, powers, 0, lights.size(), 0, 0, 0);
+}
+
+inline light_tree_ref light_tree::ref() const
+{
+    return light_tree_ref(nodes_.data(), trails_.data(), nodes_.size());
+}
+
+inline size_t light_tree::num_nodes() const
+{
+    return nodes_.size();
+}
+
+inline size_t light_tree::num_lights() const
+{
+    return trails_.size();
+}
+
+inline light_tree_node const& light_tree::node(size_t index) const
+{
+    return nodes_[index];
+}
+
+inline void light_tree::build_recursive(
+        aligned_vector<build_light>&    lights,
+        aligned_vector<float> const&    powers,
+        size_t                          first,
+        size_t                          last,
+        size_t                          node_index,
+        uint64_t                        trail,
+        unsigned                        depth
+        )
+{
+    assert(depth < 64);
+
+    if (last - first == 1)
+    {
+        auto& leaf                  = nodes_[node_index];
+        leaf.bounds                 = lights[first].bounds;
+        leaf.first                  = lights[first].index;
+        leaf.num_lights             = 1;
+        leaf.representative         = lights[first].index;
+        leaf.representative_scale   = 1.0f;
+
+        trails_[lights[first].index] = trail;
+        return;
+    }
+
+    // Split at the median of the light centers, along the axis of largest extent
+    aabb centers;
+    centers.invalidate();
+
+    for (size_t i = first; i < last; ++i)
+    {
+        centers.insert(lights[i].bounds.bbox.center());
+    }
+
+    auto size = centers.max - centers.min;
+    int axis = size.x >= size.y && size.x >= size.z ? 0 : size.y >= size.z ? 1 : 2;
+
+    size_t middle = first + (last - first) / 2;
+
+    std::nth_element(
+            lights.begin() + first,
+            lights.begin() + middle,
+            lights.begin() + last,
+            [axis](build_light const& a, build_light const& b)
+            {
+                return a.bounds.bbox.center()[axis] < b.bounds.bbox.center()[axis];
+            }
+            );
+
+    size_t child = nodes_.size();
+    nodes_.emplace_back();
+    nodes_.emplace_back();
+
+    build_recursive(lights, powers, first, middle, child, trail, depth + 1);
+    build_recursive(lights, powers, middle, last, child + 1, trail | (uint64_t(1) << depth), depth + 1);
+
+    auto const& c0 = nodes_[child];
+    auto const& c1 = nodes_[child + 1];
+
+    auto representative = powers[c0.representative] >= powers[c1.representative]
+                        ? c0.representative
+                        : c1.representative;
+
+    auto& inner                 = nodes_[node_index];
+    inner.bounds                = combine(c0.bounds, c1.bounds);
+    inner.first                 = static_cast<unsigned>(child);
+    inner.num_lights            = 0;
+    inner.representative        = representative;
+    inner.representative_scale  = powers[representative] > 0.0f
+                                ? inner.bounds.power / powers[representative]
+                                : 0.0f;
+}
+
+} // visionaray
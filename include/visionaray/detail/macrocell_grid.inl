@@ -0,0 +1,307 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include <visionaray/math/limits.h>
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// macrocell_grid_ref members
+//
+
+inline macrocell_grid_ref::macrocell_grid_ref(uint8_t const* empty, vec3i const& dims, vec3 const& cell_extent)
+    : empty_(empty)
+    , dims_(dims)
+    , cell_extent_(cell_extent)
+{
+}
+
+VSNRAY_FUNC
+inline bool macrocell_grid_ref::is_empty(int x, int y, int z) const
+{
+    return empty_[(z * dims_.y + y) * dims_.x + x] != 0;
+}
+
+VSNRAY_FUNC
+inline void macrocell_grid_ref::next_interval(
+        basic_ray<float> const& ray,
+        float                   tmin,
+        float                   tmax,
+        float&                  t0,
+        float&                  t1
+        ) const
+{
+    t0 = tmax;
+    t1 = tmax;
+
+    if (tmin >= tmax)
+    {
+        return;
+    }
+
+    // Start position in cell units
+    vec3 p = (ray.ori + ray.dir * tmin) / cell_extent_;
+
+    vec3i cell(
+            clamp(static_cast<int>(floor(p.x)), 0, dims_.x - 1),
+            clamp(static_cast<int>(floor(p.y)), 0, dims_.y - 1),
+            clamp(static_cast<int>(floor(p.z)), 0, dims_.z - 1)
+            );
+
+    // 3D DDA, see: Amanatides and Woo (1987): A fast voxel traversal algorithm
+    vec3i step;
+    vec3  t_delta;
+    vec3  t_next;
+
+    for (int d = 0; d < 3; ++d)
+    {
+        float dir = ray.dir[d] / cell_extent_[d];
+
+        if (dir > 0.0f)
+        {
+            step[d]    = 1;
+            t_delta[d] = 1.0f / dir;
+            t_next[d]  = tmin + (cell[d] + 1 - p[d]) / dir;
+        }
+        else if (dir < 0.0f)
+        {
+            step[d]    = -1;
+            t_delta[d] = -1.0f / dir;
+            t_next[d]  = tmin + (cell[d] - p[d]) / dir;
+        }
+        else
+        {
+            step[d]    = 0;
+            t_delta[d] = numeric_limits<float>::max();
+            t_next[d]  = numeric_limits<float>::max();
+        }
+    }
+
+    float t = tmin;
+    bool inside = false;
+
+    for (;;)
+    {
+        bool non_empty = !is_empty(cell.x, cell.y, cell.z);
+
+        if (!inside && non_empty)
+        {
+            t0 = t;
+            inside = true;
+        }
+        else if (inside && !non_empty)
+        {
+            if (t > t0)
+            {
+                t1 = t;
+                return;
+            }
+
+            // Ignore intervals of zero length (e.g. when starting on the boundary
+            // of a non-empty cell), so that callers always make progress
+            inside = false;
+        }
+
+        int axis = t_next.x < t_next.y
+                 ? (t_next.x < t_next.z ? 0 : 2)
+                 : (t_next.y < t_next.z ? 1 : 2);
+
+        t = max(t, t_next[axis]);
+
+        if (t >= tmax)
+        {
+            break;
+        }
+
+        cell[axis] += step[axis];
+
+        if (cell[axis] < 0 || cell[axis] >= dims_[axis])
+        {
+            break;
+        }
+
+        t_next[axis] += t_delta[axis];
+    }
+
+    if (!inside)
+    {
+        t0 = tmax;
+    }
+
+    t1 = tmax;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// majorant_grid_ref members
+//
+
+inline majorant_grid_ref::majorant_grid_ref(float const* majorants, vec3i const& dims, vec3 const& cell_extent)
+    : majorants_(majorants)
+    , dims_(dims)
+    , cell_extent_(cell_extent)
+{
+}
+
+VSNRAY_FUNC
+inline float majorant_grid_ref::majorant(int x, int y, int z) const
+{
+    return majorants_[(z * dims_.y + y) * dims_.x + x];
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// macrocell_grid members
+//
+
+template <typename Volume>
+inline void macrocell_grid::build(Volume const& volume, int cell_size)
+{
+    assert(cell_size > 0);
+
+    int w = static_cast<int>(volume.width());
+    int h = static_cast<int>(volume.height());
+    int d = static_cast<int>(volume.depth());
+
+    dims_ = vec3i(
+            (w + cell_size - 1) / cell_size,
+            (h + cell_size - 1) / cell_size,
+            (d + cell_size - 1) / cell_size
+            );
+
+    cell_extent_ = vec3(
+            cell_size / static_cast<float>(w),
+            cell_size / static_cast<float>(h),
+            cell_size / static_cast<float>(d)
+            );
+
+    value_ranges_.resize(dims_.x * dims_.y * dims_.z);
+    majorants_.resize(dims_.x * dims_.y * dims_.z);
+    empty_.assign(dims_.x * dims_.y * dims_.z, 0);
+
+    auto data = volume.data();
+
+    for (int z = 0; z < dims_.z; ++z)
+    {
+        for (int y = 0; y < dims_.y; ++y)
+        {
+            for (int x = 0; x < dims_.x; ++x)
+            {
+                // Linear filtering reads one voxel beyond the cell
+                int x0 = std::max(x * cell_size - 1, 0);
+                int y0 = std::max(y * cell_size - 1, 0);
+                int z0 = std::max(z * cell_size - 1, 0);
+                int x1 = std::min((x + 1) * cell_size, w - 1);
+                int y1 = std::min((y + 1) * cell_size, h - 1);
+                int z1 = std::min((z + 1) * cell_size, d - 1);
+
+                vec2 range(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+
+                for (int vz = z0; vz <= z1; ++vz)
+                {
+                    for (int vy = y0; vy <= y1; ++vy)
+                    {
+                        for (int vx = x0; vx <= x1; ++vx)
+                        {
+                            float value = static_cast<float>(data[(static_cast<size_t>(vz) * h + vy) * w + vx]);
+                            range.x = std::min(range.x, value);
+                            range.y = std::max(range.y, value);
+                        }
+                    }
+                }
+
+                value_ranges_[linear_index(x, y, z)] = range;
+                majorants_[linear_index(x, y, z)] = range.y;
+            }
+        }
+    }
+}
+
+template <typename TransFunc>
+inline void macrocell_grid::classify(TransFunc const& transfunc)
+{
+    int n = static_cast<int>(transfunc.width());
+    auto data = transfunc.data();
+
+    for (size_t i = 0; i < value_ranges_.size(); ++i)
+    {
+        vec2 range = value_ranges_[i];
+
+        // Texels that tex1D() reads for coordinates in range (nearest or linear
+        // filtering, coordinates outside [0..1] are clamped)
+        int lo = std::max(std::min(static_cast<int>(std::floor(range.x * n - 0.5f)), n - 1), 0);
+        int hi = std::max(std::min(static_cast<int>(std::floor(range.y * n - 0.5f)) + 1, n - 1), 0);
+
+        float opacity = 0.0f;
+
+        for (int j = lo; j <= hi; ++j)
+        {
+            opacity = std::max(opacity, static_cast<float>(data[j].w));
+        }
+
+        empty_[i] = opacity <= 0.0f ? 1 : 0;
+    }
+}
+
+inline void macrocell_grid::classify_isosurface(float isovalue)
+{
+    for (size_t i = 0; i < value_ranges_.size(); ++i)
+    {
+        vec2 range = value_ranges_[i];
+
+        empty_[i] = isovalue < range.x || isovalue > range.y ? 1 : 0;
+    }
+}
+
+inline macrocell_grid_ref macrocell_grid::ref() const
+{
+    if (empty_.empty())
+    {
+        return macrocell_grid_ref();
+    }
+
+    return macrocell_grid_ref(empty_.data(), dims_, cell_extent_);
+}
+
+inline majorant_grid_ref macrocell_grid::majorants() const
+{
+    if (majorants_.empty())
+    {
+        return majorant_grid_ref();
+    }
+
+    return majorant_grid_ref(majorants_.data(), dims_, cell_extent_);
+}
+
+inline vec3i macrocell_grid::dims() const
+{
+    return dims_;
+}
+
+inline vec2 macrocell_grid::value_range(int x, int y, int z) const
+{
+    return value_ranges_[linear_index(x, y, z)];
+}
+
+inline bool macrocell_grid::is_empty(int x, int y, int z) const
+{
+    return empty_[linear_index(x, y, z)] != 0;
+}
+
+inline size_t macrocell_grid::num_empty_cells() const
+{
+    return std::count(empty_.begin(), empty_.end(), static_cast<uint8_t>(1));
+}
+
+inline size_t macrocell_grid::linear_index(int x, int y, int z) const
+{
+    return (static_cast<size_t>(z) * dims_.y + y) * dims_.x + x;
+}
+
+} // visionaray
@@ -15,6 +15,13 @@ inline spectrum<T> emissive<T>::ambient() const
     return spectrum<T>();
 }
 
+template <typename T>
+VSNRAY_FUNC
+inline spectrum<T> emissive<T>::albedo() const
+{
+    return spectrum<T>(0.0);
+}
+
 template <typename T>
 template <typename SR>
 VSNRAY_FUNC
@@ -39,6 +46,39 @@ inline spectrum<U> emissive<T>::sample(
     return shade(shade_rec);
 }
 
+template <typename T>
+template <typename SR, size_t N>
+VSNRAY_FUNC
+inline vector<N, typename SR::scalar_type> emissive<T>::shade(spectral_shade_record<SR, N> const& sr) const
+{
+    return tex_color_samples(sr) * from_spectrum(ce_, sr.wavelengths) * ls_;
+}
+
+template <typename T>
+template <typename SR, size_t N, typename U, typename Sampler>
+VSNRAY_FUNC
+inline vector<N, U> emissive<T>::sample(
+        spectral_shade_record<SR, N> const& sr,
+        vector<3, U>&                       refl_dir,
+        U&                                  pdf,
+        Sampler&                            sampler
+        ) const
+{
+    VSNRAY_UNUSED(refl_dir);
+    VSNRAY_UNUSED(sampler);
+    pdf = U(1.0);
+    return shade(sr);
+}
+
+template <typename T>
+template <typename SR>
+VSNRAY_FUNC
+inline typename SR::scalar_type emissive<T>::pdf(SR const& sr) const
+{
+    VSNRAY_UNUSED(sr);
+    return typename SR::scalar_type(0.0);
+}
+
 // --- deprecated begin -----------------------------------
 
 template <typename T>
@@ -17,6 +17,13 @@ inline spectrum<T> matte<T>::ambient() const
     return ca_ * ka_;
 }
 
+template <typename T>
+VSNRAY_FUNC
+inline spectrum<T> matte<T>::albedo() const
+{
+    return diffuse_brdf_.cd * diffuse_brdf_.kd;
+}
+
 template <typename T>
 template <typename SR>
 VSNRAY_FUNC
@@ -66,6 +73,47 @@ inline spectrum<U> matte<T>::sample(
     return spectrum<U>(from_rgb(sr.tex_color)) * sample_impl(sr, refl_dir, pdf, sampler);
 }
 
+template <typename T>
+template <typename SR, size_t N>
+VSNRAY_FUNC
+inline vector<N, typename SR::scalar_type> matte<T>::shade(spectral_shade_record<SR, N> const& sr) const
+{
+    using U = typename SR::scalar_type;
+
+    auto l = sr.light;
+    auto wi = sr.light_dir;
+    auto wo = sr.view_dir;
+    auto n = sr.normal;
+    auto ndotl = max( U(0.0), dot(n, wi) );
+
+    return tex_color_samples(sr)
+         * diffuse_brdf_.f(n, wo, wi, sr.wavelengths)
+         * from_rgb(l.intensity(sr.isect_pos), sr.wavelengths)
+         * (constants::pi<U>() * ndotl);
+}
+
+template <typename T>
+template <typename SR, size_t N, typename U, typename Sampler>
+VSNRAY_FUNC
+inline vector<N, U> matte<T>::sample(
+        spectral_shade_record<SR, N> const& sr,
+        vector<3, U>&                       refl_dir,
+        U&                                  pdf,
+        Sampler&                            sampler
+        ) const
+{
+    return tex_color_samples(sr)
+         * diffuse_brdf_.sample_f(sr.normal, sr.view_dir, refl_dir, pdf, sampler, sr.wavelengths);
+}
+
+template <typename T>
+template <typename SR>
+VSNRAY_FUNC
+inline typename SR::scalar_type matte<T>::pdf(SR const& sr) const
+{
+    return diffuse_brdf_.pdf(sr.normal, sr.view_dir, sr.light_dir);
+}
+
 // --- deprecated begin -----------------------------------
 
 template <typename T>
@@ -15,6 +15,13 @@ inline spectrum<T> mirror<T>::ambient() const
     return spectrum<T>(0.0); // TODO: no support for  ambient
 }
 
+template <typename T>
+VSNRAY_FUNC
+inline spectrum<T> mirror<T>::albedo() const
+{
+    return specular_brdf_.cr * specular_brdf_.kr;
+}
+
 template <typename T>
 template <typename SR>
 VSNRAY_FUNC
@@ -36,6 +43,35 @@ inline spectrum<U> mirror<T>::sample(
     return specular_brdf_.sample_f(sr.normal, sr.view_dir, refl_dir, pdf, sampler);
 }
 
+template <typename T>
+template <typename SR, size_t N>
+VSNRAY_FUNC
+inline vector<N, typename SR::scalar_type> mirror<T>::shade(spectral_shade_record<SR, N> const& sr) const
+{
+    return specular_brdf_.f(sr.normal, sr.view_dir, sr.light_dir, sr.wavelengths);
+}
+
+template <typename T>
+template <typename SR, size_t N, typename U, typename Sampler>
+VSNRAY_FUNC
+inline vector<N, U> mirror<T>::sample(
+        spectral_shade_record<SR, N> const& sr,
+        vector<3, U>&                       refl_dir,
+        U&                                  pdf,
+        Sampler&                            sampler
+        ) const
+{
+    return specular_brdf_.sample_f(sr.normal, sr.view_dir, refl_dir, pdf, sampler, sr.wavelengths);
+}
+
+template <typename T>
+template <typename SR>
+VSNRAY_FUNC
+inline typename SR::scalar_type mirror<T>::pdf(SR const& sr) const
+{
+    return specular_brdf_.pdf(sr.normal, sr.view_dir, sr.light_dir);
+}
+
 //--- deprecated begin ------------------------------------
 
 template <typename T>
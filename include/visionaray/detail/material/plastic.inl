@@ -17,6 +17,13 @@ inline spectrum<T> plastic<T>::ambient() const
     return ca_ * ka_;
 }
 
+template <typename T>
+VSNRAY_FUNC
+inline spectrum<T> plastic<T>::albedo() const
+{
+    return diffuse_brdf_.cd * diffuse_brdf_.kd;
+}
+
 template <typename T>
 template <typename SR>
 VSNRAY_FUNC
@@ -67,42 +74,69 @@ inline spectrum<U> plastic<T>::sample(
         Sampler&        sampler
         ) const
 {
-    U pdf1(0.0);
-    U pdf2(0.0);
+    sample_dir(shade_rec, refl_dir, pdf, sampler);
 
-    vector<3, U> refl1(0.0);
-    vector<3, U> refl2(0.0);
+    auto n         = shade_rec.normal;
+    auto wo        = shade_rec.view_dir;
+    auto wi        = refl_dir;
 
-    spectrum<U>  diff(0.0);
-    spectrum<U>  spec(0.0);
+    return detail::tex_color_from_shade_record<U>(shade_rec) * diffuse_brdf_.f(n, wo, wi)
+         + specular_brdf_.f(n, wo, wi);
+}
 
-    auto prob_diff = mean_value( diffuse_brdf_.cd ) * diffuse_brdf_.kd;
-    auto prob_spec = mean_value( specular_brdf_.cs ) * specular_brdf_.ks;
+template <typename T>
+template <typename SR, size_t N>
+VSNRAY_FUNC
+inline vector<N, typename SR::scalar_type> plastic<T>::shade(spectral_shade_record<SR, N> const& sr) const
+{
+    using U = typename SR::scalar_type;
 
-    auto all_zero  = prob_diff == U(0.0) && prob_spec == U(0.0);
+    auto l = sr.light;
+    auto wi = sr.light_dir;
+    auto wo = sr.view_dir;
+    auto n = sr.normal;
+    auto ndotl = max( U(0.0), dot(n, wi) );
 
-    prob_diff      = select( all_zero, U(0.5), prob_diff );
-    prob_spec      = select( all_zero, U(0.5), prob_spec );
+    return ( tex_color_samples(sr) * diffuse_brdf_.f(n, wo, wi, sr.wavelengths)
+           + specular_brdf_.f(n, wo, wi, sr.wavelengths) )
+         * from_rgb(l.intensity(sr.isect_pos), sr.wavelengths)
+         * (constants::pi<U>() * ndotl);
+}
 
-    prob_diff      = prob_diff / (prob_diff + prob_spec);
+template <typename T>
+template <typename SR, size_t N, typename U, typename Sampler>
+VSNRAY_FUNC
+inline vector<N, U> plastic<T>::sample(
+        spectral_shade_record<SR, N> const& sr,
+        vector<3, U>&                       refl_dir,
+        U&                                  pdf,
+        Sampler&                            sampler
+        ) const
+{
+    sample_dir(sr, refl_dir, pdf, sampler);
 
+    auto n         = sr.normal;
+    auto wo        = sr.view_dir;
+    auto wi        = refl_dir;
 
-    auto u         = sampler.next();
+    return tex_color_samples(sr) * diffuse_brdf_.f(n, wo, wi, sr.wavelengths)
+         + specular_brdf_.f(n, wo, wi, sr.wavelengths);
+}
 
-    if (any(u < U(prob_diff)))
-    {
-        diff       = detail::tex_color_from_shade_record<U>(shade_rec) * diffuse_brdf_.sample_f(shade_rec.normal, shade_rec.view_dir, refl1, pdf1, sampler);
-    }
+template <typename T>
+template <typename SR>
+VSNRAY_FUNC
+inline typename SR::scalar_type plastic<T>::pdf(SR const& sr) const
+{
+    using U = typename SR::scalar_type;
 
-    if (any(u >= U(prob_diff)))
-    {
-        spec       = specular_brdf_.sample_f(shade_rec.normal, shade_rec.view_dir, refl2, pdf2, sampler);
-    }
+    auto n         = sr.normal;
+    auto wo        = sr.view_dir;
+    auto wi        = sr.light_dir;
 
-    pdf            = select( u < U(prob_diff), pdf1,  pdf2  );
-    refl_dir       = select( u < U(prob_diff), refl1, refl2 );
+    auto prob_diff = U(prob_diffuse());
 
-    return           select( u < U(prob_diff), diff,  spec  );
+    return prob_diff * diffuse_brdf_.pdf(n, wo, wi) + (U(1.0) - prob_diff) * specular_brdf_.pdf(n, wo, wi);
 }
 
 //--- deprecated begin ------------------------------------
@@ -310,6 +344,66 @@ inline T const& plastic<T>::specular_exp() const
 // Private functions
 //
 
+template <typename T>
+VSNRAY_FUNC
+inline T plastic<T>::prob_diffuse() const
+{
+    auto prob_diff = mean_value( diffuse_brdf_.cd ) * diffuse_brdf_.kd;
+    auto prob_spec = mean_value( specular_brdf_.cs ) * specular_brdf_.ks;
+
+    auto all_zero  = prob_diff == T(0.0) && prob_spec == T(0.0);
+
+    prob_diff      = select( all_zero, T(0.5), prob_diff );
+    prob_spec      = select( all_zero, T(0.5), prob_spec );
+
+    return prob_diff / (prob_diff + prob_spec);
+}
+
+template <typename T>
+template <typename SR, typename U, typename Sampler>
+VSNRAY_FUNC
+inline void plastic<T>::sample_dir(
+        SR const&       shade_rec,
+        vector<3, U>&   refl_dir,
+        U&              pdf,
+        Sampler&        sampler
+        ) const
+{
+    U pdf1(0.0);
+    U pdf2(0.0);
+
+    vector<3, U> refl1(0.0);
+    vector<3, U> refl2(0.0);
+
+    auto n         = shade_rec.normal;
+    auto wo        = shade_rec.view_dir;
+
+    auto prob_diff = U(prob_diffuse());
+
+    auto u         = sampler.next();
+
+    if (any(u < prob_diff))
+    {
+        diffuse_brdf_.sample_wi(n, wo, refl1, pdf1, sampler);
+    }
+
+    if (any(u >= prob_diff))
+    {
+        specular_brdf_.sample_wi(n, wo, refl2, pdf2, sampler);
+    }
+
+    refl_dir       = select( u < prob_diff, refl1, refl2 );
+
+    // Both BRDFs may generate refl_dir
+    auto wi        = refl_dir;
+
+    pdf            = prob_diff * diffuse_brdf_.pdf(n, wo, wi) + (U(1.0) - prob_diff) * specular_brdf_.pdf(n, wo, wi);
+
+    // The specular lobe may generate directions below the surface, these are
+    // discarded (pdf = 0). The pdf of the lobe is not exactly 0 with SIMD pow()
+    pdf            = select( dot(n, wi) > U(0.0), pdf, U(0.0) );
+}
+
 template <typename T>
 template <typename SR, typename V>
 VSNRAY_FUNC
@@ -0,0 +1,610 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include <visionaray/math/aabb.h>
+#include <visionaray/math/intersect.h>
+
+#include "grid_dda.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+inline vec3i num_pages(vec3i const& size, int page_bits)
+{
+    int mask = (1 << page_bits) - 1;
+
+    return vec3i(
+            (size.x + mask) >> page_bits,
+            (size.y + mask) >> page_bits,
+            (size.z + mask) >> page_bits
+            );
+}
+
+// Pages start at a multiple of 4K after the header and the coarse level
+inline std::streamoff paged_volume_pages_offset(size_t num_pages)
+{
+    size_t offset = sizeof(paged_volume_header) + num_pages * sizeof(float);
+
+    return static_cast<std::streamoff>((offset + 4095) / 4096 * 4096);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// paged_texels
+//
+
+template <typename T>
+inline float paged_texels<T>::fetch(int x, int y, int z) const
+{
+    int page = ((z >> page_bits) * num_pages.y + (y >> page_bits)) * num_pages.x + (x >> page_bits);
+
+    // Record the access, don't write to the shared cache line if it is up to date
+    unsigned f = *frame;
+
+    if (last_use[page].load(std::memory_order_relaxed) != f)
+    {
+        last_use[page].store(f, std::memory_order_relaxed);
+    }
+
+    int slot = page_table[page];
+
+    if (slot < 0)
+    {
+        return coarse_value(x, y, z);
+    }
+
+    int mask = (1 << page_bits) - 1;
+
+    size_t index = (static_cast<size_t>(slot) << (3 * page_bits))
+                 + ((((z & mask) << page_bits) + (y & mask)) << page_bits) + (x & mask);
+
+    return static_cast<float>(pages[index]);
+}
+
+// Trilinear interpolation of the page averages, which are located at the page centers
+template <typename T>
+inline float paged_texels<T>::coarse_value(int x, int y, int z) const
+{
+    float scale = 1.0f / (1 << page_bits);
+
+    vec3 c(
+        (x + 0.5f) * scale - 0.5f,
+        (y + 0.5f) * scale - 0.5f,
+        (z + 0.5f) * scale - 0.5f
+        );
+
+    c = clamp(c, vec3(0.0f), vec3(num_pages - vec3i(1)));
+
+    vec3i lo(static_cast<int>(c.x), static_cast<int>(c.y), static_cast<int>(c.z));
+    vec3i hi = min(lo + vec3i(1), num_pages - vec3i(1));
+    vec3 w = c - vec3(lo);
+
+    auto at = [&](int i, int j, int k)
+    {
+        return coarse[(static_cast<size_t>(k) * num_pages.y + j) * num_pages.x + i];
+    };
+
+    float v0 = lerp(
+            lerp(at(lo.x, lo.y, lo.z), at(hi.x, lo.y, lo.z), w.x),
+            lerp(at(lo.x, hi.y, lo.z), at(hi.x, hi.y, lo.z), w.x),
+            w.y
+            );
+
+    float v1 = lerp(
+            lerp(at(lo.x, lo.y, hi.z), at(hi.x, lo.y, hi.z), w.x),
+            lerp(at(lo.x, hi.y, hi.z), at(hi.x, hi.y, hi.z), w.x),
+            w.y
+            );
+
+    return lerp(v0, v1, w.z);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Access functions for the filters, found by ADL
+//
+
+template <typename T, typename RT>
+inline RT point(
+        paged_texels<T> const&  tex,
+        int                     x,
+        int                     y,
+        int                     z,
+        vector<3, int> const&   /* texsize */,
+        RT                      /* */
+        )
+{
+    return RT(tex.fetch(x, y, z));
+}
+
+// SIMD: pages are looked up per lane
+template <
+    typename T,
+    typename I,
+    typename RT,
+    typename = typename std::enable_if<simd::is_simd_vector<I>::value>::type
+    >
+inline RT point(
+        paged_texels<T> const&  tex,
+        I const&                x,
+        I const&                y,
+        I const&                z,
+        vector<3, I> const&     /* texsize */,
+        RT                      /* */
+        )
+{
+    simd::aligned_array_t<I> xs;
+    simd::aligned_array_t<I> ys;
+    simd::aligned_array_t<I> zs;
+
+    store(xs, x);
+    store(ys, y);
+    store(zs, z);
+
+    simd::aligned_array_t<RT> result;
+
+    for (size_t i = 0; i < simd::num_elements<I>::value; ++i)
+    {
+        result[i] = tex.fetch(xs[i], ys[i], zs[i]);
+    }
+
+    return RT(result);
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// paged_volume
+//
+
+template <typename T>
+inline paged_volume<T>::paged_volume(std::string const& filename, size_t memory_budget)
+    : file_(filename, std::ios::binary)
+{
+    if (!file_)
+    {
+        throw std::runtime_error("paged_volume: cannot open " + filename);
+    }
+
+    detail::paged_volume_header header;
+    file_.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file_ || !std::equal(header.magic, header.magic + 8, detail::paged_volume_magic))
+    {
+        throw std::runtime_error("paged_volume: " + filename + " is not a paged volume file");
+    }
+
+    if (header.texel_size != sizeof(T))
+    {
+        throw std::runtime_error("paged_volume: voxel size does not match " + filename);
+    }
+
+    size_ = vec3i(
+            static_cast<int>(header.size[0]),
+            static_cast<int>(header.size[1]),
+            static_cast<int>(header.size[2])
+            );
+
+    page_bits_ = static_cast<int>(header.page_bits);
+    num_pages_ = detail::num_pages(size_, page_bits_);
+    page_texels_ = size_t(1) << (3 * page_bits_);
+
+    size_t num_pages = static_cast<size_t>(num_pages_.x) * num_pages_.y * num_pages_.z;
+
+    coarse_.resize(num_pages);
+    file_.read(reinterpret_cast<char*>(coarse_.data()), num_pages * sizeof(float));
+
+    if (!file_)
+    {
+        throw std::runtime_error("paged_volume: cannot read coarse level of " + filename);
+    }
+
+    pages_offset_ = detail::paged_volume_pages_offset(num_pages);
+
+    num_slots_ = std::min(memory_budget / (page_texels_ * sizeof(T)), num_pages);
+    slots_.resize(num_slots_ * page_texels_);
+    slot_page_.assign(num_slots_, -1);
+
+    page_table_.assign(num_pages, -1);
+
+    last_use_.reset(new std::atomic<unsigned>[num_pages]);
+
+    for (size_t i = 0; i < num_pages; ++i)
+    {
+        last_use_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+inline paged_volume_ref<T> paged_volume<T>::ref() const
+{
+    detail::paged_texels<T> texels = {
+            slots_.data(),
+            page_table_.data(),
+            coarse_.data(),
+            last_use_.get(),
+            &frame_,
+            num_pages_,
+            page_bits_
+            };
+
+    paged_volume_ref<T> result(texels, size_);
+    result.set_filter_mode(Linear);
+    result.set_address_mode(Clamp);
+    return result;
+}
+
+template <typename T>
+inline vec3i paged_volume<T>::size() const
+{
+    return size_;
+}
+
+template <typename T>
+inline int paged_volume<T>::page_size() const
+{
+    return 1 << page_bits_;
+}
+
+template <typename T>
+inline vec3i paged_volume<T>::num_pages() const
+{
+    return num_pages_;
+}
+
+template <typename T>
+inline size_t paged_volume<T>::max_resident_pages() const
+{
+    return num_slots_;
+}
+
+template <typename T>
+inline size_t paged_volume<T>::resident_pages() const
+{
+    return resident_pages_;
+}
+
+template <typename T>
+inline bool paged_volume<T>::is_resident(int px, int py, int pz) const
+{
+    return page_table_[page_index(px, py, pz)] >= 0;
+}
+
+template <typename T>
+inline void paged_volume<T>::prefetch(basic_ray<float> const& ray, float tmax)
+{
+    auto hr = intersect(ray, aabb(vec3(0.0f), vec3(1.0f)));
+
+    float tmin = max(hr.tnear, 0.0f);
+    tmax = min(hr.tfar, tmax);
+
+    if (!hr.hit || tmin >= tmax)
+    {
+        return;
+    }
+
+    vec3 cell_extent = vec3(static_cast<float>(page_size())) / vec3(size_);
+
+    detail::grid_dda<float> dda(num_pages_, cell_extent, ray, tmin);
+
+    for (;;)
+    {
+        prefetch_.push_back(static_cast<int>(dda.cell_index()));
+
+        if (dda.exit() >= tmax)
+        {
+            break;
+        }
+
+        dda.next(true);
+    }
+}
+
+template <typename T>
+inline size_t paged_volume<T>::update(size_t max_loads)
+{
+    unsigned f = frame_;
+
+    auto last_use = [&](int page)
+    {
+        return last_use_[page].load(std::memory_order_relaxed);
+    };
+
+    // Pages that were accessed in this frame come first
+    std::vector<int> requests;
+
+    for (size_t p = 0; p < page_table_.size(); ++p)
+    {
+        if (page_table_[p] < 0 && last_use(static_cast<int>(p)) == f)
+        {
+            requests.push_back(static_cast<int>(p));
+        }
+    }
+
+    // Then prefetched pages, in the order of the requests. Marking them as
+    // accessed skips duplicates and makes them the most recently used pages
+    for (int p : prefetch_)
+    {
+        if (page_table_[p] < 0 && last_use(p) != f)
+        {
+            last_use_[p].store(f, std::memory_order_relaxed);
+            requests.push_back(p);
+        }
+    }
+
+    prefetch_.clear();
+
+    // Free slots, then slots with pages that were not accessed in this frame, least recently used first
+    std::vector<int> victims;
+
+    for (size_t s = 0; s < num_slots_; ++s)
+    {
+        if (slot_page_[s] < 0)
+        {
+            victims.push_back(static_cast<int>(s));
+        }
+    }
+
+    auto num_free = victims.size();
+
+    for (size_t s = 0; s < num_slots_; ++s)
+    {
+        if (slot_page_[s] >= 0 && last_use(slot_page_[s]) != f)
+        {
+            victims.push_back(static_cast<int>(s));
+        }
+    }
+
+    std::stable_sort(
+            victims.begin() + num_free,
+            victims.end(),
+            [&](int a, int b) { return last_use(slot_page_[a]) < last_use(slot_page_[b]); }
+            );
+
+    size_t n = std::min(requests.size(), std::min(max_loads, victims.size()));
+    requests.resize(n);
+
+    // Read in file order
+    std::sort(requests.begin(), requests.end());
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        int slot = victims[i];
+
+        if (slot_page_[slot] >= 0)
+        {
+            page_table_[slot_page_[slot]] = -1;
+            slot_page_[slot] = -1;
+            --resident_pages_;
+        }
+
+        load(requests[i], slot);
+
+        page_table_[requests[i]] = slot;
+        slot_page_[slot] = requests[i];
+        ++resident_pages_;
+    }
+
+    pages_loaded_ += n;
+
+    ++frame_;
+
+    return n;
+}
+
+template <typename T>
+inline size_t paged_volume<T>::pages_loaded() const
+{
+    return pages_loaded_;
+}
+
+template <typename T>
+inline int paged_volume<T>::page_index(int px, int py, int pz) const
+{
+    return (pz * num_pages_.y + py) * num_pages_.x + px;
+}
+
+template <typename T>
+inline void paged_volume<T>::load(int page, int slot)
+{
+    std::streamoff page_bytes = static_cast<std::streamoff>(page_texels_ * sizeof(T));
+
+    file_.seekg(pages_offset_ + page * page_bytes);
+    file_.read(reinterpret_cast<char*>(slots_.data() + slot * page_texels_), page_bytes);
+
+    if (!file_)
+    {
+        throw std::runtime_error("paged_volume: cannot read page");
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// paged_volume_writer
+//
+
+template <typename T>
+inline paged_volume_writer<T>::paged_volume_writer(
+        std::string const&  filename,
+        vec3i const&        size,
+        int                 page_bits
+        )
+    : file_(filename, std::ios::binary | std::ios::trunc)
+    , size_(size)
+    , num_pages_(detail::num_pages(size, page_bits))
+    , page_bits_(page_bits)
+    , slab_(static_cast<size_t>(size.x) * size.y << page_bits)
+    , slices_(0)
+    , slab_slices_(0)
+    , coarse_(static_cast<size_t>(num_pages_.x) * num_pages_.y * num_pages_.z)
+{
+    if (!file_)
+    {
+        throw std::runtime_error("paged_volume_writer: cannot create " + filename);
+    }
+
+    detail::paged_volume_header header;
+    std::copy(detail::paged_volume_magic, detail::paged_volume_magic + 8, header.magic);
+    header.size[0]    = static_cast<std::uint32_t>(size.x);
+    header.size[1]    = static_cast<std::uint32_t>(size.y);
+    header.size[2]    = static_cast<std::uint32_t>(size.z);
+    header.page_bits  = static_cast<std::uint32_t>(page_bits);
+    header.texel_size = static_cast<std::uint32_t>(sizeof(T));
+    header.reserved   = 0;
+
+    file_.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+    // The coarse level is written in close()
+    pages_offset_ = detail::paged_volume_pages_offset(coarse_.size());
+    file_.seekp(pages_offset_);
+}
+
+template <typename T>
+inline paged_volume_writer<T>::~paged_volume_writer()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+    }
+}
+
+template <typename T>
+inline void paged_volume_writer<T>::add_slice(T const* slice)
+{
+    if (slices_ >= size_.z)
+    {
+        throw std::runtime_error("paged_volume_writer: too many slices");
+    }
+
+    size_t slice_texels = static_cast<size_t>(size_.x) * size_.y;
+
+    std::copy(slice, slice + slice_texels, slab_.begin() + slab_slices_ * slice_texels);
+
+    ++slab_slices_;
+    ++slices_;
+
+    if (slab_slices_ == (1 << page_bits_) || slices_ == size_.z)
+    {
+        write_slab();
+    }
+}
+
+template <typename T>
+inline void paged_volume_writer<T>::close()
+{
+    if (!file_.is_open())
+    {
+        return;
+    }
+
+    if (slices_ != size_.z)
+    {
+        throw std::runtime_error("paged_volume_writer: missing slices");
+    }
+
+    file_.seekp(sizeof(detail::paged_volume_header));
+    file_.write(reinterpret_cast<char const*>(coarse_.data()), coarse_.size() * sizeof(float));
+
+    bool good = static_cast<bool>(file_);
+
+    file_.close();
+
+    if (!good || !file_)
+    {
+        throw std::runtime_error("paged_volume_writer: cannot write file");
+    }
+}
+
+template <typename T>
+inline void paged_volume_writer<T>::write_slab()
+{
+    int page_size = 1 << page_bits_;
+    int pz = (slices_ - 1) >> page_bits_;
+
+    aligned_vector<T> page(size_t(1) << (3 * page_bits_));
+
+    for (int py = 0; py < num_pages_.y; ++py)
+    {
+        for (int px = 0; px < num_pages_.x; ++px)
+        {
+            std::fill(page.begin(), page.end(), T());
+
+            double sum = 0.0;
+            size_t count = 0;
+
+            for (int k = 0; k < slab_slices_; ++k)
+            {
+                for (int j = 0; j < page_size && py * page_size + j < size_.y; ++j)
+                {
+                    for (int i = 0; i < page_size && px * page_size + i < size_.x; ++i)
+                    {
+                        int x = px * page_size + i;
+                        int y = py * page_size + j;
+
+                        T value = slab_[(static_cast<size_t>(k) * size_.y + y) * size_.x + x];
+
+                        page[(((static_cast<size_t>(k) << page_bits_) + j) << page_bits_) + i] = value;
+
+                        sum += static_cast<float>(value);
+                        ++count;
+                    }
+                }
+            }
+
+            coarse_[(static_cast<size_t>(pz) * num_pages_.y + py) * num_pages_.x + px]
+                    = static_cast<float>(sum / count);
+
+            file_.write(reinterpret_cast<char const*>(page.data()), page.size() * sizeof(T));
+        }
+    }
+
+    if (!file_)
+    {
+        throw std::runtime_error("paged_volume_writer: cannot write file");
+    }
+
+    slab_slices_ = 0;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// tex3D
+//
+
+template <typename T, typename FloatT>
+inline FloatT tex3D(paged_volume_ref<T> const& tex, vector<3, FloatT> const& coord)
+{
+    using I = simd::int_type_t<FloatT>;
+
+    vector<3, I> texsize(
+            static_cast<int>(tex.width()),
+            static_cast<int>(tex.height()),
+            static_cast<int>(tex.depth())
+            );
+
+    return detail::choose_filter(
+            FloatT{},
+            FloatT{},
+            tex.texels(),
+            coord,
+            texsize,
+            tex.get_filter_mode(),
+            tex.get_address_mode()
+            );
+}
+
+} // visionaray
@@ -0,0 +1,231 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <visionaray/math/constants.h>
+#include <visionaray/math/limits.h>
+#include <visionaray/texture/texture.h>
+
+#include "grid_dda.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Ray in texture coordinates of the density volume, t is preserved
+//
+
+template <typename Volume, typename S>
+VSNRAY_FUNC
+inline basic_ray<S> texture_space_ray(participating_medium<Volume> const& medium, basic_ray<S> const& ray)
+{
+    vector<3, S> bmin(medium.bbox.min);
+    vector<3, S> size(medium.bbox.max - medium.bbox.min);
+
+    basic_ray<S> result;
+    result.ori = (ray.ori - bmin) / size;
+    result.dir = ray.dir / size;
+    return result;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// participating_medium
+//
+
+template <typename Volume>
+inline participating_medium<Volume> make_participating_medium(
+        Volume const&               density,
+        aabb const&                 bbox,
+        majorant_grid_ref const&    majorants,
+        float                       sigma_t,
+        vec3 const&                 albedo,
+        float                       g
+        )
+{
+    return { density, bbox, majorants, sigma_t, albedo, g };
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Henyey-Greenstein phase function
+//
+
+template <typename T>
+VSNRAY_FUNC
+inline T henyey_greenstein(T const& cos_theta, float g)
+{
+    T denom = T(1.0f + g * g) - T(2.0f * g) * cos_theta;
+    return T((1.0f - g * g) / (4.0f * constants::pi<float>())) / (denom * sqrt(denom));
+}
+
+template <typename T, typename Sampler>
+VSNRAY_FUNC
+inline vector<3, T> sample_henyey_greenstein(vector<3, T> const& dir, float g, Sampler& samp)
+{
+    T u1 = samp.next();
+    T u2 = samp.next();
+
+    T cos_theta;
+
+    if (abs(g) < 1E-3f)
+    {
+        cos_theta = T(1.0) - T(2.0) * u1;
+    }
+    else
+    {
+        T sq = T(1.0f - g * g) / (T(1.0f - g) + T(2.0f * g) * u1);
+        cos_theta = (T(1.0f + g * g) - sq * sq) / T(2.0f * g);
+    }
+
+    cos_theta = clamp(cos_theta, T(-1.0), T(1.0));
+
+    T sin_theta = sqrt(max(T(0.0), T(1.0) - cos_theta * cos_theta));
+    T phi = constants::two_pi<T>() * u2;
+
+    vector<3, T> u;
+    vector<3, T> v;
+    vector<3, T> w = dir;
+    make_orthonormal_basis(u, v, w);
+
+    return u * (sin_theta * cos(phi)) + v * (sin_theta * sin(phi)) + w * cos_theta;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Delta tracking
+//
+
+template <typename Volume, typename S, typename Sampler>
+VSNRAY_FUNC
+inline S delta_tracking(
+        participating_medium<Volume> const& medium,
+        basic_ray<S> const&                 ray,
+        S const&                            tmin,
+        S const&                            tmax,
+        simd::mask_type_t<S>                active,
+        Sampler&                            samp
+        )
+{
+    S result = tmax;
+
+    active &= tmin < tmax;
+
+    if (!any(active))
+    {
+        return result;
+    }
+
+    auto tex_ray = detail::texture_space_ray(medium, ray);
+
+    auto const& grid = medium.majorants;
+    detail::grid_dda<S> dda(grid.dims(), grid.cell_extent(), tex_ray, tmin);
+
+    S t = tmin;
+
+    while (any(active))
+    {
+        S t_exit   = min(dda.exit(), tmax);
+        S majorant = detail::load_cell(grid.data(), dda.cell_index()) * S(medium.sigma_t);
+
+        // Tentative collision with the medium homogenized by the majorant of the cell
+        S u  = samp.next();
+        S tc = select(
+                majorant > S(0.0),
+                t - log(S(1.0) - u) / majorant,
+                numeric_limits<S>::max()
+                );
+
+        auto inside = active & (tc < t_exit);
+        auto leave  = active & !inside;
+
+        // The exponential distribution is memoryless, lanes without a
+        // collision in the cell start over at the next cell
+        t = select(leave, t_exit, t);
+        active &= !(leave & (t_exit >= tmax));
+        dda.next(leave & active);
+
+        if (any(inside))
+        {
+            // Accept real collisions with probability sigma_t(x) / majorant
+            S sigma = tex3D(medium.density, tex_ray.ori + tex_ray.dir * tc) * S(medium.sigma_t);
+            auto real = inside & (samp.next() * majorant < sigma);
+
+            result = select(real, tc, result);
+            t = select(inside, tc, t);
+            active &= !real;
+        }
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Ratio tracking
+//
+
+template <typename Volume, typename S, typename Sampler>
+VSNRAY_FUNC
+inline S ratio_tracking(
+        participating_medium<Volume> const& medium,
+        basic_ray<S> const&                 ray,
+        S const&                            tmin,
+        S const&                            tmax,
+        simd::mask_type_t<S>                active,
+        Sampler&                            samp
+        )
+{
+    S result(1.0);
+
+    active &= tmin < tmax;
+
+    if (!any(active))
+    {
+        return result;
+    }
+
+    auto tex_ray = detail::texture_space_ray(medium, ray);
+
+    auto const& grid = medium.majorants;
+    detail::grid_dda<S> dda(grid.dims(), grid.cell_extent(), tex_ray, tmin);
+
+    S t = tmin;
+
+    while (any(active))
+    {
+        S t_exit   = min(dda.exit(), tmax);
+        S majorant = detail::load_cell(grid.data(), dda.cell_index()) * S(medium.sigma_t);
+
+        S u  = samp.next();
+        S tc = select(
+                majorant > S(0.0),
+                t - log(S(1.0) - u) / majorant,
+                numeric_limits<S>::max()
+                );
+
+        auto inside = active & (tc < t_exit);
+        auto leave  = active & !inside;
+
+        t = select(leave, t_exit, t);
+        active &= !(leave & (t_exit >= tmax));
+        dda.next(leave & active);
+
+        if (any(inside))
+        {
+            // Weight by the probability of a null collision
+            S sigma = tex3D(medium.density, tex_ray.ori + tex_ray.dir * tc) * S(medium.sigma_t);
+
+            result = select(inside, result * max(S(1.0) - sigma / majorant, S(0.0)), result);
+            t = select(inside, tc, t);
+            active &= result > S(0.0);
+        }
+    }
+
+    return result;
+}
+
+} // visionaray
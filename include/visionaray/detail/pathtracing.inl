@@ -11,12 +11,504 @@
 #include <ostream>
 #endif
 
+#include <cstddef>
+#include <type_traits>
+
+#include <visionaray/math/constants.h>
 #include <visionaray/get_surface.h>
+#include <visionaray/hero_wavelengths.h>
+#include <visionaray/light_tree.h>
 #include <visionaray/result_record.h>
+#include <visionaray/sampling.h>
+#include <visionaray/shade_record.h>
+#include <visionaray/spectrum.h>
 #include <visionaray/traverse.h>
 
+#include "light_sampling.h"
+
 namespace visionaray
 {
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Select a light per lane for next event estimation: uniformly, or proportional to
+// the importance of the lights if a light tree is present. index is -1 for lanes
+// where no light was selected
+//
+
+VSNRAY_FUNC
+inline void sample_light_tree(
+        light_tree_ref const&   tree,
+        vector<3, float> const& pos,
+        float                   u,
+        float&                  index,
+        float&                  pmf
+        )
+{
+    index = static_cast<float>(tree.sample(pos, u, pmf));
+}
+
+template <typename S, typename = typename std::enable_if<simd::is_simd_vector<S>::value>::type>
+inline void sample_light_tree(
+        light_tree_ref const&   tree,
+        vector<3, S> const&     pos,
+        S const&                u,
+        S&                      index,
+        S&                      pmf
+        )
+{
+    using float_array = simd::aligned_array_t<S>;
+
+    auto ps = simd::unpack(pos);
+
+    float_array us;
+    store(us, u);
+
+    float_array indices;
+    float_array pmfs;
+
+    for (size_t i = 0; i < simd::num_elements<S>::value; ++i)
+    {
+        sample_light_tree(tree, ps[i], us[i], indices[i], pmfs[i]);
+    }
+
+    index = S(indices);
+    pmf   = S(pmfs);
+}
+
+template <typename Params, typename S>
+VSNRAY_FUNC
+inline void select_light(
+        Params const&       params,
+        vector<3, S> const& pos,
+        S const&            u,
+        S&                  index,
+        S&                  pmf
+        )
+{
+    if (params.light_tree.empty())
+    {
+        S n(static_cast<float>(params.lights.end - params.lights.begin));
+
+        index = min( floor(u * n), n - S(1.0) );
+        pmf   = S(1.0) / n;
+    }
+    else
+    {
+        sample_light_tree(params.light_tree, pos, u, index, pmf);
+    }
+}
+
+// Return one of the light indices of the lanes in remaining, or -1
+VSNRAY_FUNC
+inline int next_light_index(float index, bool remaining)
+{
+    return remaining ? static_cast<int>(index) : -1;
+}
+
+template <typename S, typename = typename std::enable_if<simd::is_simd_vector<S>::value>::type>
+inline int next_light_index(S const& index, simd::mask_type_t<S> const& remaining)
+{
+    simd::aligned_array_t<S> indices;
+    store(indices, select(remaining, index, S(-1.0)));
+
+    for (size_t i = 0; i < simd::num_elements<S>::value; ++i)
+    {
+        if (indices[i] >= 0.0f)
+        {
+            return static_cast<int>(indices[i]);
+        }
+    }
+
+    return -1;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Transmittance along the parts of shadow rays that are not occluded by surfaces, 1 if
+// there is no participating medium
+//
+
+struct unit_transmittance
+{
+    template <typename S, typename M, typename Sampler>
+    VSNRAY_FUNC S operator()(basic_ray<S> const& /* */, S const& /* */, M const& /* */, Sampler& /* */) const
+    {
+        return S(1.0);
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Lights behind the surface do not contribute
+//
+
+template <typename Surface, typename S>
+VSNRAY_FUNC
+inline auto faces_light(Surface const& /* */, vector<3, S> const& normal, vector<3, S> const& light_dir)
+    -> decltype(dot(normal, light_dir) > S(0.0))
+{
+    return dot(normal, light_dir) > S(0.0);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Next event estimation: select one of the lights (see select_light()), trace a shadow
+// ray and weight the contribution against BRDF sampling with the power heuristic.
+// sr is the shade record of the surface with isect_pos, normal and view_dir set, the
+// radiance has the color type of sr (see shade_color_t).
+//
+// sample_direct_light() samples the lights and returns the shadow rays along with the
+// radiance that arrives if they are not occluded, so that shadow rays can be traced
+// separately (e.g. in bulk by wavefront kernels). estimate_direct_light() also traces
+// them, shadow rays are attenuated by transmittance(shadow_ray, max_t, active, samp)
+//
+
+template <typename S, typename C = spectrum<S>>
+struct direct_light_sample
+{
+    basic_ray<S>            shadow_ray;
+    S                       max_t;      // Distance to the light minus epsilons
+    C                       radiance;   // Contribution if the shadow ray is not occluded
+    simd::mask_type_t<S>    valid;      // Lanes with a shadow ray
+};
+
+template <
+    typename Params,
+    typename Surface,
+    typename SR,
+    typename Sampler,
+    typename S = typename SR::scalar_type
+    >
+VSNRAY_FUNC
+inline direct_light_sample<S, shade_color_t<SR>> sample_direct_light(
+        Params const&               params,
+        Surface&                    surf,
+        SR                          sr,
+        simd::mask_type_t<S> const& active,
+        Sampler&                    samp
+        )
+{
+    using V = vector<3, S>;
+    using C = shade_color_t<SR>;
+
+    direct_light_sample<S, C> result;
+    result.shadow_ray = basic_ray<S>(V(0.0), V(0.0));
+    result.max_t      = S(0.0);
+    result.radiance   = C(0.0);
+    result.valid      = active & (S(0.0) > S(0.0));
+
+    auto num_lights = params.lights.end - params.lights.begin;
+
+    if (num_lights <= 0 || !any(active))
+    {
+        return result;
+    }
+
+    // Select a light, lanes may select different lights
+    S light_index;
+    S light_pmf;
+    select_light(params, sr.isect_pos, samp.next(), light_index, light_pmf);
+
+    light_sample<S> ls;
+    ls.dir   = V(0.0);
+    ls.dist  = S(0.0);
+    ls.pdf   = S(0.0);
+    ls.delta = true;
+
+    auto remaining = active & (light_index >= S(0.0));
+
+    for (int l = next_light_index(light_index, remaining); l >= 0; l = next_light_index(light_index, remaining))
+    {
+        auto selected = remaining & (light_index == S(static_cast<float>(l)));
+        remaining &= !selected;
+
+        auto sample = sample_light(params.lights.begin[l], sr.isect_pos, samp);
+
+        ls.dir   = select( selected, sample.dir, ls.dir );
+        ls.dist  = select( selected, sample.dist, ls.dist );
+        ls.pdf   = select( selected, sample.pdf, ls.pdf );
+        ls.delta = sample.delta;
+    }
+
+    result.valid = active & (ls.pdf > S(0.0)) & faces_light(surf, sr.normal, ls.dir);
+
+    if (!any(result.valid))
+    {
+        return result;
+    }
+
+    // Shadow ray, ignore the light geometry itself
+    result.shadow_ray = basic_ray<S>(sr.isect_pos + ls.dir * S(params.epsilon), ls.dir);
+    result.max_t      = ls.dist - S(2.0f * params.epsilon);
+
+    sr.light_dir    = ls.dir;
+
+    auto light_pdf  = ls.pdf * light_pmf;
+    auto weight     = ls.delta ? S(1.0) : power_heuristic(light_pdf, surf.pdf(sr));
+
+    // shade() returns pi * BRDF * intensity * cos(theta)
+    auto scale      = weight / (light_pdf * constants::pi<S>());
+
+    remaining = result.valid;
+
+    for (int l = next_light_index(light_index, remaining); l >= 0; l = next_light_index(light_index, remaining))
+    {
+        auto selected = remaining & (light_index == S(static_cast<float>(l)));
+        remaining &= !selected;
+
+        sr.light = params.lights.begin[l];
+
+        result.radiance = select( selected, surf.shade(sr) * scale, result.radiance );
+    }
+
+    return result;
+}
+
+template <
+    typename Params,
+    typename Surface,
+    typename SR,
+    typename Sampler,
+    typename Intersector,
+    typename Transmittance = unit_transmittance,
+    typename S = typename SR::scalar_type
+    >
+VSNRAY_FUNC
+inline shade_color_t<SR> estimate_direct_light(
+        Params const&               params,
+        Surface&                    surf,
+        SR const&                   sr,
+        simd::mask_type_t<S> const& active,
+        Sampler&                    samp,
+        Intersector&                isect,
+        Transmittance const&        transmittance = Transmittance()
+        )
+{
+    using C = shade_color_t<SR>;
+
+    auto ds = sample_direct_light(params, surf, sr, active, samp);
+
+    if (!any(ds.valid))
+    {
+        return C(0.0);
+    }
+
+    auto shadow_rec = any_hit(
+            ds.shadow_ray,
+            params.prims.begin,
+            params.prims.end,
+            ds.max_t,
+            isect
+            );
+
+    auto valid = ds.valid & !shadow_rec.hit;
+
+    if (!any(valid))
+    {
+        return C(0.0);
+    }
+
+    auto tr = transmittance(ds.shadow_ray, ds.max_t, valid, samp);
+
+    return select( valid, ds.radiance * tr, C(0.0) );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// pdf that estimate_direct_light() samples the direction of ray, when the closest
+// intersection of ray is at distance t
+//
+
+template <typename Params>
+VSNRAY_FUNC
+inline float light_tree_pdf(Params const& params, basic_ray<float> const& ray, float t)
+{
+    // The position where estimate_direct_light() selected the light
+    auto ref_point = ray.ori - ray.dir * params.epsilon;
+
+    float result = 0.0f;
+
+    params.light_tree.for_each_light_at(
+            ray.ori + ray.dir * t,
+            params.epsilon,
+            [&](unsigned l)
+            {
+                result += light_pdf(params.lights.begin[l], ray, t) * params.light_tree.pmf(ref_point, l);
+            }
+            );
+
+    return result;
+}
+
+template <
+    typename Params,
+    typename S,
+    typename = typename std::enable_if<simd::is_simd_vector<S>::value>::type
+    >
+inline S light_tree_pdf(Params const& params, basic_ray<S> const& ray, S const& t)
+{
+    using float_array = simd::aligned_array_t<S>;
+
+    auto rays = simd::unpack(ray);
+
+    float_array ts;
+    store(ts, t);
+
+    float_array pdfs;
+
+    for (size_t i = 0; i < simd::num_elements<S>::value; ++i)
+    {
+        pdfs[i] = light_tree_pdf(params, rays[i], ts[i]);
+    }
+
+    return S(pdfs);
+}
+
+template <typename Params, typename R>
+VSNRAY_FUNC
+inline typename R::scalar_type lights_pdf(Params const& params, R const& ray, typename R::scalar_type const& t)
+{
+    using S = typename R::scalar_type;
+
+    if (!params.light_tree.empty())
+    {
+        return light_tree_pdf(params, ray, t);
+    }
+
+    auto num_lights = params.lights.end - params.lights.begin;
+
+    S result(0.0);
+
+    for (auto it = params.lights.begin; it != params.lights.end; ++it)
+    {
+        result += light_pdf(*it, ray, t);
+    }
+
+    return num_lights > 0 ? result / S(static_cast<float>(num_lights)) : result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Russian roulette: active paths survive with a probability that is proportional to
+// their throughput, the throughput of surviving paths is divided by that probability.
+// Returns the paths that were terminated
+//
+
+template <typename S>
+VSNRAY_FUNC
+inline S max_sample(spectrum<S> const& s)
+{
+    return max_element(s.samples());
+}
+
+template <size_t N, typename S>
+VSNRAY_FUNC
+inline S max_sample(vector<N, S> const& samples)
+{
+    return max_element(samples);
+}
+
+template <typename Throughput, typename M, typename Sampler>
+VSNRAY_FUNC
+inline M russian_roulette(
+        Throughput&     throughput,
+        M const&        active,
+        Sampler&        samp
+        )
+{
+    auto p = max_sample(throughput);
+
+    using S = decltype(p);
+
+    // Paths with throughput >= 1 always survive
+    p = min(p, S(1.0));
+
+    auto survive = active & (samp.next() < p);
+
+    throughput = mul( throughput, S(1.0) / p, survive, throughput );
+
+    return active & !survive;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Radiance transport
+//
+// The path throughput and radiance are either spectra in the color space of the
+// materials (RGB or sampled SPDs, see spectrum.h), or samples at the hero wavelengths
+// of the path (kernel_params::spectral). make_shade_record() returns the shade records
+// that materials and lights are evaluated with, materials return colors in the transport
+// representation for these (see shade_color_t). from_rgb() converts RGB colors of the
+// kernel parameters
+//
+
+template <typename S>
+struct spectrum_transport
+{
+    using value_type = spectrum<S>;
+
+    template <typename Params>
+    VSNRAY_FUNC auto make_shade_record() const
+        -> decltype(visionaray::make_shade_record<Params, S>())
+    {
+        return visionaray::make_shade_record<Params, S>();
+    }
+
+    VSNRAY_FUNC value_type from_rgb(vector<3, S> const& rgb) const
+    {
+        return visionaray::from_rgb(rgb);
+    }
+
+    VSNRAY_FUNC vector<4, S> to_rgba(value_type const& value) const
+    {
+        return visionaray::to_rgba(value);
+    }
+};
+
+template <typename S>
+struct hero_wavelength_transport
+{
+    enum { num_samples = hero_wavelengths<S>::num_samples };
+
+    using value_type = vector<num_samples, S>;
+
+    template <typename Params>
+    using shade_record_type = spectral_shade_record<
+            decltype(visionaray::make_shade_record<Params, S>()),
+            num_samples
+            >;
+
+    VSNRAY_FUNC explicit hero_wavelength_transport(S const& u)
+        : wavelengths(u)
+    {
+    }
+
+    template <typename Params>
+    VSNRAY_FUNC shade_record_type<Params> make_shade_record() const
+    {
+        shade_record_type<Params> sr;
+        sr.wavelengths = wavelengths;
+        return sr;
+    }
+
+    VSNRAY_FUNC value_type from_rgb(vector<3, S> const& rgb) const
+    {
+        return visionaray::from_rgb(rgb, wavelengths);
+    }
+
+    VSNRAY_FUNC vector<4, S> to_rgba(value_type const& value) const
+    {
+        return visionaray::to_rgba(value, wavelengths);
+    }
+
+    hero_wavelengths<S> wavelengths;
+};
+
+} // detail
+
+
 namespace pathtracing
 {
 
@@ -34,12 +526,56 @@ struct kernel
             ) const
     {
         using S = typename R::scalar_type;
+
+        if (params.spectral)
+        {
+            detail::hero_wavelength_transport<S> transport(s.next());
+            return trace(transport, isect, ray, s);
+        }
+        else
+        {
+            detail::spectrum_transport<S> transport;
+            return trace(transport, isect, ray, s);
+        }
+    }
+
+    template <typename R, typename Sampler>
+    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(
+            R ray,
+            Sampler& s
+            ) const
+    {
+        default_intersector ignore;
+        return (*this)(ignore, ray, s);
+    }
+
+private:
+
+    template <typename Transport, typename Intersector, typename R, typename Sampler>
+    VSNRAY_FUNC result_record<typename R::scalar_type> trace(
+            Transport const& transport,
+            Intersector& isect,
+            R ray,
+            Sampler& s
+            ) const
+    {
+        using S = typename R::scalar_type;
+        using I = typename result_record<S>::int_type;
         using V = typename result_record<S>::vec_type;
-        using C = spectrum<S>;
+        using T = typename Transport::value_type;
 
         simd::mask_type_t<S> active_rays = true;
 
-        C dst(1.0);
+        T dst(S(1.0));
+
+        // Contribution of explicitly sampled lights (sample_lights only)
+        T direct(S(0.0));
+
+        // pdf of the BRDF sample that generated the current ray, 0 for primary rays
+        // and specular reflection (sample_lights only)
+        S prev_pdf(0.0);
+
+        T ambient = transport.from_rgb(V(params.ambient_color.xyz() * params.ambient_color.w));
 
         result_record<S> result;
         result.color = params.bg_color;
@@ -50,7 +586,7 @@ struct kernel
 
             // Handle rays that just exited
             auto exited = active_rays & !hit_rec.hit;
-            dst = mul( dst, C(from_rgba(params.ambient_color)), exited, dst );
+            dst = mul( dst, ambient, exited, dst );
 
 
             // Exit if no ray is active anymore
@@ -71,7 +607,9 @@ struct kernel
 
             // Process the current bounce
 
-            V refl_dir;
+            hit_rec.isect_pos = ray.ori + ray.dir * hit_rec.t;
+
+            V refl_dir(0.0);
             V view_dir = -ray.dir;
 
             auto surf = get_surface(hit_rec, params);
@@ -82,52 +620,93 @@ struct kernel
             n = faceforward( n, view_dir, surf.geometric_normal );
 #endif
 
+            if (bounce == 0)
+            {
+                // AOVs of the first hit
+                result.normal   = select( hit_rec.hit, n, V(0.0) );
+                result.albedo   = select( hit_rec.hit, to_rgb(surf.albedo()), V(0.0) );
+                result.prim_id  = select( hit_rec.hit, hit_rec.prim_id, I(-1) );
+                result.geom_id  = select( hit_rec.hit, hit_rec.geom_id, I(-1) );
+            }
+
             S pdf(0.0);
-            auto sr     = make_shade_record<Params, S>();
-            sr.normal   = n;
-            sr.view_dir = view_dir;
+            auto sr      = transport.template make_shade_record<Params>();
+            sr.isect_pos = hit_rec.isect_pos;
+            sr.normal    = n;
+            sr.view_dir  = view_dir;
+
+            simd::mask_type_t<S> emissive = has_emissive_material(surf);
+
+            S emission_weight(1.0);
+
+            if (params.sample_lights)
+            {
+                // Lights that were hit by BRDF sampling
+                auto weighted = active_rays & emissive & (prev_pdf > S(0.0));
+
+                if (any(weighted))
+                {
+                    auto light_pdf = detail::lights_pdf(params, ray, hit_rec.t);
+                    emission_weight = select( weighted, power_heuristic(prev_pdf, light_pdf), S(1.0) );
+                }
+
+                // The light is hit by the next bounce, if there is one
+                if (bounce + 1 < params.num_bounces)
+                {
+                    direct += dst * detail::estimate_direct_light(
+                            params,
+                            surf,
+                            sr,
+                            active_rays & !emissive,
+                            s,
+                            isect
+                            );
+                }
+            }
 
             auto src = surf.sample(sr, refl_dir, pdf, s);
 
             auto zero_pdf = pdf <= S(0.0);
-            auto emissive = has_emissive_material(surf);
 
             src = mul( src, dot(n, refl_dir) / pdf, !emissive, src ); // TODO: maybe have emissive material return refl_dir so that dot(N,R) = 1?
+            src = mul( src, emission_weight, emissive, src );
             dst = mul( dst, src, active_rays && !zero_pdf, dst );
-            dst = select( zero_pdf && active_rays, C(0.0), dst );
+            dst = select( zero_pdf && active_rays, T(S(0.0)), dst );
+
+            if (params.sample_lights)
+            {
+                sr.light_dir = refl_dir;
+                prev_pdf = surf.pdf(sr);
+            }
 
             active_rays &= !emissive;
             active_rays &= !zero_pdf;
 
+            if (params.russian_roulette && bounce >= params.rr_min_bounces)
+            {
+                auto terminated = detail::russian_roulette(dst, active_rays, s);
+
+                dst = select( terminated, T(S(0.0)), dst );
+                active_rays &= !terminated;
+            }
+
 
             if (!any(active_rays))
             {
                 break;
             }
 
-            hit_rec.isect_pos = ray.ori + ray.dir * hit_rec.t;
-
             ray.ori = hit_rec.isect_pos + refl_dir * S(params.epsilon);
             ray.dir = refl_dir;
         }
 
         // Terminate paths that are still active
-        dst = select(active_rays, C(0.0), dst);
+        dst = select(active_rays, T(S(0.0)), dst);
 
-        result.color = select( result.hit, to_rgba(dst), result.color );
+        result.color = select( result.hit, transport.to_rgba(dst + direct), result.color );
 
         return result;
     }
-
-    template <typename R, typename Sampler>
-    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(
-            R ray,
-            Sampler& s
-            ) const
-    {
-        default_intersector ignore;
-        return (*this)(ignore, ray, s);
-    }
 };
 
 } // pathtracing
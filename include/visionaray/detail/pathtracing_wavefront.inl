@@ -0,0 +1,389 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_PATHTRACING_WAVEFRONT_INL
+#define VSNRAY_DETAIL_PATHTRACING_WAVEFRONT_INL 1
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/get_surface.h>
+#include <visionaray/result_record.h>
+#include <visionaray/sampling.h>
+#include <visionaray/spectrum.h>
+#include <visionaray/traverse.h>
+
+#include "macros.h"
+#include "wavefront_queue.h"
+
+namespace visionaray
+{
+namespace pathtracing
+{
+
+//-------------------------------------------------------------------------------------------------
+// Path tracing kernel for wavefront execution (CPU only)
+//
+// Instead of tracing a whole path per invocation, the kernel provides stages
+// that process all paths of a wavefront_queue at once. The stages are driven
+// by wavefront_sched, which also generates primary rays and stores the
+// results of finished paths. R determines the SIMD width of the stages.
+//
+// Produces the same results as pathtracing::kernel, this includes next event
+// estimation when kernel_params::sample_lights is set. The shade stage then
+// only generates the shadow rays, they are traced in bulk by trace_shadow_rays
+// before the queue is compacted.
+//
+// Spectral transport (kernel_params::spectral) is not supported, paths are
+// transported in RGB.
+//
+
+template <typename Params>
+struct wavefront_kernel
+{
+    using primitive_iterator = decltype(std::declval<Params>().prims.begin);
+    using hit_record_type    = decltype(closest_hit(
+            std::declval<basic_ray<float>>(),
+            std::declval<primitive_iterator>(),
+            std::declval<primitive_iterator>()
+            ));
+    using queue_type         = wavefront_queue<hit_record_type>;
+
+    Params params;
+
+
+    //---------------------------------------------------------------------------------------------
+    // Throws if params requests options that the stages do not implement, called by
+    // wavefront_sched before a frame is rendered
+    //
+
+    void validate() const
+    {
+        if (params.spectral)
+        {
+            throw std::runtime_error("wavefront_kernel: spectral transport is not supported");
+        }
+    }
+
+
+    //---------------------------------------------------------------------------------------------
+    // Stage 1: intersect the rays of all paths with the scene
+    //
+    // Paths that leave the scene are finished
+    //
+
+    template <typename R>
+    void extend(queue_type& queue) const
+    {
+        using S = typename R::scalar_type;
+
+        if (params.num_bounces == 0)
+        {
+            for (size_t p = 0; p < queue.size(); ++p)
+            {
+                auto result = queue.result[p];
+                result.color = params.bg_color;
+                queue.finish(p, result);
+            }
+
+            return;
+        }
+
+        for (size_t i = 0; i < queue.size(); i += simd::num_elements<S>::value)
+        {
+            auto ray = queue.template load_ray<S>(i);
+
+            auto hrs = detail::unpack_lanes(closest_hit(ray, params.prims.begin, params.prims.end));
+
+            for (size_t l = 0; l < hrs.size() && i + l < queue.size(); ++l)
+            {
+                size_t p = i + l;
+
+                queue.hit_rec[p] = hrs[l];
+
+                if (hrs[l].hit)
+                {
+                    // Special handling for first bounce
+                    if (queue.bounce[p] == 0)
+                    {
+                        auto r = queue.template load_ray<float>(p);
+                        queue.result[p].hit = true;
+                        queue.result[p].isect_pos = r.ori + r.dir * hrs[l].t;
+                    }
+
+                    continue;
+                }
+
+                // Ray exited
+                auto result = queue.result[p];
+
+                if (queue.bounce[p] == 0)
+                {
+                    result.color = params.bg_color;
+                }
+                else
+                {
+                    auto dst = queue.throughput(p) * spectrum<float>(from_rgba(params.ambient_color));
+                    result.color = to_rgba(dst + queue.radiance(p));
+                }
+
+                queue.finish(p, result);
+            }
+        }
+    }
+
+
+    //---------------------------------------------------------------------------------------------
+    // Stage 2: sample the materials of all paths and set up the extension rays
+    //
+    // Paths are sorted by material type first so that the materials of a SIMD
+    // packet can be evaluated together (see simd::generic_material).
+    // Paths that hit a light source, that were absorbed, that were terminated
+    // by Russian roulette or that reached the maximum number of bounces are
+    // finished
+    //
+
+    template <typename R, typename Sampler>
+    void shade(queue_type& queue, Sampler& samp) const
+    {
+        using S = typename R::scalar_type;
+        using V = vector<3, S>;
+        using C = spectrum<S>;
+
+        enum { N = simd::num_elements<S>::value };
+
+        queue.sort_by_material(params.materials);
+
+        for (size_t i = 0; i < queue.size(); i += N)
+        {
+            array<hit_record_type, N> hr_arr;
+
+            for (size_t l = 0; l < N; ++l)
+            {
+                hr_arr[l] = i + l < queue.size() ? queue.hit_rec[i + l] : hit_record_type();
+            }
+
+            auto hit_rec = detail::pack_lanes<S>(hr_arr);
+            auto ray     = queue.template load_ray<S>(i);
+            auto dst     = queue.template load_throughput<S>(i);
+
+            hit_rec.isect_pos = ray.ori + ray.dir * hit_rec.t;
+
+            V refl_dir(0.0);
+            V view_dir = -ray.dir;
+
+            auto surf = get_surface(hit_rec, params);
+
+            auto n = surf.shading_normal;
+
+#if 1 // two-sided
+            n = faceforward( n, view_dir, surf.geometric_normal );
+#endif
+
+            S pdf(0.0);
+            auto sr      = make_shade_record<Params, S>();
+            sr.isect_pos = hit_rec.isect_pos;
+            sr.normal    = n;
+            sr.view_dir  = view_dir;
+
+            simd::mask_type_t<S> emissive = has_emissive_material(surf);
+
+            S emission_weight(1.0);
+
+            if (params.sample_lights)
+            {
+                auto prev_pdf = queue.template load_prev_pdf<S>(i);
+
+                // Lights that were hit by BRDF sampling
+                auto weighted = emissive & (prev_pdf > S(0.0));
+
+                if (any(weighted))
+                {
+                    auto light_pdf = detail::lights_pdf(params, ray, hit_rec.t);
+                    emission_weight = select( weighted, power_heuristic(prev_pdf, light_pdf), S(1.0) );
+                }
+
+                // The light is hit by the next bounce, if there is one
+                VSNRAY_ALIGN(64) float has_next_bounce[N];
+
+                for (size_t l = 0; l < N; ++l)
+                {
+                    has_next_bounce[l] = i + l < queue.size() && queue.bounce[i + l] + 1 < params.num_bounces
+                                       ? 1.0f
+                                       : 0.0f;
+                }
+
+                auto ds = detail::sample_direct_light(
+                        params,
+                        surf,
+                        sr,
+                        (detail::load_lanes<S>(has_next_bounce) > S(0.0)) & !emissive,
+                        samp
+                        );
+
+                // Traced by trace_shadow_rays()
+                queue.store_shadow_ray(
+                        i,
+                        ds.shadow_ray,
+                        select( ds.valid, ds.max_t, S(-1.0) ),
+                        select( ds.valid, dst * ds.radiance, C(0.0) )
+                        );
+            }
+
+            auto src = surf.sample(sr, refl_dir, pdf, samp);
+
+            auto zero_pdf = pdf <= S(0.0);
+
+            src = mul( src, dot(n, refl_dir) / pdf, !emissive, src );
+            src = mul( src, emission_weight, emissive, src );
+            dst = mul( dst, src, !zero_pdf, dst );
+            dst = select( zero_pdf, C(0.0), dst );
+
+            if (params.sample_lights)
+            {
+                sr.light_dir = refl_dir;
+                queue.store_prev_pdf(i, surf.pdf(sr));
+            }
+
+            auto terminated = emissive || zero_pdf;
+
+            if (params.russian_roulette)
+            {
+                VSNRAY_ALIGN(64) float rr_lanes[N];
+
+                for (size_t l = 0; l < N; ++l)
+                {
+                    rr_lanes[l] = i + l < queue.size() && queue.bounce[i + l] >= params.rr_min_bounces
+                                ? 1.0f
+                                : 0.0f;
+                }
+
+                // Killed paths are finished below and removed from the queue by compact()
+                auto killed = detail::russian_roulette(
+                        dst,
+                        (detail::load_lanes<S>(rr_lanes) > S(0.0)) & !terminated,
+                        samp
+                        );
+
+                dst = select( killed, C(0.0), dst );
+                terminated |= killed;
+            }
+
+            ray.ori = hit_rec.isect_pos + refl_dir * S(params.epsilon);
+            ray.dir = refl_dir;
+
+            queue.store_ray(i, ray);
+            queue.store_throughput(i, dst);
+
+            // Finish paths
+            VSNRAY_ALIGN(64) float finished[N];
+            detail::store_lanes(finished, select(terminated, S(1.0), S(0.0)));
+
+            for (size_t l = 0; l < N && i + l < queue.size(); ++l)
+            {
+                size_t p = i + l;
+
+                ++queue.bounce[p];
+
+                if (finished[l] != 0.0f || queue.bounce[p] >= params.num_bounces)
+                {
+                    auto result = queue.result[p];
+
+                    // Terminate paths that are still active. Their radiance
+                    // is kept, shadow rays may still contribute to it
+                    auto radiance = finished[l] != 0.0f
+                                  ? queue.throughput(p) + queue.radiance(p)
+                                  : queue.radiance(p);
+
+                    queue.store_radiance(p, radiance);
+
+                    result.color = to_rgba(radiance);
+                    queue.finish(p, result);
+                }
+            }
+        }
+    }
+
+
+    //---------------------------------------------------------------------------------------------
+    // Stage 3: trace the shadow rays generated by shade()
+    //
+    // The radiance of unoccluded shadow rays is added to the paths, the
+    // results of paths that were finished by shade() are updated
+    //
+
+    template <typename R>
+    void trace_shadow_rays(queue_type& queue) const
+    {
+        using S = typename R::scalar_type;
+
+        enum { N = simd::num_elements<S>::value };
+
+        if (!params.sample_lights)
+        {
+            return;
+        }
+
+        default_intersector isect;
+
+        for (size_t i = 0; i < queue.size(); i += N)
+        {
+            auto max_t = queue.template load_shadow_max_t<S>(i);
+
+            // Padding lanes, max_t is not initialized
+            VSNRAY_ALIGN(64) float in_queue[N];
+
+            for (size_t l = 0; l < N; ++l)
+            {
+                in_queue[l] = i + l < queue.size() ? 1.0f : 0.0f;
+            }
+
+            auto valid = (detail::load_lanes<S>(in_queue) > S(0.0)) & (max_t > S(0.0));
+
+            if (!any(valid))
+            {
+                continue;
+            }
+
+            auto shadow_ray = queue.template load_shadow_ray<S>(i);
+
+            auto shadow_rec = any_hit(
+                    shadow_ray,
+                    params.prims.begin,
+                    params.prims.end,
+                    max_t,
+                    isect
+                    );
+
+            valid = valid & !shadow_rec.hit;
+
+            if (!any(valid))
+            {
+                continue;
+            }
+
+            auto radiance = queue.template load_radiance<S>(i);
+            radiance += select( valid, queue.template load_shadow_radiance<S>(i), spectrum<S>(0.0) );
+            queue.store_radiance(i, radiance);
+
+            for (size_t l = 0; l < N && i + l < queue.size(); ++l)
+            {
+                size_t p = i + l;
+
+                if (!queue.active[p])
+                {
+                    queue.result[p].color = to_rgba(queue.radiance(p));
+                }
+            }
+        }
+    }
+};
+
+} // pathtracing
+} // visionaray
+
+#endif // VSNRAY_DETAIL_PATHTRACING_WAVEFRONT_INL
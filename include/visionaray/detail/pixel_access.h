@@ -35,7 +35,13 @@ namespace pixel_access
 // Store an input color to an output color buffer, apply color conversion
 //
 
-template <pixel_format DF, pixel_format SF, typename InputColor, typename OutputColor>
+template <
+    pixel_format DF,
+    pixel_format SF,
+    typename InputColor,
+    typename OutputColor,
+    typename = typename std::enable_if<!simd::is_simd_vector<InputColor>::value>::type
+    >
 VSNRAY_FUNC
 inline void store(
         pixel_format_constant<DF>   /* dst format */,
@@ -557,6 +563,96 @@ inline void store(
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Store SIMD vector to render target of any format, apply conversion per pixel
+//
+
+template <
+    pixel_format DF,
+    pixel_format SF,
+    size_t Dim,
+    typename T,
+    typename OutputColor,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type
+    >
+VSNRAY_FUNC
+inline void store(
+        pixel_format_constant<DF>   /* dst format */,
+        pixel_format_constant<SF>   /* src format */,
+        int                         x,
+        int                         y,
+        int                         width,
+        int                         height,
+        vector<Dim, T> const&       value,
+        OutputColor*                buffer
+        )
+{
+    auto values = simd::unpack(value);
+
+    auto w = packet_size<T>::w;
+    auto h = packet_size<T>::h;
+
+    for (auto row = 0; row < h; ++row)
+    {
+        for (auto col = 0; col < w; ++col)
+        {
+            if (x + col < width && y + row < height)
+            {
+                convert(
+                    pixel_format_constant<DF>{},
+                    pixel_format_constant<SF>{},
+                    buffer[(y + row) * width + (x + col)],
+                    values[row * w + col]
+                    );
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Store single SIMD channel (float or int) to render target of any format,
+// apply conversion per pixel
+//
+
+template <pixel_format DF, pixel_format SF, typename T, typename OutputColor>
+VSNRAY_FUNC
+inline typename std::enable_if<simd::is_simd_vector<T>::value>::type store(
+        pixel_format_constant<DF>   /* dst format */,
+        pixel_format_constant<SF>   /* src format */,
+        int                         x,
+        int                         y,
+        int                         width,
+        int                         height,
+        T const&                    value,
+        OutputColor*                buffer
+        )
+{
+    simd::aligned_array_t<T> v;
+
+    store(v, value);
+
+    // Int vectors map to pixels like the corresponding float vectors
+    auto w = packet_size<simd::float_type_t<T>>::w;
+    auto h = packet_size<simd::float_type_t<T>>::h;
+
+    for (auto row = 0; row < h; ++row)
+    {
+        for (auto col = 0; col < w; ++col)
+        {
+            if (x + col < width && y + row < height)
+            {
+                convert(
+                    pixel_format_constant<DF>{},
+                    pixel_format_constant<SF>{},
+                    buffer[(y + row) * width + (x + col)],
+                    v[row * w + col]
+                    );
+            }
+        }
+    }
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Store color from result record to output color buffer
 //
@@ -0,0 +1,137 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+#include <visionaray/math/math.h>
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// preintegration_table members
+//
+
+inline preintegration_table::preintegration_table(unsigned num_threads)
+    : pool_(std::make_shared<thread_pool>(num_threads))
+    , priority_(thread_pool::Normal)
+{
+}
+
+inline preintegration_table::preintegration_table(std::shared_ptr<thread_pool> pool, int priority)
+    : pool_(pool)
+    , priority_(priority)
+{
+}
+
+template <typename TransFunc>
+inline void preintegration_table::build(TransFunc const& transfunc, float delta, float delta_ref, int size)
+{
+    assert(size > 0);
+    assert(delta > 0.0f && delta_ref > 0.0f);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    size_ = size;
+    data_.resize(static_cast<size_t>(size) * size);
+
+    int n = static_cast<int>(transfunc.width());
+    auto tf = transfunc.data();
+
+    // Linear filtering and clamping, as with tex1D()
+    auto lookup = [&](float s)
+    {
+        float x = std::min(std::max(s * n - 0.5f, 0.0f), static_cast<float>(n - 1));
+        int i0 = static_cast<int>(x);
+        int i1 = std::min(i0 + 1, n - 1);
+        return lerp(vec4(tf[i0]), vec4(tf[i1]), x - i0);
+    };
+
+    parallel_rows([&](int j)
+    {
+        float sb = (j + 0.5f) / size;
+
+        for (int i = 0; i < size; ++i)
+        {
+            float sf = (i + 0.5f) / size;
+
+            // Two samples per transfer function texel that the segment crosses,
+            // segments with sf == sb only need a single sample
+            int num_steps = std::max(static_cast<int>(std::ceil(std::abs(sb - sf) * n * 2.0f)), 1);
+
+            // Opacity correction for the length of the sub-segments
+            float exponent = delta / (num_steps * delta_ref);
+
+            vec4 dst(0.0f);
+
+            for (int k = 0; k < num_steps; ++k)
+            {
+                vec4 color = lookup(sf + (sb - sf) * (k + 0.5f) / num_steps);
+
+                if (color.w <= 0.0f)
+                {
+                    continue;
+                }
+
+                float alpha = color.w < 1.0f ? 1.0f - std::pow(1.0f - color.w, exponent) : 1.0f;
+
+                // front-to-back alpha compositing, premultiplied
+                dst.xyz() += color.xyz() * (alpha * (1.0f - dst.w));
+                dst.w     += alpha * (1.0f - dst.w);
+            }
+
+            data_[static_cast<size_t>(j) * size + i] = dst;
+        }
+    });
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    last_build_time_ = elapsed.count();
+}
+
+inline texture_ref<vec4, 2> preintegration_table::ref() const
+{
+    texture_ref<vec4, 2> result(size_, size_);
+    result.reset(data_.data());
+    result.set_filter_mode(Linear);
+    result.set_address_mode(Clamp);
+    return result;
+}
+
+inline int preintegration_table::size() const
+{
+    return size_;
+}
+
+inline vec4 const& preintegration_table::operator()(int i, int j) const
+{
+    return data_[static_cast<size_t>(j) * size_ + i];
+}
+
+inline double preintegration_table::last_build_time() const
+{
+    return last_build_time_;
+}
+
+inline void preintegration_table::parallel_rows(std::function<void(int)> const& func)
+{
+    if (size_ <= 0)
+    {
+        return;
+    }
+
+    auto j = std::make_shared<thread_pool::job>(size_, priority_);
+
+    j->process_item = [&func](long y)
+    {
+        func(static_cast<int>(y));
+    };
+
+    auto done = j->done.get_future();
+    pool_->submit(j);
+    done.wait();
+}
+
+} // visionaray
@@ -0,0 +1,134 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_RAY_STREAM_H
+#define VSNRAY_DETAIL_RAY_STREAM_H 1
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/aabb.h>
+#include <visionaray/math/ray.h>
+#include <visionaray/math/vector.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+#include "macros.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// ray_stream
+//
+// Single rays that are traced together (CPU only). The rays are stored in ray
+// packets of native SIMD width in the order they were added. any_hit() walks each
+// BVH once for the whole stream instead of once per ray or ray packet: at each node
+// the packets that are still active are tested against the node's bounds, only
+// those that pass visit the node's children
+//
+
+class ray_stream
+{
+public:
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+    using float_type = simd::float16;
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    using float_type = simd::float8;
+#else
+    using float_type = simd::float4;
+#endif
+
+    using mask_type = simd::mask_type_t<float_type>;
+    using ray_type  = basic_ray<float_type>;
+
+    enum { Width = simd::num_elements<float_type>::value };
+
+    void clear();
+
+    size_t size() const;
+
+    // Add a ray, hits are only reported in [0..max_t)
+    void push_back(basic_ray<float> const& ray, float max_t);
+
+    // Set by any_hit() if the ray hits a primitive
+    bool occluded(size_t index) const;
+
+    template <typename Primitives, typename Intersector>
+    void any_hit(Primitives begin, Primitives end, Intersector& isect);
+
+private:
+
+    struct stack_entry
+    {
+        unsigned node;
+
+        // Range in indices_ with the packets that intersect the node's bounds
+        unsigned first;
+        unsigned last;
+    };
+
+    struct packet
+    {
+        ray_type                ray;
+        vector<3, float_type>   inv_dir;
+        float_type              max_t;
+        mask_type               occluded;
+    };
+
+    aligned_vector<packet, 64> packets_;
+
+    // Rays that were added, the last packet may be partially filled
+    size_t size_ = 0;
+
+    // Single rays that were added to the last packet
+    simd::aligned_array_t<float_type> ori_x_;
+    simd::aligned_array_t<float_type> ori_y_;
+    simd::aligned_array_t<float_type> ori_z_;
+    simd::aligned_array_t<float_type> dir_x_;
+    simd::aligned_array_t<float_type> dir_y_;
+    simd::aligned_array_t<float_type> dir_z_;
+    simd::aligned_array_t<float_type> lane_max_t_;
+
+    // Scratch buffers for traversal, kept to avoid reallocation
+    aligned_vector<unsigned>    indices_;
+    aligned_vector<unsigned>    second_;
+    aligned_vector<stack_entry> stack_;
+
+    // Store the last packet, unused lanes are disabled with max_t = 0
+    void flush();
+
+    bool active(size_t packet) const;
+
+    // Append the packets in indices_[first..last) that intersect the bounds of
+    // the first child to indices_, those that intersect the second child to second_
+    template <typename Node, typename Intersector>
+    void filter(size_t first, size_t last, Node const* children, Intersector& isect);
+
+    // Test the packets in indices_[first..last) against primitive
+    template <typename Primitive, typename Intersector>
+    void intersect(size_t first, size_t last, Primitive const& prim, Intersector& isect);
+
+    // Traverse a BVH
+    template <typename BVH, typename Intersector>
+    void traverse(std::true_type /* is_any_bvh */, BVH const& b, Intersector& isect);
+
+    // Test the whole stream against a single primitive
+    template <typename Primitive, typename Intersector>
+    void traverse(std::false_type /* is_any_bvh */, Primitive const& prim, Intersector& isect);
+
+};
+
+} // detail
+} // visionaray
+
+#include "ray_stream.inl"
+
+#endif // VSNRAY_DETAIL_RAY_STREAM_H
@@ -0,0 +1,223 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// ray_stream members
+//
+
+inline void ray_stream::clear()
+{
+    packets_.clear();
+    size_ = 0;
+}
+
+inline size_t ray_stream::size() const
+{
+    return size_;
+}
+
+inline void ray_stream::push_back(basic_ray<float> const& ray, float max_t)
+{
+    size_t lane = size_ % Width;
+
+    ori_x_[lane]      = ray.ori.x;
+    ori_y_[lane]      = ray.ori.y;
+    ori_z_[lane]      = ray.ori.z;
+    dir_x_[lane]      = ray.dir.x;
+    dir_y_[lane]      = ray.dir.y;
+    dir_z_[lane]      = ray.dir.z;
+    lane_max_t_[lane] = max_t;
+
+    ++size_;
+
+    if (lane == Width - 1)
+    {
+        flush();
+    }
+}
+
+inline bool ray_stream::occluded(size_t index) const
+{
+    VSNRAY_ALIGN(64) int occluded[Width];
+    store(occluded, convert_to_int(packets_[index / Width].occluded));
+
+    return occluded[index % Width] != 0;
+}
+
+template <typename Primitives, typename Intersector>
+inline void ray_stream::any_hit(Primitives begin, Primitives end, Intersector& isect)
+{
+    using primitive_type = typename std::iterator_traits<Primitives>::value_type;
+
+    flush();
+
+    for (Primitives it = begin; it != end; ++it)
+    {
+        traverse(is_any_bvh<primitive_type>{}, *it, isect);
+    }
+}
+
+inline void ray_stream::flush()
+{
+    size_t count = size_ - packets_.size() * Width;
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    for (size_t i = count; i < Width; ++i)
+    {
+        // Copy of the first lane, but inactive
+        ori_x_[i]      = ori_x_[0];
+        ori_y_[i]      = ori_y_[0];
+        ori_z_[i]      = ori_z_[0];
+        dir_x_[i]      = dir_x_[0];
+        dir_y_[i]      = dir_y_[0];
+        dir_z_[i]      = dir_z_[0];
+        lane_max_t_[i] = 0.0f;
+    }
+
+    auto ray = ray_type(
+            vector<3, float_type>(float_type(ori_x_), float_type(ori_y_), float_type(ori_z_)),
+            vector<3, float_type>(float_type(dir_x_), float_type(dir_y_), float_type(dir_z_))
+            );
+
+    packets_.push_back({ ray, float_type(1.0) / ray.dir, float_type(lane_max_t_), mask_type(false) });
+}
+
+inline bool ray_stream::active(size_t packet) const
+{
+    return any( (!packets_[packet].occluded) & (packets_[packet].max_t > float_type(0.0)) );
+}
+
+template <typename Node, typename Intersector>
+inline void ray_stream::filter(size_t first, size_t last, Node const* children, Intersector& isect)
+{
+    second_.clear();
+
+    for (size_t i = first; i < last; ++i)
+    {
+        unsigned p = indices_[i];
+
+        auto const& pa = packets_[p];
+
+        auto hr1 = isect(pa.ray, children[0].get_bounds(), pa.inv_dir);
+        auto hr2 = isect(pa.ray, children[1].get_bounds(), pa.inv_dir);
+
+        auto active = (pa.max_t > float_type(0.0)) & !pa.occluded;
+
+        if (any( active & hr1.hit & (hr1.tnear < pa.max_t) & (hr1.tfar >= float_type(0.0)) ))
+        {
+            second_.push_back(p);
+        }
+
+        if (any( active & hr2.hit & (hr2.tnear < pa.max_t) & (hr2.tfar >= float_type(0.0)) ))
+        {
+            indices_.push_back(p);
+        }
+    }
+}
+
+template <typename Primitive, typename Intersector>
+inline void ray_stream::intersect(size_t first, size_t last, Primitive const& prim, Intersector& isect)
+{
+    for (size_t i = first; i < last; ++i)
+    {
+        auto& pa = packets_[indices_[i]];
+
+        if (all(pa.occluded))
+        {
+            continue;
+        }
+
+        auto hr = isect(pa.ray, prim);
+
+        pa.occluded |= hr.hit & (hr.t >= float_type(0.0)) & (hr.t < pa.max_t);
+    }
+}
+
+template <typename BVH, typename Intersector>
+inline void ray_stream::traverse(std::true_type /* is_any_bvh */, BVH const& b, Intersector& isect)
+{
+    indices_.clear();
+    stack_.clear();
+
+    for (size_t p = 0; p < packets_.size(); ++p)
+    {
+        if (active(p))
+        {
+            indices_.push_back(static_cast<unsigned>(p));
+        }
+    }
+
+    if (!indices_.empty())
+    {
+        stack_.push_back({ 0, 0, static_cast<unsigned>(indices_.size()) });
+    }
+
+    while (!stack_.empty())
+    {
+        auto entry = stack_.back();
+        stack_.pop_back();
+
+        // Ranges above belong to subtrees that were already traversed
+        indices_.resize(entry.last);
+
+        auto const& node = b.node(entry.node);
+
+        if (is_leaf(node))
+        {
+            for (auto i = node.get_indices().first; i != node.get_indices().last; ++i)
+            {
+                intersect(entry.first, entry.last, b.primitive(i), isect);
+            }
+
+            continue;
+        }
+
+        // The packets that intersect the second child are stored first, so that
+        // the range of the first child is on top and can be traversed first
+        size_t first = indices_.size();
+
+        filter(entry.first, entry.last, &b.node(node.get_child(0)), isect);
+
+        size_t second = indices_.size();
+
+        indices_.insert(indices_.end(), second_.begin(), second_.end());
+
+        if (second > first)
+        {
+            stack_.push_back({ node.get_child(1), static_cast<unsigned>(first), static_cast<unsigned>(second) });
+        }
+
+        if (indices_.size() > second)
+        {
+            stack_.push_back({ node.get_child(0), static_cast<unsigned>(second), static_cast<unsigned>(indices_.size()) });
+        }
+    }
+}
+
+template <typename Primitive, typename Intersector>
+inline void ray_stream::traverse(std::false_type /* is_any_bvh */, Primitive const& prim, Intersector& isect)
+{
+    indices_.clear();
+
+    for (size_t p = 0; p < packets_.size(); ++p)
+    {
+        if (active(p))
+        {
+            indices_.push_back(static_cast<unsigned>(p));
+        }
+    }
+
+    intersect(0, indices_.size(), prim, isect);
+}
+
+} // detail
+} // visionaray
@@ -44,6 +44,30 @@ inline unsigned tic()
 }
 #endif
 
+// Integer hash (finalizer of MurmurHash3)
+VSNRAY_FUNC
+inline unsigned hash_seed(unsigned a)
+{
+    a ^= a >> 16;
+    a *= 0x85ebca6b;
+    a ^= a >> 13;
+    a *= 0xc2b2ae35;
+    a ^= a >> 16;
+    return a;
+}
+
+// RNG seed for a stream of random numbers of a work item (e.g. a tile) of a frame.
+// The default engines are LCGs, seeds that differ by small offsets produce correlated
+// sequences, so the ids are hashed instead of just added
+VSNRAY_FUNC
+inline unsigned make_seed(unsigned frame_id, unsigned item_id, unsigned stream_id = 0)
+{
+    unsigned seed = hash_seed(frame_id);
+    seed = hash_seed(seed ^ item_id);
+    seed = hash_seed(seed ^ stream_id);
+    return seed;
+}
+
 
 //-------------------------------------------------------------------------------------------------
 // Invoke kernel
@@ -325,9 +349,9 @@ inline array<R, Num> make_primary_rays(
 // Depth transform
 //
 
-template <typename T>
+template <typename T, typename Camera>
 VSNRAY_FUNC
-inline T depth_transform(vector<3, T> const& isect_pos, matrix_camera const& cam)
+inline T depth_transform(vector<3, T> const& isect_pos, Camera const& cam)
 {
     matrix<4, 4, T> view_matrix(cam.get_view_matrix());
     matrix<4, 4, T> proj_matrix(cam.get_proj_matrix());
@@ -339,6 +363,164 @@ inline T depth_transform(vector<3, T> const& isect_pos, matrix_camera const& cam
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Motion vector: offset in pixels from the window position of isect_pos in the current
+// frame to its window position in the previous frame
+//
+
+template <typename T>
+VSNRAY_FUNC
+inline vector<2, T> window_coords(vector<3, T> const& pos, mat4 const& view_proj, int width, int height)
+{
+    matrix<4, 4, T> vp(view_proj);
+
+    auto pos4 = vp * vector<4, T>(pos, T(1.0));
+    auto pos2 = vector<2, T>(pos4.x, pos4.y) / pos4.w;
+
+    return (pos2 + T(1.0)) * T(0.5) * vector<2, T>(T(width), T(height));
+}
+
+template <typename T, typename Camera>
+VSNRAY_FUNC
+inline vector<2, T> motion_vector(
+        vector<3, T> const& isect_pos,
+        Camera const&       cam,
+        mat4 const&         prev_view_proj,
+        int                 width,
+        int                 height
+        )
+{
+    auto view_proj = cam.get_proj_matrix() * cam.get_view_matrix();
+
+    return window_coords(isect_pos, prev_view_proj, width, height)
+         - window_coords(isect_pos, view_proj, width, height);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Store AOVs from result record to the buffers of an AOV render target ref,
+// buffers with format PF_UNSPECIFIED are skipped
+//
+
+template <pixel_format DF, pixel_format SF, typename Value, typename Buffer>
+VSNRAY_FUNC
+inline void store_aov(
+        pixel_format_constant<DF>   /* dst format */,
+        pixel_format_constant<SF>   /* src format */,
+        int                         x,
+        int                         y,
+        int                         width,
+        int                         height,
+        Value const&                value,
+        Buffer*                     buffer
+        )
+{
+    pixel_access::store(
+            pixel_format_constant<DF>{},
+            pixel_format_constant<SF>{},
+            x,
+            y,
+            width,
+            height,
+            value,
+            buffer
+            );
+}
+
+template <pixel_format SF, typename Value, typename Buffer>
+VSNRAY_FUNC
+inline void store_aov(
+        pixel_format_constant<PF_UNSPECIFIED>   /* dst format */,
+        pixel_format_constant<SF>               /* src format */,
+        int                                     /* x */,
+        int                                     /* y */,
+        int                                     /* width */,
+        int                                     /* height */,
+        Value const&                            /* value */,
+        Buffer*                                 /* buffer */
+        )
+{
+}
+
+template <
+    typename T,
+    pixel_format CF,
+    pixel_format DF,
+    pixel_format NF,
+    pixel_format AF,
+    pixel_format IF,
+    pixel_format MF,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void store_aovs(
+        result_record<T> const&                         rr,
+        aov_render_target_ref<CF, DF, NF, AF, IF, MF>   rt_ref,
+        int                                             x,
+        int                                             y,
+        int                                             width,
+        int                                             height,
+        Camera const&                                   cam
+        )
+{
+    auto depth = select( rr.hit, depth_transform(rr.isect_pos, cam), T(1.0) );
+
+    auto motion = select(
+            rr.hit,
+            motion_vector(rr.isect_pos, cam, rt_ref.prev_view_proj(), width, height),
+            vector<2, T>(0.0)
+            );
+
+    store_aov(
+            pixel_format_constant<DF>{},
+            pixel_format_constant<PF_DEPTH32F>{},
+            x, y, width, height,
+            depth,
+            rt_ref.depth()
+            );
+
+    store_aov(
+            pixel_format_constant<NF>{},
+            pixel_format_constant<PF_RGB32F>{},
+            x, y, width, height,
+            rr.normal,
+            rt_ref.normal()
+            );
+
+    store_aov(
+            pixel_format_constant<AF>{},
+            pixel_format_constant<PF_RGB32F>{},
+            x, y, width, height,
+            rr.albedo,
+            rt_ref.albedo()
+            );
+
+    store_aov(
+            pixel_format_constant<IF>{},
+            pixel_format_constant<PF_R32I>{},
+            x, y, width, height,
+            rr.prim_id,
+            rt_ref.prim_id()
+            );
+
+    store_aov(
+            pixel_format_constant<IF>{},
+            pixel_format_constant<PF_R32I>{},
+            x, y, width, height,
+            rr.geom_id,
+            rt_ref.geom_id()
+            );
+
+    store_aov(
+            pixel_format_constant<MF>{},
+            pixel_format_constant<PF_RG32F>{},
+            x, y, width, height,
+            motion,
+            rt_ref.motion()
+            );
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Simple uniform pixel sampler
 //
@@ -424,6 +606,50 @@ inline void sample_pixel_impl(
 }
 
 
+template <
+    typename K,
+    typename R,
+    typename Sampler,
+    pixel_format CF,
+    pixel_format DF,
+    pixel_format NF,
+    pixel_format AF,
+    pixel_format IF,
+    pixel_format MF,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void sample_pixel_impl(
+        K                                               kernel,
+        pixel_sampler::uniform_type                     /* */,
+        R const&                                        r,
+        Sampler&                                        samp,
+        unsigned                                        frame_num,
+        aov_render_target_ref<CF, DF, NF, AF, IF, MF>   rt_ref,
+        int                                             x,
+        int                                             y,
+        int                                             width,
+        int                                             height,
+        Camera const&                                   cam
+        )
+{
+    VSNRAY_UNUSED(frame_num);
+
+    auto result = invoke_kernel(kernel, r, samp, x, y);
+    pixel_access::store(
+            pixel_format_constant<CF>{},
+            pixel_format_constant<PF_RGBA32F>{},
+            x,
+            y,
+            width,
+            height,
+            result,
+            rt_ref.color()
+            );
+    store_aovs(result, rt_ref, x, y, width, height, cam);
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Jittered pixel sampler, sampler is passed to kernel
 //
@@ -467,6 +693,50 @@ inline void sample_pixel_impl(
 }
 
 
+template <
+    typename K,
+    typename R,
+    typename Sampler,
+    pixel_format CF,
+    pixel_format DF,
+    pixel_format NF,
+    pixel_format AF,
+    pixel_format IF,
+    pixel_format MF,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void sample_pixel_impl(
+        K                                               kernel,
+        pixel_sampler::jittered_type                    /* */,
+        R const&                                        r,
+        Sampler&                                        samp,
+        unsigned                                        frame_num,
+        aov_render_target_ref<CF, DF, NF, AF, IF, MF>   rt_ref,
+        int                                             x,
+        int                                             y,
+        int                                             width,
+        int                                             height,
+        Camera const&                                   cam
+        )
+{
+    VSNRAY_UNUSED(frame_num);
+
+    auto result = invoke_kernel(kernel, r, samp, x, y);
+    pixel_access::store(
+            pixel_format_constant<CF>{},
+            pixel_format_constant<PF_RGBA32F>{},
+            x,
+            y,
+            width,
+            height,
+            result,
+            rt_ref.color()
+            );
+    store_aovs(result, rt_ref, x, y, width, height, cam);
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Jittered pixel sampler, result is blended on top of color buffer, sampler is passed to kernel
 //
@@ -560,6 +830,54 @@ inline void sample_pixel_impl(
 }
 
 
+template <
+    typename K,
+    typename R,
+    typename Sampler,
+    pixel_format CF,
+    pixel_format DF,
+    pixel_format NF,
+    pixel_format AF,
+    pixel_format IF,
+    pixel_format MF,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void sample_pixel_impl(
+        K                                               kernel,
+        pixel_sampler::jittered_blend_type              /* */,
+        R const&                                        r,
+        Sampler&                                        samp,
+        unsigned                                        frame_num,
+        aov_render_target_ref<CF, DF, NF, AF, IF, MF>   rt_ref,
+        int                                             x,
+        int                                             y,
+        int                                             width,
+        int                                             height,
+        Camera const&                                   cam
+        )
+{
+    using S = typename R::scalar_type;
+
+    auto result = invoke_kernel(kernel, r, samp, x, y);
+    auto alpha  = S(1.0) / S(frame_num);
+
+    // Only color is blended, the AOVs of the last sample are stored
+    pixel_access::blend(
+            pixel_format_constant<CF>{},
+            pixel_format_constant<PF_RGBA32F>{},
+            x,
+            y,
+            width,
+            height,
+            result,
+            rt_ref.color(),
+            alpha, S(1.0) - alpha
+            );
+    store_aovs(result, rt_ref, x, y, width, height, cam);
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // jittered pixel sampler, blends several samples at once
 //
@@ -26,6 +26,7 @@ struct kernel
     VSNRAY_FUNC result_record<typename R::scalar_type> operator()(Intersector& isect, R ray) const
     {
         using S = typename R::scalar_type;
+        using I = typename result_record<S>::int_type;
         using V = typename result_record<S>::vec_type;
         using C = spectrum<S>;
 
@@ -48,6 +49,12 @@ struct kernel
             n = faceforward( n, view_dir, surf.geometric_normal );
 #endif
 
+            // AOVs
+            result.normal       = select( hit_rec.hit, n, V(0.0) );
+            result.albedo       = select( hit_rec.hit, to_rgb(surf.albedo()), V(0.0) );
+            result.prim_id      = select( hit_rec.hit, hit_rec.prim_id, I(-1) );
+            result.geom_id      = select( hit_rec.hit, hit_rec.geom_id, I(-1) );
+
             for (auto it = params.lights.begin; it != params.lights.end; ++it)
             {
                 auto sr         = make_shade_record<Params, S>();
@@ -65,6 +65,20 @@ inline void spot_light<T>::sample(
     }
 }
 
+template <typename T>
+VSNRAY_FUNC
+inline vector<3, T> spot_light<T>::cl() const
+{
+    return cl_;
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T spot_light<T>::kl() const
+{
+    return kl_;
+}
+
 template <typename T>
 VSNRAY_FUNC
 inline vector<3, T> spot_light<T>::position() const
@@ -178,4 +192,104 @@ inline void spot_light<T>::set_quadratic_attenuation(T att)
     quadratic_attenuation_ = att;
 }
 
+
+namespace simd
+{
+
+//-------------------------------------------------------------------------------------------------
+// pack / unpack spot lights
+//
+// A spot_light<T> with a SIMD type T stores N lights as structure of arrays
+// and evaluates them at once, e.g. against a single hit point
+//
+
+template <size_t N>
+VSNRAY_FUNC
+inline spot_light<float_from_simd_width_t<N>> pack(array<spot_light<float>, N> const& lights)
+{
+    using T = float_from_simd_width_t<N>;
+    using float_array = aligned_array_t<T>;
+
+    array<vector<3, float>, N> cl;
+    array<vector<3, float>, N> position;
+    array<vector<3, float>, N> spot_direction;
+    float_array kl;
+    float_array spot_cutoff;
+    float_array spot_exponent;
+    float_array constant_att;
+    float_array linear_att;
+    float_array quadratic_att;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        cl[i]             = lights[i].cl();
+        position[i]       = lights[i].position();
+        spot_direction[i] = lights[i].spot_direction();
+        kl[i]             = lights[i].kl();
+        spot_cutoff[i]    = lights[i].spot_cutoff();
+        spot_exponent[i]  = lights[i].spot_exponent();
+        constant_att[i]   = lights[i].constant_attenuation();
+        linear_att[i]     = lights[i].linear_attenuation();
+        quadratic_att[i]  = lights[i].quadratic_attenuation();
+    }
+
+    spot_light<T> result;
+    result.set_cl(pack(cl));
+    result.set_kl(T(kl));
+    result.set_position(pack(position));
+    result.set_spot_direction(pack(spot_direction));
+    result.set_spot_cutoff(T(spot_cutoff));
+    result.set_spot_exponent(T(spot_exponent));
+    result.set_constant_attenuation(T(constant_att));
+    result.set_linear_attenuation(T(linear_att));
+    result.set_quadratic_attenuation(T(quadratic_att));
+    return result;
+}
+
+template <
+    typename T,
+    typename = typename std::enable_if<is_simd_vector<T>::value>::type
+    >
+VSNRAY_FUNC
+inline array<spot_light<float>, num_elements<T>::value> unpack(spot_light<T> const& light)
+{
+    using float_array = aligned_array_t<T>;
+
+    auto cl             = unpack(light.cl());
+    auto position       = unpack(light.position());
+    auto spot_direction = unpack(light.spot_direction());
+
+    float_array kl;
+    float_array spot_cutoff;
+    float_array spot_exponent;
+    float_array constant_att;
+    float_array linear_att;
+    float_array quadratic_att;
+
+    store(kl, light.kl());
+    store(spot_cutoff, light.spot_cutoff());
+    store(spot_exponent, light.spot_exponent());
+    store(constant_att, light.constant_attenuation());
+    store(linear_att, light.linear_attenuation());
+    store(quadratic_att, light.quadratic_attenuation());
+
+    array<spot_light<float>, num_elements<T>::value> result;
+
+    for (size_t i = 0; i < num_elements<T>::value; ++i)
+    {
+        result[i].set_cl(cl[i]);
+        result[i].set_kl(kl[i]);
+        result[i].set_position(position[i]);
+        result[i].set_spot_direction(spot_direction[i]);
+        result[i].set_spot_cutoff(spot_cutoff[i]);
+        result[i].set_spot_exponent(spot_exponent[i]);
+        result[i].set_constant_attenuation(constant_att[i]);
+        result[i].set_linear_attenuation(linear_att[i]);
+        result[i].set_quadratic_attenuation(quadratic_att[i]);
+    }
+
+    return result;
+}
+
+} // simd
 } // visionaray
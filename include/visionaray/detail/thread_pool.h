@@ -0,0 +1,231 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_THREAD_POOL_H
+#define VSNRAY_DETAIL_THREAD_POOL_H 1
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cpu_topology.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Pool of render threads that can be shared by several schedulers
+//
+// Jobs consist of a number of work items (e.g. image tiles). Each job signals
+// its completion separately. Jobs take turns (weighted round-robin): a worker
+// takes a number of items from one job that grows with the job's priority
+// (1, 4 and 16 items for Background, Normal and Interactive), then switches
+// to the next job. Lower priority jobs thus get a smaller share of the
+// workers, but are never starved. Items are taken with atomic operations,
+// the queue is only locked when a worker switches jobs or when a job is
+// submitted, completed or cancelled.
+//
+// Idle workers spin for a short while before they go to sleep, so that frames
+// submitted in quick succession (e.g. small interactive frames) don't pay
+// for waking up the threads. Waking up sleeping workers is skipped when no
+// worker is actually asleep.
+//
+// Optionally, workers are pinned to cpus (physical cores first, then SMT
+// siblings). With pinning, the items of each job are split into contiguous
+// ranges, one per NUMA node the workers run on. Workers process the range of
+// their own node first and then help out with the others, unless stealing is
+// disabled for the job. Data that is read or written per item (e.g. the
+// framebuffer) can be placed on the matching nodes with first_touch(), which
+// runs each item on the node that owns it in jobs with the same number of
+// items. cpu_buffer_rt does so per tile when it is constructed with the pool.
+// Only cpus that the process may run on (see sched_getaffinity()) are used.
+//
+
+class thread_pool
+{
+public:
+
+    // Default priorities, higher priorities get a larger share of the workers
+    enum priority
+    {
+        Background  = -1,
+        Normal      =  0,
+        Interactive =  1
+    };
+
+    // Thread affinity
+    enum affinity
+    {
+        NoAffinity, // threads may migrate freely
+        Compact,    // fill up the cores of one NUMA node before using the next
+        Scatter     // distribute threads round-robin over the NUMA nodes
+    };
+
+    struct job
+    {
+        // Contiguous range of items that is preferably processed on one NUMA node
+        struct range
+        {
+            std::atomic<long>       next;
+            long                    end;
+        };
+
+        job(long num_items, int prio = Normal);
+
+        // Process a single work item, called by the worker threads
+        std::function<void(long)>   process_item;
+
+        // Called from the thread that finishes the last item
+        // (or from the thread that cancelled the job)
+        std::function<void()>       complete;
+
+        // Ready after complete() was called
+        std::promise<void>          done;
+
+        // If false, the items of a range are only processed by the workers of
+        // the NUMA node the range belongs to, workers of other nodes don't help out
+        bool                        steal;
+
+        // Set up by submit() (under the pool's mutex)
+        std::unique_ptr<range[]>    ranges;
+        unsigned                    num_ranges;
+
+        // Set by cancel() (under the pool's mutex), a job that was
+        // cancelled before it was submitted completes right away
+        bool                        cancelled;
+
+        std::atomic<long>           item_fin_counter;
+        long const                  item_num;
+        int const                   priority;
+    };
+
+    using job_ptr = std::shared_ptr<job>;
+
+public:
+
+    // spin_count: number of iterations idle workers busy-wait for new jobs
+    // before they go to sleep, 0 disables spinning
+    explicit thread_pool(
+            unsigned num_threads,
+            unsigned spin_count = 4096,
+            affinity aff = NoAffinity
+            );
+   ~thread_pool();
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    // Enqueue a job and return immediately
+    void submit(job_ptr const& j);
+
+    // Drop all items of the job that were not yet picked up by a worker.
+    // Items that are currently being processed are finished. May be called
+    // concurrently with submit(), also before the job was submitted
+    void cancel(job_ptr const& j);
+
+    // Change the number of worker threads. Jobs in flight are resumed
+    // by the new threads
+    void reset(unsigned num_threads);
+
+    unsigned num_threads() const;
+
+    void set_spin_count(unsigned spin_count);
+    unsigned spin_count() const;
+
+    // Number of NUMA nodes the workers are distributed over (1 w/o affinity)
+    unsigned num_nodes() const;
+
+    // NUMA node index [0..num_nodes) of the calling worker thread,
+    // 0 if not called from a worker thread. Can be used to access
+    // data that was replicated per node
+    static unsigned this_thread_node();
+
+    // Call touch(item) for items [0..num_items). Each item is processed by
+    // the NUMA node that processes it in jobs with num_items items, without
+    // help from other nodes, so that on systems with a first-touch policy
+    // the pages that touch() writes to first are placed close to that node.
+    // Call on freshly allocated memory, blocks until done
+    template <typename Touch>
+    void first_touch(long num_items, Touch touch);
+
+    // Initialize count elements with value. The elements are split into one
+    // contiguous range per NUMA node, like the items of jobs are
+    template <typename T>
+    void first_touch(T* data, size_t count, T const& value = T());
+
+private:
+
+    void init_threads(unsigned num_threads);
+    void destroy_threads();
+
+    void worker_loop(unsigned worker_id);
+
+    // Fetch an item from the range of the given node first, then from the
+    // other ranges if the job allows stealing, returns false if no item
+    // is left for the node
+    bool fetch_item(job& j, unsigned node, long& item_idx);
+
+    // True if all items of the job were handed out
+    static bool all_items_issued(job const& j);
+
+    static unsigned& this_thread_node_ref();
+
+    // Busy-wait until epoch_ != epoch or the spin count is exhausted
+    void spin_wait(unsigned long epoch) const;
+
+    // Choose the next job to pick items from and the number of items to
+    // take before switching to another job, mutex must be locked
+    job_ptr next_job(long& quantum);
+
+    // Remove a job from the queue, mutex must be locked
+    void remove_job(job_ptr const& j);
+
+    void finish_items(job_ptr const& j, long num_items);
+
+    std::vector<std::thread>    threads_;
+
+    std::mutex                  mutex_;
+    std::condition_variable     work_available_;
+
+    // Jobs with items left (guarded by mutex_)
+    std::vector<job_ptr>        jobs_;
+
+    // Round-robin counter (guarded by mutex_)
+    unsigned long               next_;
+
+    // Number of workers waiting on work_available_ (guarded by mutex_)
+    unsigned                    num_sleeping_;
+
+    // Incremented (under mutex_) whenever a job was submitted or the
+    // workers shall exit, observed by spinning and busy workers
+    std::atomic<unsigned long>  epoch_;
+
+    std::atomic<unsigned>       spin_count_;
+
+    bool                        exit_;
+
+    affinity                    affinity_;
+
+    // Cpus in the order they are assigned to workers
+    std::vector<detail::cpu_info> cpus_;
+
+    // NUMA node index per cpu in cpus_
+    std::vector<unsigned>       cpu_nodes_;
+
+    unsigned                    num_nodes_;
+
+};
+
+} // visionaray
+
+#include "thread_pool.inl"
+
+#endif // VSNRAY_DETAIL_THREAD_POOL_H
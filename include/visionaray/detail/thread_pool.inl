@@ -0,0 +1,503 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+
+#include <visionaray/math/simd/intrinsics.h>
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Hint to the CPU that we're in a spin-wait loop
+//
+
+inline void cpu_relax()
+{
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_SSE2)
+    _mm_pause();
+#endif
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// thread_pool::job
+//
+
+inline thread_pool::job::job(long num_items, int prio)
+    : steal(true)
+    , num_ranges(0)
+    , cancelled(false)
+    , item_fin_counter(0)
+    , item_num(num_items)
+    , priority(prio)
+{
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// thread_pool
+//
+
+inline thread_pool::thread_pool(unsigned num_threads, unsigned spin_count, affinity aff)
+    : next_(0)
+    , num_sleeping_(0)
+    , epoch_(0)
+    , spin_count_(spin_count)
+    , exit_(false)
+    , affinity_(aff)
+    , num_nodes_(1)
+{
+    if (affinity_ != NoAffinity)
+    {
+        cpus_ = detail::order_cpus(detail::query_cpu_topology(), affinity_ == Scatter);
+    }
+
+    init_threads(num_threads);
+}
+
+inline thread_pool::~thread_pool()
+{
+    destroy_threads();
+}
+
+inline void thread_pool::submit(job_ptr const& j)
+{
+    bool wake = false;
+
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+
+        if (!j->cancelled && j->item_num > 0)
+        {
+            // One range of items per NUMA node
+            j->num_ranges = static_cast<unsigned>(std::min(static_cast<long>(num_nodes_), j->item_num));
+            j->ranges.reset(new job::range[j->num_ranges]);
+
+            for (unsigned i = 0; i < j->num_ranges; ++i)
+            {
+                j->ranges[i].next = j->item_num * i / j->num_ranges;
+                j->ranges[i].end  = j->item_num * (i + 1) / j->num_ranges;
+            }
+
+            jobs_.push_back(j);
+            ++epoch_;
+            wake = num_sleeping_ > 0;
+        }
+    }
+
+    if (j->num_ranges == 0)
+    {
+        // Empty or already cancelled
+        if (j->complete)
+        {
+            j->complete();
+        }
+        j->done.set_value();
+        return;
+    }
+
+    if (wake)
+    {
+        work_available_.notify_all();
+    }
+}
+
+inline void thread_pool::cancel(job_ptr const& j)
+{
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+
+        j->cancelled = true;
+
+        if (j->num_ranges == 0)
+        {
+            // Not yet submitted (or empty), submit() completes the job
+            return;
+        }
+
+        remove_job(j);
+    }
+
+    // Pretend that all items were already handed out, then
+    // account for the ones that no worker will pick up
+    long unissued = 0;
+
+    for (unsigned i = 0; i < j->num_ranges; ++i)
+    {
+        auto& r = j->ranges[i];
+        auto issued = r.next.exchange(r.end);
+
+        if (issued < r.end)
+        {
+            unissued += r.end - issued;
+        }
+    }
+
+    if (unissued > 0)
+    {
+        finish_items(j, unissued);
+    }
+}
+
+inline void thread_pool::reset(unsigned num_threads)
+{
+    if (static_cast<unsigned>(threads_.size()) == num_threads)
+    {
+        return;
+    }
+
+    destroy_threads();
+    init_threads(num_threads);
+}
+
+inline unsigned thread_pool::num_threads() const
+{
+    return static_cast<unsigned>(threads_.size());
+}
+
+inline void thread_pool::set_spin_count(unsigned spin_count)
+{
+    spin_count_ = spin_count;
+}
+
+inline unsigned thread_pool::spin_count() const
+{
+    return spin_count_;
+}
+
+inline unsigned thread_pool::num_nodes() const
+{
+    return num_nodes_;
+}
+
+inline unsigned thread_pool::this_thread_node()
+{
+    return this_thread_node_ref();
+}
+
+inline unsigned& thread_pool::this_thread_node_ref()
+{
+    static thread_local unsigned node = 0;
+    return node;
+}
+
+template <typename Touch>
+void thread_pool::first_touch(long num_items, Touch touch)
+{
+    // Same ranges as other jobs with num_items items (see submit()),
+    // but a page that one node touches first is not touched by another
+    auto j = std::make_shared<job>(num_items, Interactive);
+    j->steal = false;
+    j->process_item = touch;
+
+    auto done = j->done.get_future();
+    submit(j);
+    done.wait();
+}
+
+template <typename T>
+void thread_pool::first_touch(T* data, size_t count, T const& value)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // One item per node
+    long num_items = static_cast<long>(std::min(static_cast<size_t>(num_nodes_), count));
+
+    first_touch(num_items, [=](long item_idx)
+    {
+        size_t first = count * item_idx / num_items;
+        size_t last  = count * (item_idx + 1) / num_items;
+
+        std::fill(data + first, data + last, value);
+    });
+}
+
+inline void thread_pool::init_threads(unsigned num_threads)
+{
+    // Map the NUMA nodes of the cpus that are actually used to [0..num_nodes)
+    cpu_nodes_.assign(cpus_.size(), 0);
+    num_nodes_ = 1;
+
+    if (!cpus_.empty())
+    {
+        size_t num_used = std::min(static_cast<size_t>(num_threads), cpus_.size());
+
+        std::vector<int> nodes;
+
+        for (size_t i = 0; i < num_used; ++i)
+        {
+            nodes.push_back(cpus_[i].node);
+        }
+
+        std::sort(nodes.begin(), nodes.end());
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+        for (size_t i = 0; i < cpus_.size(); ++i)
+        {
+            auto it = std::find(nodes.begin(), nodes.end(), cpus_[i].node);
+
+            if (it != nodes.end())
+            {
+                cpu_nodes_[i] = static_cast<unsigned>(it - nodes.begin());
+            }
+        }
+
+        num_nodes_ = static_cast<unsigned>(std::max(size_t(1), nodes.size()));
+    }
+
+    for (unsigned i = 0; i < num_threads; ++i)
+    {
+        threads_.emplace_back([this, i](){ worker_loop(i); });
+    }
+}
+
+inline void thread_pool::destroy_threads()
+{
+    if (threads_.size() == 0)
+    {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        exit_ = true;
+        ++epoch_;
+    }
+    work_available_.notify_all();
+
+    for (auto& t : threads_)
+    {
+        if (t.joinable())
+        {
+            t.join();
+        }
+    }
+
+    exit_ = false;
+    threads_.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+// Main worker loop
+//
+
+inline void thread_pool::worker_loop(unsigned worker_id)
+{
+    unsigned node = 0;
+
+    if (!cpus_.empty())
+    {
+        size_t i = worker_id % cpus_.size();
+        detail::pin_this_thread(cpus_[i].cpu);
+        node = cpu_nodes_[i];
+    }
+
+    this_thread_node_ref() = node;
+
+    // Job the worker currently takes items from, number of items it may
+    // still take before it has to switch, and epoch_ when it was chosen
+    job_ptr j;
+    long quantum = 0;
+    unsigned long epoch = 0;
+
+    for (;;)
+    {
+        long item_idx = 0;
+
+        // Fast path w/o locking: next item of the current job
+        bool switch_job = !j || quantum <= 0 || epoch_.load(std::memory_order_relaxed) != epoch;
+        bool exhausted = !switch_job && !fetch_item(*j, node, item_idx);
+
+        if (switch_job || exhausted)
+        {
+            std::unique_lock<std::mutex> l(mutex_);
+
+            if (exhausted && all_items_issued(*j))
+            {
+                // All items were handed out, other workers are finishing the job
+                remove_job(j);
+            }
+
+            j.reset();
+
+            while (!j)
+            {
+                if (!exit_ && jobs_.empty())
+                {
+                    auto e = epoch_.load();
+
+                    l.unlock();
+                    spin_wait(e);
+                    l.lock();
+
+                    ++num_sleeping_;
+                    work_available_.wait(l, [this]() { return exit_ || !jobs_.empty(); });
+                    --num_sleeping_;
+                }
+
+                if (exit_)
+                {
+                    return;
+                }
+
+                epoch = epoch_.load();
+
+                auto candidate = next_job(quantum);
+
+                if (fetch_item(*candidate, node, item_idx))
+                {
+                    j = candidate;
+                }
+                else if (all_items_issued(*candidate))
+                {
+                    remove_job(candidate);
+                }
+                else
+                {
+                    // Only items of other nodes are left (job w/o stealing),
+                    // let their workers pick them up
+                    l.unlock();
+                    std::this_thread::yield();
+                    l.lock();
+                }
+            }
+        }
+
+        --quantum;
+
+        j->process_item(item_idx);
+
+        finish_items(j, 1);
+    }
+}
+
+inline void thread_pool::spin_wait(unsigned long epoch) const
+{
+    unsigned n = spin_count_;
+
+    for (unsigned i = 0; i < n; ++i)
+    {
+        if (epoch_.load(std::memory_order_relaxed) != epoch)
+        {
+            return;
+        }
+
+        // Give other threads a chance when the cores are oversubscribed
+        if ((i & 63) == 63)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            detail::cpu_relax();
+        }
+    }
+}
+
+inline bool thread_pool::fetch_item(job& j, unsigned node, long& item_idx)
+{
+    unsigned num_ranges = j.steal ? j.num_ranges : std::min(j.num_ranges, 1U);
+
+    for (unsigned i = 0; i < num_ranges; ++i)
+    {
+        auto& r = j.ranges[(node + i) % j.num_ranges];
+
+        if (r.next.load(std::memory_order_relaxed) >= r.end)
+        {
+            continue;
+        }
+
+        item_idx = r.next.fetch_add(1);
+
+        if (item_idx < r.end)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline bool thread_pool::all_items_issued(job const& j)
+{
+    for (unsigned i = 0; i < j.num_ranges; ++i)
+    {
+        if (j.ranges[i].next.load(std::memory_order_relaxed) < j.ranges[i].end)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline thread_pool::job_ptr thread_pool::next_job(long& quantum)
+{
+    assert(!jobs_.empty());
+
+    if (jobs_.size() == 1)
+    {
+        // Keep going until another job is submitted
+        quantum = std::numeric_limits<long>::max();
+        return jobs_[0];
+    }
+
+    auto const& j = jobs_[next_++ % jobs_.size()];
+
+    // Background: 1, Normal: 4, Interactive: 16 items per turn
+    int shift = std::min(std::max(2 * (j->priority - Background), 0), 16);
+    quantum = 1L << shift;
+
+    return j;
+}
+
+inline void thread_pool::remove_job(job_ptr const& j)
+{
+    auto it = std::find(jobs_.begin(), jobs_.end(), j);
+
+    if (it != jobs_.end())
+    {
+        jobs_.erase(it);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Mark items as finished, the thread that finishes the last item completes the job
+//
+
+inline void thread_pool::finish_items(job_ptr const& j, long num_items)
+{
+    auto num_items_fin = j->item_fin_counter.fetch_add(num_items) + num_items;
+
+    if (num_items_fin < j->item_num)
+    {
+        return;
+    }
+
+    assert(num_items_fin == j->item_num);
+
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        remove_job(j);
+    }
+
+    if (j->complete)
+    {
+        j->complete();
+    }
+
+    j->done.set_value();
+}
+
+} // visionaray
@@ -6,8 +6,11 @@
 #ifndef VSNRAY_DETAIL_TILED_SCHED_H
 #define VSNRAY_DETAIL_TILED_SCHED_H 1
 
+#include <future>
 #include <memory>
 
+#include "thread_pool.h"
+
 namespace visionaray
 {
 
@@ -16,14 +19,53 @@ class tiled_sched
 {
 public:
 
+    // Frames are split into tiles of this size, one work item per tile in
+    // row-major order (cf. cpu_buffer_rt, which places its pages per tile)
+    static const int tile_width  = 16;
+    static const int tile_height = 16;
+
+public:
+
+    // Create a scheduler with its own thread pool
     explicit tiled_sched(unsigned num_threads);
+
+    // Create a scheduler that submits its frames to a thread pool that is
+    // shared with other schedulers. Tiles of frames from different schedulers
+    // are interleaved, higher priorities get a larger share of the workers
+    explicit tiled_sched(std::shared_ptr<thread_pool> pool, int priority = thread_pool::Normal);
+
    ~tiled_sched();
 
+    // Render a frame, returns when all tiles were processed.
     template <typename K, typename SP>
     void frame(K kernel, SP sched_params, unsigned frame_num = 0);
 
+    // Submit a frame and return immediately. If another frame of this
+    // scheduler is still in flight, blocks until that one is done.
+    // Waiting on the returned future (wait() or get()) blocks until all
+    // tiles were processed or the frame was cancelled, and then calls
+    // rt.end_frame() and cam.end_frame() on the waiting thread. The future
+    // is deferred, i.e. wait_for() and wait_until() don't wait and return
+    // std::future_status::deferred. If the future is dropped without
+    // waiting on it, the next call to frame_async() or frame() calls
+    // end_frame() of the last frame before begin_frame(), so that the
+    // render target and the camera see alternating begin/end calls.
+    template <typename K, typename SP>
+    std::future<void> frame_async(K kernel, SP sched_params, unsigned frame_num = 0);
+
+    // Drop all tiles of the frame in flight that were not yet picked up by
+    // a worker thread. Tiles that are currently being rendered are finished.
+    void cancel();
+
+    // Change the number of worker threads (of the shared pool, if any)
     void reset(unsigned num_threads);
 
+    // Priority of frames submitted after this call
+    void set_priority(int priority);
+    int priority() const;
+
+    std::shared_ptr<thread_pool> const& pool() const;
+
 private:
 
     struct impl;
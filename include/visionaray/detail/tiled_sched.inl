@@ -1,12 +1,11 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
-#include <atomic>
-#include <cassert>
 #include <condition_variable>
 #include <functional>
+#include <future>
+#include <memory>
 #include <mutex>
-#include <thread>
 #include <type_traits>
 #include <utility>
 
@@ -15,36 +14,10 @@
 
 #include "macros.h"
 #include "sched_common.h"
-#include "semaphore.h"
 
 namespace visionaray
 {
 
-namespace detail
-{
-
-struct sync_params
-{
-    sync_params()
-        : render_loop_exit(false)
-    {
-    }
-
-    std::mutex mutex;
-    std::condition_variable threads_start;
-    visionaray::semaphore   threads_ready;
-
-    std::atomic<long>       tile_idx_counter;
-    std::atomic<long>       tile_fin_counter;
-    std::atomic<long>       tile_num;
-
-    std::atomic<bool>       render_loop_exit;
-};
-
-
-} // detail
-
-
 //-------------------------------------------------------------------------------------------------
 // Private implementation
 //
@@ -53,15 +26,16 @@ template <typename R>
 struct tiled_sched<R>::impl
 {
     // TODO: any sampler
-    typedef std::function<void(recti const&, random_sampler<typename R::scalar_type>&)> render_tile_func;
-
-    void init_threads(unsigned num_threads);
-    void destroy_threads();
+    typedef std::function<void(long, random_sampler<typename R::scalar_type>&)> render_tile_func;
 
-    void render_loop();
+    impl(std::shared_ptr<thread_pool> p, int prio)
+        : pool(p)
+        , priority(prio)
+    {
+    }
 
     template <typename K, typename SP>
-    void init_render_func(K kernel, SP sparams, unsigned frame_num);
+    render_tile_func make_render_func(K kernel, SP sparams, unsigned frame_num);
 
     template <typename K, typename SP, typename Sampler, typename ...Args>
     void call_sample_pixel(
@@ -121,122 +95,63 @@ struct tiled_sched<R>::impl
                 );
     }
 
-    std::vector<std::thread>    threads;
-    detail::sync_params         sync_params;
-
-    int                         width;
-    int                         height;
-    static const int            tile_width  = 16;
-    static const int            tile_height = 16;
-    recti                       scissor_box;
-
-    render_tile_func            render_tile;
-};
-
-template <typename R>
-void tiled_sched<R>::impl::init_threads(unsigned num_threads)
-{
-    for (unsigned i = 0; i < num_threads; ++i)
-    {
-        threads.emplace_back([this](){ render_loop(); });
-    }
-}
-
-template <typename R>
-void tiled_sched<R>::impl::destroy_threads()
-{
-    if (threads.size() == 0)
+    // rt.end_frame() and cam.end_frame() of a submitted frame, called once: by
+    // the thread that waits on the frame's future, or by the next frame_async()
+    struct end_frame_call
     {
-        return;
-    }
+        std::once_flag          flag;
+        std::function<void()>   func;
 
-    sync_params.render_loop_exit = true;
-    sync_params.threads_start.notify_all();
-
-    for (auto& t : threads)
-    {
-        if (t.joinable())
-        {
-            t.join();
-        }
-    }
-
-    sync_params.render_loop_exit = false;
-    threads.clear();
-}
-
-//-------------------------------------------------------------------------------------------------
-// Main render loop
-//
-
-template <typename R>
-void tiled_sched<R>::impl::render_loop()
-{
-    for (;;)
-    {
+        void run()
         {
-            std::unique_lock<std::mutex> l( sync_params.mutex );
-            sync_params.threads_start.wait(l);
+            std::call_once(flag, func);
         }
+    };
 
-    // case event.exit:
-        if (sync_params.render_loop_exit)
-        {
-            break;
-        }
-
-    // case event.render:
-        random_sampler<typename R::scalar_type> samp(detail::tic());
-        for (;;)
-        {
-            auto tile_idx = sync_params.tile_idx_counter.fetch_add(1);
-
-            if (tile_idx >= sync_params.tile_num)
-            {
-                break;
-            }
-
-            auto tilew = tile_width;
-            auto tileh = tile_height;
-            auto numtilesx = div_up( width, tilew );
+    std::shared_ptr<thread_pool> pool;
+    int                         priority;
 
-            recti tile(
-                    (tile_idx % numtilesx) * tilew,
-                    (tile_idx / numtilesx) * tileh,
-                    tilew,
-                    tileh
-                    );
+    std::mutex                  mutex;
+    std::condition_variable     frame_done;
 
-            render_tile(tile, samp);
+    // The frame in flight, nullptr if idle (guarded by mutex)
+    thread_pool::job_ptr        job;
 
-            auto num_tiles_fin = sync_params.tile_fin_counter.fetch_add(1);
+    // end_frame() of the last frame, may still be pending (guarded by mutex)
+    std::shared_ptr<end_frame_call> last_end_frame;
 
-            if (num_tiles_fin >= sync_params.tile_num - 1)
-            {
-                assert(num_tiles_fin == sync_params.tile_num - 1);
-                sync_params.threads_ready.notify();
-                break;
-            }
-        }
-    }
-}
+    static const int            tile_width  = tiled_sched<R>::tile_width;
+    static const int            tile_height = tiled_sched<R>::tile_height;
+};
 
 template <typename R>
 template <typename K, typename SP>
-void tiled_sched<R>::impl::init_render_func(K kernel, SP sparams, unsigned frame_num)
+typename tiled_sched<R>::impl::render_tile_func tiled_sched<R>::impl::make_render_func(
+        K           kernel,
+        SP          sparams,
+        unsigned    frame_num
+        )
 {
     using T = typename R::scalar_type;
 
-    width       = sparams.rt.width();
-    height      = sparams.rt.height();
-    scissor_box = sparams.scissor_box;
+    auto tilew = tile_width;
+    auto tileh = tile_height;
+    auto numtilesx = div_up( sparams.rt.width(), tilew );
+    auto scissor_box = sparams.scissor_box;
 
     recti clip_rect(scissor_box.x, scissor_box.y, scissor_box.w - 1, scissor_box.h - 1);
 
-    render_tile = [=](recti const& tile, random_sampler<T>& samp)
+    return [=](long tile_idx, random_sampler<T>& samp)
     {
-        unsigned numx = tile_width  / packet_size<T>::w;
-        unsigned numy = tile_height / packet_size<T>::h;
+        recti tile(
+                (tile_idx % numtilesx) * tilew,
+                (tile_idx / numtilesx) * tileh,
+                tilew,
+                tileh
+                );
+
+        unsigned numx = tilew / packet_size<T>::w;
+        unsigned numy = tileh / packet_size<T>::h;
         for (unsigned i = 0; i < numx * numy; ++i)
         {
             auto pos = vec2i(i % numx, i / numx);
@@ -273,56 +188,154 @@ void tiled_sched<R>::impl::init_render_func(K kernel, SP sparams, unsigned frame
 
 template <typename R>
 tiled_sched<R>::tiled_sched(unsigned num_threads)
-    : impl_(new impl())
+    : impl_(new impl(std::make_shared<thread_pool>(num_threads), thread_pool::Normal))
+{
+}
+
+template <typename R>
+tiled_sched<R>::tiled_sched(std::shared_ptr<thread_pool> pool, int priority)
+    : impl_(new impl(pool, priority))
 {
-    impl_->init_threads(num_threads);
 }
 
 template <typename R>
 tiled_sched<R>::~tiled_sched()
 {
-    impl_->destroy_threads();
+    cancel();
+
+    // Workers of a shared pool may still be busy with the last tiles
+    std::unique_lock<std::mutex> l( impl_->mutex );
+    impl_->frame_done.wait(l, [this]() { return !impl_->job; });
 }
 
 template <typename R>
 template <typename K, typename SP>
 void tiled_sched<R>::frame(K kernel, SP sched_params, unsigned frame_num)
 {
+    frame_async(kernel, sched_params, frame_num).wait();
+}
+
+template <typename R>
+template <typename K, typename SP>
+std::future<void> tiled_sched<R>::frame_async(K kernel, SP sched_params, unsigned frame_num)
+{
+    using T = typename R::scalar_type;
+
+    // Only one frame per scheduler in flight at a time
+    std::shared_ptr<typename impl::end_frame_call> last_end_frame;
+
+    {
+        std::unique_lock<std::mutex> l( impl_->mutex );
+        impl_->frame_done.wait(l, [this]() { return !impl_->job; });
+        last_end_frame = std::move(impl_->last_end_frame);
+    }
+
+    // The future of the last frame may have been dropped without waiting
+    // on it, begin_frame() and end_frame() have to alternate
+    if (last_end_frame)
+    {
+        last_end_frame->run();
+    }
+
     sched_params.cam.begin_frame();
 
     sched_params.rt.begin_frame();
 
-    impl_->init_render_func(kernel, sched_params, frame_num);
+    auto tilew = impl::tile_width;
+    auto tileh = impl::tile_height;
+    auto numtilesx = div_up(sched_params.rt.width(),  tilew);
+    auto numtilesy = div_up(sched_params.rt.height(), tileh);
 
-    auto numtilesx = div_up(impl_->width,  impl_->tile_width);
-    auto numtilesy = div_up(impl_->height, impl_->tile_height);
+    auto j = std::make_shared<thread_pool::job>(numtilesx * numtilesy, impl_->priority);
 
-    auto& sparams = impl_->sync_params;
+    // Same for all tiles, so that the frame number alone doesn't correlate
+    // the random sequences of subsequent (e.g. non-progressive) frames
+    auto frame_id = detail::tic() + frame_num;
 
-    sparams.tile_idx_counter = 0;
-    sparams.tile_fin_counter = 0;
-    sparams.tile_num = numtilesx * numtilesy;
+    auto render_tile = impl_->make_render_func(kernel, sched_params, frame_num);
+    j->process_item = [render_tile, frame_id](long tile_idx)
+    {
+        random_sampler<T> samp(detail::make_seed(frame_id, static_cast<unsigned>(tile_idx)));
+        render_tile(tile_idx, samp);
+    };
 
-    // render frame
-    sparams.threads_start.notify_all();
+    auto i = impl_.get();
+    j->complete = [i]()
+    {
+        // Notify under the lock, the scheduler may be destroyed right after
+        std::unique_lock<std::mutex> l( i->mutex );
+        i->job.reset();
+        i->frame_done.notify_all();
+    };
 
-    sparams.threads_ready.wait();
+    auto tiles_done = j->done.get_future().share();
 
-    sched_params.rt.end_frame();
+    auto end_frame = std::make_shared<typename impl::end_frame_call>();
+    end_frame->func = [sched_params]() mutable
+    {
+        sched_params.rt.end_frame();
 
-    sched_params.cam.end_frame();
+        sched_params.cam.end_frame();
+    };
+
+    // Publish the job before it is submitted, a concurrent cancel() is
+    // recorded by the pool and the job then completes in submit()
+    {
+        std::unique_lock<std::mutex> l( impl_->mutex );
+        impl_->job = j;
+        impl_->last_end_frame = end_frame;
+    }
+
+    impl_->pool->submit(j);
+
+    // end_frame() is called on the thread that waits for the frame (usually
+    // the one that called begin_frame(), e.g. the thread with the GL context)
+    return std::async(std::launch::deferred, [tiles_done, end_frame]()
+    {
+        tiles_done.wait();
+
+        end_frame->run();
+    });
 }
 
 template <typename R>
-void tiled_sched<R>::reset(unsigned num_threads)
+void tiled_sched<R>::cancel()
 {
-    if (static_cast<unsigned>(impl_->threads.size()) == num_threads)
+    thread_pool::job_ptr j;
+
     {
-        return;
+        std::unique_lock<std::mutex> l( impl_->mutex );
+        j = impl_->job;
     }
 
-    impl_->destroy_threads();
-    impl_->init_threads(num_threads);
+    if (j)
+    {
+        impl_->pool->cancel(j);
+    }
+}
+
+template <typename R>
+void tiled_sched<R>::reset(unsigned num_threads)
+{
+    impl_->pool->reset(num_threads);
+}
+
+template <typename R>
+void tiled_sched<R>::set_priority(int priority)
+{
+    impl_->priority = priority;
+}
+
+template <typename R>
+int tiled_sched<R>::priority() const
+{
+    return impl_->priority;
+}
+
+template <typename R>
+std::shared_ptr<thread_pool> const& tiled_sched<R>::pool() const
+{
+    return impl_->pool;
 }
 
 } // visionaray
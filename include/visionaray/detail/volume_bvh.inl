@@ -0,0 +1,333 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <type_traits>
+
+#include <visionaray/math/simd/type_traits.h>
+
+#include "stack.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Smallest value of all lanes
+//
+
+VSNRAY_FUNC
+inline float reduce_min(float x)
+{
+    return x;
+}
+
+template <typename T, typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+inline float reduce_min(T const& x)
+{
+    simd::aligned_array_t<T> arr;
+    store(arr, x);
+
+    float result = arr[0];
+
+    for (size_t i = 1; i < simd::num_elements<T>::value; ++i)
+    {
+        result = arr[i] < result ? arr[i] : result;
+    }
+
+    return result;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// volume_bounds
+//
+
+inline volume_bounds make_volume_bounds(unsigned id, aabb const& local_bounds, mat4 const& transform)
+{
+    volume_bounds result;
+    result.geom_id = 0;
+    result.prim_id = id;
+    result.local_bounds = local_bounds;
+    result.transform_inv = inverse(transform);
+    return result;
+}
+
+inline aabb get_bounds(volume_bounds const& vb)
+{
+    mat4 transform = inverse(vb.transform_inv);
+
+    aabb result;
+    result.invalidate();
+
+    for (auto v : compute_vertices(vb.local_bounds))
+    {
+        result.insert((transform * vec4(v, 1.0f)).xyz());
+    }
+
+    return result;
+}
+
+inline void split_primitive(aabb& L, aabb& R, float plane, int axis, volume_bounds const& vb)
+{
+    aabb bounds = get_bounds(vb);
+
+    L.invalidate();
+    R.invalidate();
+
+    if (plane <= bounds.min[axis])
+    {
+        R = bounds;
+    }
+    else if (plane >= bounds.max[axis])
+    {
+        L = bounds;
+    }
+    else
+    {
+        L = bounds;
+        R = bounds;
+
+        L.max[axis] = plane;
+        R.min[axis] = plane;
+    }
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline hit_record<basic_ray<T>, aabb> intersect(basic_ray<T> const& ray, volume_bounds const& vb)
+{
+    using M = matrix<4, 4, T>;
+
+    // The direction is not normalized, so that t is the same in object space
+    basic_ray<T> local_ray;
+    local_ray.ori = (M(vb.transform_inv) * vector<4, T>(ray.ori, T(1.0))).xyz();
+    local_ray.dir = (M(vb.transform_inv) * vector<4, T>(ray.dir, T(0.0))).xyz();
+
+    return intersect(local_ray, vb.local_bounds);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Multi-hit traversal
+//
+
+template <size_t N, typename T, typename BVH>
+VSNRAY_FUNC
+inline size_t intersect_volumes(
+        basic_ray<T> const& ray,
+        BVH const&          bvh,
+        volume_interval<T>  (&intervals)[N],
+        T                   tmin,
+        T                   tmax
+        )
+{
+    static_assert(N > 0, "Size mismatch");
+
+    // Number of stored intervals and number of overlapping volumes
+    size_t count = 0;
+    size_t total = 0;
+
+    if (bvh.num_nodes() == 0)
+    {
+        return total;
+    }
+
+    detail::stack<32> st;
+    st.push(0); // address of root node
+
+    auto inv_dir = T(1.0) / ray.dir;
+
+next:
+    while (!st.empty())
+    {
+        auto node = bvh.node(st.pop());
+
+        // All hits are needed, children are visited in any order
+        while (!is_leaf(node))
+        {
+            auto children = &bvh.node(node.get_child(0));
+
+            auto hr1 = intersect(ray, children[0].get_bounds(), inv_dir);
+            auto hr2 = intersect(ray, children[1].get_bounds(), inv_dir);
+
+            auto b1 = any( hr1.hit && hr1.tfar >= tmin && hr1.tnear < tmax );
+            auto b2 = any( hr2.hit && hr2.tfar >= tmin && hr2.tnear < tmax );
+
+            if (b1 && b2)
+            {
+                st.push(node.get_child(1));
+                node = children[0];
+            }
+            else if (b1)
+            {
+                node = children[0];
+            }
+            else if (b2)
+            {
+                node = children[1];
+            }
+            else
+            {
+                goto next;
+            }
+        }
+
+        for (auto i = node.get_indices().first; i != node.get_indices().last; ++i)
+        {
+            auto const& prim = bvh.primitive(i);
+
+            auto hr = intersect(ray, prim);
+            auto valid = hr.hit && hr.tfar > tmin && hr.tnear < tmax;
+
+            if (!any(valid))
+            {
+                continue;
+            }
+
+            volume_interval<T> iv;
+            iv.tnear = select(valid, max(hr.tnear, tmin),  numeric_limits<T>::max());
+            iv.tfar  = select(valid, min(hr.tfar, tmax),  -numeric_limits<T>::max());
+            iv.id    = prim.prim_id;
+
+            ++total;
+
+            // Insertion sort, drop the farthest interval if the array is full
+            float key = detail::reduce_min(iv.tnear);
+
+            if (count == N && key >= detail::reduce_min(intervals[N - 1].tnear))
+            {
+                continue;
+            }
+
+            size_t j = count < N ? count++ : N - 1;
+
+            while (j > 0 && detail::reduce_min(intervals[j - 1].tnear) > key)
+            {
+                intervals[j] = intervals[j - 1];
+                --j;
+            }
+
+            intervals[j] = iv;
+        }
+    }
+
+    return total;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Interval-merged ray marching
+//
+
+template <typename T, typename Sample>
+VSNRAY_FUNC
+inline vector<4, T> integrate_volumes(
+        volume_interval<T> const*   intervals,
+        size_t                      count,
+        float                       delta,
+        Sample const&               sample,
+        float                       opacity_threshold
+        )
+{
+    using C = vector<4, T>;
+
+    C dst(0.0f);
+
+    T t0   =  numeric_limits<T>::max();
+    T tmax = -numeric_limits<T>::max();
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        t0   = min(t0, intervals[i].tnear);
+        tmax = max(tmax, intervals[i].tfar);
+    }
+
+    // Samples are taken at t0 + k * delta
+    T k(0.0);
+    T t = t0;
+
+    auto active = t < tmax;
+
+    // Intervals before first were left by all active lanes
+    size_t first = 0;
+
+    while (any(active))
+    {
+        while (first < count && all(t >= intervals[first].tfar || !active))
+        {
+            ++first;
+        }
+
+        C color(0.0f);
+        simd::mask_type_t<T> inside_any(false);
+
+        for (size_t i = first; i < count; ++i)
+        {
+            auto const& iv = intervals[i];
+
+            // Intervals are sorted, all of the following ones start later
+            if (all(t < T(detail::reduce_min(iv.tnear)) || !active))
+            {
+                break;
+            }
+
+            auto inside = active && t >= iv.tnear && t < iv.tfar;
+
+            if (!any(inside))
+            {
+                continue;
+            }
+
+            C colori = sample(iv.id, t);
+
+            // premultiplied alpha
+            colori.xyz() *= colori.w;
+
+            color += select(inside, colori, C(0.0f));
+            inside_any = inside_any || inside;
+        }
+
+        // Overlapping volumes may add up to an opacity greater than one
+        color = select(color.w > T(1.0), color / color.w, color);
+
+        // front-to-back alpha compositing
+        dst += select(active, color * (1.0f - dst.w), C(0.0f));
+
+        // Step on, lanes outside of all intervals jump to the next entry point
+        T k_next = k + T(1.0);
+
+        auto gap = active && !inside_any;
+
+        if (any(gap))
+        {
+            T t_entry = numeric_limits<T>::max();
+
+            for (size_t i = first; i < count; ++i)
+            {
+                t_entry = select(intervals[i].tnear > t, min(t_entry, intervals[i].tnear), t_entry);
+            }
+
+            k_next = select(
+                    gap && t_entry < tmax,
+                    max(ceil((t_entry - t0) / delta), k_next),
+                    k_next
+                    );
+
+            // No more intervals
+            active = active && !(gap && t_entry >= tmax);
+        }
+
+        k = k_next;
+        t = t0 + k * delta;
+
+        // early-ray termination
+        active = active && t < tmax && dst.w < opacity_threshold;
+    }
+
+    return dst;
+}
+
+} // visionaray
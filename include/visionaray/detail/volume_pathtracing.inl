@@ -0,0 +1,388 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_VOLUME_PATHTRACING_INL
+#define VSNRAY_DETAIL_VOLUME_PATHTRACING_INL 1
+
+#include <cstddef>
+
+#include <visionaray/math/constants.h>
+#include <visionaray/math/intersect.h>
+#include <visionaray/math/limits.h>
+#include <visionaray/get_surface.h>
+#include <visionaray/participating_medium.h>
+#include <visionaray/result_record.h>
+#include <visionaray/shade_record.h>
+#include <visionaray/spectrum.h>
+#include <visionaray/traverse.h>
+
+#include "pathtracing.inl"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Scattering in the medium, with the interface of surfaces that estimate_direct_light()
+// uses. The phase function replaces BRDF * cos(theta)
+//
+
+template <typename S>
+struct medium_scattering
+{
+    float g;
+
+    template <typename SR>
+    VSNRAY_FUNC spectrum<S> shade(SR const& sr) const
+    {
+        return spectrum<S>(
+                constants::pi<S>()
+              * pdf(sr)
+              * spectrum<S>(from_rgb(sr.light.intensity(sr.isect_pos)))
+                );
+    }
+
+    template <typename SR, size_t N>
+    VSNRAY_FUNC vector<N, S> shade(spectral_shade_record<SR, N> const& sr) const
+    {
+        return from_rgb(sr.light.intensity(sr.isect_pos), sr.wavelengths)
+             * (constants::pi<S>() * pdf(sr));
+    }
+
+    template <typename SR>
+    VSNRAY_FUNC S pdf(SR const& sr) const
+    {
+        return henyey_greenstein(dot(-sr.view_dir, sr.light_dir), g);
+    }
+};
+
+// Media scatter in all directions
+template <typename S>
+VSNRAY_FUNC
+inline simd::mask_type_t<S> faces_light(
+        medium_scattering<S> const& /* */,
+        vector<3, S> const&         /* */,
+        vector<3, S> const&         /* */
+        )
+{
+    return simd::mask_type_t<S>(true);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Transmittance of shadow rays through the medium (ratio tracking)
+//
+
+template <typename Medium>
+struct medium_transmittance
+{
+    Medium const& medium;
+
+    template <typename S, typename M, typename Sampler>
+    VSNRAY_FUNC S operator()(basic_ray<S> const& ray, S const& max_t, M const& active, Sampler& samp) const
+    {
+        auto hr = intersect(ray, medium.bbox);
+
+        S t0 = max(hr.tnear, S(0.0));
+        S t1 = min(hr.tfar, max_t);
+
+        return ratio_tracking(medium, ray, t0, t1, active & hr.hit, samp);
+    }
+};
+
+} // detail
+
+
+namespace volume_pathtracing
+{
+
+//-------------------------------------------------------------------------------------------------
+// Path tracing of surfaces inside a participating medium
+//
+// Params are the kernel_params of pathtracing::kernel (surfaces, materials and lights,
+// the options sample_lights, russian_roulette and spectral are supported), Medium is a
+// participating_medium. Distances to collisions with the medium are sampled with delta
+// tracking, scattered paths continue in a direction that is sampled from the phase
+// function and are weighted with the albedo of the medium. With sample_lights, the
+// lights are also sampled at scattering events, shadow rays are attenuated by the
+// transmittance of the medium (ratio tracking).
+//
+// Primary rays that neither hit a surface nor scatter in the medium return bg_color,
+// scattered paths that leave the scene are multiplied by ambient_color, as with
+// pathtracing::kernel
+//
+
+template <typename Params, typename Medium>
+struct kernel
+{
+
+    Params params;
+    Medium medium;
+
+    template <typename Intersector, typename R, typename Sampler>
+    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(
+            Intersector& isect,
+            R ray,
+            Sampler& s
+            ) const
+    {
+        using S = typename R::scalar_type;
+
+        if (params.spectral)
+        {
+            detail::hero_wavelength_transport<S> transport(s.next());
+            return trace(transport, isect, ray, s);
+        }
+        else
+        {
+            detail::spectrum_transport<S> transport;
+            return trace(transport, isect, ray, s);
+        }
+    }
+
+    template <typename R, typename Sampler>
+    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(
+            R ray,
+            Sampler& s
+            ) const
+    {
+        default_intersector ignore;
+        return (*this)(ignore, ray, s);
+    }
+
+private:
+
+    template <typename Transport, typename Intersector, typename R, typename Sampler>
+    VSNRAY_FUNC result_record<typename R::scalar_type> trace(
+            Transport const& transport,
+            Intersector& isect,
+            R ray,
+            Sampler& s
+            ) const
+    {
+        using S = typename R::scalar_type;
+        using I = typename result_record<S>::int_type;
+        using V = typename result_record<S>::vec_type;
+        using T = typename Transport::value_type;
+
+        simd::mask_type_t<S> active_rays = true;
+
+        T dst(S(1.0));
+
+        // Contribution of explicitly sampled lights (sample_lights only)
+        T direct(S(0.0));
+
+        // pdf of the BRDF or phase function sample that generated the current ray,
+        // 0 for primary rays and specular reflection (sample_lights only)
+        S prev_pdf(0.0);
+
+        detail::medium_scattering<S> phase = { medium.g };
+        detail::medium_transmittance<Medium> transmittance = { medium };
+
+        T albedo  = transport.from_rgb(V(medium.albedo));
+        T ambient = transport.from_rgb(V(params.ambient_color.xyz() * params.ambient_color.w));
+
+        result_record<S> result;
+        result.color = params.bg_color;
+
+        for (unsigned bounce = 0; bounce < params.num_bounces; ++bounce)
+        {
+            auto hit_rec = closest_hit(ray, params.prims.begin, params.prims.end, isect);
+
+            // Sample a collision with the medium in front of the closest surface
+            auto box_rec = intersect(ray, medium.bbox);
+
+            S t_surf = select( hit_rec.hit, hit_rec.t, numeric_limits<S>::max() );
+            S t0     = max( box_rec.tnear, S(0.0) );
+            S t1     = min( box_rec.tfar, t_surf );
+
+            auto in_medium = active_rays & box_rec.hit & (t0 < t1);
+
+            S tc = delta_tracking(medium, ray, t0, t1, in_medium, s);
+
+            auto scattered = in_medium & (tc < t1);
+            auto surface   = active_rays & hit_rec.hit & !scattered;
+
+            // Handle rays that just exited
+            auto exited = active_rays & !hit_rec.hit & !scattered;
+            dst = mul( dst, ambient, exited, dst );
+
+
+            // Exit if no ray is active anymore
+            active_rays &= hit_rec.hit | scattered;
+
+            if (!any(active_rays))
+            {
+                break;
+            }
+
+            // Special handling for first bounce
+            if (bounce == 0)
+            {
+                result.hit = hit_rec.hit | scattered;
+                result.isect_pos = ray.ori + ray.dir * select( scattered, tc, hit_rec.t );
+            }
+
+
+            // Process the current bounce
+
+            V medium_pos = ray.ori + ray.dir * tc;
+            V view_dir = -ray.dir;
+
+            if (bounce == 0)
+            {
+                // AOVs of the first hit, overwritten below for surface hits
+                result.normal   = V(0.0);
+                result.albedo   = select( scattered, V(medium.albedo), V(0.0) );
+                result.prim_id  = I(-1);
+                result.geom_id  = I(-1);
+            }
+
+
+            // Surface interactions
+
+            V refl_dir(0.0);
+
+            // Scalar rays that scattered have no surface to query
+            if (any(surface))
+            {
+                hit_rec.isect_pos = ray.ori + ray.dir * hit_rec.t;
+
+                auto surf = get_surface(hit_rec, params);
+
+                auto n = surf.shading_normal;
+
+#if 1 // two-sided
+                n = faceforward( n, view_dir, surf.geometric_normal );
+#endif
+
+                if (bounce == 0)
+                {
+                    result.normal   = select( surface, n, result.normal );
+                    result.albedo   = select( surface, to_rgb(surf.albedo()), result.albedo );
+                    result.prim_id  = select( surface, hit_rec.prim_id, result.prim_id );
+                    result.geom_id  = select( surface, hit_rec.geom_id, result.geom_id );
+                }
+
+                S pdf(0.0);
+                auto sr      = transport.template make_shade_record<Params>();
+                sr.isect_pos = hit_rec.isect_pos;
+                sr.normal    = n;
+                sr.view_dir  = view_dir;
+
+                simd::mask_type_t<S> emissive = has_emissive_material(surf);
+
+                S emission_weight(1.0);
+
+                if (params.sample_lights)
+                {
+                    // Lights that were hit by BRDF or phase function sampling
+                    auto weighted = surface & emissive & (prev_pdf > S(0.0));
+
+                    if (any(weighted))
+                    {
+                        auto light_pdf = detail::lights_pdf(params, ray, hit_rec.t);
+                        emission_weight = select( weighted, power_heuristic(prev_pdf, light_pdf), S(1.0) );
+                    }
+
+                    // The light is hit by the next bounce, if there is one
+                    if (bounce + 1 < params.num_bounces)
+                    {
+                        direct += dst * detail::estimate_direct_light(
+                                params,
+                                surf,
+                                sr,
+                                surface & !emissive,
+                                s,
+                                isect,
+                                transmittance
+                                );
+                    }
+                }
+
+                auto src = surf.sample(sr, refl_dir, pdf, s);
+
+                auto zero_pdf = surface & (pdf <= S(0.0));
+
+                src = mul( src, dot(n, refl_dir) / pdf, !emissive, src );
+                src = mul( src, emission_weight, emissive, src );
+                dst = mul( dst, src, surface & !zero_pdf, dst );
+                dst = select( zero_pdf, T(S(0.0)), dst );
+
+                if (params.sample_lights)
+                {
+                    sr.light_dir = refl_dir;
+                    prev_pdf = select( surface, surf.pdf(sr), prev_pdf );
+                }
+
+                active_rays &= !(surface & emissive);
+                active_rays &= !zero_pdf;
+            }
+
+
+            // Medium interactions
+
+            V scatter_dir = ray.dir;
+
+            if (any(scattered))
+            {
+                dst = mul( dst, albedo, scattered, dst );
+
+                if (params.sample_lights && bounce + 1 < params.num_bounces)
+                {
+                    auto sr      = transport.template make_shade_record<Params>();
+                    sr.isect_pos = medium_pos;
+                    sr.normal    = V(0.0);
+                    sr.view_dir  = view_dir;
+
+                    direct += dst * detail::estimate_direct_light(
+                            params,
+                            phase,
+                            sr,
+                            scattered,
+                            s,
+                            isect,
+                            transmittance
+                            );
+                }
+
+                // The phase function is sampled exactly, the path weight does not change
+                scatter_dir = sample_henyey_greenstein(ray.dir, medium.g, s);
+
+                prev_pdf = select( scattered, henyey_greenstein(dot(ray.dir, scatter_dir), medium.g), prev_pdf );
+            }
+
+            if (params.russian_roulette && bounce >= params.rr_min_bounces)
+            {
+                auto terminated = detail::russian_roulette(dst, active_rays, s);
+
+                dst = select( terminated, T(S(0.0)), dst );
+                active_rays &= !terminated;
+            }
+
+
+            if (!any(active_rays))
+            {
+                break;
+            }
+
+            ray.ori = select( scattered, medium_pos, hit_rec.isect_pos + refl_dir * S(params.epsilon) );
+            ray.dir = select( scattered, scatter_dir, refl_dir );
+        }
+
+        // Terminate paths that are still active
+        dst = select(active_rays, T(S(0.0)), dst);
+
+        result.color = select( result.hit, transport.to_rgba(dst + direct), result.color );
+
+        return result;
+    }
+};
+
+} // volume_pathtracing
+} // visionaray
+
+#endif // VSNRAY_DETAIL_VOLUME_PATHTRACING_INL
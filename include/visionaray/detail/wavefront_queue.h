@@ -0,0 +1,258 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_WAVEFRONT_QUEUE_H
+#define VSNRAY_DETAIL_WAVEFRONT_QUEUE_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/ray.h>
+#include <visionaray/math/vector.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/array.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/result_record.h>
+#include <visionaray/spectrum.h>
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Load and store SIMD vectors from / to SoA arrays, scalar overloads for
+// SIMD width 1. Pointers must be aligned to the SIMD width
+//
+
+template <typename T, typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+inline T load_lanes(float const* ptr)
+{
+    return T(ptr);
+}
+
+template <typename T, typename = typename std::enable_if<!simd::is_simd_vector<T>::value>::type, typename = void>
+inline T load_lanes(float const* ptr)
+{
+    return *ptr;
+}
+
+template <typename T, typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+inline void store_lanes(float* ptr, T const& value)
+{
+    store(ptr, value);
+}
+
+inline void store_lanes(float* ptr, float value)
+{
+    *ptr = value;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// pack() / unpack() hit records, scalar overloads for SIMD width 1
+//
+
+template <typename T, typename HR, typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+inline auto pack_lanes(array<HR, simd::num_elements<T>::value> const& hrs)
+    -> decltype(simd::pack(hrs))
+{
+    return simd::pack(hrs);
+}
+
+template <typename T, typename HR, typename = typename std::enable_if<!simd::is_simd_vector<T>::value>::type>
+inline HR pack_lanes(array<HR, 1> const& hrs)
+{
+    return hrs[0];
+}
+
+template <typename HR, typename = typename std::enable_if<simd::is_simd_vector<typename HR::scalar_type>::value>::type>
+inline auto unpack_lanes(HR const& hr)
+    -> decltype(simd::unpack(hr))
+{
+    return simd::unpack(hr);
+}
+
+template <typename HR, typename = typename std::enable_if<!simd::is_simd_vector<typename HR::scalar_type>::value>::type, typename = void>
+inline array<HR, 1> unpack_lanes(HR const& hr)
+{
+    array<HR, 1> result;
+    result[0] = hr;
+    return result;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Queue of paths for wavefront rendering
+//
+// Path state is stored as structure of arrays so that the stages (intersection,
+// shading, ...) can load and store whole SIMD packets of paths at once. The
+// capacity is padded to a multiple of the widest SIMD type, so that stages may
+// always process full packets. Padding paths have no valid state and must be
+// masked out by the stages.
+//
+
+template <typename HR>
+class wavefront_queue
+{
+public:
+
+    using hit_record_type = HR;
+
+    enum { num_spectrum_samples = spectrum<float>::num_samples };
+    enum { padding = 16 };
+    enum { alignment = 64 };
+
+public:
+
+    explicit wavefront_queue(size_t capacity = 0);
+
+    void reserve(size_t capacity);
+
+    size_t size() const     { return size_; }
+    size_t capacity() const { return capacity_; }
+
+    bool empty() const      { return size_ == 0; }
+    bool full() const       { return size_ == capacity_; }
+
+    // Append a path that starts at a primary ray
+    void push(basic_ray<float> const& r, int x, int y);
+
+    // Mark a path as finished with the given result
+    void finish(size_t i, result_record<float> const& result);
+
+    // Call f(x, y, result) for every finished path and remove these paths
+    // from the queue. The order of the remaining paths is preserved
+    template <typename Func>
+    void compact(Func f);
+
+    // Reorder paths by the material index (hit_record::geom_id)
+    void sort_by_material();
+
+    // Reorder paths by the type of their material (the type index of a
+    // generic_material), paths with the same type are ordered by the
+    // material index. materials[i] is the material with index i
+    template <typename Materials>
+    void sort_by_material(Materials materials);
+
+    // Ray packets
+    template <typename T>
+    basic_ray<T> load_ray(size_t i) const;
+
+    template <typename T>
+    void store_ray(size_t i, basic_ray<T> const& r);
+
+    // Throughput packets
+    template <typename T>
+    spectrum<T> load_throughput(size_t i) const;
+
+    template <typename T>
+    void store_throughput(size_t i, spectrum<T> const& s);
+
+    spectrum<float> throughput(size_t i) const;
+
+    // Radiance packets (light gathered along the path so far)
+    template <typename T>
+    spectrum<T> load_radiance(size_t i) const;
+
+    template <typename T>
+    void store_radiance(size_t i, spectrum<T> const& s);
+
+    spectrum<float> radiance(size_t i) const;
+
+    // pdf packets (pdf of the BRDF sample that generated the current ray)
+    template <typename T>
+    T load_prev_pdf(size_t i) const;
+
+    template <typename T>
+    void store_prev_pdf(size_t i, T const& pdf);
+
+    // Shadow ray packets and the radiance they transport if not occluded.
+    // Lanes with max_t <= 0 have no shadow ray. Shadow rays are only valid
+    // between the stage that generates and the stage that traces them, they
+    // are not preserved by compact() and sort_by_material()
+    template <typename T>
+    basic_ray<T> load_shadow_ray(size_t i) const;
+
+    template <typename T>
+    T load_shadow_max_t(size_t i) const;
+
+    template <typename T>
+    spectrum<T> load_shadow_radiance(size_t i) const;
+
+    template <typename T>
+    void store_shadow_ray(size_t i, basic_ray<T> const& r, T const& max_t, spectrum<T> const& radiance);
+
+public:
+
+    // SoA ray storage
+    aligned_vector<float, 64>               ori_x;
+    aligned_vector<float, 64>               ori_y;
+    aligned_vector<float, 64>               ori_z;
+    aligned_vector<float, 64>               dir_x;
+    aligned_vector<float, 64>               dir_y;
+    aligned_vector<float, 64>               dir_z;
+
+    // Spectrum samples, sample k of path i is stored at [k * capacity + i]
+    aligned_vector<float, 64>               throughput_samples;
+    aligned_vector<float, 64>               radiance_samples;
+
+    aligned_vector<float, 64>               prev_pdf;
+
+    // SoA shadow ray storage
+    aligned_vector<float, 64>               shadow_ori_x;
+    aligned_vector<float, 64>               shadow_ori_y;
+    aligned_vector<float, 64>               shadow_ori_z;
+    aligned_vector<float, 64>               shadow_dir_x;
+    aligned_vector<float, 64>               shadow_dir_y;
+    aligned_vector<float, 64>               shadow_dir_z;
+    aligned_vector<float, 64>               shadow_max_t;
+    aligned_vector<float, 64>               shadow_radiance_samples;
+
+    aligned_vector<HR>                      hit_rec;
+    aligned_vector<result_record<float>>    result;
+    aligned_vector<int>                     pixel_x;
+    aligned_vector<int>                     pixel_y;
+    aligned_vector<unsigned>                bounce;
+    aligned_vector<uint8_t>                 active;
+
+private:
+
+    // Copy path state from src[src_idx] to this[dst_idx]
+    void copy_path(wavefront_queue const& src, size_t src_idx, size_t dst_idx);
+
+    template <typename T>
+    spectrum<T> load_spectrum(aligned_vector<float, 64> const& samples, size_t i) const;
+
+    template <typename T>
+    void store_spectrum(aligned_vector<float, 64>& samples, size_t i, spectrum<T> const& s);
+
+    void permute_spectrum(aligned_vector<float, 64>& samples);
+
+    unsigned max_material_index() const;
+
+    // Counting sort of the paths by keys_[material index]
+    void sort_by_keys(unsigned num_keys);
+
+    size_t size_;
+    size_t capacity_;
+
+    // Scratch memory for sorting
+    aligned_vector<unsigned>                counts_;
+    aligned_vector<unsigned>                keys_;
+    aligned_vector<size_t>                  order_;
+
+};
+
+} // visionaray
+
+#include "wavefront_queue.inl"
+
+#endif // VSNRAY_DETAIL_WAVEFRONT_QUEUE_H
@@ -0,0 +1,472 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cassert>
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Reorder the first n elements of v
+//
+
+template <typename Vec>
+inline void permute(Vec& v, aligned_vector<size_t> const& order, size_t n)
+{
+    Vec tmp(n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        tmp[i] = v[order[i]];
+    }
+
+    std::copy(tmp.begin(), tmp.begin() + n, v.begin());
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Index of the material type, generic materials are sorted by the type of
+// the variant, all other materials have the same type
+//
+
+template <typename M>
+inline unsigned material_type_index(M const&)
+{
+    return 0;
+}
+
+template <typename ...Ts>
+inline unsigned material_type_index(generic_material<Ts...> const& mat)
+{
+    return mat.which();
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// wavefront_queue
+//
+
+template <typename HR>
+inline wavefront_queue<HR>::wavefront_queue(size_t capacity)
+    : size_(0)
+    , capacity_(0)
+{
+    reserve(capacity);
+}
+
+template <typename HR>
+inline void wavefront_queue<HR>::reserve(size_t capacity)
+{
+    assert(empty());
+
+    capacity_ = capacity;
+
+    size_t n = ((capacity + padding - 1) / padding) * padding;
+
+    ori_x.resize(n);
+    ori_y.resize(n);
+    ori_z.resize(n);
+    dir_x.resize(n);
+    dir_y.resize(n);
+    dir_z.resize(n);
+    throughput_samples.resize(n * num_spectrum_samples);
+    radiance_samples.resize(n * num_spectrum_samples);
+    prev_pdf.resize(n);
+    shadow_ori_x.resize(n);
+    shadow_ori_y.resize(n);
+    shadow_ori_z.resize(n);
+    shadow_dir_x.resize(n);
+    shadow_dir_y.resize(n);
+    shadow_dir_z.resize(n);
+    shadow_max_t.resize(n);
+    shadow_radiance_samples.resize(n * num_spectrum_samples);
+    hit_rec.resize(n);
+    result.resize(n);
+    pixel_x.resize(n);
+    pixel_y.resize(n);
+    bounce.resize(n);
+    active.resize(n);
+}
+
+template <typename HR>
+inline void wavefront_queue<HR>::push(basic_ray<float> const& r, int x, int y)
+{
+    assert(!full());
+
+    size_t i = size_++;
+
+    ori_x[i] = r.ori.x;
+    ori_y[i] = r.ori.y;
+    ori_z[i] = r.ori.z;
+    dir_x[i] = r.dir.x;
+    dir_y[i] = r.dir.y;
+    dir_z[i] = r.dir.z;
+
+    for (size_t k = 0; k < num_spectrum_samples; ++k)
+    {
+        throughput_samples[k * ori_x.size() + i] = 1.0f;
+        radiance_samples[k * ori_x.size() + i] = 0.0f;
+    }
+
+    prev_pdf[i] = 0.0f;
+    hit_rec[i] = HR();
+    result[i]  = result_record<float>();
+    pixel_x[i] = x;
+    pixel_y[i] = y;
+    bounce[i]  = 0;
+    active[i]  = 1;
+}
+
+template <typename HR>
+inline void wavefront_queue<HR>::finish(size_t i, result_record<float> const& res)
+{
+    result[i] = res;
+    active[i] = 0;
+}
+
+template <typename HR>
+template <typename Func>
+inline void wavefront_queue<HR>::compact(Func f)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < size_; ++i)
+    {
+        if (active[i])
+        {
+            if (i != n)
+            {
+                copy_path(*this, i, n);
+            }
+
+            ++n;
+        }
+        else
+        {
+            f(pixel_x[i], pixel_y[i], result[i]);
+        }
+    }
+
+    size_ = n;
+}
+
+template <typename HR>
+inline void wavefront_queue<HR>::sort_by_material()
+{
+    if (size_ < 2)
+    {
+        return;
+    }
+
+    unsigned num_materials = max_material_index() + 1;
+
+    keys_.resize(num_materials);
+
+    for (unsigned m = 0; m < num_materials; ++m)
+    {
+        keys_[m] = m;
+    }
+
+    sort_by_keys(num_materials);
+}
+
+template <typename HR>
+template <typename Materials>
+inline void wavefront_queue<HR>::sort_by_material(Materials materials)
+{
+    if (size_ < 2)
+    {
+        return;
+    }
+
+    unsigned num_materials = max_material_index() + 1;
+
+    // Counting sort of the materials by type, keys_[m] is the rank of material m
+    unsigned num_types = 0;
+
+    for (unsigned m = 0; m < num_materials; ++m)
+    {
+        num_types = std::max(num_types, detail::material_type_index(materials[m]) + 1);
+    }
+
+    counts_.assign(num_types + 1, 0);
+
+    for (unsigned m = 0; m < num_materials; ++m)
+    {
+        ++counts_[detail::material_type_index(materials[m]) + 1];
+    }
+
+    for (unsigned k = 1; k <= num_types; ++k)
+    {
+        counts_[k] += counts_[k - 1];
+    }
+
+    keys_.resize(num_materials);
+
+    for (unsigned m = 0; m < num_materials; ++m)
+    {
+        keys_[m] = counts_[detail::material_type_index(materials[m])]++;
+    }
+
+    sort_by_keys(num_materials);
+}
+
+template <typename HR>
+inline unsigned wavefront_queue<HR>::max_material_index() const
+{
+    unsigned result = 0;
+
+    for (size_t i = 0; i < size_; ++i)
+    {
+        result = std::max(result, static_cast<unsigned>(hit_rec[i].geom_id));
+    }
+
+    return result;
+}
+
+template <typename HR>
+inline void wavefront_queue<HR>::sort_by_keys(unsigned num_keys)
+{
+    // Counting sort
+    counts_.assign(num_keys + 1, 0);
+
+    for (size_t i = 0; i < size_; ++i)
+    {
+        ++counts_[keys_[hit_rec[i].geom_id] + 1];
+    }
+
+    // Already sorted if there's only one key
+    if (std::count(counts_.begin(), counts_.end(), 0U) == static_cast<ptrdiff_t>(num_keys))
+    {
+        return;
+    }
+
+    for (unsigned k = 1; k <= num_keys; ++k)
+    {
+        counts_[k] += counts_[k - 1];
+    }
+
+    order_.resize(size_);
+
+    for (size_t i = 0; i < size_; ++i)
+    {
+        order_[counts_[keys_[hit_rec[i].geom_id]]++] = i;
+    }
+
+    detail::permute(ori_x, order_, size_);
+    detail::permute(ori_y, order_, size_);
+    detail::permute(ori_z, order_, size_);
+    detail::permute(dir_x, order_, size_);
+    detail::permute(dir_y, order_, size_);
+    detail::permute(dir_z, order_, size_);
+    detail::permute(prev_pdf, order_, size_);
+    detail::permute(hit_rec, order_, size_);
+    detail::permute(result, order_, size_);
+    detail::permute(pixel_x, order_, size_);
+    detail::permute(pixel_y, order_, size_);
+    detail::permute(bounce, order_, size_);
+    detail::permute(active, order_, size_);
+
+    permute_spectrum(throughput_samples);
+    permute_spectrum(radiance_samples);
+}
+
+template <typename HR>
+template <typename T>
+inline basic_ray<T> wavefront_queue<HR>::load_ray(size_t i) const
+{
+    using V = vector<3, T>;
+
+    return basic_ray<T>(
+            V(detail::load_lanes<T>(&ori_x[i]), detail::load_lanes<T>(&ori_y[i]), detail::load_lanes<T>(&ori_z[i])),
+            V(detail::load_lanes<T>(&dir_x[i]), detail::load_lanes<T>(&dir_y[i]), detail::load_lanes<T>(&dir_z[i]))
+            );
+}
+
+template <typename HR>
+template <typename T>
+inline void wavefront_queue<HR>::store_ray(size_t i, basic_ray<T> const& r)
+{
+    detail::store_lanes(&ori_x[i], r.ori.x);
+    detail::store_lanes(&ori_y[i], r.ori.y);
+    detail::store_lanes(&ori_z[i], r.ori.z);
+    detail::store_lanes(&dir_x[i], r.dir.x);
+    detail::store_lanes(&dir_y[i], r.dir.y);
+    detail::store_lanes(&dir_z[i], r.dir.z);
+}
+
+template <typename HR>
+template <typename T>
+inline spectrum<T> wavefront_queue<HR>::load_throughput(size_t i) const
+{
+    return load_spectrum<T>(throughput_samples, i);
+}
+
+template <typename HR>
+template <typename T>
+inline void wavefront_queue<HR>::store_throughput(size_t i, spectrum<T> const& s)
+{
+    store_spectrum(throughput_samples, i, s);
+}
+
+template <typename HR>
+inline spectrum<float> wavefront_queue<HR>::throughput(size_t i) const
+{
+    return load_throughput<float>(i);
+}
+
+template <typename HR>
+template <typename T>
+inline spectrum<T> wavefront_queue<HR>::load_radiance(size_t i) const
+{
+    return load_spectrum<T>(radiance_samples, i);
+}
+
+template <typename HR>
+template <typename T>
+inline void wavefront_queue<HR>::store_radiance(size_t i, spectrum<T> const& s)
+{
+    store_spectrum(radiance_samples, i, s);
+}
+
+template <typename HR>
+inline spectrum<float> wavefront_queue<HR>::radiance(size_t i) const
+{
+    return load_radiance<float>(i);
+}
+
+template <typename HR>
+template <typename T>
+inline T wavefront_queue<HR>::load_prev_pdf(size_t i) const
+{
+    return detail::load_lanes<T>(&prev_pdf[i]);
+}
+
+template <typename HR>
+template <typename T>
+inline void wavefront_queue<HR>::store_prev_pdf(size_t i, T const& pdf)
+{
+    detail::store_lanes(&prev_pdf[i], pdf);
+}
+
+template <typename HR>
+template <typename T>
+inline basic_ray<T> wavefront_queue<HR>::load_shadow_ray(size_t i) const
+{
+    using V = vector<3, T>;
+
+    return basic_ray<T>(
+            V(detail::load_lanes<T>(&shadow_ori_x[i]), detail::load_lanes<T>(&shadow_ori_y[i]), detail::load_lanes<T>(&shadow_ori_z[i])),
+            V(detail::load_lanes<T>(&shadow_dir_x[i]), detail::load_lanes<T>(&shadow_dir_y[i]), detail::load_lanes<T>(&shadow_dir_z[i]))
+            );
+}
+
+template <typename HR>
+template <typename T>
+inline T wavefront_queue<HR>::load_shadow_max_t(size_t i) const
+{
+    return detail::load_lanes<T>(&shadow_max_t[i]);
+}
+
+template <typename HR>
+template <typename T>
+inline spectrum<T> wavefront_queue<HR>::load_shadow_radiance(size_t i) const
+{
+    return load_spectrum<T>(shadow_radiance_samples, i);
+}
+
+template <typename HR>
+template <typename T>
+inline void wavefront_queue<HR>::store_shadow_ray(
+        size_t              i,
+        basic_ray<T> const& r,
+        T const&            max_t,
+        spectrum<T> const&  radiance
+        )
+{
+    detail::store_lanes(&shadow_ori_x[i], r.ori.x);
+    detail::store_lanes(&shadow_ori_y[i], r.ori.y);
+    detail::store_lanes(&shadow_ori_z[i], r.ori.z);
+    detail::store_lanes(&shadow_dir_x[i], r.dir.x);
+    detail::store_lanes(&shadow_dir_y[i], r.dir.y);
+    detail::store_lanes(&shadow_dir_z[i], r.dir.z);
+    detail::store_lanes(&shadow_max_t[i], max_t);
+    store_spectrum(shadow_radiance_samples, i, radiance);
+}
+
+template <typename HR>
+inline void wavefront_queue<HR>::copy_path(wavefront_queue const& src, size_t src_idx, size_t dst_idx)
+{
+    ori_x[dst_idx]   = src.ori_x[src_idx];
+    ori_y[dst_idx]   = src.ori_y[src_idx];
+    ori_z[dst_idx]   = src.ori_z[src_idx];
+    dir_x[dst_idx]   = src.dir_x[src_idx];
+    dir_y[dst_idx]   = src.dir_y[src_idx];
+    dir_z[dst_idx]   = src.dir_z[src_idx];
+
+    size_t stride = ori_x.size();
+
+    for (size_t k = 0; k < num_spectrum_samples; ++k)
+    {
+        throughput_samples[k * stride + dst_idx] = src.throughput_samples[k * stride + src_idx];
+        radiance_samples[k * stride + dst_idx] = src.radiance_samples[k * stride + src_idx];
+    }
+
+    prev_pdf[dst_idx] = src.prev_pdf[src_idx];
+    hit_rec[dst_idx] = src.hit_rec[src_idx];
+    result[dst_idx]  = src.result[src_idx];
+    pixel_x[dst_idx] = src.pixel_x[src_idx];
+    pixel_y[dst_idx] = src.pixel_y[src_idx];
+    bounce[dst_idx]  = src.bounce[src_idx];
+    active[dst_idx]  = src.active[src_idx];
+}
+
+template <typename HR>
+template <typename T>
+inline spectrum<T> wavefront_queue<HR>::load_spectrum(aligned_vector<float, 64> const& samples, size_t i) const
+{
+    vector<num_spectrum_samples, T> result;
+
+    for (size_t k = 0; k < num_spectrum_samples; ++k)
+    {
+        result[k] = detail::load_lanes<T>(&samples[k * ori_x.size() + i]);
+    }
+
+    return spectrum<T>(result);
+}
+
+template <typename HR>
+template <typename T>
+inline void wavefront_queue<HR>::store_spectrum(aligned_vector<float, 64>& samples, size_t i, spectrum<T> const& s)
+{
+    for (size_t k = 0; k < num_spectrum_samples; ++k)
+    {
+        detail::store_lanes(&samples[k * ori_x.size() + i], s.samples()[k]);
+    }
+}
+
+template <typename HR>
+inline void wavefront_queue<HR>::permute_spectrum(aligned_vector<float, 64>& samples)
+{
+    aligned_vector<float, 64> tmp(size_);
+    size_t stride = ori_x.size();
+
+    for (size_t k = 0; k < num_spectrum_samples; ++k)
+    {
+        float* s = samples.data() + k * stride;
+
+        for (size_t i = 0; i < size_; ++i)
+        {
+            tmp[i] = s[order_[i]];
+        }
+
+        std::copy(tmp.begin(), tmp.end(), s);
+    }
+}
+
+} // visionaray
@@ -0,0 +1,71 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_WAVEFRONT_SCHED_H
+#define VSNRAY_DETAIL_WAVEFRONT_SCHED_H 1
+
+#include <cstddef>
+#include <memory>
+
+#include "thread_pool.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Scheduler for wavefront kernels (e.g. pathtracing::wavefront_kernel)
+//
+// The image is split into large tiles that are distributed over the threads
+// of a thread_pool. For each tile, a queue of paths is filled with primary
+// rays. The kernel stages (intersection, shading, shadow rays) then process the whole
+// queue at once, using SIMD packets of ray type R. Finished paths are stored
+// to the render target and replaced by new primary rays, so that the queue
+// stays full until the tile runs out of pixels.
+//
+// Supports the uniform, jittered and jittered_blend pixel samplers. frame()
+// calls kernel.validate() first, which throws if the kernel cannot render
+// with its parameters.
+//
+
+template <typename R>
+class wavefront_sched
+{
+public:
+
+    // Create a scheduler with its own thread pool
+    explicit wavefront_sched(unsigned num_threads);
+
+    // Create a scheduler that submits its frames to a shared thread pool
+    explicit wavefront_sched(std::shared_ptr<thread_pool> pool, int priority = thread_pool::Normal);
+
+    template <typename K, typename SP>
+    void frame(K kernel, SP sched_params, unsigned frame_num = 0);
+
+    // Change the number of worker threads (of the shared pool, if any)
+    void reset(unsigned num_threads);
+
+    // Number of paths that are kept in flight per tile
+    void set_queue_capacity(size_t capacity);
+    size_t queue_capacity() const;
+
+private:
+
+    template <typename K, typename SP>
+    void render_tile(K const& kernel, SP const& sched_params, unsigned frame_num, unsigned frame_id, long tile_idx);
+
+    std::shared_ptr<thread_pool> pool_;
+    int                         priority_;
+    size_t                      queue_capacity_;
+
+    static const int            tile_width  = 64;
+    static const int            tile_height = 64;
+
+};
+
+} // visionaray
+
+#include "wavefront_sched.inl"
+
+#endif // VSNRAY_DETAIL_WAVEFRONT_SCHED_H
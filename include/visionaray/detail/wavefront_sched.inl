@@ -0,0 +1,206 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <type_traits>
+
+#include <visionaray/math/detail/math.h> // div_up
+#include <visionaray/math/ray.h>
+#include <visionaray/math/rectangle.h>
+#include <visionaray/random_sampler.h>
+#include <visionaray/result_record.h>
+
+#include "sched_common.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// wavefront_sched implementation
+//
+
+template <typename R>
+wavefront_sched<R>::wavefront_sched(unsigned num_threads)
+    : pool_(std::make_shared<thread_pool>(num_threads))
+    , priority_(thread_pool::Normal)
+    , queue_capacity_(1024)
+{
+}
+
+template <typename R>
+wavefront_sched<R>::wavefront_sched(std::shared_ptr<thread_pool> pool, int priority)
+    : pool_(pool)
+    , priority_(priority)
+    , queue_capacity_(1024)
+{
+}
+
+template <typename R>
+template <typename K, typename SP>
+void wavefront_sched<R>::frame(K kernel, SP sched_params, unsigned frame_num)
+{
+    kernel.validate();
+
+    sched_params.cam.begin_frame();
+
+    sched_params.rt.begin_frame();
+
+    auto tilew = tile_width;
+    auto tileh = tile_height;
+    auto numtilesx = div_up(sched_params.rt.width(),  tilew);
+    auto numtilesy = div_up(sched_params.rt.height(), tileh);
+
+    auto j = std::make_shared<thread_pool::job>(numtilesx * numtilesy, priority_);
+
+    // Same for all tiles, random sequences are derived from it per tile
+    auto frame_id = detail::tic() + frame_num;
+
+    j->process_item = [&](long tile_idx)
+    {
+        render_tile(kernel, sched_params, frame_num, frame_id, tile_idx);
+    };
+
+    auto done = j->done.get_future();
+    pool_->submit(j);
+    done.wait();
+
+    sched_params.rt.end_frame();
+
+    sched_params.cam.end_frame();
+}
+
+template <typename R>
+void wavefront_sched<R>::reset(unsigned num_threads)
+{
+    pool_->reset(num_threads);
+}
+
+template <typename R>
+void wavefront_sched<R>::set_queue_capacity(size_t capacity)
+{
+    queue_capacity_ = capacity;
+}
+
+template <typename R>
+size_t wavefront_sched<R>::queue_capacity() const
+{
+    return queue_capacity_;
+}
+
+template <typename R>
+template <typename K, typename SP>
+void wavefront_sched<R>::render_tile(
+        K const&    kernel,
+        SP const&   sparams,
+        unsigned    frame_num,
+        unsigned    frame_id,
+        long        tile_idx
+        )
+{
+    using S = typename R::scalar_type;
+    using pixel_sampler_type = typename SP::pixel_sampler_type;
+
+    static_assert(
+            std::is_same<
+                decltype(detail::make_primary_rays(
+                        ray{},
+                        pixel_sampler_type{},
+                        std::declval<random_sampler<float>&>(),
+                        0,
+                        0,
+                        0,
+                        0,
+                        sparams.cam
+                        )),
+                ray
+                >::value,
+            "wavefront_sched: pixel sampler not supported"
+            );
+
+    typename K::queue_type queue(queue_capacity_);
+
+    // Independent streams for the scalar (primary rays) and the SIMD (shading) sampler
+    random_sampler<float> samp(detail::make_seed(frame_id, static_cast<unsigned>(tile_idx), 0));
+    random_sampler<S> simd_samp(detail::make_seed(frame_id, static_cast<unsigned>(tile_idx), 1));
+
+    int width  = sparams.rt.width();
+    int height = sparams.rt.height();
+
+    auto scissor_box = sparams.scissor_box;
+
+    int tilew = tile_width;
+    int tileh = tile_height;
+    int numtilesx = div_up(width, tilew);
+
+    recti tile(
+            (tile_idx % numtilesx) * tilew,
+            (tile_idx / numtilesx) * tileh,
+            tilew,
+            tileh
+            );
+
+    // Store the result of a finished path
+    auto store = [&](int x, int y, result_record<float> const& result)
+    {
+        sample_pixel(
+                [&](ray const&) { return result; },
+                pixel_sampler_type{},
+                ray{},
+                samp,
+                frame_num,
+                sparams.rt.ref(),
+                x,
+                y,
+                width,
+                height,
+                sparams.cam
+                );
+    };
+
+    int next_pixel = 0;
+    int num_pixels = tilew * tileh;
+
+    for (;;)
+    {
+        // Regenerate: fill up the queue with paths for the remaining pixels
+        while (!queue.full() && next_pixel < num_pixels)
+        {
+            int x = tile.x + next_pixel % tilew;
+            int y = tile.y + next_pixel / tilew;
+            ++next_pixel;
+
+            if (x >= width || y >= height
+             || x < scissor_box.x || y < scissor_box.y
+             || x >= scissor_box.x + scissor_box.w || y >= scissor_box.y + scissor_box.h)
+            {
+                continue;
+            }
+
+            auto r = detail::make_primary_rays(
+                    ray{},
+                    pixel_sampler_type{},
+                    samp,
+                    x,
+                    y,
+                    width,
+                    height,
+                    sparams.cam
+                    );
+
+            queue.push(r, x, y);
+        }
+
+        if (queue.empty())
+        {
+            break;
+        }
+
+        kernel.template extend<R>(queue);
+        queue.compact(store);
+
+        kernel.template shade<R>(queue, simd_samp);
+        kernel.template trace_shadow_rays<R>(queue);
+        queue.compact(store);
+    }
+}
+
+} // visionaray
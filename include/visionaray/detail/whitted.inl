@@ -9,11 +9,19 @@
 #include <cstddef>
 #include <type_traits>
 
+#include <visionaray/math/simd/type_traits.h>
 #include <visionaray/array.h>
 #include <visionaray/get_surface.h>
+#include <visionaray/light_groups.h>
+#include <visionaray/point_light.h>
 #include <visionaray/result_record.h>
+#include <visionaray/shade_record.h>
+#include <visionaray/spot_light.h>
 #include <visionaray/traverse.h>
 
+#include "macros.h"
+#include "ray_stream.h"
+
 namespace visionaray
 {
 namespace whitted
@@ -126,7 +134,7 @@ inline auto specular_bounce(
 {
     return make_bounce_result(
         reflect(view_dir, normal),
-        mat.get_kr()
+        mat.kr()
         );
 }
 
@@ -210,6 +218,324 @@ inline auto specular_bounce(
         );
 }
 
+
+//-------------------------------------------------------------------------------------------------
+// Add the contribution of lights to the color of a surface point, for the lanes
+// that the light is visible from
+//
+// Groups of lights (single rays only) are shaded in SIMD, the surface is replicated
+// to all lanes and lane i is lit by light i of the group
+//
+
+template <typename Params, typename Surface, typename V, typename C>
+struct light_shader
+{
+    using S = typename V::value_type;
+
+    template <typename M>
+    VSNRAY_FUNC
+    void operator()(
+            typename Params::light_type const&  light,
+            V const&                            light_dir,
+            M const&                            visible,
+            float                               scale
+            ) const
+    {
+        auto sr         = make_shade_record<Params, S>();
+        sr.isect_pos    = isect_pos;
+        sr.normal       = normal;
+        sr.view_dir     = view_dir;
+        sr.light_dir    = light_dir;
+        sr.light        = light;
+        auto clr        = surf.shade(sr);
+
+        color += select(
+                visible,
+                clr * S(scale),
+                C(0.0)
+                );
+    }
+
+    template <typename Light, typename T>
+    void operator()(
+            Light const&                group,
+            vector<3, T> const&         light_dir,
+            simd::mask_type_t<T> const& visible
+            ) const
+    {
+        using simd_surface = visionaray::detail::simd_decl_surface<Params, T>;
+
+        typename simd_surface::array_type surfs;
+
+        for (size_t i = 0; i < surfs.size(); ++i)
+        {
+            surfs[i] = surf;
+        }
+
+        auto group_surf = simd::pack(surfs);
+
+        auto sr         = make_shade_record<Params, T, Light>();
+        sr.isect_pos    = vector<3, T>(isect_pos);
+        sr.normal       = vector<3, T>(normal);
+        sr.view_dir     = vector<3, T>(view_dir);
+        sr.light_dir    = light_dir;
+        sr.light        = group;
+        auto clr        = select( visible, group_surf.shade(sr), spectrum<T>(0.0) );
+
+        // Sum over the lights of the group
+        simd::aligned_array_t<T> lanes;
+
+        for (size_t k = 0; k < C::num_samples; ++k)
+        {
+            store(lanes, clr[k]);
+
+            for (size_t i = 0; i < simd::num_elements<T>::value; ++i)
+            {
+                color[k] += lanes[i];
+            }
+        }
+    }
+
+    Surface&    surf;
+    V const&    isect_pos;
+    V const&    normal;
+    V const&    view_dir;
+    C&          color;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Shadow rays
+//
+// shade_lights() traces the shadow rays to all lights and calls shade() for the
+// lights that are visible. How the shadow rays are traced depends on the ray type:
+//
+//  - light groups: single rays on the CPU process point and spot lights in groups
+//    of SIMD width (see light_groups.h). Directions and distances to the hit point
+//    are computed and the visible lights are shaded for the whole group. Groups
+//    are taken from kernel_params::light_groups if set, otherwise the lights are
+//    packed for each hit point
+//
+//  - ray stream: ray packets on the CPU collect the shadow rays of all lanes and
+//    all lights in a ray_stream that walks the BVH only once
+//
+//  - otherwise one shadow ray (packet) is traced per light
+//
+
+struct trace_per_light_tag {};
+struct light_groups_tag {};
+struct ray_stream_tag {};
+
+template <typename S, typename Light>
+struct shadow_ray_tag
+{
+    using type = typename std::conditional<
+            VSNRAY_CPU_MODE && std::is_same<S, float>::value && is_light_group_type<Light>::value,
+            light_groups_tag,
+            typename std::conditional<
+                VSNRAY_CPU_MODE && simd::is_simd_vector<S>::value,
+                ray_stream_tag,
+                trace_per_light_tag
+                >::type
+            >::type;
+};
+
+
+// Fall-through: trace a shadow ray for each light
+template <typename Params, typename V, typename M, typename Intersector, typename Shade>
+VSNRAY_FUNC
+inline void shade_lights(
+        Params const&   params,
+        V const&        isect_pos,
+        M const&        hit,
+        Intersector&    isect,
+        Shade           shade,
+        trace_per_light_tag
+        )
+{
+    using S = typename V::value_type;
+
+    for (auto it = params.lights.begin; it != params.lights.end; ++it)
+    {
+        auto light_dir = normalize( V(it->position()) - isect_pos );
+        basic_ray<S> shadow_ray(
+                isect_pos + light_dir * S(params.epsilon),
+                light_dir
+                );
+
+        // only cast a shadow if occluder between light source and hit pos
+        auto shadow_rec = any_hit(
+                shadow_ray,
+                params.prims.begin,
+                params.prims.end,
+                length(isect_pos - V(it->position())),
+                isect
+                );
+
+        shade(*it, light_dir, hit & !shadow_rec.hit, 1.0f);
+    }
+}
+
+// Light groups, single rays only
+template <typename Params, typename Intersector, typename Shade>
+inline void shade_lights(
+        Params const&       params,
+        vector<3, float>    isect_pos,
+        bool                hit,
+        Intersector&        isect,
+        Shade               shade,
+        light_groups_tag
+        )
+{
+    using T = light_group_float;
+    using V = vector<3, T>;
+    using light_type = typename Params::light_type;
+    using float_array = simd::aligned_array_t<T>;
+
+    enum { N = simd::num_elements<T>::value };
+
+    if (!hit)
+    {
+        return;
+    }
+
+    auto num_lights = static_cast<size_t>(params.lights.end - params.lights.begin);
+
+    // Otherwise, the groups do not match the lights (e.g. the lights were changed)
+    bool use_groups = params.light_groups.num_lights() == num_lights;
+
+    for (size_t g = 0, first = 0; first < num_lights; ++g, first += N)
+    {
+        size_t count = num_lights - first < size_t(N) ? num_lights - first : size_t(N);
+
+        light_group_t<light_type> packed;
+
+        if (!use_groups)
+        {
+            array<light_type, N> lights;
+
+            for (size_t i = 0; i < N; ++i)
+            {
+                // Pad the last group, padded lanes are ignored
+                lights[i] = params.lights.begin[first + (i < count ? i : 0)];
+            }
+
+            packed = simd::pack(lights);
+        }
+
+        auto const& group = use_groups ? params.light_groups.group(g) : packed;
+
+        V pos(isect_pos);
+        V to_light = group.position() - pos;
+        T dist = length(to_light);
+        V light_dir = to_light / dist;
+
+        float_array max_t;
+        store(max_t, dist);
+
+        auto origins = simd::unpack(pos + light_dir * T(params.epsilon));
+        auto dirs    = simd::unpack(light_dir);
+
+        float_array visible;
+        bool any_visible = false;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            visible[i] = 0.0f;
+
+            if (i >= count)
+            {
+                continue;
+            }
+
+            // The rays diverge, single rays traverse the BVH faster than a packet
+            auto shadow_rec = any_hit(
+                    basic_ray<float>(origins[i], dirs[i]),
+                    params.prims.begin,
+                    params.prims.end,
+                    max_t[i],
+                    isect
+                    );
+
+            if (!shadow_rec.hit)
+            {
+                visible[i] = 1.0f;
+                any_visible = true;
+            }
+        }
+
+        if (any_visible)
+        {
+            shade(group, light_dir, T(visible) > T(0.0));
+        }
+    }
+}
+
+// Ray stream, ray packets only
+template <typename Params, typename T, typename M, typename Intersector, typename Shade>
+inline void shade_lights(
+        Params const&       params,
+        vector<3, T> const& isect_pos,
+        M const&            hit,
+        Intersector&        isect,
+        Shade               shade,
+        ray_stream_tag
+        )
+{
+    using V = vector<3, T>;
+    using float_array = simd::aligned_array_t<T>;
+
+    enum { N = simd::num_elements<T>::value };
+
+    static thread_local visionaray::detail::ray_stream stream;
+    stream.clear();
+
+    float_array active;
+    store(active, select(hit, T(1.0), T(0.0)));
+
+    auto origins = simd::unpack(isect_pos);
+
+    // Shadow rays of the active lanes, in the order lights x lanes
+    for (auto it = params.lights.begin; it != params.lights.end; ++it)
+    {
+        V light_pos(it->position());
+
+        auto light_dirs = simd::unpack(normalize(light_pos - isect_pos));
+
+        float_array dists;
+        store(dists, length(isect_pos - light_pos));
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (active[i] != 0.0f)
+            {
+                stream.push_back(
+                        basic_ray<float>(origins[i] + light_dirs[i] * params.epsilon, light_dirs[i]),
+                        dists[i]
+                        );
+            }
+        }
+    }
+
+    stream.any_hit(params.prims.begin, params.prims.end, isect);
+
+    size_t index = 0;
+
+    for (auto it = params.lights.begin; it != params.lights.end; ++it)
+    {
+        float_array visible;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            // Only active lanes have a shadow ray in the stream
+            visible[i] = active[i] != 0.0f && !stream.occluded(index++) ? 1.0f : 0.0f;
+        }
+
+        auto light_dir = normalize( V(it->position()) - isect_pos );
+        shade(*it, light_dir, T(visible) > T(0.0), 1.0f);
+    }
+}
+
 } // detail
 
 
@@ -228,6 +554,7 @@ struct kernel
     {
 
         using S = typename R::scalar_type;
+        using I = typename result_record<S>::int_type;
         using V = typename result_record<S>::vec_type;
         using C = spectrum<S>;
 
@@ -267,36 +594,64 @@ struct kernel
             n = faceforward( n, view_dir, surf.geometric_normal );
 #endif
 
-            for (auto it = params.lights.begin; it != params.lights.end; ++it)
+            if (depth == 1)
             {
-                auto light_dir = normalize( V(it->position()) - hit_rec.isect_pos );
-                R shadow_ray
-                (
-                    hit_rec.isect_pos + light_dir * S(params.epsilon),
-                    light_dir
-                );
+                // AOVs of the first hit
+                result.normal   = select( hit_rec.hit, n, V(0.0) );
+                result.albedo   = select( hit_rec.hit, to_rgb(surf.albedo()), V(0.0) );
+                result.prim_id  = select( hit_rec.hit, hit_rec.prim_id, I(-1) );
+                result.geom_id  = select( hit_rec.hit, hit_rec.geom_id, I(-1) );
+            }
+
+            detail::light_shader<Params, decltype(surf), V, C> shade{
+                    surf,
+                    hit_rec.isect_pos,
+                    n,
+                    view_dir,
+                    shaded_clr
+                    };
 
-                // only cast a shadow if occluder between light source and hit pos
-                auto shadow_rec  = any_hit(
-                        shadow_ray,
-                        params.prims.begin,
-                        params.prims.end,
-                        length(hit_rec.isect_pos - V(it->position())),
-                        isect
+            if (params.light_tree.empty())
+            {
+                detail::shade_lights(
+                        params,
+                        hit_rec.isect_pos,
+                        hit_rec.hit,
+                        isect,
+                        shade,
+                        typename detail::shadow_ray_tag<S, typename Params::light_type>::type{}
                         );
+            }
+            else
+            {
+                auto shade_light = [&](typename Params::light_type const& light, float scale)
+                {
+                    auto light_dir = normalize( V(light.position()) - hit_rec.isect_pos );
+                    R shadow_ray
+                    (
+                        hit_rec.isect_pos + light_dir * S(params.epsilon),
+                        light_dir
+                    );
 
-                auto sr         = make_shade_record<Params, S>();
-                sr.isect_pos    = hit_rec.isect_pos;
-                sr.normal       = n;
-                sr.view_dir     = view_dir;
-                sr.light_dir    = light_dir;
-                sr.light        = *it;
-                auto clr        = surf.shade(sr);
-
-                shaded_clr += select(
-                        hit_rec.hit & !shadow_rec.hit,
-                        clr,
-                        C(0.0)
+                    // only cast a shadow if occluder between light source and hit pos
+                    auto shadow_rec  = any_hit(
+                            shadow_ray,
+                            params.prims.begin,
+                            params.prims.end,
+                            length(hit_rec.isect_pos - V(light.position())),
+                            isect
+                            );
+
+                    shade(light, light_dir, hit_rec.hit & !shadow_rec.hit, scale);
+                };
+
+                // Shade the lights of a lightcut, less important lights are clustered
+                params.light_tree.cut(
+                        hit_rec.isect_pos,
+                        n,
+                        hit_rec.hit,
+                        params.light_cut_threshold,
+                        [&](unsigned l, float scale) { shade_light(params.lights.begin[l], scale); }
                         );
             }
 
@@ -13,12 +13,17 @@
 namespace visionaray
 {
 
-template <typename T>
+//-------------------------------------------------------------------------------------------------
+// Fresnel reflectance, C is either a spectrum or a vector with samples at the hero
+// wavelengths of a path (see hero_wavelengths.h)
+//
+
+template <typename C, typename T>
 VSNRAY_FUNC
-inline spectrum<T> fresnel_reflectance(
+inline C fresnel_reflectance(
         conductor_tag       /* */,
-        spectrum<T> const&  eta,
-        spectrum<T> const&  k,
+        C const&            eta,
+        C const&            k,
         T const&            cosi
         )
 {
@@ -34,12 +39,12 @@ inline spectrum<T> fresnel_reflectance(
 
 }
 
-template <typename T>
+template <typename C, typename T>
 VSNRAY_FUNC
-inline spectrum<T> fresnel_reflectance(
+inline C fresnel_reflectance(
         dielectric_tag      /* */,
-        spectrum<T> const&  etai,
-        spectrum<T> const&  etat,
+        C const&            etai,
+        C const&            etat,
         T                   cosi,
         T                   cost
         )
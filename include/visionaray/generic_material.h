@@ -8,6 +8,7 @@
 
 #include "detail/macros.h"
 #include "math/vector.h"
+#include "shade_record.h"
 #include "spectrum.h"
 #include "variant.h"
 
@@ -40,17 +41,22 @@ public:
 
     VSNRAY_FUNC spectrum<scalar_type> ambient() const;
 
+    VSNRAY_FUNC spectrum<scalar_type> albedo() const;
+
     template <typename SR>
-    VSNRAY_FUNC spectrum<typename SR::scalar_type> shade(SR const& sr) const;
+    VSNRAY_FUNC shade_color_t<SR> shade(SR const& sr) const;
 
     template <typename SR, typename U, typename Sampler>
-    VSNRAY_FUNC spectrum<U> sample(
+    VSNRAY_FUNC shade_color_t<SR> sample(
             SR const&       sr,
             vector<3, U>&   refl_dir,
             U&              pdf,
             Sampler&        sampler
             ) const;
 
+    template <typename SR>
+    VSNRAY_FUNC typename SR::scalar_type pdf(SR const& sr) const;
+
 private:
 
     // Variant visitors
@@ -59,12 +65,17 @@ private:
 
     struct ambient_visitor;
 
+    struct albedo_visitor;
+
     template <typename SR>
     struct shade_visitor;
 
     template <typename SR, typename U, typename S>
     struct sample_visitor;
 
+    template <typename SR>
+    struct pdf_visitor;
+
 };
 
 } // visionaray
@@ -0,0 +1,108 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_GRADIENT_VOLUME_H
+#define VSNRAY_GRADIENT_VOLUME_H 1
+
+#include <functional>
+#include <memory>
+
+#include "detail/macros.h"
+#include "detail/thread_pool.h"
+#include "math/unorm.h"
+#include "math/vector.h"
+#include "texture/texture.h"
+#include "aligned_vector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// gradient_volume
+//
+// Precomputed gradients of a scalar volume for shaded volume rendering. Kernels fetch
+// the gradient with a single tex3D() from ref() instead of computing central differences
+// with six extra fetches per sample.
+//
+// Gradients are central differences of the voxels (one-sided at the borders) in texture
+// coordinates, i.e. the change of the voxel value per unit of texture space, the same as
+// (tex3D(volume, p + d) - tex3D(volume, p - d)) / 2|d| for voxel centers p and steps d of
+// one voxel along each axis. Each gradient is stored in 4 bytes (RGBA, 8 bits each): the
+// normalized direction, mapped from [-1..1] to [0..1], and the magnitude relative to
+// max_magnitude(). Unlike e.g. octahedral encodings, this format can be filtered linearly.
+// Use decode_gradient() or decode_normal() on the result of tex3D().
+//
+// Slices of the volume are distributed over the threads of a thread pool that may be
+// shared with a scheduler. build() must be called again when the volume changes
+//
+
+class gradient_volume
+{
+public:
+
+    using texel_type = vector<4, unorm<8>>;
+
+    // Create a gradient volume with its own thread pool
+    explicit gradient_volume(unsigned num_threads);
+
+    // Create a gradient volume that submits its jobs to a shared thread pool
+    explicit gradient_volume(std::shared_ptr<thread_pool> pool, int priority = thread_pool::Normal);
+
+    // Compute the gradients of a 3D texture (reference) with scalar voxels, blocks until done
+    template <typename Volume>
+    void build(Volume const& volume);
+
+    // Texture reference with linear filtering and clamping, same size as the volume
+    texture_ref<texel_type, 3> ref() const;
+
+    vec3i size() const;
+
+    // Largest gradient magnitude in the volume
+    float max_magnitude() const;
+
+    // Encoded gradient of voxel (x,y,z)
+    texel_type const& operator()(int x, int y, int z) const;
+
+    // Wall clock time of the last call to build() in milliseconds
+    double last_build_time() const;
+
+private:
+
+    std::shared_ptr<thread_pool> pool_;
+    int priority_;
+
+    vec3i size_ = vec3i(0);
+
+    float max_magnitude_ = 0.0f;
+
+    double last_build_time_ = 0.0;
+
+    aligned_vector<texel_type> data_;
+
+    // Process slices [0..size.z) on the thread pool, blocks until done
+    void parallel_slices(std::function<void(int)> const& func);
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Decode (filtered) texels of gradient_volume::ref()
+//
+
+// Gradient in texture coordinates
+template <typename T>
+VSNRAY_FUNC
+vector<3, T> decode_gradient(vector<4, T> const& texel, float max_magnitude);
+
+// Normalized gradient, zero where the gradient vanishes
+template <typename T>
+VSNRAY_FUNC
+vector<3, T> decode_normal(vector<4, T> const& texel);
+
+} // visionaray
+
+#include "detail/gradient_volume.inl"
+
+#endif // VSNRAY_GRADIENT_VOLUME_H
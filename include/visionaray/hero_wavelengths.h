@@ -0,0 +1,80 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_HERO_WAVELENGTHS_H
+#define VSNRAY_HERO_WAVELENGTHS_H 1
+
+#include <cstddef>
+
+#include "detail/macros.h"
+#include "math/vector.h"
+#include "spectrum.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Hero wavelength sampling
+//
+// See: Wilkie et al. (2014): Hero wavelength spectral sampling
+//
+// A path carries N wavelengths in [lambda_min..lambda_max). The hero wavelength is
+// chosen uniformly at random, the other wavelengths are rotations of the hero
+// wavelength by multiples of (lambda_max - lambda_min) / N. Radiance is transported
+// as vector<N, T> with one sample per wavelength, the free functions below evaluate
+// SPDs, RGB colors and spectra at the wavelengths and estimate the color of the
+// samples. Materials evaluate their SPDs at the wavelengths of a spectral_shade_record
+// (see shade_record.h). Because the wavelengths are stratified, a few wavelengths per path
+// suffice for low color noise, so that spectral transport costs about as much as
+// RGB transport
+//
+
+template <typename T, size_t N = 4>
+class hero_wavelengths
+{
+public:
+
+    enum { num_samples = N };
+
+    // Range of sampled spectra, which are 0 outside of it
+    static constexpr float  lambda_min  = 400.0f;
+    static constexpr float  lambda_max  = 700.0f;
+
+public:
+
+    VSNRAY_FUNC hero_wavelengths() = default;
+
+    // Hero wavelength at lambda_min + u * (lambda_max - lambda_min), u in [0..1)
+    VSNRAY_FUNC explicit hero_wavelengths(T const& u);
+
+    // Wavelengths that were sampled before (e.g. one lane of a SIMD packet)
+    VSNRAY_FUNC explicit hero_wavelengths(vector<N, T> const& lambdas);
+
+    VSNRAY_FUNC T const& operator[](size_t i) const { return lambdas_[i]; }
+
+    VSNRAY_FUNC vector<N, T> const& lambdas() const { return lambdas_; }
+
+    // Probability density of each of the wavelengths
+    VSNRAY_FUNC T pdf() const;
+
+private:
+
+    vector<N, T> lambdas_;
+
+};
+
+#if !VSNRAY_SPECTRUM_RGB
+static_assert(
+        hero_wavelengths<float>::lambda_min >= spectrum<float>::lambda_min &&
+        hero_wavelengths<float>::lambda_max <= spectrum<float>::lambda_max,
+        "Hero wavelengths outside of the range of sampled spectra"
+        );
+#endif
+
+} // visionaray
+
+#include "detail/hero_wavelengths.inl"
+
+#endif // VSNRAY_HERO_WAVELENGTHS_H
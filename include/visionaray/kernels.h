@@ -9,7 +9,12 @@
 #include <iterator>
 #include <limits>
 
+#include <visionaray/math/aabb.h>
 #include <visionaray/math/vector.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/light_groups.h>
+#include <visionaray/light_tree.h>
+#include <visionaray/macrocell_grid.h>
 #include <visionaray/tags.h>
 
 namespace visionaray
@@ -85,6 +90,33 @@ namespace visionaray
 //      );
 //
 //
+// Options that are not set by make_kernel_params(), assign them afterwards:
+//
+//      sample_lights:      path tracing only: sample the lights explicitly (next event
+//                          estimation) and combine with BRDF sampling using multiple
+//                          importance sampling (default: false)
+//      russian_roulette:   path tracing only: terminate paths randomly, with a probability
+//                          that depends on the path throughput, and reweight the surviving
+//                          paths. num_bounces remains the maximum path length (default: false)
+//      rr_min_bounces:     number of bounces before Russian roulette starts (default: 3)
+//      spectral:           path tracing only: transport radiance at four wavelengths per path
+//                          (hero wavelength sampling, see hero_wavelengths.h). RGB colors are
+//                          upsampled to spectra at these wavelengths. Not supported by the
+//                          wavefront kernel, wavefront_sched throws (default: false)
+//      light_tree:         light_tree built over [lights_begin..lights_end). If set, path
+//                          tracing samples lights proportional to their importance and
+//                          whitted shades the lights of a lightcut (default: empty)
+//      light_cut_threshold:
+//                          whitted only: lights whose importance is less than this fraction
+//                          of the importance of all lights are shaded as clusters, using a
+//                          single representative light per cluster (default: 1E-2)
+//      light_groups:       whitted only: light_groups built over [lights_begin..lights_end).
+//                          Single rays on the CPU shade point and spot lights in SIMD groups,
+//                          if set the groups are not packed per hit point (default: empty)
+//      ao_samples:         ambient occlusion only: number of occlusion rays per pixel (default: 8)
+//      ao_radius:          ambient occlusion only: occluders are only considered if they are
+//                          closer to the surface than this distance (default: 0.1)
+//
 //-------------------------------------------------------------------------------------------------
 
 //-------------------------------------------------------------------------------------------------
@@ -137,6 +169,18 @@ struct kernel_params<
 
     Color bg_color;
     Color ambient_color;
+
+    bool sample_lights;
+    bool russian_roulette;
+    unsigned rr_min_bounces;
+    bool spectral;
+
+    light_tree_ref light_tree;
+    float light_cut_threshold;
+    light_groups_ref<light_type> light_groups;
+
+    unsigned ao_samples;
+    float ao_radius;
 };
 
 template <
@@ -189,6 +233,18 @@ struct kernel_params<
 
     Color bg_color;
     Color ambient_color;
+
+    bool sample_lights;
+    bool russian_roulette;
+    unsigned rr_min_bounces;
+    bool spectral;
+
+    light_tree_ref light_tree;
+    float light_cut_threshold;
+    light_groups_ref<light_type> light_groups;
+
+    unsigned ao_samples;
+    float ao_radius;
 };
 
 template <
@@ -250,6 +306,18 @@ struct kernel_params<
 
     Color bg_color;
     Color ambient_color;
+
+    bool sample_lights;
+    bool russian_roulette;
+    unsigned rr_min_bounces;
+    bool spectral;
+
+    light_tree_ref light_tree;
+    float light_cut_threshold;
+    light_groups_ref<light_type> light_groups;
+
+    unsigned ao_samples;
+    float ao_radius;
 };
 
 template <
@@ -316,6 +384,18 @@ struct kernel_params<
 
     Color bg_color;
     Color ambient_color;
+
+    bool sample_lights;
+    bool russian_roulette;
+    unsigned rr_min_bounces;
+    bool spectral;
+
+    light_tree_ref light_tree;
+    float light_cut_threshold;
+    light_groups_ref<light_type> light_groups;
+
+    unsigned ao_samples;
+    float ao_radius;
 };
 
 
@@ -350,7 +430,16 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bg_color,
-        ambient_color
+        ambient_color,
+        false,
+        false,
+        3,
+        false,
+        light_tree_ref(),
+        1E-2f,
+        {},
+        8,
+        0.1f
         };
 }
 
@@ -388,7 +477,16 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bg_color,
-        ambient_color
+        ambient_color,
+        false,
+        false,
+        3,
+        false,
+        light_tree_ref(),
+        1E-2f,
+        {},
+        8,
+        0.1f
         };
 }
 
@@ -432,7 +530,16 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bg_color,
-        ambient_color
+        ambient_color,
+        false,
+        false,
+        3,
+        false,
+        light_tree_ref(),
+        1E-2f,
+        {},
+        8,
+        0.1f
         };
 }
 
@@ -493,14 +600,167 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bg_color,
-        ambient_color
+        ambient_color,
+        false,
+        false,
+        3,
+        false,
+        light_tree_ref(),
+        1E-2f,
+        {},
+        8,
+        0.1f
+        };
+}
+
+
+
+//-------------------------------------------------------------------------------------------------
+// Parameter struct for the direct volume rendering kernel (dvr::kernel)
+//
+// Use the make_volume_kernel_params() factory function to create:
+//
+//  make_volume_kernel_params(
+//      volume,             3D texture (reference) with scalar voxels
+//      transfunc,          1D texture (reference) with RGBA post-classification transfer
+//                          function, voxel values are used as texture coordinates
+//      bbox,               world space bounds of the volume, texture coordinates are
+//                          (pos - bbox.min) / (bbox.max - bbox.min)
+//      delta               distance between two samples along a ray (world space)
+//      );
+//
+// Options that are not set by make_volume_kernel_params(), assign them afterwards:
+//
+//      grid:               macrocell_grid_ref of a macrocell_grid that was built over the volume
+//                          and classified with the transfer function. If set, regions with zero
+//                          opacity are skipped (default: empty)
+//      opacity_threshold:  rays are terminated when their opacity reaches this value
+//                          (default: 0.999)
+//      preintegrated:      classify ray segments between two samples with the pre-integrated
+//                          transfer function instead of classifying the samples (default: false)
+//      preintegration_table:
+//                          ref() of a preintegration_table that was built from transfunc for
+//                          segments of length delta. Allows for considerably larger steps than
+//                          post-classification, set delta accordingly (default: empty)
+//      adaptive:           adapt the step length to the rate of change of the scalar value and
+//                          to the opacity, see dvr::adaptive_integrator. Transfer function
+//                          opacities refer to steps of length delta. preintegrated is ignored
+//                          (default: false)
+//      adaptive_range:     minimum and maximum step length, relative to delta (default: (0.25, 8))
+//
+//-------------------------------------------------------------------------------------------------
+
+template <typename Volume, typename TransFunc>
+struct volume_kernel_params
+{
+    Volume volume;
+    TransFunc transfunc;
+
+    aabb bbox;
+    float delta;
+
+    macrocell_grid_ref grid;
+    float opacity_threshold;
+
+    bool preintegrated;
+    texture_ref<vec4, 2> preintegration_table;
+
+    bool adaptive;
+    vec2 adaptive_range;
+};
+
+template <typename Volume, typename TransFunc>
+auto make_volume_kernel_params(
+        Volume const&       volume,
+        TransFunc const&    transfunc,
+        aabb const&         bbox,
+        float               delta = 0.01f
+        )
+    -> volume_kernel_params<Volume, TransFunc>
+{
+    return {
+        volume,
+        transfunc,
+        bbox,
+        delta,
+        macrocell_grid_ref(),
+        0.999f,
+        false,
+        texture_ref<vec4, 2>(),
+        false,
+        vec2(0.25f, 8.0f)
+        };
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Parameter struct for the isosurface kernel (isosurface::kernel)
+//
+// Use the make_isosurface_kernel_params() factory function to create:
+//
+//  make_isosurface_kernel_params(
+//      volume,             3D texture (reference) with scalar voxels, use linear filtering
+//      isovalue,           voxel value of the surface
+//      bbox,               world space bounds of the volume, texture coordinates are
+//                          (pos - bbox.min) / (bbox.max - bbox.min)
+//      delta               distance between two samples along a ray (world space)
+//      );
+//
+// Options that are not set by make_isosurface_kernel_params(), assign them afterwards:
+//
+//      grid:               macrocell_grid_ref of a macrocell_grid that was built over the volume
+//                          and classified with classify_isosurface(isovalue). If set, cells that
+//                          cannot contain the surface are skipped (default: empty)
+//      refinement_steps:   number of secant steps to refine the intersection between the two
+//                          samples that enclose the surface (default: 4)
+//      color:              RGBA color of the surface (default: white)
+//
+//-------------------------------------------------------------------------------------------------
+
+template <typename Volume>
+struct isosurface_kernel_params
+{
+    Volume volume;
+    float isovalue;
+
+    aabb bbox;
+    float delta;
+
+    macrocell_grid_ref grid;
+    int refinement_steps;
+
+    vec4 color;
+};
+
+template <typename Volume>
+auto make_isosurface_kernel_params(
+        Volume const&       volume,
+        float               isovalue,
+        aabb const&         bbox,
+        float               delta = 0.01f
+        )
+    -> isosurface_kernel_params<Volume>
+{
+    return {
+        volume,
+        isovalue,
+        bbox,
+        delta,
+        macrocell_grid_ref(),
+        4,
+        vec4(1.0f)
         };
 }
 
 } // visionaray
 
+#include "detail/ambient_occlusion.inl"
+#include "detail/dvr.inl"
+#include "detail/isosurface.inl"
 #include "detail/pathtracing.inl"
+#include "detail/pathtracing_wavefront.inl"
 #include "detail/simple.inl"
+#include "detail/volume_pathtracing.inl"
 #include "detail/whitted.inl"
 
 #endif // VSNRAY_KERNELS_H
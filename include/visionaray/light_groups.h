@@ -0,0 +1,149 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_LIGHT_GROUPS_H
+#define VSNRAY_LIGHT_GROUPS_H 1
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "detail/macros.h"
+#include "math/simd/type_traits.h"
+#include "math/simd/simd.h"
+#include "aligned_vector.h"
+#include "array.h"
+#include "point_light.h"
+#include "spot_light.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Light groups
+//
+// Point and spot lights can be packed into groups of SIMD width (see simd::pack()).
+// A group stores its lights as structure of arrays and evaluates all of them
+// against a single position, e.g. the hit point of a single ray. The group
+// width is the native SIMD width of the CPU
+//
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+using light_group_float = simd::float16;
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+using light_group_float = simd::float8;
+#else
+using light_group_float = simd::float4;
+#endif
+
+template <typename Light>
+struct is_light_group_type : std::false_type {};
+
+template <>
+struct is_light_group_type<point_light<float>> : std::true_type {};
+
+template <>
+struct is_light_group_type<spot_light<float>> : std::true_type {};
+
+// Type of a group of lights of type Light
+template <typename Light>
+using light_group_t = decltype(simd::pack(std::declval<
+        array<Light, simd::num_elements<light_group_float>::value>
+        >()));
+
+
+//-------------------------------------------------------------------------------------------------
+// light_groups_ref
+//
+// Non-owning view of light_groups, can be passed to kernels (kernel_params::light_groups).
+// Empty for light types that cannot be grouped
+//
+
+template <typename Light, typename Enable = void>
+class light_groups_ref
+{
+public:
+
+    VSNRAY_FUNC bool empty() const { return true; }
+    VSNRAY_FUNC size_t num_lights() const { return 0; }
+};
+
+template <typename Light>
+class light_groups_ref<Light, typename std::enable_if<is_light_group_type<Light>::value>::type>
+{
+public:
+
+    using group_type = light_group_t<Light>;
+
+    enum { group_size = simd::num_elements<light_group_float>::value };
+
+public:
+
+    light_groups_ref() = default;
+
+    light_groups_ref(group_type const* groups, size_t num_lights);
+
+    VSNRAY_FUNC bool empty() const { return num_lights_ == 0; }
+    VSNRAY_FUNC size_t num_lights() const { return num_lights_; }
+    VSNRAY_FUNC size_t num_groups() const { return (num_lights_ + group_size - 1) / group_size; }
+
+    // Group index contains the lights [index * group_size..(index + 1) * group_size),
+    // the lanes of the last group past num_lights() are copies of its first light
+    VSNRAY_FUNC group_type const& group(size_t index) const { return groups_[index]; }
+
+private:
+
+    group_type const* groups_ = nullptr;
+    size_t            num_lights_ = 0;
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// light_groups
+//
+// Lights of a scene packed into groups once (e.g. per frame), so that kernels
+// don't have to pack them for each hit point
+//
+
+template <typename Light>
+class light_groups
+{
+public:
+
+    static_assert(is_light_group_type<Light>::value, "Light type cannot be grouped");
+
+    using group_type = light_group_t<Light>;
+
+    enum { group_size = simd::num_elements<light_group_float>::value };
+
+public:
+
+    light_groups() = default;
+
+    template <typename Lights>
+    light_groups(Lights first, Lights last);
+
+    // Pack the lights [first..last)
+    template <typename Lights>
+    void reset(Lights first, Lights last);
+
+    light_groups_ref<Light> ref() const;
+
+    size_t num_groups() const;
+    size_t num_lights() const;
+
+private:
+
+    aligned_vector<group_type, 64> groups_;
+    size_t                         num_lights_ = 0;
+
+};
+
+} // visionaray
+
+#include "detail/light_groups.inl"
+
+#endif // VSNRAY_LIGHT_GROUPS_H
@@ -0,0 +1,208 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_LIGHT_TREE_H
+#define VSNRAY_LIGHT_TREE_H 1
+
+#include <cstddef>
+#include <cstdint>
+
+#include "detail/macros.h"
+#include "math/simd/type_traits.h"
+#include "math/aabb.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+#include "area_light.h"
+#include "point_light.h"
+#include "spot_light.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// light_bounds
+//
+// Conservative bounds for the emission of a light or of a cluster of lights:
+// spatial extent, a cone around axis that contains the emission directions
+// (lights emit into directions up to theta_o + theta_e away from axis), the
+// summed intensity and the smallest attenuation coefficients.
+//
+// See: Conty Estevez and Kulla (2018): Importance sampling of many lights
+// with adaptive tree splitting
+//
+
+struct light_bounds
+{
+    aabb  bbox;
+    vec3  axis;
+    float cos_theta_o;
+    float cos_theta_e;
+    float power;
+    float constant_attenuation;
+    float linear_attenuation;
+    float quadratic_attenuation;
+};
+
+template <typename T>
+light_bounds get_light_bounds(point_light<T> const& light);
+
+template <typename T>
+light_bounds get_light_bounds(spot_light<T> const& light);
+
+template <typename Geometry>
+light_bounds get_light_bounds(area_light<Geometry> const& light);
+
+// Bounds of a cluster that contains the lights of a and b
+light_bounds combine(light_bounds const& a, light_bounds const& b);
+
+// Upper bound for the contribution of the lights to position p
+template <typename T>
+VSNRAY_FUNC T light_importance(light_bounds const& lb, vector<3, T> const& p);
+
+// Upper bound for the contribution of the lights to a surface at p with normal n
+template <typename T>
+VSNRAY_FUNC T light_importance(light_bounds const& lb, vector<3, T> const& p, vector<3, T> const& n);
+
+
+//-------------------------------------------------------------------------------------------------
+// light_tree_node
+//
+
+struct light_tree_node
+{
+    light_bounds bounds;
+
+    // Inner nodes: index of the first of two children, leafs: index of the light
+    unsigned first;
+
+    // 0 for inner nodes, 1 for leafs
+    unsigned num_lights;
+
+    // Light that represents the lights of the subtree, and the ratio of
+    // the power of all the lights in the subtree to its power
+    unsigned representative;
+    float    representative_scale;
+
+    VSNRAY_FUNC bool is_inner() const { return num_lights == 0; }
+    VSNRAY_FUNC bool is_leaf() const { return num_lights != 0; }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// light_tree_ref
+//
+// Non-owning view of a light_tree, can be passed to kernels (kernel_params::light_tree).
+// Light indices refer to the range of lights the tree was built from
+//
+
+class light_tree_ref
+{
+public:
+
+    light_tree_ref() = default;
+
+    light_tree_ref(light_tree_node const* nodes, uint64_t const* trails, size_t num_nodes);
+
+    VSNRAY_FUNC bool empty() const { return num_nodes_ == 0; }
+    VSNRAY_FUNC size_t num_nodes() const { return num_nodes_; }
+    VSNRAY_FUNC light_tree_node const& node(size_t index) const { return nodes_[index]; }
+
+    // Select a light with probability proportional to its importance for position p,
+    // u must be uniformly distributed in [0..1). Returns the index of the light, or
+    // -1 if no light contributes to p
+    VSNRAY_FUNC int sample(vector<3, float> const& p, float u, float& pmf) const;
+
+    // The probability that sample() selects light_index for position p
+    VSNRAY_FUNC float pmf(vector<3, float> const& p, unsigned light_index) const;
+
+    // Call f(light_index, scale) for a set of lights that represents all the lights that
+    // contribute to p (lightcut). Subtrees whose importance is less than threshold times
+    // the importance of the whole tree for all active lanes are represented by a single
+    // light, whose contribution must be multiplied by scale. Lights that cannot contribute
+    // are skipped, a threshold of 0 visits all other lights individually (with scale = 1)
+    template <typename T, typename Func>
+    VSNRAY_FUNC void cut(
+            vector<3, T> const&         p,
+            vector<3, T> const&         n,
+            simd::mask_type_t<T> const& active,
+            float                       threshold,
+            Func                        f
+            ) const;
+
+    // Call f(light_index) for all lights whose bounding box, extended by eps,
+    // contains p
+    template <typename Func>
+    VSNRAY_FUNC void for_each_light_at(vector<3, float> const& p, float eps, Func f) const;
+
+private:
+
+    light_tree_node const* nodes_  = nullptr;
+    uint64_t const*        trails_ = nullptr;
+    size_t                 num_nodes_ = 0;
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// light_tree
+//
+// Binary tree over the lights of a scene, so that the lights that are important
+// for a position can be sampled or gathered in time that grows logarithmically
+// with the number of lights. Leafs store a single light, inner nodes store the
+// light with the most power in their subtree as representative. The tree is
+// built on the host, split positions are the median of the light centers
+//
+
+class light_tree
+{
+public:
+
+    light_tree() = default;
+
+    template <typename Lights>
+    light_tree(Lights first, Lights last);
+
+    // Build the tree over [first..last), lights must support get_light_bounds()
+    template <typename Lights>
+    void build(Lights first, Lights last);
+
+    light_tree_ref ref() const;
+
+    size_t num_nodes() const;
+    size_t num_lights() const;
+
+    light_tree_node const& node(size_t index) const;
+
+private:
+
+    struct build_light
+    {
+        light_bounds bounds;
+        unsigned     index;
+    };
+
+    void build_recursive(
+            aligned_vector<build_light>& lights,
+            aligned_vector<float> const& powers,
+            size_t                       first,
+            size_t                       last,
+            size_t                       node_index,
+            uint64_t                     trail,
+            unsigned                     depth
+            );
+
+    aligned_vector<light_tree_node> nodes_;
+
+    // Per light: path from the root to the leaf, bit i is set if the
+    // right child was taken at depth i
+    aligned_vector<uint64_t> trails_;
+
+};
+
+} // visionaray
+
+#include "detail/light_tree.inl"
+
+#endif // VSNRAY_LIGHT_TREE_H
@@ -0,0 +1,167 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_MACROCELL_GRID_H
+#define VSNRAY_MACROCELL_GRID_H 1
+
+#include <cstddef>
+#include <cstdint>
+
+#include "detail/macros.h"
+#include "math/forward.h"
+#include "math/ray.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// macrocell_grid_ref
+//
+// Non-owning view of a macrocell_grid, can be passed to kernels (volume_kernel_params::grid).
+// Positions and rays are in texture coordinates of the volume, i.e. the volume is [0..1)^3
+//
+
+class macrocell_grid_ref
+{
+public:
+
+    macrocell_grid_ref() = default;
+
+    macrocell_grid_ref(uint8_t const* empty, vec3i const& dims, vec3 const& cell_extent);
+
+    VSNRAY_FUNC bool empty() const { return empty_ == nullptr; }
+
+    VSNRAY_FUNC vec3i dims() const { return dims_; }
+
+    VSNRAY_FUNC vec3 cell_extent() const { return cell_extent_; }
+
+    // Empty flags (0 or 1) of the cells in x-major order
+    VSNRAY_FUNC uint8_t const* data() const { return empty_; }
+
+    // Cells that the transfer function maps to zero opacity
+    VSNRAY_FUNC bool is_empty(int x, int y, int z) const;
+
+    // First interval [t0..t1) along ray, starting at tmin, that is covered by consecutive
+    // non-empty cells. t1 is clipped to tmax, t0 = t1 = tmax if there is no such interval
+    VSNRAY_FUNC void next_interval(
+            basic_ray<float> const& ray,
+            float                   tmin,
+            float                   tmax,
+            float&                  t0,
+            float&                  t1
+            ) const;
+
+private:
+
+    uint8_t const* empty_ = nullptr;
+    vec3i          dims_  = vec3i(0);
+    vec3           cell_extent_ = vec3(0.0f);
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// majorant_grid_ref
+//
+// Non-owning view of the maximum voxel values of the cells of a macrocell_grid, e.g. to
+// bound the density of participating media for delta and ratio tracking. Positions are
+// in texture coordinates of the volume, as with macrocell_grid_ref
+//
+
+class majorant_grid_ref
+{
+public:
+
+    majorant_grid_ref() = default;
+
+    majorant_grid_ref(float const* majorants, vec3i const& dims, vec3 const& cell_extent);
+
+    VSNRAY_FUNC bool empty() const { return majorants_ == nullptr; }
+
+    VSNRAY_FUNC vec3i dims() const { return dims_; }
+
+    VSNRAY_FUNC vec3 cell_extent() const { return cell_extent_; }
+
+    // Cells are stored in x-major order
+    VSNRAY_FUNC float const* data() const { return majorants_; }
+
+    // Upper bound of the values that can be sampled inside the cell
+    VSNRAY_FUNC float majorant(int x, int y, int z) const;
+
+private:
+
+    float const* majorants_ = nullptr;
+    vec3i        dims_ = vec3i(0);
+    vec3         cell_extent_ = vec3(0.0f);
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// macrocell_grid
+//
+// Uniform grid of macrocells over a volume for empty space skipping. Each cell stores
+// the range of the voxel values that can be sampled inside the cell with nearest or
+// linear filtering (i.e. including a border of one voxel). classify() marks the cells
+// whose value range the transfer function maps to zero opacity, kernels skip those
+// cells with a 3D DDA. build() must be called when the volume changes, classify() when
+// the transfer function changes (this is cheap, only the cells are visited).
+// classify_isosurface() marks the cells that cannot contain a given isosurface instead.
+//
+// Voxel values are converted to float and are used as transfer function coordinates,
+// as with tex1D(transfunc, tex3D(volume, coord)). majorants() provides the maximum
+// values of the cells, independent of the transfer function
+//
+
+class macrocell_grid
+{
+public:
+
+    macrocell_grid() = default;
+
+    // Compute the value ranges of cells of cell_size^3 voxels
+    template <typename Volume>
+    void build(Volume const& volume, int cell_size = 8);
+
+    // Mark the cells where the transfer function (RGBA, 1D) has zero opacity
+    template <typename TransFunc>
+    void classify(TransFunc const& transfunc);
+
+    // Mark the cells whose value range does not contain isovalue
+    void classify_isosurface(float isovalue);
+
+    macrocell_grid_ref ref() const;
+
+    majorant_grid_ref majorants() const;
+
+    vec3i dims() const;
+
+    // Value range of a cell
+    vec2 value_range(int x, int y, int z) const;
+
+    bool is_empty(int x, int y, int z) const;
+
+    size_t num_empty_cells() const;
+
+private:
+
+    vec3i dims_ = vec3i(0);
+    vec3  cell_extent_ = vec3(0.0f);
+
+    aligned_vector<vec2>    value_ranges_;
+    aligned_vector<float>   majorants_;
+    aligned_vector<uint8_t> empty_;
+
+    size_t linear_index(int x, int y, int z) const;
+
+};
+
+} // visionaray
+
+#include "detail/macrocell_grid.inl"
+
+#endif // VSNRAY_MACROCELL_GRID_H
@@ -6,6 +6,8 @@
 #ifndef VSNRAY_MATERIAL_H
 #define VSNRAY_MATERIAL_H 1
 
+#include <cstddef>
+
 #include "detail/macros.h"
 #include "math/vector.h"
 #include "brdf.h"
@@ -34,6 +36,20 @@ namespace visionaray
 //      modifiable parameter sampler:   implements sampler interface to get pseudo random
 //                                      numbers or quasi random numbers
 //
+//  - pdf():
+//      const parameter shade_record:   shading info (normal, view_dir, light_dir, ...)
+//      return type:                    probability density that sample() generates
+//                                      light_dir, 0 for perfectly specular reflection
+//                                      (used for multiple importance sampling)
+//
+//  - albedo():
+//      return type:                    spectrum, reflectance of the material w/o
+//                                      texture (used for albedo outputs of the kernels)
+//
+//  shade() and sample() of the built-in materials also accept spectral_shade_records
+//  (see shade_record.h). They then evaluate their spectra and the light intensity at
+//  the hero wavelengths of the shade record only and return one sample per wavelength
+//
 //
 // Built-in materials
 //
@@ -51,7 +67,8 @@ namespace visionaray
 //  - plastic:
 //      OpenGL-like material with a diffuse BRDF (Lambertian reflection) and a specular BRDF
 //      (Blinn reflection model). When being sampled, the diffuse and specular terms
-//      are used to determine whether the diffuse or specular BRDF will contribute:
+//      are used to determine whether the diffuse or specular BRDF generates the reflected
+//      direction. The returned value and pdf account for both BRDFs:
 //
 //          Pd = mean_value(cd) * kd        /* probability of diff. reflection */
 //          Ps = mean_value(cs) * ks        /* probability of spec. reflection */
@@ -91,6 +108,7 @@ public:
 public:
 
     VSNRAY_FUNC spectrum<T> ambient() const;
+    VSNRAY_FUNC spectrum<T> albedo() const;
 
     template <typename SR>
     VSNRAY_FUNC spectrum<typename SR::scalar_type> shade(SR const& sr) const;
@@ -102,6 +120,20 @@ public:
             U&              pdf,
             Sampler&        sampler) const;
 
+    template <typename SR, size_t N>
+    VSNRAY_FUNC vector<N, typename SR::scalar_type> shade(spectral_shade_record<SR, N> const& sr) const;
+
+    template <typename SR, size_t N, typename U, typename Sampler>
+    VSNRAY_FUNC vector<N, U> sample(
+            spectral_shade_record<SR, N> const& sr,
+            vector<3, U>&                       refl_dir,
+            U&                                  pdf,
+            Sampler&                            sampler
+            ) const;
+
+    template <typename SR>
+    VSNRAY_FUNC typename SR::scalar_type pdf(SR const& sr) const;
+
     // deprecated!
     VSNRAY_FUNC void VSNRAY_DEPRECATED set_ce(spectrum<T> const& ce);
     VSNRAY_FUNC spectrum<T> VSNRAY_DEPRECATED get_ce() const;
@@ -148,6 +180,7 @@ public:
 public:
 
     VSNRAY_FUNC spectrum<T> ambient() const;
+    VSNRAY_FUNC spectrum<T> albedo() const;
 
     template <typename SR>
     VSNRAY_FUNC
@@ -169,6 +202,20 @@ public:
             Sampler&                        sampler
             ) const;
 
+    template <typename SR, size_t N>
+    VSNRAY_FUNC vector<N, typename SR::scalar_type> shade(spectral_shade_record<SR, N> const& sr) const;
+
+    template <typename SR, size_t N, typename U, typename Sampler>
+    VSNRAY_FUNC vector<N, U> sample(
+            spectral_shade_record<SR, N> const& sr,
+            vector<3, U>&                       refl_dir,
+            U&                                  pdf,
+            Sampler&                            sampler
+            ) const;
+
+    template <typename SR>
+    VSNRAY_FUNC typename SR::scalar_type pdf(SR const& sr) const;
+
 
     // deprecated!
     VSNRAY_FUNC void VSNRAY_DEPRECATED set_ca(spectrum<T> const& ca);
@@ -240,6 +287,7 @@ public:
 
     // TODO: no support for  ambient (function returns 0.0)
     VSNRAY_FUNC spectrum<T> ambient() const;
+    VSNRAY_FUNC spectrum<T> albedo() const;
 
     template <typename SR>
     VSNRAY_FUNC
@@ -253,6 +301,20 @@ public:
             Sampler&        sampler
             ) const;
 
+    template <typename SR, size_t N>
+    VSNRAY_FUNC vector<N, typename SR::scalar_type> shade(spectral_shade_record<SR, N> const& sr) const;
+
+    template <typename SR, size_t N, typename U, typename Sampler>
+    VSNRAY_FUNC vector<N, U> sample(
+            spectral_shade_record<SR, N> const& sr,
+            vector<3, U>&                       refl_dir,
+            U&                                  pdf,
+            Sampler&                            sampler
+            ) const;
+
+    template <typename SR>
+    VSNRAY_FUNC typename SR::scalar_type pdf(SR const& sr) const;
+
 
     // deprecated!
     VSNRAY_FUNC void VSNRAY_DEPRECATED set_cr(spectrum<T> const& cr);
@@ -310,6 +372,7 @@ public:
 public:
 
     VSNRAY_FUNC spectrum<T> ambient() const;
+    VSNRAY_FUNC spectrum<T> albedo() const;
 
     template <typename SR>
     VSNRAY_FUNC
@@ -323,6 +386,20 @@ public:
             Sampler&        sampler
             ) const;
 
+    template <typename SR, size_t N>
+    VSNRAY_FUNC vector<N, typename SR::scalar_type> shade(spectral_shade_record<SR, N> const& sr) const;
+
+    template <typename SR, size_t N, typename U, typename Sampler>
+    VSNRAY_FUNC vector<N, U> sample(
+            spectral_shade_record<SR, N> const& sr,
+            vector<3, U>&                       refl_dir,
+            U&                                  pdf,
+            Sampler&                            sampler
+            ) const;
+
+    template <typename SR>
+    VSNRAY_FUNC typename SR::scalar_type pdf(SR const& sr) const;
+
 
     // deprecated!
     VSNRAY_FUNC void VSNRAY_DEPRECATED set_ca(spectrum<T> const& ca);
@@ -375,6 +452,18 @@ private:
     lambertian<T>   diffuse_brdf_;
     blinn<T>        specular_brdf_;
 
+    // Probability to sample the diffuse BRDF
+    VSNRAY_FUNC T prob_diffuse() const;
+
+    // Sample the diffuse or the specular BRDF, pdf accounts for both
+    template <typename SR, typename U, typename Sampler>
+    VSNRAY_FUNC void sample_dir(
+            SR const&       sr,
+            vector<3, U>&   refl_dir,
+            U&              pdf,
+            Sampler&        sampler
+            ) const;
+
     template <typename SR, typename V>
     VSNRAY_FUNC spectrum<T> cd_impl(SR const& sr, V const& n, V const& wo, V const& wi) const;
 
@@ -336,19 +336,25 @@ inline hit_record<basic_ray<T>, primitive<unsigned>> pack(
         array<hit_record<ray, primitive<unsigned>>, N> const& hrs
         )
 {
+    using float_array = aligned_array_t<T>;
+    using int_array = aligned_array_t<int_type_t<T>>;
+    using mask_array = aligned_array_t<mask_type_t<T>>;
+
     hit_record<basic_ray<T>, primitive<unsigned>> result;
 
-    int* hit = reinterpret_cast<int*>(&result.hit);
-    int* prim_id = reinterpret_cast<int*>(&result.prim_id);
-    int* geom_id = reinterpret_cast<int*>(&result.geom_id);
-    float* t = reinterpret_cast<float*>(&result.t);
+    // Fill arrays and construct the SIMD types from them, writing
+    // to the SIMD types through int* / float* violates strict aliasing
+    mask_array hit;
+    int_array prim_id;
+    int_array geom_id;
+    float_array t;
     array<vec3, N> isect_pos;
-    float* u = reinterpret_cast<float*>(&result.u);
-    float* v = reinterpret_cast<float*>(&result.v);
+    float_array u;
+    float_array v;
 
     for (size_t i = 0; i < N; ++i)
     {
-        hit[i]       = hrs[i].hit ? 0xFFFFFFFF : 0x00000000;
+        hit[i]       = hrs[i].hit;
         prim_id[i]   = hrs[i].prim_id;
         geom_id[i]   = hrs[i].geom_id;
         t[i]         = hrs[i].t;
@@ -357,6 +363,12 @@ inline hit_record<basic_ray<T>, primitive<unsigned>> pack(
         v[i]         = hrs[i].v;
     }
 
+    result.hit       = mask_type_t<T>(hit);
+    result.prim_id   = int_type_t<T>(prim_id);
+    result.geom_id   = int_type_t<T>(geom_id);
+    result.t         = T(t);
+    result.u         = T(u);
+    result.v         = T(v);
     result.isect_pos = pack(isect_pos);
 
     return result;
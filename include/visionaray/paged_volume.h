@@ -0,0 +1,262 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_PAGED_VOLUME_H
+#define VSNRAY_PAGED_VOLUME_H 1
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "math/simd/type_traits.h"
+#include "math/ray.h"
+#include "math/vector.h"
+#include "texture/texture.h"
+#include "aligned_vector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Out-of-core volumes
+//
+// A paged volume file stores a volume of scalar voxels in pages of page_size^3 voxels
+// (32^3 by default) and a coarse level with the average of each page. paged_volume_writer
+// creates such files slice by slice, so the volume never has to fit into memory.
+//
+// paged_volume opens a file and keeps the coarse level and at most memory_budget bytes of
+// pages in memory. Sampling paged_volume::ref() with tex3D() (all filter and address
+// modes) records the pages that are accessed; voxels of pages that are not resident are
+// interpolated from the coarse level. update(), called between frames and not concurrently
+// with rendering, loads the pages requested in the last frame and pages prefetched along
+// rays with prefetch(), and evicts the least recently used pages if the budget is
+// exhausted. Images thus converge to full resolution over a few frames.
+//
+// tex3D() returns float (or SIMD float), voxels of integer and unorm types are converted
+// the same way as with float(voxel)
+//
+
+namespace detail
+{
+
+// File layout: header, coarse level (float per page, x-major), pages (x-major) starting at
+// pages_offset. Voxels of a page are x-major, pages at the borders are padded
+struct paged_volume_header
+{
+    char            magic[8];
+    std::uint32_t   size[3];
+    std::uint32_t   page_bits;
+    std::uint32_t   texel_size;
+    std::uint32_t   reserved;
+};
+
+static char const paged_volume_magic[8] = { 'V', 'S', 'N', 'R', 'P', 'V', 'O', 'L' };
+
+// Texels of a paged volume as seen by the filter functions
+template <typename T>
+struct paged_texels
+{
+    T const*                pages;      // Resident pages, indexed by slot
+    int const*              page_table; // Slot of each page, -1 if not resident
+    float const*            coarse;     // Average of each page
+    std::atomic<unsigned>*  last_use;   // Frame in which each page was last accessed
+    unsigned const*         frame;      // Current frame
+    vec3i                   num_pages;
+    int                     page_bits;
+
+    float fetch(int x, int y, int z) const;
+    float coarse_value(int x, int y, int z) const;
+};
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// paged_volume_ref, use with tex3D()
+//
+
+template <typename T>
+class paged_volume_ref : public texture_params_base<3>
+{
+public:
+
+    using value_type = T;
+    enum { dimensions = 3 };
+
+public:
+
+    paged_volume_ref() = default;
+
+    paged_volume_ref(detail::paged_texels<T> const& texels, vec3i const& size)
+        : texels_(texels)
+        , size_(size)
+    {
+    }
+
+    detail::paged_texels<T> const& texels() const { return texels_; }
+
+    vec3i size() const { return size_; }
+
+    int width() const { return size_.x; }
+    int height() const { return size_.y; }
+    int depth() const { return size_.z; }
+
+private:
+
+    detail::paged_texels<T> texels_;
+    vec3i size_;
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// paged_volume
+//
+
+template <typename T>
+class paged_volume
+{
+public:
+
+    using value_type = T;
+    using ref_type   = paged_volume_ref<T>;
+
+    // Open a paged volume file, throws std::runtime_error if that fails
+    paged_volume(std::string const& filename, size_t memory_budget);
+
+    paged_volume(paged_volume const&) = delete;
+    paged_volume& operator=(paged_volume const&) = delete;
+
+    // Texture reference with linear filtering and clamping, valid as long as the volume
+    ref_type ref() const;
+
+    vec3i size() const;
+
+    // Edge length of the pages in voxels
+    int page_size() const;
+
+    // Number of pages along each axis
+    vec3i num_pages() const;
+
+    size_t max_resident_pages() const;
+    size_t resident_pages() const;
+
+    // Page (px,py,pz) is in memory
+    bool is_resident(int px, int py, int pz) const;
+
+    // Request the pages that a ray in texture coordinates ([0..1]^3) traverses up to tmax,
+    // in the order of traversal. Requests are served in update() after the pages that
+    // were accessed in the last frame, if the budget allows
+    void prefetch(basic_ray<float> const& ray, float tmax = std::numeric_limits<float>::max());
+
+    // Load requested pages, at most max_loads, and start a new frame. Returns the number
+    // of pages that were loaded. Must not be called concurrently with rendering
+    size_t update(size_t max_loads = size_t(-1));
+
+    // Number of pages that were read from the file since the volume was opened
+    size_t pages_loaded() const;
+
+private:
+
+    std::ifstream file_;
+
+    vec3i size_;
+    vec3i num_pages_;
+    int page_bits_;
+
+    size_t page_texels_;
+    std::streamoff pages_offset_;
+
+    std::vector<float> coarse_;
+
+    // Pages in memory, max_resident_pages() slots of page_texels_
+    aligned_vector<T> slots_;
+    size_t num_slots_;
+
+    std::vector<int> page_table_;
+    std::vector<int> slot_page_;
+
+    std::unique_ptr<std::atomic<unsigned>[]> last_use_;
+    unsigned frame_ = 1;
+
+    std::vector<int> prefetch_;
+
+    size_t resident_pages_ = 0;
+    size_t pages_loaded_ = 0;
+
+    int page_index(int px, int py, int pz) const;
+
+    void load(int page, int slot);
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// paged_volume_writer
+//
+// Write a volume slice by slice (x-major, width * height voxels each) in z order,
+// page_size slices are buffered in memory
+//
+
+template <typename T>
+class paged_volume_writer
+{
+public:
+
+    // Create a paged volume file, throws std::runtime_error if that fails
+    paged_volume_writer(std::string const& filename, vec3i const& size, int page_bits = 5);
+
+    // Closes the file if close() was not called before, errors are ignored
+   ~paged_volume_writer();
+
+    paged_volume_writer(paged_volume_writer const&) = delete;
+    paged_volume_writer& operator=(paged_volume_writer const&) = delete;
+
+    void add_slice(T const* slice);
+
+    // Write the remaining pages and the coarse level, throws std::runtime_error if not all
+    // slices were added or writing fails
+    void close();
+
+private:
+
+    std::ofstream file_;
+
+    vec3i size_;
+    vec3i num_pages_;
+    int page_bits_;
+
+    std::streamoff pages_offset_;
+
+    // Slices of the current row of pages
+    aligned_vector<T> slab_;
+    int slices_;
+    int slab_slices_;
+
+    std::vector<float> coarse_;
+
+    void write_slab();
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Sample a paged volume, returns the coarse level interpolation for voxels that are not
+// resident and requests their pages
+//
+
+template <typename T, typename FloatT>
+inline FloatT tex3D(paged_volume_ref<T> const& tex, vector<3, FloatT> const& coord);
+
+} // visionaray
+
+#include "detail/paged_volume.inl"
+
+#endif // VSNRAY_PAGED_VOLUME_H
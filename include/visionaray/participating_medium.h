@@ -0,0 +1,121 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_PARTICIPATING_MEDIUM_H
+#define VSNRAY_PARTICIPATING_MEDIUM_H 1
+
+#include "detail/macros.h"
+#include "math/simd/type_traits.h"
+#include "math/aabb.h"
+#include "math/ray.h"
+#include "math/vector.h"
+#include "macrocell_grid.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// participating_medium
+//
+// Heterogeneous medium that absorbs and scatters light (e.g. smoke or clouds). The
+// extinction coefficient at a position is sigma_t times the density that is sampled from
+// a 3D texture (reference). The texture coordinates of a world space position are
+// (pos - bbox.min) / (bbox.max - bbox.min), as with the direct volume rendering kernel.
+//
+// majorants must be the majorant grid of a macrocell_grid that was built over the
+// density volume, delta and ratio tracking take steps that are proportional to the
+// majorant of the cells they traverse, so that sparse media are crossed with few steps.
+//
+// Scattering is described by the single scattering albedo (sigma_s / sigma_t) and the
+// Henyey-Greenstein phase function with asymmetry parameter g (g > 0: forward scattering).
+//
+// Use make_participating_medium() to create, and volume_pathtracing::kernel to render
+//
+
+template <typename Volume>
+struct participating_medium
+{
+    Volume density;
+    aabb bbox;
+    majorant_grid_ref majorants;
+
+    float sigma_t;
+    vec3 albedo;
+    float g;
+};
+
+template <typename Volume>
+participating_medium<Volume> make_participating_medium(
+        Volume const&               density,
+        aabb const&                 bbox,
+        majorant_grid_ref const&    majorants,
+        float                       sigma_t,
+        vec3 const&                 albedo = vec3(1.0f),
+        float                       g = 0.0f
+        );
+
+
+//-------------------------------------------------------------------------------------------------
+// Henyey-Greenstein phase function
+//
+// cos_theta is the cosine of the angle between the propagation directions before and
+// after scattering. sample_henyey_greenstein() returns a new propagation direction for
+// a ray with (normalized) direction dir, the pdf of the sample is the phase function
+//
+
+template <typename T>
+VSNRAY_FUNC
+T henyey_greenstein(T const& cos_theta, float g);
+
+template <typename T, typename Sampler>
+VSNRAY_FUNC
+vector<3, T> sample_henyey_greenstein(vector<3, T> const& dir, float g, Sampler& samp);
+
+
+//-------------------------------------------------------------------------------------------------
+// Delta tracking (Woodcock tracking)
+//
+// Sample the distance to the next real collision along ray in [tmin..tmax), with the
+// majorant of each grid cell as the extinction of the (homogenized) medium. Returns
+// tmax for lanes without a collision in that range and for lanes that are not active.
+// Works with float and SIMD rays
+//
+
+template <typename Volume, typename S, typename Sampler>
+VSNRAY_FUNC
+S delta_tracking(
+        participating_medium<Volume> const& medium,
+        basic_ray<S> const&                 ray,
+        S const&                            tmin,
+        S const&                            tmax,
+        simd::mask_type_t<S>                active,
+        Sampler&                            samp
+        );
+
+
+//-------------------------------------------------------------------------------------------------
+// Ratio tracking
+//
+// Unbiased estimate of the transmittance along ray in [tmin..tmax), see: Novak et al.
+// (2014): Residual ratio tracking for estimating attenuation in participating media.
+// Returns 1 for lanes that are not active
+//
+
+template <typename Volume, typename S, typename Sampler>
+VSNRAY_FUNC
+S ratio_tracking(
+        participating_medium<Volume> const& medium,
+        basic_ray<S> const&                 ray,
+        S const&                            tmin,
+        S const&                            tmax,
+        simd::mask_type_t<S>                active,
+        Sampler&                            samp
+        );
+
+} // visionaray
+
+#include "detail/participating_medium.inl"
+
+#endif // VSNRAY_PARTICIPATING_MEDIUM_H
@@ -48,6 +48,12 @@ struct pixel_traits<PF_R32F>
     typedef float type;
 };
 
+template <>
+struct pixel_traits<PF_RG32F>
+{
+    typedef vector<2, float> type;
+};
+
 template <>
 struct pixel_traits<PF_RGB32F>
 {
@@ -61,6 +67,23 @@ struct pixel_traits<PF_RGBA32F>
 };
 
 
+//-------------------------------------------------------------------------------------------------
+// Integer formats
+//
+
+template <>
+struct pixel_traits<PF_R32I>
+{
+    typedef int type;
+};
+
+template <>
+struct pixel_traits<PF_R32UI>
+{
+    typedef unsigned type;
+};
+
+
 //-------------------------------------------------------------------------------------------------
 // Depth / stencil formats
 //
@@ -0,0 +1,88 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_PREINTEGRATION_TABLE_H
+#define VSNRAY_PREINTEGRATION_TABLE_H 1
+
+#include <functional>
+#include <memory>
+
+#include "detail/thread_pool.h"
+#include "math/vector.h"
+#include "texture/texture.h"
+#include "aligned_vector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// preintegration_table
+//
+// Pre-integrated transfer function, see: Engel et al. (2001): High-quality pre-integrated
+// volume rendering using hardware-accelerated pixel shading.
+//
+// Entry (sf, sb) of the 2D RGBA table holds the premultiplied color and the opacity of a
+// ray segment of length delta along which the scalar value changes linearly from sf (front)
+// to sb (back). The segments are integrated numerically with a resolution that follows the
+// texels of the transfer function, so that thin features of the transfer function are not
+// missed when the volume is sampled with large steps.
+//
+// Opacities of the transfer function refer to segments of length delta_ref (i.e. the step
+// size the transfer function was designed for), segment opacities are corrected for
+// delta / delta_ref. The table must be rebuilt when the transfer function or the step size
+// of the kernel change. Rows of the table are distributed over the threads of a thread pool
+// that may be shared with a scheduler.
+//
+// Use the table with the direct volume rendering kernel (volume_kernel_params::preintegrated)
+//
+
+class preintegration_table
+{
+public:
+
+    // Create a table with its own thread pool
+    explicit preintegration_table(unsigned num_threads);
+
+    // Create a table that submits its jobs to a shared thread pool
+    explicit preintegration_table(std::shared_ptr<thread_pool> pool, int priority = thread_pool::Normal);
+
+    // Integrate the 1D RGBA transfer function (with linear filtering and clamping, as
+    // sampled by the kernel) for segments of length delta, creates size x size entries.
+    // Blocks until done
+    template <typename TransFunc>
+    void build(TransFunc const& transfunc, float delta, float delta_ref, int size = 256);
+
+    // Texture reference with linear filtering, x is sf and y is sb
+    texture_ref<vec4, 2> ref() const;
+
+    int size() const;
+
+    // Entry for the scalar values (i + 0.5) / size and (j + 0.5) / size
+    vec4 const& operator()(int i, int j) const;
+
+    // Wall clock time of the last call to build() in milliseconds
+    double last_build_time() const;
+
+private:
+
+    std::shared_ptr<thread_pool> pool_;
+    int priority_;
+
+    int size_ = 0;
+
+    double last_build_time_ = 0.0;
+
+    aligned_vector<vec4> data_;
+
+    // Process rows [0..size) on the thread pool, blocks until done
+    void parallel_rows(std::function<void(int)> const& func);
+
+};
+
+} // visionaray
+
+#include "detail/preintegration_table.inl"
+
+#endif // VSNRAY_PREINTEGRATION_TABLE_H
@@ -7,6 +7,7 @@
 #define VSNRAY_RENDER_TARGET_H 1
 
 #include "detail/macros.h"
+#include "math/matrix.h"
 #include "pixel_traits.h"
 
 namespace visionaray
@@ -86,6 +87,101 @@ struct render_target_ref
 
 };
 
+
+//-------------------------------------------------------------------------------------------------
+// Render target ref with AOV buffers
+//
+// Besides color and depth, provides buffers for the attributes of the first hit
+// (AOVs): normal, albedo, primitive and geometry ids, and motion vectors. Motion
+// vectors are the offsets in pixels from the position of the hit point in the
+// current frame to its position in the previous frame. prev_view_proj is the
+// view-projection matrix of the previous frame. Buffers whose pixel format is
+// PF_UNSPECIFIED are not written to
+//
+
+template <
+    pixel_format ColorFormat,
+    pixel_format DepthFormat,
+    pixel_format NormalFormat,
+    pixel_format AlbedoFormat,
+    pixel_format IdFormat,
+    pixel_format MotionFormat
+    >
+struct aov_render_target_ref
+{
+    using color_type  = typename pixel_traits<ColorFormat>::type;
+    using depth_type  = typename pixel_traits<DepthFormat>::type;
+    using normal_type = typename pixel_traits<NormalFormat>::type;
+    using albedo_type = typename pixel_traits<AlbedoFormat>::type;
+    using id_type     = typename pixel_traits<IdFormat>::type;
+    using motion_type = typename pixel_traits<MotionFormat>::type;
+
+    VSNRAY_FUNC color_type* color()
+    {
+        return color_;
+    }
+
+    VSNRAY_FUNC depth_type* depth()
+    {
+        return depth_;
+    }
+
+    VSNRAY_FUNC normal_type* normal()
+    {
+        return normal_;
+    }
+
+    VSNRAY_FUNC albedo_type* albedo()
+    {
+        return albedo_;
+    }
+
+    VSNRAY_FUNC id_type* prim_id()
+    {
+        return prim_id_;
+    }
+
+    VSNRAY_FUNC id_type* geom_id()
+    {
+        return geom_id_;
+    }
+
+    VSNRAY_FUNC motion_type* motion()
+    {
+        return motion_;
+    }
+
+    VSNRAY_FUNC mat4 const& prev_view_proj() const
+    {
+        return prev_view_proj_;
+    }
+
+    VSNRAY_FUNC int width() const
+    {
+        return width_;
+    }
+
+    VSNRAY_FUNC int height() const
+    {
+        return height_;
+    }
+
+    // Public, to allow for aggregate initialization!
+    color_type*  color_;
+    depth_type*  depth_;
+    normal_type* normal_;
+    albedo_type* albedo_;
+    id_type*     prim_id_;
+    id_type*     geom_id_;
+    motion_type* motion_;
+
+    mat4 prev_view_proj_;
+
+    int width_;
+    int height_;
+
+};
+
 } // visionaray
 
 #endif // VSNRAY_RENDER_TARGET_H
@@ -15,6 +15,11 @@ namespace visionaray
 //-------------------------------------------------------------------------------------------------
 // Result record that the builtin visionaray kernels return
 //
+// Besides color, the builtin kernels store the attributes of the first surface that
+// was hit (AOVs). They are written to the respective buffers of render targets that
+// have them (see aov_buffer_rt). Depth and motion vectors are computed from isect_pos
+// by the scheduler. Lanes that hit nothing have prim_id = geom_id = -1
+//
 
 template <typename T>
 class result_record
@@ -22,6 +27,7 @@ class result_record
 public:
 
     using scalar_type = T;
+    using int_type    = simd::int_type_t<T>;
     using mask_type   = simd::mask_type_t<T>;
     using vec_type    = vector<3, T>;
     using color_type  = vector<4, T>;
@@ -33,6 +39,10 @@ public:
         , color(0.0)
         , depth(0.0)
         , isect_pos(0.0)
+        , normal(0.0)
+        , albedo(0.0)
+        , prim_id(-1)
+        , geom_id(-1)
     {
     }
 
@@ -41,6 +51,12 @@ public:
     scalar_type depth;
     vec_type    isect_pos;
 
+    // AOVs
+    vec_type    normal;
+    vec_type    albedo;
+    int_type    prim_id;
+    int_type    geom_id;
+
 };
 
 } // visionaray
@@ -95,6 +95,30 @@ inline vector<3, T> cosine_sample_hemisphere(T u1, T u2)
     return vector<3, T>(x, y, z);
 }
 
+
+//-------------------------------------------------------------------------------------------------
+// Weights for multiple importance sampling
+//
+// pdf1: pdf of the sampling technique that generated the sample
+// pdf2: pdf of the other technique for the same sample
+//
+
+template <typename T>
+VSNRAY_FUNC
+inline T balance_heuristic(T pdf1, T pdf2)
+{
+    auto sum = pdf1 + pdf2;
+    return select( sum > T(0.0), pdf1 / sum, T(0.0) );
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T power_heuristic(T pdf1, T pdf2)
+{
+    auto sum = pdf1 * pdf1 + pdf2 * pdf2;
+    return select( sum > T(0.0), (pdf1 * pdf1) / sum, T(0.0) );
+}
+
 } // visionaray
 
 #endif // VSNRAY_SAMPLING_H
@@ -208,6 +208,7 @@ auto make_sched_params(First first, Args&&... args)
 #include "detail/simple_sched.h"
 #if !defined(__MINGW32__) && !defined(__MINGW64__)
 #include "detail/tiled_sched.h"
+#include "detail/wavefront_sched.h"
 #endif
 
 #endif // VSNRAY_SCHEDULER_H
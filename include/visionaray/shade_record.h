@@ -6,6 +6,7 @@
 #ifndef VSNRAY_SHADE_RECORD_H
 #define VSNRAY_SHADE_RECORD_H 1
 
+#include <cstddef>
 #include <type_traits>
 #include <utility>
 
@@ -13,6 +14,8 @@
 #include "math/simd/type_traits.h"
 #include "math/vector.h"
 #include "array.h"
+#include "hero_wavelengths.h"
+#include "spectrum.h"
 
 namespace visionaray
 {
@@ -40,6 +43,72 @@ struct shade_record<L, C, T, Args...> : public shade_record_base<L, T, Args...>
     C tex_color;
 };
 
+
+//-------------------------------------------------------------------------------------------------
+// Shade record with the hero wavelengths of a path (see hero_wavelengths.h). Materials
+// evaluate their SPDs and the light intensities at these wavelengths only and return
+// one sample per wavelength (vector<N, T>) instead of a spectrum
+//
+
+template <typename Base, size_t N>
+struct spectral_shade_record : public Base
+{
+    hero_wavelengths<typename Base::scalar_type, N> wavelengths;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Colors that materials return for shade records of type SR
+//
+
+template <typename SR>
+struct shade_color
+{
+    using type = spectrum<typename SR::scalar_type>;
+};
+
+template <typename Base, size_t N>
+struct shade_color<spectral_shade_record<Base, N>>
+{
+    using type = vector<N, typename Base::scalar_type>;
+};
+
+template <typename SR>
+using shade_color_t = typename shade_color<SR>::type;
+
+
+//-------------------------------------------------------------------------------------------------
+// Texture color of a spectral shade record at its wavelengths, 1 if there is no
+// texture color
+//
+
+namespace detail
+{
+
+template <typename SR, typename T, size_t N>
+VSNRAY_FUNC
+inline vector<N, T> tex_color_samples(SR const& /* */, hero_wavelengths<T, N> const& /* */)
+{
+    return vector<N, T>(1.0);
+}
+
+template <typename L, typename C, typename T, size_t N>
+VSNRAY_FUNC
+inline vector<N, T> tex_color_samples(shade_record<L, C, T> const& sr, hero_wavelengths<T, N> const& wl)
+{
+    return from_rgb(sr.tex_color, wl);
+}
+
+} // detail
+
+template <typename Base, size_t N>
+VSNRAY_FUNC
+inline vector<N, typename Base::scalar_type> tex_color_samples(spectral_shade_record<Base, N> const& sr)
+{
+    return detail::tex_color_samples(static_cast<Base const&>(sr), sr.wavelengths);
+}
+
+
 namespace simd
 {
 
@@ -116,6 +185,111 @@ inline array<shade_record<L, vector<3, float>, float>, num_elements<T>::value> u
     return result;
 }
 
+
+//-------------------------------------------------------------------------------------------------
+// Unpack SIMD shade records of light groups (SIMD lights, see light_groups.h), lane i
+// is lit by light i of the group
+//
+
+template <
+    template <typename> class L,
+    typename T,
+    typename = typename std::enable_if<is_simd_vector<T>::value>::type,
+    typename = typename std::enable_if<
+        std::is_floating_point<element_type_t<T>>::value
+        >::type
+    >
+VSNRAY_FUNC
+inline array<shade_record<L<float>, float>, num_elements<T>::value> unpack(shade_record<L<T>, T> const& sr)
+{
+    auto isect_pos  = unpack(sr.isect_pos);
+    auto normal     = unpack(sr.normal);
+    auto view_dir   = unpack(sr.view_dir);
+    auto light_dir  = unpack(sr.light_dir);
+    auto light      = unpack(sr.light);
+
+    array<shade_record<L<float>, float>, num_elements<T>::value> result;
+
+    for (unsigned i = 0; i < num_elements<T>::value; ++i)
+    {
+        result[i].isect_pos = isect_pos[i];
+        result[i].normal    = normal[i];
+        result[i].view_dir  = view_dir[i];
+        result[i].light_dir = light_dir[i];
+        result[i].light     = light[i];
+    }
+
+    return result;
+}
+
+template <
+    template <typename> class L,
+    typename T,
+    typename = typename std::enable_if<is_simd_vector<T>::value>::type,
+    typename = typename std::enable_if<
+        std::is_floating_point<element_type_t<T>>::value
+        >::type
+    >
+VSNRAY_FUNC
+inline array<shade_record<L<float>, vector<3, float>, float>, num_elements<T>::value> unpack(
+        shade_record<L<T>, vector<3, T>, T> const& sr
+        )
+{
+    auto isect_pos  = unpack(sr.isect_pos);
+    auto normal     = unpack(sr.normal);
+    auto view_dir   = unpack(sr.view_dir);
+    auto light_dir  = unpack(sr.light_dir);
+    auto light      = unpack(sr.light);
+    auto tex_color  = unpack(sr.tex_color);
+
+    array<shade_record<L<float>, vector<3, float>, float>, num_elements<T>::value> result;
+
+    for (unsigned i = 0; i < num_elements<T>::value; ++i)
+    {
+        result[i].isect_pos = isect_pos[i];
+        result[i].normal    = normal[i];
+        result[i].view_dir  = view_dir[i];
+        result[i].light_dir = light_dir[i];
+        result[i].light     = light[i];
+        result[i].tex_color = tex_color[i];
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Unpack SIMD spectral shade record
+//
+
+template <
+    typename Base,
+    size_t N,
+    typename T = typename Base::scalar_type,
+    typename = typename std::enable_if<is_simd_vector<T>::value>::type
+    >
+inline auto unpack(spectral_shade_record<Base, N> const& sr)
+    -> array<
+        spectral_shade_record<typename std::decay<decltype(unpack(std::declval<Base>())[0])>::type, N>,
+        num_elements<T>::value
+        >
+{
+    using base_type = typename std::decay<decltype(unpack(std::declval<Base>())[0])>::type;
+
+    auto base        = unpack(static_cast<Base const&>(sr));
+    auto wavelengths = unpack(sr.wavelengths);
+
+    array<spectral_shade_record<base_type, N>, num_elements<T>::value> result;
+
+    for (unsigned i = 0; i < num_elements<T>::value; ++i)
+    {
+        static_cast<base_type&>(result[i]) = base[i];
+        result[i].wavelengths = wavelengths[i];
+    }
+
+    return result;
+}
+
 } // simd
 
 
@@ -131,30 +305,32 @@ namespace srf
 struct R2 {};
 struct R1 : R2 {};
 
-template <typename P, typename T>
+template <typename P, typename L, typename T>
 VSNRAY_FUNC
 inline auto test_shade_record_type(R1)
     -> decltype(
         std::declval<P>().textures,
-        shade_record<typename P::light_type, vector<3, T>, T>()
+        shade_record<L, vector<3, T>, T>()
        );
 
-template <typename P, typename T>
+template <typename P, typename L, typename T>
 VSNRAY_FUNC
 inline auto test_shade_record_type(R2)
-    -> shade_record<typename P::light_type, T>;
+    -> shade_record<L, T>;
 
-template <typename P, typename T>
+template <typename P, typename T, typename L = typename std::decay<P>::type::light_type>
 using shade_record_type
     = decltype( test_shade_record_type<typename std::decay<P>::type,
+                                       L,
                                        typename std::decay<T>::type>(R1()) );
 
 } // srf
 } // detail
 
-template <typename Params, typename T>
+// Shade record for Params with scalar type T, Light defaults to Params::light_type
+template <typename Params, typename T, typename Light = typename Params::light_type>
 VSNRAY_FUNC
-inline auto make_shade_record() -> detail::srf::shade_record_type<Params, T>
+inline auto make_shade_record() -> detail::srf::shade_record_type<Params, T, Light>
 {
     return {};
 }
@@ -7,8 +7,10 @@
 #define VSNRAY_SPOT_LIGHT_H 1
 
 #include <cstddef>
+#include <type_traits>
 
 #include "detail/macros.h"
+#include "math/simd/type_traits.h"
 #include "math/vector.h"
 #include "array.h"
 
@@ -42,6 +44,8 @@ public:
             Sampler& samp
             ) const;
 
+    VSNRAY_FUNC color_type cl() const;
+    VSNRAY_FUNC scalar_type kl() const;
     VSNRAY_FUNC vec_type position() const;
     VSNRAY_FUNC vec_type spot_direction() const;
     VSNRAY_FUNC T spot_cutoff() const;
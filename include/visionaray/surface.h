@@ -10,6 +10,7 @@
 #include "detail/tags.h"
 #include "math/vector.h"
 #include "material.h"
+#include "shade_record.h"
 
 namespace visionaray
 {
@@ -28,17 +29,29 @@ struct surface<N, M>
 
     template <typename SR>
     VSNRAY_FUNC
-    spectrum<scalar_type> shade(SR const& shade_rec)
+    shade_color_t<SR> shade(SR const& shade_rec)
     {
         return material.shade(shade_rec);
     }
 
     template <typename SR, typename U, typename S /* sampler */>
     VSNRAY_FUNC
-    spectrum<scalar_type> sample(SR const& shade_rec, vector<3, U>& refl_dir, U& pdf, S& sampler)
+    shade_color_t<SR> sample(SR const& shade_rec, vector<3, U>& refl_dir, U& pdf, S& sampler)
     {
         return material.sample(shade_rec, refl_dir, pdf, sampler);
     }
+
+    template <typename SR>
+    VSNRAY_FUNC
+    scalar_type pdf(SR const& shade_rec)
+    {
+        return material.pdf(shade_rec);
+    }
+    VSNRAY_FUNC
+    spectrum<scalar_type> albedo() const
+    {
+        return material.albedo();
+    }
 };
 
 template <typename N, typename M, typename C>
@@ -54,7 +67,7 @@ struct surface<N, M, C>
 
     template <typename SR>
     VSNRAY_FUNC
-    spectrum<scalar_type> shade(SR shade_rec)
+    shade_color_t<SR> shade(SR shade_rec)
     {
         shade_rec.tex_color = tex_color;
         return material.shade(shade_rec);
@@ -62,11 +75,23 @@ struct surface<N, M, C>
 
     template <typename SR, typename U, typename S /* sampler */>
     VSNRAY_FUNC
-    spectrum<scalar_type> sample(SR shade_rec, vector<3, U>& refl_dir, U& pdf, S& sampler)
+    shade_color_t<SR> sample(SR shade_rec, vector<3, U>& refl_dir, U& pdf, S& sampler)
     {
         shade_rec.tex_color = tex_color;
         return material.sample(shade_rec, refl_dir, pdf, sampler);
     }
+
+    template <typename SR>
+    VSNRAY_FUNC
+    scalar_type pdf(SR const& shade_rec)
+    {
+        return material.pdf(shade_rec);
+    }
+    VSNRAY_FUNC
+    spectrum<scalar_type> albedo() const
+    {
+        return spectrum<scalar_type>(from_rgb(tex_color)) * material.albedo();
+    }
 };
 
 } // visionaray
@@ -0,0 +1,153 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_TEXTURE_DETAIL_BRICKED_TEXTURE_H
+#define VSNRAY_TEXTURE_DETAIL_BRICKED_TEXTURE_H 1
+
+#include <cstddef>
+
+#include <visionaray/detail/macros.h>
+#include <visionaray/math/vector.h>
+#include <visionaray/aligned_vector.h>
+
+#include "texel_layout.h"
+#include "texture_common.h"
+#include "texture3d.h"
+
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Storage for 3D textures with brick_layout, see texel_layout.h
+//
+// bricked_texture<T, 3> owns its texels, reset() and the conversion from texture<T, 3>
+// and texture_ref<T, 3> take texels in x-major order and arrange them in bricks.
+// bricked_texture_ref<T, 3> refers to texels that are already arranged in bricks.
+// Use tex3D() with all filter modes as with linear textures
+//
+
+template <typename T, size_t Dim>
+class bricked_texture_base : public texture_params_base<Dim>
+{
+public:
+
+    static_assert(Dim == 3, "Bricked textures must be 3D");
+
+    using value_type = T;
+    using base_type  = texture_params_base<Dim>;
+    enum { dimensions = Dim };
+
+public:
+
+    bricked_texture_base() = default;
+
+    bricked_texture_base(size_t w, size_t h, size_t d)
+        : data_(detail::brick_storage_size(w, h, d))
+        , texsize_(w, h, d)
+    {
+    }
+
+    // Convert a texture with linear layout, including the sampling parameters
+    bricked_texture_base(texture_ref<T, Dim> const& tex)
+        : base_type(tex)
+        , data_(detail::brick_storage_size(tex.width(), tex.height(), tex.depth()))
+        , texsize_(tex.size())
+    {
+        reset(tex.data());
+    }
+
+    // Texels in x-major order, the padding of the bricks is left untouched
+    void reset(T const* data)
+    {
+        for (size_t z = 0; z < texsize_.z; ++z)
+        {
+            for (size_t y = 0; y < texsize_.y; ++y)
+            {
+                for (size_t x = 0; x < texsize_.x; ++x)
+                {
+                    data_[detail::brick_index(x, y, z, texsize_)] = *data++;
+                }
+            }
+        }
+    }
+
+    value_type const* data() const
+    {
+        return data_.data();
+    }
+
+protected:
+
+    aligned_vector<T> data_;
+
+    vector<3, size_t> texsize_;
+
+};
+
+template <typename T, size_t Dim>
+class bricked_texture_ref_base : public texture_params_base<Dim>
+{
+public:
+
+    static_assert(Dim == 3, "Bricked textures must be 3D");
+
+    using value_type = T;
+    using base_type  = texture_params_base<Dim>;
+    enum { dimensions = Dim };
+
+public:
+
+    bricked_texture_ref_base() = default;
+
+    bricked_texture_ref_base(size_t w, size_t h, size_t d)
+    {
+        VSNRAY_UNUSED(w, h, d);
+    }
+
+    bricked_texture_ref_base(bricked_texture_base<T, Dim> const& tex)
+        : base_type(tex)
+        , data_(tex.data())
+    {
+    }
+
+    // Texels that are already arranged in bricks, detail::brick_storage_size() elements
+    void reset(T const* data)
+    {
+        data_ = data;
+    }
+
+    T const* data() const
+    {
+        return data_;
+    }
+
+protected:
+
+    T const* data_;
+
+};
+
+
+namespace detail
+{
+
+template <typename T, size_t Dim>
+struct texel_layout<bricked_texture_base<T, Dim>>
+{
+    using type = brick_layout;
+};
+
+template <typename T, size_t Dim>
+struct texel_layout<bricked_texture_ref_base<T, Dim>>
+{
+    using type = brick_layout;
+};
+
+} // detail
+
+} // visionaray
+
+#endif // VSNRAY_TEXTURE_DETAIL_BRICKED_TEXTURE_H
@@ -15,6 +15,7 @@
 #include <visionaray/math/vector.h>
 
 #include "../../forward.h"
+#include "../texel_layout.h"
 
 
 namespace visionaray
@@ -26,6 +27,14 @@ namespace detail
 // Remap tex coord based on address mode
 //
 
+// Fractional part in [0..1), coord - floor(coord) rounds to 1 for tiny negative coordinates
+template <typename F>
+inline F wrap_tex_coord(F const& coord)
+{
+    F frac = coord - floor(coord);
+    return select( frac < F(1.0), frac, F(0.0) );
+}
+
 template <typename F, typename I>
 inline F map_tex_coord(F const& coord, I const& texsize, tex_address_mode mode)
 {
@@ -37,12 +46,12 @@ inline F map_tex_coord(F const& coord, I const& texsize, tex_address_mode mode)
     case Mirror:
         return select(
             (convert_to_int(floor(coord)) & I(1)) == 1, // if is odd
-            convert_to_float(texsize - 1) / convert_to_float(texsize) - (coord - floor(coord)),
-            coord - floor(coord)
+            convert_to_float(texsize - 1) / convert_to_float(texsize) - wrap_tex_coord(coord),
+            wrap_tex_coord(coord)
             );
 
     case Wrap:
-        return coord - floor(coord);
+        return wrap_tex_coord(coord);
 
     case Clamp:
         // fall-through
@@ -140,6 +149,37 @@ inline simd::float4 point(
 #endif // VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_SSE2) || VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_NEON_FP)
 
 
+//-------------------------------------------------------------------------------------------------
+// Access functions for 3D textures, address texel (x,y,z) according to the layout
+//
+
+template <typename T, typename I, typename RT>
+inline RT point(
+        T const*                tex,
+        I const&                x,
+        I const&                y,
+        I const&                z,
+        vector<3, I> const&     texsize,
+        RT                      /* */
+        )
+{
+    return point(tex, index(x, y, z, texsize), RT{});
+}
+
+template <typename T, typename I, typename RT>
+inline RT point(
+        bricked_texels<T> const&    tex,
+        I const&                    x,
+        I const&                    y,
+        I const&                    z,
+        vector<3, I> const&         texsize,
+        RT                          /* */
+        )
+{
+    return point(tex.data, brick_index(x, y, z, texsize), RT{});
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Weight functions for higher order texture interpolation
 //
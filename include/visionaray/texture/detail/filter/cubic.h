@@ -187,7 +187,7 @@ template <
 inline ReturnT cubic(
         ReturnT                                 /* */,
         InternalT                               /* */,
-        TexelT const*                           tex,
+        TexelT const&                           tex,
         vector<3, FloatT>                       coord,
         vector<3, SizeT>                        texsize,
         std::array<tex_address_mode, 3> const&  address_mode,
@@ -235,7 +235,10 @@ inline ReturnT cubic(
     {
         return InternalT( point(
                 tex,
-                index(pos[i].x, pos[j].y, pos[k].z, texsize),
+                pos[i].x,
+                pos[j].y,
+                pos[k].z,
+                texsize,
                 ReturnT{}
                 ) );
     };
@@ -133,7 +133,7 @@ template <
 inline ReturnT linear(
         ReturnT                                 /* */,
         InternalT                               /* */,
-        TexelT const*                           tex,
+        TexelT const&                           tex,
         vector<3, FloatT>                       coord,
         vector<3, SizeT>                        texsize,
         std::array<tex_address_mode, 3> const&  address_mode
@@ -156,14 +156,14 @@ inline ReturnT linear(
 
     InternalT samples[8] =
     {
-        InternalT( point(tex, index( lo.x, lo.y, lo.z, texsize ), ReturnT{}) ),
-        InternalT( point(tex, index( hi.x, lo.y, lo.z, texsize ), ReturnT{}) ),
-        InternalT( point(tex, index( lo.x, hi.y, lo.z, texsize ), ReturnT{}) ),
-        InternalT( point(tex, index( hi.x, hi.y, lo.z, texsize ), ReturnT{}) ),
-        InternalT( point(tex, index( lo.x, lo.y, hi.z, texsize ), ReturnT{}) ),
-        InternalT( point(tex, index( hi.x, lo.y, hi.z, texsize ), ReturnT{}) ),
-        InternalT( point(tex, index( lo.x, hi.y, hi.z, texsize ), ReturnT{}) ),
-        InternalT( point(tex, index( hi.x, hi.y, hi.z, texsize ), ReturnT{}) )
+        InternalT( point(tex, lo.x, lo.y, lo.z, texsize, ReturnT{}) ),
+        InternalT( point(tex, hi.x, lo.y, lo.z, texsize, ReturnT{}) ),
+        InternalT( point(tex, lo.x, hi.y, lo.z, texsize, ReturnT{}) ),
+        InternalT( point(tex, hi.x, hi.y, lo.z, texsize, ReturnT{}) ),
+        InternalT( point(tex, lo.x, lo.y, hi.z, texsize, ReturnT{}) ),
+        InternalT( point(tex, hi.x, lo.y, hi.z, texsize, ReturnT{}) ),
+        InternalT( point(tex, lo.x, hi.y, hi.z, texsize, ReturnT{}) ),
+        InternalT( point(tex, hi.x, hi.y, hi.z, texsize, ReturnT{}) )
     };
 
 
@@ -88,7 +88,7 @@ template <
 inline ReturnT nearest(
         ReturnT                                 /* */,
         InternalT                               /* */,
-        TexelT const*                           tex,
+        TexelT const&                           tex,
         vector<3, FloatT>                       coord,
         vector<3, SizeT>                        texsize,
         std::array<tex_address_mode, 3> const&  address_mode
@@ -98,8 +98,7 @@ inline ReturnT nearest(
 
     auto lo = convert_to_int(coord * convert_to_float(texsize));
 
-    auto idx = index(lo[0], lo[1], lo[2], texsize);
-    return point(tex, idx, ReturnT{});
+    return point(tex, lo[0], lo[1], lo[2], texsize, ReturnT{});
 }
 
 } // detail
@@ -0,0 +1,90 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_TEXTURE_DETAIL_MAPPED_TEXTURE_H
+#define VSNRAY_TEXTURE_DETAIL_MAPPED_TEXTURE_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <visionaray/detail/file_mapping.h>
+
+#include "texture_common.h"
+
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Storage for textures that point into a read-only mapped file
+//
+// mapped_texture<T, Dim> has the same layout as texture<T, Dim> and is used the same way,
+// except that map() replaces reset(): texels are not copied but read from the file when
+// they are accessed for the first time. Copies share the mapping, the file is unmapped
+// when the last copy is destroyed. texture_ref<T, Dim> can refer to mapped textures
+//
+
+template <typename T, size_t Dim>
+class mapped_texture_base : public texture_params_base<Dim>
+{
+public:
+
+    using value_type = T;
+    using base_type  = texture_params_base<Dim>;
+    enum { dimensions = Dim };
+
+public:
+
+    mapped_texture_base() = default;
+
+    explicit mapped_texture_base(size_t size)
+        : size_(size)
+    {
+    }
+
+    // Map a file with texels starting at offset bytes, in the same order as with reset()
+    // of texture<T, Dim>. Throws std::runtime_error if the file cannot be mapped, is too
+    // small, or if the texels are not aligned for T
+    void map(std::string const& filename, size_t offset = 0)
+    {
+        auto mapping = std::make_shared<detail::file_mapping>(filename);
+
+        if (mapping->size() < offset || (mapping->size() - offset) / sizeof(T) < size_)
+        {
+            throw std::runtime_error("mapped_texture: " + filename + " is too small");
+        }
+
+        char const* texels = mapping->data() + offset;
+
+        if (reinterpret_cast<std::uintptr_t>(texels) % alignof(T) != 0)
+        {
+            throw std::runtime_error("mapped_texture: texels are not aligned");
+        }
+
+        mapping_ = mapping;
+        data_ = reinterpret_cast<T const*>(texels);
+    }
+
+    value_type const* data() const
+    {
+        return data_;
+    }
+
+protected:
+
+    std::shared_ptr<detail::file_mapping> mapping_;
+
+    T const* data_ = nullptr;
+
+    size_t size_ = 0;
+
+};
+
+} // visionaray
+
+#endif // VSNRAY_TEXTURE_DETAIL_MAPPED_TEXTURE_H
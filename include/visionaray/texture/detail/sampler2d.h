@@ -132,6 +132,36 @@ inline vector<Dim, FloatT> tex2D_impl_expand_types(
 }
 
 
+// SIMD: AoS textures
+
+template <
+    typename T,
+    typename FloatT,
+    typename = typename std::enable_if<simd::is_simd_vector<FloatT>::value>::type
+    >
+inline vector<4, FloatT> tex2D_impl_expand_types(
+        vector<4, T> const*                         tex,
+        vector<2, FloatT> const&                    coord,
+        vector<2, simd::int_type_t<FloatT>> const&  texsize,
+        tex_filter_mode                             filter_mode,
+        std::array<tex_address_mode, 2> const&      address_mode
+        )
+{
+    using return_type   = vector<4, FloatT>;
+    using internal_type = vector<4, FloatT>;
+
+    return choose_filter(
+            return_type{},
+            internal_type{},
+            tex,
+            coord,
+            texsize,
+            filter_mode,
+            address_mode
+            );
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // tex2D() dispatch function
 //
@@ -34,6 +34,7 @@ namespace detail
 template <
     typename T,
     typename FloatT,
+    typename Layout,
     typename = typename std::enable_if<std::is_floating_point<FloatT>::value>::type,
     typename = typename std::enable_if<!simd::is_simd_vector<FloatT>::value>::type
     >
@@ -42,7 +43,8 @@ inline T tex3D_impl_expand_types(
         vector<3, FloatT> const&                coord,
         vector<3, int> const&                   texsize,
         tex_filter_mode                         filter_mode,
-        std::array<tex_address_mode, 3> const&  address_mode
+        std::array<tex_address_mode, 3> const&  address_mode,
+        Layout                                  /* */
         )
 {
     using return_type   = T;
@@ -51,7 +53,7 @@ inline T tex3D_impl_expand_types(
     return choose_filter(
             return_type{},
             internal_type{},
-            tex,
+            texels(tex, Layout{}),
             coord,
             texsize,
             filter_mode,
@@ -63,6 +65,7 @@ template <
     size_t Dim,
     typename T,
     typename FloatT,
+    typename Layout,
     typename = typename std::enable_if<std::is_floating_point<FloatT>::value>::type,
     typename = typename std::enable_if<!simd::is_simd_vector<FloatT>::value>::type
     >
@@ -71,7 +74,8 @@ inline vector<Dim, T> tex3D_impl_expand_types(
         vector<3, FloatT> const&                coord,
         vector<3, int> const&                   texsize,
         tex_filter_mode                         filter_mode,
-        std::array<tex_address_mode, 3> const&  address_mode
+        std::array<tex_address_mode, 3> const&  address_mode,
+        Layout                                  /* */
         )
 {
     using return_type   = vector<Dim, T>;
@@ -80,7 +84,7 @@ inline vector<Dim, T> tex3D_impl_expand_types(
     return choose_filter(
             return_type{},
             internal_type{},
-            tex,
+            texels(tex, Layout{}),
             coord,
             texsize,
             filter_mode,
@@ -94,6 +98,7 @@ inline vector<Dim, T> tex3D_impl_expand_types(
 template <
     unsigned Bits,
     typename FloatT,
+    typename Layout,
     typename = typename std::enable_if<std::is_floating_point<FloatT>::value>::type,
     typename = typename std::enable_if<!simd::is_simd_vector<FloatT>::value>::type
     >
@@ -102,7 +107,8 @@ inline FloatT tex3D_impl_expand_types(
         vector<3, FloatT> const&                coord,
         vector<3, int> const&                   texsize,
         tex_filter_mode                         filter_mode,
-        std::array<tex_address_mode, 3> const&  address_mode
+        std::array<tex_address_mode, 3> const&  address_mode,
+        Layout                                  /* */
         )
 {
     using return_type   = int;
@@ -113,7 +119,7 @@ inline FloatT tex3D_impl_expand_types(
     auto tmp = choose_filter(
             return_type{},
             internal_type{},
-            reinterpret_cast<typename best_uint<Bits>::type const*>(tex),
+            texels(reinterpret_cast<typename best_uint<Bits>::type const*>(tex), Layout{}),
             coord,
             texsize,
             filter_mode,
@@ -125,11 +131,52 @@ inline FloatT tex3D_impl_expand_types(
 }
 
 
+// normalized floating point vector texture, non-simd coordinates
+
+template <
+    size_t Dim,
+    unsigned Bits,
+    typename FloatT,
+    typename Layout,
+    typename = typename std::enable_if<std::is_floating_point<FloatT>::value>::type,
+    typename = typename std::enable_if<!simd::is_simd_vector<FloatT>::value>::type
+    >
+inline vector<Dim, FloatT> tex3D_impl_expand_types(
+        vector<Dim, unorm<Bits>> const*         tex,
+        vector<3, FloatT> const&                coord,
+        vector<3, int> const&                   texsize,
+        tex_filter_mode                         filter_mode,
+        std::array<tex_address_mode, 3> const&  address_mode,
+        Layout                                  /* */
+        )
+{
+    using return_type   = vector<Dim, FloatT>;
+    using internal_type = vector<Dim, FloatT>;
+
+    // use unnormalized types for internal calculations
+    // to avoid the normalization overhead, filter in floating
+    // point so that the result is not truncated to integers
+    auto tmp = choose_filter(
+            return_type{},
+            internal_type{},
+            texels(reinterpret_cast<vector<Dim, typename best_uint<Bits>::type> const*>(tex), Layout{}),
+            coord,
+            texsize,
+            filter_mode,
+            address_mode
+            );
+
+    // normalize only once upon return
+    return tmp / static_cast<FloatT>((1ULL << Bits) - 1);
+}
+
+
 // any texture, non-simd coordinates
 
 template <
     typename T,
     typename FloatT,
+    typename Layout,
     typename = typename std::enable_if<!std::is_integral<T>::value>::type,
     typename = typename std::enable_if<simd::is_simd_vector<FloatT>::value>::type
     >
@@ -138,7 +185,8 @@ inline FloatT tex3D_impl_expand_types(
         vector<3, FloatT> const&                    coord,
         vector<3, simd::int_type_t<FloatT>> const&  texsize,
         tex_filter_mode                             filter_mode,
-        std::array<tex_address_mode, 3> const&      address_mode
+        std::array<tex_address_mode, 3> const&      address_mode,
+        Layout                                      /* */
         )
 {
     using return_type   = FloatT;
@@ -147,7 +195,39 @@ inline FloatT tex3D_impl_expand_types(
     return choose_filter(
             return_type{},
             internal_type{},
-            tex,
+            texels(tex, Layout{}),
+            coord,
+            texsize,
+            filter_mode,
+            address_mode
+            );
+}
+
+
+// SIMD: AoS textures
+
+template <
+    typename T,
+    typename FloatT,
+    typename Layout,
+    typename = typename std::enable_if<simd::is_simd_vector<FloatT>::value>::type
+    >
+inline vector<4, FloatT> tex3D_impl_expand_types(
+        vector<4, T> const*                         tex,
+        vector<3, FloatT> const&                    coord,
+        vector<3, simd::int_type_t<FloatT>> const&  texsize,
+        tex_filter_mode                             filter_mode,
+        std::array<tex_address_mode, 3> const&      address_mode,
+        Layout                                      /* */
+        )
+{
+    using return_type   = vector<4, FloatT>;
+    using internal_type = vector<4, FloatT>;
+
+    return choose_filter(
+            return_type{},
+            internal_type{},
+            texels(tex, Layout{}),
             coord,
             texsize,
             filter_mode,
@@ -161,6 +241,7 @@ inline FloatT tex3D_impl_expand_types(
 template <
     unsigned Bits,
     typename FloatT,
+    typename Layout,
     typename = typename std::enable_if<simd::is_simd_vector<FloatT>::value>::type
     >
 inline FloatT tex3D_impl_expand_types(
@@ -168,7 +249,8 @@ inline FloatT tex3D_impl_expand_types(
         vector<3, FloatT> const&                    coord,
         vector<3, simd::int_type_t<FloatT>> const&  texsize,
         tex_filter_mode                             filter_mode,
-        std::array<tex_address_mode, 3> const&      address_mode
+        std::array<tex_address_mode, 3> const&      address_mode,
+        Layout                                      /* */
         )
 {
     using return_type   = simd::int_type_t<FloatT>;
@@ -179,7 +261,7 @@ inline FloatT tex3D_impl_expand_types(
     auto tmp = choose_filter(
             return_type{},
             internal_type{},
-            reinterpret_cast<typename best_uint<Bits>::type const*>(tex),
+            texels(reinterpret_cast<typename best_uint<Bits>::type const*>(tex), Layout{}),
             coord,
             texsize,
             filter_mode,
@@ -196,6 +278,7 @@ inline FloatT tex3D_impl_expand_types(
 template <
     typename T,
     typename FloatT,
+    typename Layout,
     typename = typename std::enable_if<std::is_integral<T>::value>::type,
     typename = typename std::enable_if<simd::is_simd_vector<FloatT>::value>::type
     >
@@ -204,7 +287,8 @@ inline simd::int_type_t<FloatT> tex3D_impl_expand_types(
         vector<3, FloatT> const&                    coord,
         vector<3, simd::int_type_t<FloatT>> const&  texsize,
         tex_filter_mode                             filter_mode,
-        std::array<tex_address_mode, 3> const&      address_mode
+        std::array<tex_address_mode, 3> const&      address_mode,
+        Layout                                      /* */
         )
 {
     using return_type   = simd::int_type_t<FloatT>;
@@ -213,7 +297,7 @@ inline simd::int_type_t<FloatT> tex3D_impl_expand_types(
     return choose_filter(
             return_type{},
             internal_type{},
-            tex,
+            texels(tex, Layout{}),
             coord,
             texsize,
             filter_mode,
@@ -233,7 +317,8 @@ inline auto tex3D(Tex const& tex, vector<3, FloatT> coord)
             coord,
             vector<3, decltype(convert_to_int(std::declval<FloatT>()))>(),
             tex.get_filter_mode(),
-            tex.get_address_mode()
+            tex.get_address_mode(),
+            typename Tex::layout_type{}
             ) )
 {
     static_assert(Tex::dimensions == 3, "Incompatible texture type");
@@ -251,7 +336,8 @@ inline auto tex3D(Tex const& tex, vector<3, FloatT> coord)
             coord,
             texsize,
             tex.get_filter_mode(),
-            tex.get_address_mode()
+            tex.get_address_mode(),
+            typename Tex::layout_type{}
             );
 }
 
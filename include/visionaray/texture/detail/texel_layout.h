@@ -0,0 +1,98 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_TEXTURE_DETAIL_TEXEL_LAYOUT_H
+#define VSNRAY_TEXTURE_DETAIL_TEXEL_LAYOUT_H 1
+
+#include <cstddef>
+
+#include <visionaray/math/vector.h>
+
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Memory layouts of 3D textures
+//
+// linear_layout: x-major, texel (x,y,z) is at z * width * height + y * width + x
+//
+// brick_layout: the texture is divided into bricks of brick_size^3 texels, bricks are
+// stored in x-major order, and so are the texels inside a brick. The 2x2x2 texels of a
+// trilinear fetch are close together in memory independent of the direction of the
+// ray, while with linear_layout texels along z are width * height texels apart.
+// Textures are padded to a multiple of brick_size in each dimension
+//
+
+struct linear_layout {};
+struct brick_layout {};
+
+// Layout of the texels of a texture, depending on the storage (Base) of texture_iface
+template <typename Base>
+struct texel_layout
+{
+    using type = linear_layout;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Brick addressing, for scalar and SIMD integers
+//
+
+enum { brick_bits = 3, brick_size = 1 << brick_bits };
+
+// Number of texels to store a texture of size w x h x d with brick_layout
+inline size_t brick_storage_size(size_t w, size_t h, size_t d)
+{
+    auto bricks = [](size_t n) { return (n + brick_size - 1) >> brick_bits; };
+
+    return bricks(w) * bricks(h) * bricks(d) << (3 * brick_bits);
+}
+
+template <typename I>
+inline I brick_index(I const& x, I const& y, I const& z, vector<3, I> const& texsize)
+{
+    I mask(brick_size - 1);
+
+    // Number of bricks per row and per slice
+    I nx = (texsize[0] + mask) >> brick_bits;
+    I ny = (texsize[1] + mask) >> brick_bits;
+
+    I brick = ((z >> brick_bits) * ny + (y >> brick_bits)) * nx + (x >> brick_bits);
+    I texel = ((((z & mask) << brick_bits) + (y & mask)) << brick_bits) + (x & mask);
+
+    return (brick << (3 * brick_bits)) + texel;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Texel arrays as seen by the filter functions: textures with linear_layout pass a
+// plain pointer, textures with brick_layout a pointer wrapped in bricked_texels
+//
+
+template <typename T>
+struct bricked_texels
+{
+    T const* data;
+};
+
+template <typename T>
+inline T const* texels(T const* data, linear_layout)
+{
+    return data;
+}
+
+template <typename T>
+inline bricked_texels<T> texels(T const* data, brick_layout)
+{
+    return { data };
+}
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_TEXTURE_DETAIL_TEXEL_LAYOUT_H
@@ -7,7 +7,9 @@
 #define VSNRAY_TEXTURE_DETAIL_TEXTURE3D_H 1
 
 #include <cstddef>
+#include <type_traits>
 
+#include "texel_layout.h"
 #include "texture_common.h"
 
 
@@ -19,20 +21,22 @@ class texture_iface<Base, T, 3> : public Base
 {
 public:
 
-    using ref_type = texture_ref<T, 3>;
-
     using base_type = Base;
     using value_type = T;
+    using layout_type = typename detail::texel_layout<Base>::type;
+
+    using ref_type = typename std::conditional<
+            std::is_same<layout_type, detail::brick_layout>::value,
+            bricked_texture_ref<T, 3>,
+            texture_ref<T, 3>
+            >::type;
 
 public:
 
     texture_iface() = default;
 
     texture_iface(size_t w, size_t h, size_t d)
-        : Base(w * h * d)
-        , width_(w)
-        , height_(h)
-        , depth_(d)
+        : texture_iface(w, h, d, layout_type{})
     {
     }
 
@@ -47,12 +51,12 @@ public:
 
     value_type& operator()(size_t x, size_t y, size_t z)
     {
-        return base_type::data()[z * width_ * height_ + y * width_ + x];
+        return base_type::data()[index(x, y, z, layout_type{})];
     }
 
     value_type const& operator()(size_t x, size_t y, size_t z) const
     {
-        return base_type::data()[z * width_ * height_ + y * width_ + x];
+        return base_type::data()[index(x, y, z, layout_type{})];
     }
 
 
@@ -71,6 +75,33 @@ private:
     size_t height_;
     size_t depth_;
 
+    texture_iface(size_t w, size_t h, size_t d, detail::linear_layout)
+        : Base(w * h * d)
+        , width_(w)
+        , height_(h)
+        , depth_(d)
+    {
+    }
+
+    // Bricked storage is padded and needs the size to arrange the texels
+    texture_iface(size_t w, size_t h, size_t d, detail::brick_layout)
+        : Base(w, h, d)
+        , width_(w)
+        , height_(h)
+        , depth_(d)
+    {
+    }
+
+    size_t index(size_t x, size_t y, size_t z, detail::linear_layout) const
+    {
+        return z * width_ * height_ + y * width_ + x;
+    }
+
+    size_t index(size_t x, size_t y, size_t z, detail::brick_layout) const
+    {
+        return detail::brick_index(x, y, z, size());
+    }
+
 };
 
 } // visionaray
@@ -29,7 +29,12 @@ class texture_params_base
 {
 public:
 
-    texture_params_base() = default;
+    // Wrap and Nearest by default
+    texture_params_base()
+        : filter_mode_(Nearest)
+    {
+        address_mode_.fill(Wrap);
+    }
 
     void set_address_mode(size_t index, tex_address_mode mode)
     {
@@ -178,6 +183,12 @@ public:
     {
     }
 
+    texture_ref_base(mapped_texture_base<T, Dim> const& tex)
+        : base_type(tex)
+        , data_(tex.data())
+    {
+    }
+
     void reset(T const* data)
     {
         data_ = data;
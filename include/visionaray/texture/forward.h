@@ -49,6 +49,30 @@ using texture = texture_iface<texture_base<T, Dim>, T, Dim>;
 template <typename T, size_t Dim>
 using texture_ref = texture_iface<texture_ref_base<T, Dim>, T, Dim>;
 
+
+// Textures that store texels in bricks, 3D only
+
+template <typename T, size_t Dim>
+class bricked_texture_base;
+
+template <typename T, size_t Dim>
+class bricked_texture_ref_base;
+
+template <typename T, size_t Dim>
+using bricked_texture = texture_iface<bricked_texture_base<T, Dim>, T, Dim>;
+
+template <typename T, size_t Dim>
+using bricked_texture_ref = texture_iface<bricked_texture_ref_base<T, Dim>, T, Dim>;
+
+
+// Textures that point into a read-only mapped file
+
+template <typename T, size_t Dim>
+class mapped_texture_base;
+
+template <typename T, size_t Dim>
+using mapped_texture = texture_iface<mapped_texture_base<T, Dim>, T, Dim>;
+
 } // visionaray
 
 #endif // VSNRAY_TEXTURE_FORWARD_H
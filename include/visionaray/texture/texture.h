@@ -12,6 +12,8 @@
 #include "detail/cuda_texture.h"
 #endif
 
+#include "detail/bricked_texture.h"
+#include "detail/mapped_texture.h"
 #include "detail/prefilter.h"
 #include "detail/sampler1d.h"
 #include "detail/sampler2d.h"
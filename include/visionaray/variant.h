@@ -160,6 +160,12 @@ public:
             : nullptr;
     }
 
+    // Index of the type of the stored value in Ts...
+    VSNRAY_FUNC unsigned which() const
+    {
+        return type_index_ - 1;
+    }
+
 private:
 
     detail::variant_storage<Ts...>  storage_;
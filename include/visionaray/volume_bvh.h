@@ -0,0 +1,119 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_VOLUME_BVH_H
+#define VSNRAY_VOLUME_BVH_H 1
+
+#include <cstddef>
+
+#include "detail/macros.h"
+#include "math/aabb.h"
+#include "math/intersect.h"
+#include "math/limits.h"
+#include "math/matrix.h"
+#include "math/primitive.h"
+#include "math/ray.h"
+#include "math/vector.h"
+#include "bvh.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// volume_bounds
+//
+// BVH primitive for scenes with many volumes (e.g. volume bricks or AMR patches): the object
+// space bounding box of a volume and the transform from world to object space. prim_id
+// identifies the volume. Build BVHs with build<index_bvh<volume_bounds>>(), the world space
+// bounds of the primitives are the bounds of the transformed boxes
+//
+
+struct volume_bounds : primitive<unsigned>
+{
+    aabb local_bounds;
+    mat4 transform_inv;
+};
+
+// Volume with object space bounds and object to world transform
+volume_bounds make_volume_bounds(unsigned id, aabb const& local_bounds, mat4 const& transform = mat4::identity());
+
+aabb get_bounds(volume_bounds const& vb);
+
+// Conservative, clips the world space bounds
+void split_primitive(aabb& L, aabb& R, float plane, int axis, volume_bounds const& vb);
+
+// Entry and exit distance of a world space ray, t refers to the world space ray
+template <typename T>
+VSNRAY_FUNC
+hit_record<basic_ray<T>, aabb> intersect(basic_ray<T> const& ray, volume_bounds const& vb);
+
+
+//-------------------------------------------------------------------------------------------------
+// volume_interval
+//
+// Range [tnear..tfar) along a ray that is covered by volume id. With ray packets, tnear and
+// tfar are per lane, tnear > tfar for lanes that miss the volume
+//
+
+template <typename T>
+struct volume_interval
+{
+    T tnear;
+    T tfar;
+    unsigned id;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Multi-hit traversal
+//
+// Collect the intervals of all volumes that overlap [tmin..tmax) along ray, clipped to that
+// range and sorted by tnear (the smallest tnear of the lanes for ray packets). Keeps the N
+// nearest intervals and returns the number of overlapping volumes, which exceeds N if
+// intervals were dropped. Pass min(count, N) intervals on. Works with float and SIMD rays
+//
+
+template <size_t N, typename T, typename BVH>
+VSNRAY_FUNC
+size_t intersect_volumes(
+        basic_ray<T> const& ray,
+        BVH const&          bvh,
+        volume_interval<T>  (&intervals)[N],
+        T                   tmin = T(0.0),
+        T                   tmax = numeric_limits<T>::max()
+        );
+
+
+//-------------------------------------------------------------------------------------------------
+// Interval-merged ray marching
+//
+// Front-to-back integration over the sorted intervals from intersect_volumes(). Samples are
+// taken at t = t0 + k * delta, where t0 is the first entry point of the ray. Each sample
+// only visits the volumes whose intervals contain t, the cost per sample is proportional to
+// the number of overlapping volumes rather than to the number of volumes along the ray.
+// Gaps between intervals are skipped.
+//
+// sample(id, t) returns the post-classified, non-premultiplied RGBA value of volume id at t
+// (all lanes are passed, only lanes inside the volume are used). Contributions of
+// overlapping volumes are added up (premultiplied) and normalized if their opacity exceeds
+// one. Lanes terminate when their opacity reaches opacity_threshold. Returns the
+// premultiplied color
+//
+
+template <typename T, typename Sample>
+VSNRAY_FUNC
+vector<4, T> integrate_volumes(
+        volume_interval<T> const*   intervals,
+        size_t                      count,
+        float                       delta,
+        Sample const&               sample,
+        float                       opacity_threshold = 0.999f
+        );
+
+} // visionaray
+
+#include "detail/volume_bvh.inl"
+
+#endif // VSNRAY_VOLUME_BVH_H
@@ -0,0 +1,318 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/get_normal.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/point_light.h>
+#include <visionaray/random_sampler.h>
+#include <visionaray/sampling.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <common/timer.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Compare the built-in ambient occlusion kernel with the kernel from the ao example
+//
+// Usage: ao_benchmark [num_threads] [num_boxes] [ao_samples]
+//
+
+using triangle_type = basic_triangle<3, float>;
+using bvh_type      = index_bvh<triangle_type>;
+using bvh_ref       = bvh_type::bvh_ref;
+using rt_type       = simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+
+static const int   width      = 512;
+static const int   height     = 512;
+static const int   num_frames = 8;
+static const float ao_radius  = 0.2f;
+
+
+//-------------------------------------------------------------------------------------------------
+// Procedural scene: floor and two walls with randomly placed boxes
+//
+
+static void add_quad(aligned_vector<triangle_type>& triangles, vec3 a, vec3 b, vec3 c, vec3 d)
+{
+    triangle_type t1(a, b - a, c - a);
+    triangle_type t2(a, c - a, d - a);
+
+    t1.prim_id = static_cast<unsigned>(triangles.size());
+    t1.geom_id = 0;
+    triangles.push_back(t1);
+
+    t2.prim_id = static_cast<unsigned>(triangles.size());
+    t2.geom_id = 0;
+    triangles.push_back(t2);
+}
+
+static void add_box(aligned_vector<triangle_type>& triangles, vec3 a, vec3 b)
+{
+    add_quad(triangles, vec3(a.x, a.y, a.z), vec3(b.x, a.y, a.z), vec3(b.x, b.y, a.z), vec3(a.x, b.y, a.z));
+    add_quad(triangles, vec3(a.x, a.y, b.z), vec3(a.x, b.y, b.z), vec3(b.x, b.y, b.z), vec3(b.x, a.y, b.z));
+    add_quad(triangles, vec3(a.x, a.y, a.z), vec3(a.x, b.y, a.z), vec3(a.x, b.y, b.z), vec3(a.x, a.y, b.z));
+    add_quad(triangles, vec3(b.x, a.y, a.z), vec3(b.x, a.y, b.z), vec3(b.x, b.y, b.z), vec3(b.x, b.y, a.z));
+    add_quad(triangles, vec3(a.x, b.y, a.z), vec3(b.x, b.y, a.z), vec3(b.x, b.y, b.z), vec3(a.x, b.y, b.z));
+}
+
+static aligned_vector<triangle_type> make_scene(int num_boxes)
+{
+    aligned_vector<triangle_type> triangles;
+
+    add_quad(triangles, vec3(-1.0f, -1.0f, -1.0f), vec3( 1.0f, -1.0f, -1.0f), vec3( 1.0f, -1.0f,  1.0f), vec3(-1.0f, -1.0f,  1.0f));
+    add_quad(triangles, vec3(-1.0f, -1.0f, -1.0f), vec3(-1.0f,  1.0f, -1.0f), vec3( 1.0f,  1.0f, -1.0f), vec3( 1.0f, -1.0f, -1.0f));
+    add_quad(triangles, vec3(-1.0f, -1.0f, -1.0f), vec3(-1.0f, -1.0f,  1.0f), vec3(-1.0f,  1.0f,  1.0f), vec3(-1.0f,  1.0f, -1.0f));
+
+    random_sampler<float> rs(0U);
+
+    for (int i = 0; i < num_boxes; ++i)
+    {
+        vec3 center(rs.next(), rs.next(), rs.next());
+        center = center * 1.8f - vec3(0.9f);
+
+        vec3 half_size = vec3(0.02f + rs.next() * 0.04f);
+
+        add_box(triangles, center - half_size, center + half_size);
+    }
+
+    return triangles;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// The kernel from the ao example
+//
+
+template <typename R>
+struct example_kernel
+{
+    bvh_ref const* prims_begin;
+    bvh_ref const* prims_end;
+    int            samples;
+    float          radius;
+
+    template <typename Sampler>
+    result_record<typename R::scalar_type> operator()(R ray, Sampler& samp) const
+    {
+        using S = typename R::scalar_type;
+        using C = vector<4, S>;
+        using V = vector<3, S>;
+
+        // White background, as with the built-in kernel
+        result_record<S> result;
+        result.color = C(1.0f);
+
+        auto hit_rec = closest_hit(ray, prims_begin, prims_end);
+
+        result.hit = hit_rec.hit;
+
+        if (any(hit_rec.hit))
+        {
+            hit_rec.isect_pos = ray.ori + ray.dir * hit_rec.t;
+            result.isect_pos  = hit_rec.isect_pos;
+
+            C clr(1.0);
+
+            auto n = get_normal(hit_rec, *prims_begin);
+            n = faceforward(n, -ray.dir, n);
+
+            V u;
+            V v;
+            V w = n;
+            make_orthonormal_basis(u, v, w);
+
+            for (int i = 0; i < samples; ++i)
+            {
+                auto sp = cosine_sample_hemisphere(samp.next(), samp.next());
+
+                auto dir = normalize( sp.x * u + sp.y * v + sp.z * w );
+
+                R ao_ray;
+                ao_ray.ori = hit_rec.isect_pos + dir * S(1E-3f);
+                ao_ray.dir = dir;
+
+                auto ao_rec = any_hit(ao_ray, prims_begin, prims_end, S(radius));
+
+                clr = select(
+                        ao_rec.hit,
+                        clr - S(1.0f / samples),
+                        clr
+                        );
+            }
+
+            result.color = select( hit_rec.hit, C(clr.xyz(), S(1.0)), result.color );
+        }
+
+        return result;
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Render num_frames frames, return the average frame time in milliseconds and the
+// mean occlusion of the accumulated image
+//
+
+template <typename R, typename Kernel>
+static double measure(
+        std::shared_ptr<thread_pool>    pool,
+        Kernel const&                   kernel,
+        pinhole_camera const&           cam,
+        double&                         mean_occlusion
+        )
+{
+    tiled_sched<R> sched(pool);
+
+    rt_type rt;
+    rt.resize(width, height);
+
+    auto sparams = make_sched_params(pixel_sampler::jittered_blend_type{}, cam, rt);
+
+    // Warm up
+    sched.frame(kernel, sparams, 1);
+
+    timer t;
+
+    for (int i = 0; i < num_frames; ++i)
+    {
+        sched.frame(kernel, sparams, static_cast<unsigned>(i + 1));
+    }
+
+    double elapsed = t.elapsed() * 1000.0 / num_frames;
+
+    double sum = 0.0;
+
+    for (int i = 0; i < width * height; ++i)
+    {
+        sum += rt.color()[i].x;
+    }
+
+    mean_occlusion = 1.0 - sum / (width * height);
+
+    return elapsed;
+}
+
+template <typename R, typename Params>
+static void run(
+        char const*                     name,
+        std::shared_ptr<thread_pool>    pool,
+        bvh_ref const*                  prims,
+        Params const&                   params,
+        pinhole_camera const&           cam
+        )
+{
+    double example_occlusion = 0.0;
+    double kernel_occlusion = 0.0;
+
+    double example_ms = measure<R>(
+            pool,
+            example_kernel<R>{ prims, prims + 1, static_cast<int>(params.ao_samples), params.ao_radius },
+            cam,
+            example_occlusion
+            );
+
+    double kernel_ms = measure<R>(
+            pool,
+            ambient_occlusion::kernel<Params>{ params },
+            cam,
+            kernel_occlusion
+            );
+
+    std::printf("%10s %14.2f %14.2f %10.2f %12.4f %12.4f\n",
+            name,
+            example_ms,
+            kernel_ms,
+            example_ms / kernel_ms,
+            example_occlusion,
+            kernel_occlusion
+            );
+}
+
+int main(int argc, char** argv)
+{
+    unsigned num_threads = std::thread::hardware_concurrency();
+    int num_boxes = 2000;
+    unsigned ao_samples = 8;
+
+    if (argc > 1)
+    {
+        num_threads = static_cast<unsigned>(std::atoi(argv[1]));
+    }
+
+    if (argc > 2)
+    {
+        num_boxes = std::atoi(argv[2]);
+    }
+
+    if (argc > 3)
+    {
+        ao_samples = static_cast<unsigned>(std::atoi(argv[3]));
+    }
+
+    auto triangles = make_scene(num_boxes);
+
+    auto bvh = build<bvh_type>(triangles.data(), triangles.size());
+
+    aligned_vector<bvh_ref> prims(1, bvh.ref());
+
+    // Unused, the kernel only needs the geometric normals
+    aligned_vector<matte<float>> materials(1);
+    aligned_vector<point_light<float>> lights;
+
+    auto params = make_kernel_params(
+            prims.data(),
+            prims.data() + prims.size(),
+            materials.data(),
+            lights.data(),
+            lights.data(),
+            1,
+            1E-3f,
+            vec4(1.0f),
+            vec4(0.0f)
+            );
+
+    params.ao_samples = ao_samples;
+    params.ao_radius  = ao_radius;
+
+    pinhole_camera cam;
+    cam.perspective(45.0f * constants::degrees_to_radians<float>(), 1.0f, 0.01f, 100.0f);
+    cam.look_at(vec3(2.0f, 1.5f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    cam.set_viewport(0, 0, width, height);
+
+    auto pool = std::make_shared<thread_pool>(num_threads);
+
+    std::printf("Threads: %u, triangles: %u, samples: %u, radius: %.2f, image: %dx%d\n\n",
+            num_threads,
+            static_cast<unsigned>(triangles.size()),
+            ao_samples,
+            ao_radius,
+            width,
+            height
+            );
+
+    std::printf("%10s %14s %14s %10s %12s %12s\n",
+            "Rays", "Example [ms]", "Kernel [ms]", "Speedup", "Occl. (ex.)", "Occl. (k.)");
+
+    run<basic_ray<float>>("float", pool, prims.data(), params, cam);
+    run<basic_ray<simd::float4>>("float4", pool, prims.data(), params, cam);
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    run<basic_ray<simd::float8>>("float8", pool, prims.data(), params, cam);
+#endif
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+    run<basic_ray<simd::float16>>("float16", pool, prims.data(), params, cam);
+#endif
+}
@@ -0,0 +1,435 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/kernels.h>
+#include <visionaray/macrocell_grid.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/preintegration_table.h>
+#include <visionaray/random_sampler.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <common/timer.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Compare direct volume rendering with and without empty space skipping, and
+// post-classification with pre-integration for different step sizes and with
+// adaptive steps
+//
+// Usage: dvr_benchmark [num_threads] [volume_size] [num_blobs]
+//
+
+using voxel_type  = unorm<8>;
+using volume_ref  = texture_ref<voxel_type, 3>;
+using tf_ref      = texture_ref<vec4, 1>;
+using params_type = volume_kernel_params<volume_ref, tf_ref>;
+using rt_type     = simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+
+static const int   width      = 512;
+static const int   height     = 512;
+static const int   num_frames = 8;
+
+
+//-------------------------------------------------------------------------------------------------
+// Procedural volume: randomly placed blobs, the rest of the volume is 0
+//
+
+static aligned_vector<voxel_type> make_volume(int size, int num_blobs)
+{
+    aligned_vector<voxel_type> voxels(size * size * size, voxel_type(0.0f));
+
+    random_sampler<float> rs(0U);
+
+    for (int i = 0; i < num_blobs; ++i)
+    {
+        vec3 center(rs.next(), rs.next(), rs.next());
+        center = center * 0.8f + vec3(0.1f);
+        center *= static_cast<float>(size);
+
+        float radius = (0.02f + rs.next() * 0.05f) * size;
+
+        vec3i lo(max(center - vec3(radius), vec3(0.0f)));
+        vec3i hi(min(center + vec3(radius), vec3(static_cast<float>(size - 1))));
+
+        for (int z = lo.z; z <= hi.z; ++z)
+        {
+            for (int y = lo.y; y <= hi.y; ++y)
+            {
+                for (int x = lo.x; x <= hi.x; ++x)
+                {
+                    float d = length(vec3(x + 0.5f, y + 0.5f, z + 0.5f) - center) / radius;
+
+                    if (d < 1.0f)
+                    {
+                        auto& v = voxels[(static_cast<size_t>(z) * size + y) * size + x];
+                        v = voxel_type(max(static_cast<float>(v), 1.0f - d));
+                    }
+                }
+            }
+        }
+    }
+
+    return voxels;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// The ray marching loop from the volume example: step through the whole bounding box,
+// until all lanes have left the box or are opaque
+//
+
+template <typename R>
+struct example_kernel
+{
+    params_type params;
+
+    result_record<typename R::scalar_type> operator()(R ray) const
+    {
+        using S = typename R::scalar_type;
+        using C = vector<4, S>;
+        using V = vector<3, S>;
+
+        result_record<S> result;
+
+        auto hit_rec = intersect(ray, params.bbox);
+        auto t = max(hit_rec.tnear, S(0.0));
+
+        V size(params.bbox.max - params.bbox.min);
+
+        result.color = C(0.0);
+
+        while ( any(t < hit_rec.tfar) )
+        {
+            auto pos = ray.ori + ray.dir * t;
+            auto tex_coord = (pos - V(params.bbox.min)) / size;
+
+            // sample volume and do post-classification
+            auto voxel = tex3D(params.volume, tex_coord);
+            C color = tex1D(params.transfunc, voxel);
+
+            // premultiplied alpha
+            color.xyz() *= color.w;
+
+            // front-to-back alpha compositing
+            result.color += select(
+                    hit_rec.hit & (t < hit_rec.tfar),
+                    color * (1.0f - result.color.w),
+                    C(0.0)
+                    );
+
+            // early-ray termination - don't traverse w/o a contribution
+            if ( all(result.color.w >= 0.999) )
+            {
+                break;
+            }
+
+            // step on
+            t += params.delta;
+        }
+
+        result.hit = hit_rec.hit;
+        return result;
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Render num_frames frames, return the average frame time in milliseconds and the image
+//
+
+template <typename R, typename Kernel>
+static double measure(
+        std::shared_ptr<thread_pool>    pool,
+        Kernel const&                   kernel,
+        pinhole_camera const&           cam,
+        std::vector<vec4>&              image
+        )
+{
+    tiled_sched<R> sched(pool);
+
+    rt_type rt;
+    rt.resize(width, height);
+
+    auto sparams = make_sched_params(cam, rt);
+
+    // Warm up
+    sched.frame(kernel, sparams);
+
+    timer t;
+
+    for (int i = 0; i < num_frames; ++i)
+    {
+        sched.frame(kernel, sparams);
+    }
+
+    double elapsed = t.elapsed() * 1000.0 / num_frames;
+
+    image.assign(rt.color(), rt.color() + width * height);
+
+    return elapsed;
+}
+
+static double mean_opacity(std::vector<vec4> const& image)
+{
+    double sum = 0.0;
+
+    for (auto const& c : image)
+    {
+        sum += c.w;
+    }
+
+    return sum / image.size();
+}
+
+static double rms_error(std::vector<vec4> const& a, std::vector<vec4> const& b)
+{
+    double sum = 0.0;
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        vec4 d = a[i] - b[i];
+        sum += dot(d, d);
+    }
+
+    return std::sqrt(sum / a.size());
+}
+
+template <typename R>
+static void run(
+        char const*                     name,
+        std::shared_ptr<thread_pool>    pool,
+        params_type                     params,
+        macrocell_grid_ref const&       grid,
+        pinhole_camera const&           cam
+        )
+{
+    std::vector<vec4> example_image;
+    std::vector<vec4> kernel_image;
+    std::vector<vec4> skip_image;
+
+    double example_ms = measure<R>(pool, example_kernel<R>{ params }, cam, example_image);
+
+    params.grid = macrocell_grid_ref();
+    double kernel_ms = measure<R>(pool, dvr::kernel<params_type>{ params }, cam, kernel_image);
+
+    params.grid = grid;
+    double skip_ms = measure<R>(pool, dvr::kernel<params_type>{ params }, cam, skip_image);
+
+    std::printf("%10s %14.2f %14.2f %14.2f %10.2f %10.4f %10.4f %10.4f\n",
+            name,
+            example_ms,
+            kernel_ms,
+            skip_ms,
+            example_ms / skip_ms,
+            mean_opacity(example_image),
+            mean_opacity(kernel_image),
+            mean_opacity(skip_image)
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Post-classification vs. pre-integration and adaptive steps with a transfer function
+// with thin features, with empty space skipping. Errors are relative to pre-integration
+// with 1/4 of the step
+//
+
+template <typename R>
+static void run_preintegration(
+        std::shared_ptr<thread_pool>    pool,
+        params_type                     params,
+        pinhole_camera const&           cam
+        )
+{
+    float delta_ref = params.delta;
+
+    preintegration_table table(pool);
+
+    std::vector<vec4> reference;
+    table.build(params.transfunc, delta_ref / 4.0f, delta_ref);
+    params.delta = delta_ref / 4.0f;
+    params.preintegrated = true;
+    params.preintegration_table = table.ref();
+    measure<R>(pool, dvr::kernel<params_type>{ params }, cam, reference);
+
+    std::printf("%16s %10s %14s %14s %10s %10s\n", "Mode", "Step", "Table [ms]", "Frame [ms]", "RMS error", "Opacity");
+
+    std::vector<vec4> image;
+
+    params.delta = delta_ref;
+    params.preintegrated = false;
+    double post_ms = measure<R>(pool, dvr::kernel<params_type>{ params }, cam, image);
+
+    std::printf("%16s %9dx %14s %14.2f %10.4f %10.4f\n",
+            "Post-class.",
+            1,
+            "-",
+            post_ms,
+            rms_error(image, reference),
+            mean_opacity(image)
+            );
+
+    for (int steps : { 1, 2, 4, 8 })
+    {
+        params.delta = delta_ref * steps;
+        table.build(params.transfunc, params.delta, delta_ref);
+
+        params.preintegrated = true;
+        double pre_ms = measure<R>(pool, dvr::kernel<params_type>{ params }, cam, image);
+
+        std::printf("%16s %9dx %14.2f %14.2f %10.4f %10.4f\n",
+                "Pre-integration",
+                steps,
+                table.last_build_time(),
+                pre_ms,
+                rms_error(image, reference),
+                mean_opacity(image)
+                );
+    }
+
+    params.delta = delta_ref;
+    params.preintegrated = false;
+    params.adaptive = true;
+    double adaptive_ms = measure<R>(pool, dvr::kernel<params_type>{ params }, cam, image);
+
+    std::printf("%16s %10s %14s %14.2f %10.4f %10.4f\n",
+            "Adaptive",
+            "0.25-8x",
+            "-",
+            adaptive_ms,
+            rms_error(image, reference),
+            mean_opacity(image)
+            );
+
+    std::printf("%16s %10s %14s %14s %10s %10.4f\n", "Reference", "1/4x", "", "", "", mean_opacity(reference));
+}
+
+int main(int argc, char** argv)
+{
+    unsigned num_threads = std::thread::hardware_concurrency();
+    int volume_size = 256;
+    int num_blobs = 40;
+
+    if (argc > 1)
+    {
+        num_threads = static_cast<unsigned>(std::atoi(argv[1]));
+    }
+
+    if (argc > 2)
+    {
+        volume_size = std::atoi(argv[2]);
+    }
+
+    if (argc > 3)
+    {
+        num_blobs = std::atoi(argv[3]);
+    }
+
+    auto voxels = make_volume(volume_size, num_blobs);
+
+    volume_ref volume(volume_size, volume_size, volume_size);
+    volume.reset(voxels.data());
+    volume.set_filter_mode(Linear);
+    volume.set_address_mode(Clamp);
+
+    // Transparent for low values
+    aligned_vector<vec4> tfdata = {
+            { 0.0f, 0.0f, 0.0f, 0.0f },
+            { 0.0f, 0.0f, 0.0f, 0.0f },
+            { 0.7f, 0.1f, 0.2f, 0.03f },
+            { 0.1f, 0.9f, 0.3f, 0.04f },
+            { 1.0f, 1.0f, 1.0f, 0.05f }
+            };
+
+    tf_ref transfunc(tfdata.size());
+    transfunc.reset(tfdata.data());
+    transfunc.set_filter_mode(Linear);
+    transfunc.set_address_mode(Clamp);
+
+    macrocell_grid grid;
+
+    timer t;
+    grid.build(volume);
+    double build_ms = t.elapsed() * 1000.0;
+
+    t.reset();
+    grid.classify(transfunc);
+    double classify_ms = t.elapsed() * 1000.0;
+
+    auto params = make_volume_kernel_params(
+            volume,
+            transfunc,
+            aabb(vec3(-1.0f), vec3(1.0f)),
+            2.0f / volume_size
+            );
+
+    pinhole_camera cam;
+    cam.perspective(45.0f * constants::degrees_to_radians<float>(), 1.0f, 0.01f, 100.0f);
+    cam.look_at(vec3(2.0f, 1.5f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    cam.set_viewport(0, 0, width, height);
+
+    auto pool = std::make_shared<thread_pool>(num_threads);
+
+    auto dims = grid.dims();
+
+    std::printf("Threads: %u, volume: %d^3, blobs: %d, image: %dx%d\n",
+            num_threads,
+            volume_size,
+            num_blobs,
+            width,
+            height
+            );
+
+    std::printf("Macrocells: %dx%dx%d, empty: %.1f%%, build: %.2f ms, classify: %.2f ms\n\n",
+            dims.x,
+            dims.y,
+            dims.z,
+            100.0 * grid.num_empty_cells() / (dims.x * dims.y * dims.z),
+            build_ms,
+            classify_ms
+            );
+
+    std::printf("%10s %14s %14s %14s %10s %10s %10s %10s\n",
+            "Rays", "Example [ms]", "Kernel [ms]", "Skipping [ms]", "Speedup", "Op. (ex.)", "Op. (k.)", "Op. (s.)");
+
+    run<basic_ray<float>>("float", pool, params, grid.ref(), cam);
+    run<basic_ray<simd::float4>>("float4", pool, params, grid.ref(), cam);
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    run<basic_ray<simd::float8>>("float8", pool, params, grid.ref(), cam);
+#endif
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+    run<basic_ray<simd::float16>>("float16", pool, params, grid.ref(), cam);
+#endif
+
+    // Thin shells of the blobs
+    aligned_vector<vec4> shells(256, vec4(0.0f));
+    shells[100] = vec4(1.0f, 0.5f, 0.2f, 0.5f);
+    shells[180] = vec4(0.2f, 0.4f, 1.0f, 0.8f);
+
+    transfunc = tf_ref(shells.size());
+    transfunc.reset(shells.data());
+    transfunc.set_filter_mode(Linear);
+    transfunc.set_address_mode(Clamp);
+
+    grid.classify(transfunc);
+
+    params.transfunc = transfunc;
+    params.grid = grid.ref();
+
+    std::printf("\nPre-integration (float4):\n");
+    run_preintegration<basic_ray<simd::float4>>(pool, params, cam);
+}
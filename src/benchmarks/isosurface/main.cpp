@@ -0,0 +1,369 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/get_normal.h>
+#include <visionaray/kernels.h>
+#include <visionaray/macrocell_grid.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/random_sampler.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <common/timer.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Compare the isosurface kernel with ray tracing a triangle mesh of the same surface
+//
+// Usage: isosurface_benchmark [num_threads] [volume_size] [num_blobs]
+//
+
+using volume_ref    = texture_ref<float, 3>;
+using params_type   = isosurface_kernel_params<volume_ref>;
+using triangle_type = basic_triangle<3, float>;
+using bvh_type      = index_bvh<triangle_type>;
+using bvh_ref       = bvh_type::bvh_ref;
+using rt_type       = simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+
+static const int   width      = 512;
+static const int   height     = 512;
+static const int   num_frames = 8;
+static const float isovalue   = 0.5f;
+
+
+//-------------------------------------------------------------------------------------------------
+// Procedural scene: randomly placed blobs, the value decreases linearly from 1 at the
+// center to 0 at the radius. The isosurface is the union of spheres with radius
+// (1 - isovalue) * radius, which are also tessellated for the triangle path
+//
+
+struct blob
+{
+    vec3  center;   // voxel units
+    float radius;   // voxel units
+};
+
+static std::vector<blob> make_blobs(int size, int num_blobs)
+{
+    std::vector<blob> blobs;
+
+    random_sampler<float> rs(0U);
+
+    for (int i = 0; i < num_blobs; ++i)
+    {
+        vec3 center(rs.next(), rs.next(), rs.next());
+        center = center * 0.8f + vec3(0.1f);
+        center *= static_cast<float>(size);
+
+        float radius = (0.02f + rs.next() * 0.05f) * size;
+
+        blobs.push_back({ center, radius });
+    }
+
+    return blobs;
+}
+
+static aligned_vector<float> make_volume(int size, std::vector<blob> const& blobs)
+{
+    aligned_vector<float> voxels(size * size * size, 0.0f);
+
+    for (auto const& b : blobs)
+    {
+        vec3i lo(max(b.center - vec3(b.radius), vec3(0.0f)));
+        vec3i hi(min(b.center + vec3(b.radius), vec3(static_cast<float>(size - 1))));
+
+        for (int z = lo.z; z <= hi.z; ++z)
+        {
+            for (int y = lo.y; y <= hi.y; ++y)
+            {
+                for (int x = lo.x; x <= hi.x; ++x)
+                {
+                    float d = length(vec3(x + 0.5f, y + 0.5f, z + 0.5f) - b.center) / b.radius;
+
+                    auto& v = voxels[(static_cast<size_t>(z) * size + y) * size + x];
+                    v = max(v, 1.0f - d);
+                }
+            }
+        }
+    }
+
+    return voxels;
+}
+
+static aligned_vector<triangle_type> make_triangles(int size, std::vector<blob> const& blobs, int segments)
+{
+    aligned_vector<triangle_type> triangles;
+
+    // Volume is [-1..1]^3 in world space
+    float scale = 2.0f / size;
+
+    auto vertex = [&](blob const& b, int i, int j)
+    {
+        float theta = constants::pi<float>() * i / (segments / 2);
+        float phi = constants::two_pi<float>() * j / segments;
+
+        vec3 dir(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+
+        return (b.center + dir * b.radius * (1.0f - isovalue)) * scale - vec3(1.0f);
+    };
+
+    for (auto const& b : blobs)
+    {
+        for (int i = 0; i < segments / 2; ++i)
+        {
+            for (int j = 0; j < segments; ++j)
+            {
+                vec3 v1 = vertex(b, i, j);
+                vec3 v2 = vertex(b, i + 1, j);
+                vec3 v3 = vertex(b, i + 1, j + 1);
+                vec3 v4 = vertex(b, i, j + 1);
+
+                // Skip the degenerate triangles at the poles
+                if (i > 0)
+                {
+                    triangle_type t(v1, v3 - v1, v4 - v1);
+                    t.prim_id = static_cast<unsigned>(triangles.size());
+                    t.geom_id = 0;
+                    triangles.push_back(t);
+                }
+
+                if (i < segments / 2 - 1)
+                {
+                    triangle_type t(v1, v2 - v1, v3 - v1);
+                    t.prim_id = static_cast<unsigned>(triangles.size());
+                    t.geom_id = 0;
+                    triangles.push_back(t);
+                }
+            }
+        }
+    }
+
+    return triangles;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Triangle path: closest hit with the same headlight shading as the isosurface kernel
+//
+
+template <typename R>
+struct triangle_kernel
+{
+    bvh_ref const* prims_begin;
+    bvh_ref const* prims_end;
+
+    result_record<typename R::scalar_type> operator()(R ray) const
+    {
+        using S = typename R::scalar_type;
+        using C = vector<4, S>;
+
+        result_record<S> result;
+        result.color = C(0.0);
+
+        auto hit_rec = closest_hit(ray, prims_begin, prims_end);
+
+        result.hit = hit_rec.hit;
+
+        if (any(hit_rec.hit))
+        {
+            auto n = get_normal(hit_rec, *prims_begin);
+            S ndotv = abs( dot(n, normalize(ray.dir)) );
+
+            result.isect_pos = ray.ori + ray.dir * hit_rec.t;
+            result.color = select( hit_rec.hit, C(ndotv, ndotv, ndotv, S(1.0)), result.color );
+        }
+
+        return result;
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Render num_frames frames, return the average frame time in milliseconds and the image
+//
+
+template <typename R, typename Kernel>
+static double measure(
+        std::shared_ptr<thread_pool>    pool,
+        Kernel const&                   kernel,
+        pinhole_camera const&           cam,
+        std::vector<vec4>&              image
+        )
+{
+    tiled_sched<R> sched(pool);
+
+    rt_type rt;
+    rt.resize(width, height);
+
+    auto sparams = make_sched_params(cam, rt);
+
+    // Warm up
+    sched.frame(kernel, sparams);
+
+    timer t;
+
+    for (int i = 0; i < num_frames; ++i)
+    {
+        sched.frame(kernel, sparams);
+    }
+
+    double elapsed = t.elapsed() * 1000.0 / num_frames;
+
+    image.assign(rt.color(), rt.color() + width * height);
+
+    return elapsed;
+}
+
+// Fraction of pixels that are covered in one image, but not in the other
+static double coverage_difference(std::vector<vec4> const& a, std::vector<vec4> const& b)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if ((a[i].w > 0.0f) != (b[i].w > 0.0f))
+        {
+            ++count;
+        }
+    }
+
+    return static_cast<double>(count) / a.size();
+}
+
+template <typename R>
+static void run(
+        char const*                     name,
+        std::shared_ptr<thread_pool>    pool,
+        bvh_ref const*                  prims,
+        params_type                     params,
+        macrocell_grid_ref const&       grid,
+        pinhole_camera const&           cam
+        )
+{
+    std::vector<vec4> triangle_image;
+    std::vector<vec4> kernel_image;
+    std::vector<vec4> skip_image;
+
+    double triangle_ms = measure<R>(pool, triangle_kernel<R>{ prims, prims + 1 }, cam, triangle_image);
+
+    params.grid = macrocell_grid_ref();
+    double kernel_ms = measure<R>(pool, isosurface::kernel<params_type>{ params }, cam, kernel_image);
+
+    params.grid = grid;
+    double skip_ms = measure<R>(pool, isosurface::kernel<params_type>{ params }, cam, skip_image);
+
+    std::printf("%10s %14.2f %14.2f %14.2f %10.2f %12.4f\n",
+            name,
+            triangle_ms,
+            kernel_ms,
+            skip_ms,
+            triangle_ms / skip_ms,
+            coverage_difference(triangle_image, skip_image)
+            );
+}
+
+int main(int argc, char** argv)
+{
+    unsigned num_threads = std::thread::hardware_concurrency();
+    int volume_size = 256;
+    int num_blobs = 40;
+
+    if (argc > 1)
+    {
+        num_threads = static_cast<unsigned>(std::atoi(argv[1]));
+    }
+
+    if (argc > 2)
+    {
+        volume_size = std::atoi(argv[2]);
+    }
+
+    if (argc > 3)
+    {
+        num_blobs = std::atoi(argv[3]);
+    }
+
+    auto blobs = make_blobs(volume_size, num_blobs);
+    auto voxels = make_volume(volume_size, blobs);
+
+    volume_ref volume(volume_size, volume_size, volume_size);
+    volume.reset(voxels.data());
+    volume.set_filter_mode(Linear);
+    volume.set_address_mode(Clamp);
+
+    macrocell_grid grid;
+
+    timer t;
+    grid.build(volume);
+    grid.classify_isosurface(isovalue);
+    double grid_ms = t.elapsed() * 1000.0;
+
+    // Triangle path, tessellation is considerably finer than the voxels
+    auto triangles = make_triangles(volume_size, blobs, 64);
+
+    t.reset();
+    auto bvh = build<bvh_type>(triangles.data(), triangles.size());
+    double bvh_ms = t.elapsed() * 1000.0;
+
+    aligned_vector<bvh_ref> prims(1, bvh.ref());
+
+    // One sample per voxel
+    auto params = make_isosurface_kernel_params(
+            volume,
+            isovalue,
+            aabb(vec3(-1.0f), vec3(1.0f)),
+            2.0f / volume_size
+            );
+
+    pinhole_camera cam;
+    cam.perspective(45.0f * constants::degrees_to_radians<float>(), 1.0f, 0.01f, 100.0f);
+    cam.look_at(vec3(2.0f, 1.5f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    cam.set_viewport(0, 0, width, height);
+
+    auto pool = std::make_shared<thread_pool>(num_threads);
+
+    auto dims = grid.dims();
+
+    std::printf("Threads: %u, volume: %d^3, blobs: %d, triangles: %u, image: %dx%d\n",
+            num_threads,
+            volume_size,
+            num_blobs,
+            static_cast<unsigned>(triangles.size()),
+            width,
+            height
+            );
+
+    std::printf("Macrocells: %dx%dx%d, empty: %.1f%%, build + classify: %.2f ms, BVH build: %.2f ms\n\n",
+            dims.x,
+            dims.y,
+            dims.z,
+            100.0 * grid.num_empty_cells() / (dims.x * dims.y * dims.z),
+            grid_ms,
+            bvh_ms
+            );
+
+    std::printf("%10s %14s %14s %14s %10s %12s\n",
+            "Rays", "Triangles [ms]", "Kernel [ms]", "Skipping [ms]", "Ratio", "Coverage diff.");
+
+    run<basic_ray<float>>("float", pool, prims.data(), params, grid.ref(), cam);
+    run<basic_ray<simd::float4>>("float4", pool, prims.data(), params, grid.ref(), cam);
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    run<basic_ray<simd::float8>>("float8", pool, prims.data(), params, grid.ref(), cam);
+#endif
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+    run<basic_ray<simd::float16>>("float16", pool, prims.data(), params, grid.ref(), cam);
+#endif
+}
@@ -0,0 +1,417 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/array.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/material.h>
+#include <visionaray/point_light.h>
+#include <visionaray/random_sampler.h>
+#include <visionaray/shade_record.h>
+
+#include <common/timer.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Compare per-lane, grouped and type-sorted evaluation of generic materials
+//
+// Usage: material_sort_benchmark [num_lanes] [num_materials]
+//
+
+using material_type = generic_material<
+        plastic<float>,
+        matte<float>,
+        emissive<float>,
+        mirror<float>
+        >;
+
+using light_type    = point_light<float>;
+
+static const int num_runs = 5;
+
+
+//-------------------------------------------------------------------------------------------------
+// Material library, the types are assigned round robin
+//
+
+static aligned_vector<material_type> make_materials(int num_materials)
+{
+    aligned_vector<material_type> result;
+
+    random_sampler<float> rs(0U);
+
+    for (int i = 0; i < num_materials; ++i)
+    {
+        vec3 color(rs.next(), rs.next(), rs.next());
+
+        switch (i % 4)
+        {
+        case 0:
+        {
+            plastic<float> m;
+            m.ca() = from_rgb(vec3(0.0f));
+            m.cd() = from_rgb(color);
+            m.cs() = from_rgb(vec3(0.5f));
+            m.ka() = 0.0f;
+            m.kd() = 1.0f;
+            m.ks() = 0.5f;
+            m.specular_exp() = 4.0f + rs.next() * 60.0f;
+            result.emplace_back(m);
+            break;
+        }
+
+        case 1:
+        {
+            matte<float> m;
+            m.ca() = from_rgb(vec3(0.0f));
+            m.cd() = from_rgb(color);
+            m.ka() = 0.0f;
+            m.kd() = 1.0f;
+            result.emplace_back(m);
+            break;
+        }
+
+        case 2:
+        {
+            emissive<float> m;
+            m.ce() = from_rgb(color);
+            m.ls() = 1.0f + rs.next() * 4.0f;
+            result.emplace_back(m);
+            break;
+        }
+
+        default:
+        {
+            mirror<float> m;
+            m.cr() = from_rgb(color);
+            m.kr() = 1.0f;
+            m.ior() = spectrum<float>(0.0f);
+            m.absorption() = spectrum<float>(0.0f);
+            result.emplace_back(m);
+            break;
+        }
+        }
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Random lanes: material index and shade record
+//
+
+struct lanes
+{
+    std::vector<unsigned>   material;
+    std::vector<vec3>       normal;
+    std::vector<vec3>       view_dir;
+    std::vector<vec3>       light_dir;
+};
+
+static vec3 random_direction(random_sampler<float>& rs, vec3 const& n)
+{
+    // Upper hemisphere w.r.t. n
+    vec3 d = normalize(vec3(rs.next(), rs.next(), rs.next()) * 2.0f - vec3(1.0f));
+    return dot(d, n) < 0.0f ? -d : d;
+}
+
+static lanes make_lanes(size_t num_lanes, int num_materials)
+{
+    lanes result;
+
+    random_sampler<float> rs(1U);
+
+    for (size_t i = 0; i < num_lanes; ++i)
+    {
+        unsigned m = static_cast<unsigned>(rs.next() * num_materials);
+        vec3 n = normalize(vec3(rs.next(), rs.next(), rs.next()) * 2.0f - vec3(1.0f));
+
+        result.material.push_back(m < static_cast<unsigned>(num_materials) ? m : 0);
+        result.normal.push_back(n);
+        result.view_dir.push_back(random_direction(rs, n));
+        result.light_dir.push_back(random_direction(rs, n));
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Evaluation modes
+//
+
+template <typename T>
+static T hadd(spectrum<T> const& s)
+{
+    T result(0.0);
+
+    for (int i = 0; i < spectrum<T>::num_samples; ++i)
+    {
+        result += s[i];
+    }
+
+    return result;
+}
+
+enum mode { PerLane, Grouped, Sorted };
+
+template <typename S>
+struct packet_evaluator
+{
+    enum { N = simd::num_elements<S>::value };
+
+    using simd_material = decltype(simd::pack(std::declval<array<material_type, N>>()));
+
+    aligned_vector<material_type> const&    materials;
+    lanes const&                            ls;
+    light_type                              light;
+
+    // Sum of the lanes, so that the compiler does not discard the results
+    float evaluate(std::vector<size_t> const& order, mode m, random_sampler<S>& samp) const
+    {
+        S sum(0.0);
+
+        for (size_t i = 0; i + N <= order.size(); i += N)
+        {
+            array<material_type, N> mats;
+            array<vec3, N> ns;
+            array<vec3, N> vds;
+            array<vec3, N> lds;
+
+            for (size_t l = 0; l < N; ++l)
+            {
+                size_t index = order[i + l];
+                mats[l] = materials[ls.material[index]];
+                ns[l]   = ls.normal[index];
+                vds[l]  = ls.view_dir[index];
+                lds[l]  = ls.light_dir[index];
+            }
+
+            shade_record<light_type, S> sr;
+            sr.isect_pos = vector<3, S>(0.0);
+            sr.normal    = simd::pack(ns);
+            sr.view_dir  = simd::pack(vds);
+            sr.light_dir = simd::pack(lds);
+            sr.light     = light;
+
+            vector<3, S> refl_dir;
+            S pdf;
+
+            spectrum<S> shaded;
+            spectrum<S> sampled;
+
+            // Kernels obtain the materials of a packet packed (cf. get_surface())
+            auto mat = simd::pack(mats);
+
+            if (m == PerLane)
+            {
+                shaded  = shade_per_lane(mat, sr);
+                sampled = sample_per_lane(mat, sr, refl_dir, pdf, samp.get_sampler());
+            }
+            else
+            {
+                shaded  = mat.shade(sr);
+                sampled = mat.sample(sr, refl_dir, pdf, samp);
+            }
+
+            sum += hadd(shaded) + hadd(sampled) + refl_dir.x + pdf;
+        }
+
+        simd::aligned_array_t<S> arr;
+        simd::store(arr, sum);
+
+        float result = 0.0f;
+
+        for (size_t l = 0; l < N; ++l)
+        {
+            result += arr[l];
+        }
+
+        return result;
+    }
+
+    // How simd::generic_material used to evaluate the lanes: the shade record
+    // is unpacked and the scalar materials are evaluated one by one
+    spectrum<S> shade_per_lane(
+            simd_material const&                mat,
+            shade_record<light_type, S> const&  sr
+            ) const
+    {
+        auto srs = simd::unpack(sr);
+
+        array<spectrum<float>, N> shaded;
+
+        for (size_t l = 0; l < N; ++l)
+        {
+            shaded[l] = mat.get(l).shade(srs[l]);
+        }
+
+        return simd::pack(shaded);
+    }
+
+    spectrum<S> sample_per_lane(
+            simd_material const&                mat,
+            shade_record<light_type, S> const&  sr,
+            vector<3, S>&                       refl_dir,
+            S&                                  pdf,
+            random_sampler<float>&              samp
+            ) const
+    {
+        auto srs = simd::unpack(sr);
+
+        array<vector<3, float>, N>  rds;
+        simd::aligned_array_t<S>    pdfs;
+        array<spectrum<float>, N>   sampled;
+
+        for (size_t l = 0; l < N; ++l)
+        {
+            rds[l]     = vector<3, float>(0.0f);
+            pdfs[l]    = 0.0f;
+            sampled[l] = mat.get(l).sample(srs[l], rds[l], pdfs[l], samp);
+        }
+
+        refl_dir = simd::pack(rds);
+        pdf = S(pdfs);
+        return simd::pack(sampled);
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Counting sort of the lanes by material type
+//
+
+static void sort_by_type(aligned_vector<material_type> const& materials, lanes const& ls, std::vector<size_t>& order)
+{
+    unsigned counts[5] = { 0, 0, 0, 0, 0 };
+
+    for (size_t i = 0; i < ls.material.size(); ++i)
+    {
+        ++counts[materials[ls.material[i]].which() + 1];
+    }
+
+    for (int k = 1; k < 5; ++k)
+    {
+        counts[k] += counts[k - 1];
+    }
+
+    for (size_t i = 0; i < ls.material.size(); ++i)
+    {
+        order[counts[materials[ls.material[i]].which()]++] = i;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Return the best time of num_runs runs in nanoseconds per lane
+//
+
+template <typename S>
+static double measure(packet_evaluator<S> const& eval, mode m, float& checksum)
+{
+    size_t num_lanes = eval.ls.material.size();
+
+    std::vector<size_t> order(num_lanes);
+
+    double best = 0.0;
+
+    for (int run = 0; run < num_runs; ++run)
+    {
+        random_sampler<S> samp(0U);
+
+        timer t;
+
+        for (size_t i = 0; i < num_lanes; ++i)
+        {
+            order[i] = i;
+        }
+
+        if (m == Sorted)
+        {
+            sort_by_type(eval.materials, eval.ls, order);
+        }
+
+        checksum = eval.evaluate(order, m, samp);
+
+        double elapsed = t.elapsed() * 1E9 / num_lanes;
+        best = run == 0 ? elapsed : std::min(best, elapsed);
+    }
+
+    return best;
+}
+
+template <typename S>
+static void run(char const* name, aligned_vector<material_type> const& materials, lanes const& ls)
+{
+    light_type light;
+    light.set_cl(vec3(1.0f));
+    light.set_kl(1.0f);
+    light.set_position(vec3(0.0f, 10.0f, 0.0f));
+    light.set_constant_attenuation(1.0f);
+    light.set_linear_attenuation(0.0f);
+    light.set_quadratic_attenuation(0.0f);
+
+    packet_evaluator<S> eval{ materials, ls, light };
+
+    float checksum[3];
+
+    double per_lane = measure(eval, PerLane, checksum[0]);
+    double grouped  = measure(eval, Grouped, checksum[1]);
+    double sorted   = measure(eval, Sorted,  checksum[2]);
+
+    std::printf("%10s %14.2f %14.2f %14.2f %10.2f %10.2f\n",
+            name,
+            per_lane,
+            grouped,
+            sorted,
+            per_lane / grouped,
+            per_lane / sorted
+            );
+
+    // Results differ because the random numbers are consumed in a different order
+    std::fprintf(stderr, "%10s checksums: %g %g %g\n", name, checksum[0], checksum[1], checksum[2]);
+}
+
+int main(int argc, char** argv)
+{
+    size_t num_lanes = 1 << 18;
+    int num_materials = 64;
+
+    if (argc > 1)
+    {
+        num_lanes = static_cast<size_t>(std::atol(argv[1]));
+    }
+
+    if (argc > 2)
+    {
+        num_materials = std::max(1, std::atoi(argv[2]));
+    }
+
+    auto materials = make_materials(num_materials);
+    auto ls = make_lanes(num_lanes, num_materials);
+
+    std::printf("Lanes: %u, materials: %d (plastic, matte, emissive, mirror)\n\n",
+            static_cast<unsigned>(num_lanes),
+            num_materials
+            );
+
+    std::printf("%10s %14s %14s %14s %10s %10s\n",
+            "Width", "Per lane [ns]", "Grouped [ns]", "Sorted [ns]", "Speedup", "Speedup");
+
+    run<simd::float4>("float4", materials, ls);
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    run<simd::float8>("float8", materials, ls);
+#endif
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+    run<simd::float16>("float16", materials, ls);
+#endif
+}
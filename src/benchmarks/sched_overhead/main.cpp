@@ -0,0 +1,97 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#include <visionaray/math/math.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <common/timer.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Measure the per-frame overhead of tiled_sched
+//
+// A trivial kernel is used so that the frame time is dominated by handing
+// out tiles to and collecting them from the worker threads.
+//
+// Usage: sched_overhead [num_threads]
+//
+
+using ray_type  = basic_ray<float>;
+using rt_type   = simple_buffer_rt<PF_RGBA8, PF_UNSPECIFIED>;
+
+
+//-------------------------------------------------------------------------------------------------
+// Average frame time in microseconds
+//
+
+static double measure(tiled_sched<ray_type>& sched, rt_type& rt, int num_frames)
+{
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    auto sparams = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt);
+
+    auto kernel = [](ray_type) -> vec4 { return vec4(1.0f); };
+
+    // Warm up
+    for (int i = 0; i < 10; ++i)
+    {
+        sched.frame(kernel, sparams);
+    }
+
+    timer t;
+
+    for (int i = 0; i < num_frames; ++i)
+    {
+        sched.frame(kernel, sparams);
+    }
+
+    return t.elapsed() * 1000000.0 / num_frames;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned num_threads = std::thread::hardware_concurrency();
+
+    if (argc > 1)
+    {
+        num_threads = static_cast<unsigned>(std::atoi(argv[1]));
+    }
+
+    auto pool = std::make_shared<thread_pool>(num_threads);
+    tiled_sched<ray_type> sched(pool);
+
+    unsigned spin_count = pool->spin_count();
+
+    int sizes[] = { 16, 32, 64, 128, 256, 512, 1024 };
+
+    std::printf("Threads: %u\n\n", num_threads);
+    std::printf("%10s %10s %16s %16s\n", "Size", "Frames", "No spin [us]", "Spin [us]");
+
+    for (int size : sizes)
+    {
+        rt_type rt;
+        rt.resize(size, size);
+
+        // Roughly the same number of pixels for each image size
+        int num_frames = std::max(20, (1 << 24) / (size * size));
+        num_frames = std::min(num_frames, 20000);
+
+        pool->set_spin_count(0);
+        double no_spin = measure(sched, rt, num_frames);
+
+        pool->set_spin_count(spin_count);
+        double spin = measure(sched, rt, num_frames);
+
+        std::printf("%10d %10d %16.2f %16.2f\n", size, num_frames, no_spin, spin);
+    }
+}
@@ -0,0 +1,239 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/kernels.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <common/timer.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Compare direct volume rendering of 3D textures with linear and with brick layout,
+// for different viewing directions
+//
+// Usage: texture_layout_benchmark [num_threads] [volume_size]
+//
+
+using linear_ref  = texture_ref<float, 3>;
+using bricked_ref = bricked_texture_ref<float, 3>;
+using tf_ref      = texture_ref<vec4, 1>;
+using rt_type     = simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+
+static const int   width      = 512;
+static const int   height     = 512;
+static const int   num_frames = 4;
+
+
+//-------------------------------------------------------------------------------------------------
+// Procedural volume without empty space, rays traverse the whole volume
+//
+
+static aligned_vector<float> make_volume(int size)
+{
+    aligned_vector<float> voxels(static_cast<size_t>(size) * size * size);
+
+    float f = constants::two_pi<float>() * 4.0f / size;
+
+    for (int z = 0; z < size; ++z)
+    {
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                voxels[(static_cast<size_t>(z) * size + y) * size + x]
+                        = 0.5f + 0.5f * std::sin(x * f) * std::sin(y * f * 1.3f) * std::sin(z * f * 0.7f);
+            }
+        }
+    }
+
+    return voxels;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Render num_frames frames, return the average frame time in milliseconds and the image
+//
+
+template <typename R, typename Kernel>
+static double measure(
+        std::shared_ptr<thread_pool>    pool,
+        Kernel const&                   kernel,
+        pinhole_camera const&           cam,
+        std::vector<vec4>&              image
+        )
+{
+    tiled_sched<R> sched(pool);
+
+    rt_type rt;
+    rt.resize(width, height);
+
+    auto sparams = make_sched_params(cam, rt);
+
+    // Warm up
+    sched.frame(kernel, sparams);
+
+    timer t;
+
+    for (int i = 0; i < num_frames; ++i)
+    {
+        sched.frame(kernel, sparams);
+    }
+
+    double elapsed = t.elapsed() * 1000.0 / num_frames;
+
+    image.assign(rt.color(), rt.color() + width * height);
+
+    return elapsed;
+}
+
+static double max_difference(std::vector<vec4> const& a, std::vector<vec4> const& b)
+{
+    double result = 0.0;
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        result = std::max(result, static_cast<double>(length(a[i] - b[i])));
+    }
+
+    return result;
+}
+
+template <typename R>
+static void run(
+        char const*                     name,
+        std::shared_ptr<thread_pool>    pool,
+        linear_ref const&               linear_volume,
+        bricked_ref const&              bricked_volume,
+        tf_ref const&                   transfunc,
+        float                           delta
+        )
+{
+    // Along the axes and diagonals, z is the slowest dimension in linear layout
+    vec3 dirs[] = {
+            vec3(1.0f, 0.0f, 0.0f),
+            vec3(0.0f, 1.0f, 0.0f),
+            vec3(0.0f, 0.0f, 1.0f),
+            vec3(1.0f, 1.0f, 1.0f),
+            vec3(-1.0f, 0.5f, 1.0f)
+            };
+
+    char const* dir_names[] = { "x", "y", "z", "(1,1,1)", "(-1,.5,1)" };
+
+    aabb bbox(vec3(-1.0f), vec3(1.0f));
+
+    auto linear_params = make_volume_kernel_params(linear_volume, transfunc, bbox, delta);
+    auto bricked_params = make_volume_kernel_params(bricked_volume, transfunc, bbox, delta);
+
+    double linear_min = 1E10;
+    double linear_max = 0.0;
+    double bricked_min = 1E10;
+    double bricked_max = 0.0;
+
+    for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); ++i)
+    {
+        pinhole_camera cam;
+        cam.perspective(45.0f * constants::degrees_to_radians<float>(), 1.0f, 0.01f, 100.0f);
+        cam.look_at(normalize(dirs[i]) * 3.0f, vec3(0.0f), dirs[i].y == 0.0f ? vec3(0.0f, 1.0f, 0.0f) : vec3(0.0f, 0.0f, 1.0f));
+        cam.set_viewport(0, 0, width, height);
+
+        std::vector<vec4> linear_image;
+        std::vector<vec4> bricked_image;
+
+        double linear_ms = measure<R>(pool, dvr::kernel<decltype(linear_params)>{ linear_params }, cam, linear_image);
+        double bricked_ms = measure<R>(pool, dvr::kernel<decltype(bricked_params)>{ bricked_params }, cam, bricked_image);
+
+        linear_min = std::min(linear_min, linear_ms);
+        linear_max = std::max(linear_max, linear_ms);
+        bricked_min = std::min(bricked_min, bricked_ms);
+        bricked_max = std::max(bricked_max, bricked_ms);
+
+        std::printf("%10s %10s %12.2f %12.2f %10.2f %12.2g\n",
+                name,
+                dir_names[i],
+                linear_ms,
+                bricked_ms,
+                linear_ms / bricked_ms,
+                max_difference(linear_image, bricked_image)
+                );
+    }
+
+    std::printf("%10s %10s %12.2f %12.2f\n\n", name, "max/min", linear_max / linear_min, bricked_max / bricked_min);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned num_threads = std::thread::hardware_concurrency();
+    int volume_size = 384;
+
+    if (argc > 1)
+    {
+        num_threads = static_cast<unsigned>(std::atoi(argv[1]));
+    }
+
+    if (argc > 2)
+    {
+        volume_size = std::atoi(argv[2]);
+    }
+
+    auto voxels = make_volume(volume_size);
+
+    linear_ref linear_volume(volume_size, volume_size, volume_size);
+    linear_volume.reset(voxels.data());
+    linear_volume.set_filter_mode(Linear);
+    linear_volume.set_address_mode(Clamp);
+
+    timer t;
+    bricked_texture<float, 3> bricked_storage(linear_volume);
+    double convert_ms = t.elapsed() * 1000.0;
+
+    bricked_ref bricked_volume(bricked_storage);
+
+    // Low opacity, rays are not terminated early
+    aligned_vector<vec4> tfdata = {
+            { 0.1f, 0.1f, 0.8f, 0.001f },
+            { 0.1f, 0.8f, 0.1f, 0.002f },
+            { 0.8f, 0.1f, 0.1f, 0.003f }
+            };
+
+    tf_ref transfunc(tfdata.size());
+    transfunc.reset(tfdata.data());
+    transfunc.set_filter_mode(Linear);
+    transfunc.set_address_mode(Clamp);
+
+    auto pool = std::make_shared<thread_pool>(num_threads);
+
+    std::printf("Threads: %u, volume: %d^3 (%.1f MB), image: %dx%d, conversion to bricks: %.2f ms\n\n",
+            num_threads,
+            volume_size,
+            voxels.size() * sizeof(float) / (1024.0 * 1024.0),
+            width,
+            height,
+            convert_ms
+            );
+
+    std::printf("%10s %10s %12s %12s %10s %12s\n", "Rays", "View dir.", "Linear [ms]", "Bricked [ms]", "Speedup", "Max. diff.");
+
+    // One sample per voxel
+    float delta = 2.0f / volume_size;
+
+    run<basic_ray<float>>("float", pool, linear_volume, bricked_volume, transfunc, delta);
+    run<basic_ray<simd::float4>>("float4", pool, linear_volume, bricked_volume, transfunc, delta);
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    run<basic_ray<simd::float8>>("float8", pool, linear_volume, bricked_volume, transfunc, delta);
+#endif
+}
@@ -18,10 +18,12 @@
 #include <visionaray/texture/texture.h>
 
 #include <visionaray/cpu_buffer_rt.h>
+#include <visionaray/gradient_volume.h>
 #include <visionaray/material.h>
 #include <visionaray/pinhole_camera.h>
 #include <visionaray/point_light.h>
 #include <visionaray/scheduler.h>
+#include <visionaray/volume_bvh.h>
 
 #ifdef __CUDACC__
 #include <visionaray/pixel_unpack_buffer_rt.h>
@@ -86,30 +88,6 @@ VSNRAY_ALIGN(32) static const vec4 tfdata[3 * 5] = {
         };
 
 
-//-------------------------------------------------------------------------------------------------
-// Helpers
-//
-
-template <typename T, typename Tex>
-VSNRAY_FUNC
-vector<3, T> gradient(Tex const& tex, vector<3, T> tex_coord)
-{
-    vector<3, T> s1;
-    vector<3, T> s2;
-
-    float DELTA = 0.01f;
-
-    s1.x = tex3D(tex, tex_coord - vector<3, T>(DELTA, 0.0f, 0.0f));
-    s2.x = tex3D(tex, tex_coord + vector<3, T>(DELTA, 0.0f, 0.0f));
-    s1.y = tex3D(tex, tex_coord + vector<3, T>(0.0f, DELTA, 0.0f));
-    s2.y = tex3D(tex, tex_coord - vector<3, T>(0.0f, DELTA, 0.0f));
-    s1.z = tex3D(tex, tex_coord + vector<3, T>(0.0f, 0.0f, DELTA));
-    s2.z = tex3D(tex, tex_coord - vector<3, T>(0.0f, 0.0f, DELTA));
-
-    return s2 - s1;
-}
-
-
 //-------------------------------------------------------------------------------------------------
 // struct with state variables
 //
@@ -125,7 +103,8 @@ struct renderer : viewer_type
 
     renderer()
         : viewer_type(512, 512, "Visionaray Multi-Volume Rendering Example")
-        , host_sched(8)
+        , pool(std::make_shared<thread_pool>(8))
+        , host_sched(pool)
     {
     }
 
@@ -211,6 +190,23 @@ struct renderer : viewer_type
             transforms.push_back(t * r * s);
         }
 
+
+        // Precompute the gradients for shading, the builder shares
+        // its threads with the scheduler
+
+        for (auto const& volume : volumes)
+        {
+            gradients.emplace_back(pool);
+            gradients.back().build(volume);
+
+            std::cout << "Gradient volume: " << gradients.back().last_build_time() << " ms\n";
+        }
+
+        for (auto const& gradient : gradients)
+        {
+            gradient_refs.push_back(gradient.ref());
+        }
+
         for (size_t i = 0; i < volumes.size(); ++i)
         {
             model_manips.emplace_back( std::make_shared<rotate_manipulator>(
@@ -355,6 +351,11 @@ struct renderer : viewer_type
             device_volumes_storage.emplace_back(volume);
         }
 
+        for (auto const& gradient : gradient_refs)
+        {
+            device_gradients_storage.emplace_back(gradient);
+        }
+
         for (auto const& transfunc : transfuncs)
         {
             device_transfuncs_storage.emplace_back(transfunc);
@@ -364,6 +365,7 @@ struct renderer : viewer_type
 
     pinhole_camera                                              cam;
     manipulators                                                manips;
+    std::shared_ptr<thread_pool>                                pool;
     tiled_sched<ray_type>                                       host_sched;
     cpu_buffer_rt<PF_RGBA8, PF_UNSPECIFIED>                     host_rt;
 #ifdef __CUDACC__
@@ -380,18 +382,23 @@ struct renderer : viewer_type
     aligned_vector<float>                                       heart;
     aligned_vector<float>                                       mandelbulb;
 
+    // Precomputed gradients, one per volume
+    std::vector<gradient_volume>                                gradients;
+
 
     // textures and texture references
 
     // On the CPU, we can simply "ref" the arrays with data
     std::vector<texture_ref<float, 3>>                          volumes;
     std::vector<texture_ref<vec4, 1>>                           transfuncs;
+    std::vector<texture_ref<vector<4, unorm<8>>, 3>>            gradient_refs;
 
 #ifdef __CUDACC__
     // On the GPU, we need permanent storage in texture memory
     // and will create references later on
     std::vector<cuda_texture<float, 3>>                         device_volumes_storage;
     std::vector<cuda_texture<vec4, 1>>                          device_transfuncs_storage;
+    std::vector<cuda_texture<vector<4, unorm<8>>, 3>>           device_gradients_storage;
 #endif
 
 
@@ -425,154 +432,119 @@ struct kernel
     using V    = vector<3, S>;
     using C    = vector<4, S>;
     using Mat4 = matrix<4, 4, S>;
-    using HR   = hit_record<R, aabb>;
-
 
-    VSNRAY_GPU_FUNC
-    result_record<S> operator()(R ray)
-    {
-        result_record<S> result;
-
-        // visionaray::numeric_limits is compatible with
-        // CUDA and with x86 SIMD types, prefer this in
-        // a cross-platform kernel.
 
-        S tmin =  numeric_limits<float>::max();
-        S tmax = -numeric_limits<float>::max();
+    // Post-classified and shaded sample of a single volume
 
-
-        // tnear and tfar for each volume
-
-        vector<2, S> range[MAX_VOLS];
-
-        for (size_t i = 0; i < num_volumes; ++i)
+    struct sampler
+    {
+        VSNRAY_GPU_FUNC
+        C operator()(unsigned i, S t) const
         {
-            R inv_ray;
-            inv_ray.ori = (Mat4(transforms_inv[i]) * vector<4, S>(ray.ori, S(1.0))).xyz();
-            inv_ray.dir = (Mat4(transforms_inv[i]) * vector<4, S>(ray.dir, S(0.0))).xyz();
+            auto pos = ray.ori + ray.dir * t;
+                 pos = (Mat4(kern->transforms_inv[i]) * vector<4, S>(pos, S(1.0f))).xyz();
 
-            auto hit_rec = intersect(inv_ray, bboxes[i]);
-
-            tmin = select(
-                    hit_rec.hit && hit_rec.tnear < tmin,
-                    hit_rec.tnear,
-                    tmin
+            auto tex_coord = vector<3, S>(
+                    ( pos.x + 1.0f ) / 2.0f,
+                    (-pos.y + 1.0f ) / 2.0f,
+                    (-pos.z + 1.0f ) / 2.0f
                     );
 
-            tmax = select(
-                    hit_rec.hit && hit_rec.tfar > tmax,
-                    hit_rec.tfar,
-                    tmax
-                    );
+            // sample volume and do post-classification
+            auto voxel = tex3D(kern->volumes[i], tex_coord);
+            C colori = tex1D(kern->transfuncs[i], voxel);
 
-            range[i].x = hit_rec.tnear;
-            range[i].y = hit_rec.tfar;
-        }
-
-        auto t = tmin;
-        auto delta_t = 0.007f;
 
-        result.color = C(0.0);
+            auto do_shade = colori.w >= 0.1f;
 
-        while ( visionaray::any(t < tmax) )
-        {
-            auto color = C(0.0f);
-
-            for (size_t i = 0; i < num_volumes; ++i)
+            if (visionaray::any(do_shade))
             {
-                auto inside = t >= range[i].x && t < range[i].y;
+                // Single fetch from the precomputed gradients, y and z
+                // of the texture coordinates point opposite to the object
+                auto n = decode_normal(C(tex3D(kern->gradients[i], tex_coord)));
+                auto grad = V(n.x, -n.y, -n.z);
+                do_shade &= length(grad) != 0.0f;
+
+                shade_record<decltype(kern->light), S> sr;
+                sr.isect_pos = pos;
+                sr.light = kern->light;
+                sr.normal = grad;
+                sr.view_dir = -ray.dir;
+                auto light_pos = ( Mat4(kern->transforms_inv[i]) * vector<4, S>(V(sr.light.position()), S(1.0)) ).xyz();
+                sr.light_dir = normalize(light_pos);
+
+                auto shaded_clr = kern->materials[i].shade(sr);
+                colori.xyz() = mul(
+                        colori.xyz(),
+                        to_rgb(shaded_clr),
+                        do_shade,
+                        colori.xyz()
+                        );
+            }
 
-                if (visionaray::any(inside))
-                {
-                    auto pos = ray.ori + ray.dir * t;
-                         pos = (Mat4(transforms_inv[i]) * vector<4, S>(pos, S(1.0f))).xyz();
 
-                    auto tex_coord = vector<3, S>(
-                            ( pos.x + 1.0f ) / 2.0f,
-                            (-pos.y + 1.0f ) / 2.0f,
-                            (-pos.z + 1.0f ) / 2.0f
-                            );
+            // opacity correction
+//            colori.w = 1.0f - pow(1.0f - colori.w, delta_t);
 
-                    // sample volume and do post-classification
-                    auto voxel = tex3D(volumes[i], tex_coord);
-                    C colori = tex1D(transfuncs[i], voxel);
+            return colori;
+        }
 
+        kernel const* kern;
+        R ray;
+    };
 
-                    auto do_shade = colori.w >= 0.1f;
 
-                    if (visionaray::any(do_shade))
-                    {
-                        auto grad = gradient(volumes[i], tex_coord);
-                        do_shade &= length(grad) != 0.0f;
-
-                        shade_record<decltype(light), S> sr;
-                        sr.isect_pos = pos;
-                        sr.light = light;
-                        sr.normal = normalize(grad);
-                        sr.view_dir = -ray.dir;
-                        auto light_pos = ( Mat4(transforms_inv[i]) * vector<4, S>(V(sr.light.position()), S(1.0)) ).xyz();
-                        sr.light_dir = normalize(light_pos);
-
-                        auto shaded_clr = materials[i].shade(sr);
-                        colori.xyz() = mul(
-                                colori.xyz(),
-                                to_rgb(shaded_clr),
-                                do_shade,
-                                colori.xyz()
-                                );
-                    }
+    VSNRAY_GPU_FUNC
+    result_record<S> operator()(R ray) const
+    {
+        result_record<S> result;
 
+        // Entry and exit distances of the volumes along the ray, sorted
+        // by entry distance. Only the volumes whose bounding boxes overlap
+        // the ray are visited when traversing the BVH
 
-                    // opacity correction
-//                    colori.w = 1.0f - pow(1.0f - colori.w, delta_t);
+        volume_interval<S> intervals[MAX_VOLS];
+        size_t num_volumes = intersect_volumes(ray, bvh, intervals);
 
-                    // premultiplied alpha
-                    colori.xyz() *= colori.w;
+        // Only the MAX_VOLS nearest volumes are rendered
+        size_t count = num_volumes < MAX_VOLS ? num_volumes : MAX_VOLS;
 
-                    color += select(inside, colori, C(0.0f));
-                }
-            }
 
+        // Ray marching, only samples the volumes that overlap at each step
 
-            // front-to-back alpha compositing
-            result.color += select(
-                    t < tmax,
-                    color * (1.0f - result.color.w),
-                    C(0.0)
-                    );
+        auto delta_t = 0.007f;
 
+        sampler samp = { this, ray };
+        result.color = integrate_volumes(intervals, count, delta_t, samp);
 
-            // early-ray termination - don't traverse w/o a contribution
-            if ( visionaray::all(result.color.w >= 0.999) )
-            {
-                break;
-            }
+        result.hit = false;
 
-            // step on
-            t += delta_t;
+        for (size_t i = 0; i < count; ++i)
+        {
+            result.hit |= intervals[i].tnear <= intervals[i].tfar;
         }
 
-        result.hit = tmax > tmin;
         return result;
     }
 
 
-    // Kernel parameters: textures, bounding boxes, inverse transforms...
+    // Kernel parameters: textures, BVH over the volume bounds, inverse transforms...
 
+    // Max. number of volumes along a ray (of all rays of a packet)
     static const int MAX_VOLS = 32;
 
-    size_t num_volumes;
-
 #ifdef __CUDACC__
-    cuda_texture_ref<float, 3> const*   volumes;
-    cuda_texture_ref<vec4, 1> const*    transfuncs;
+    cuda_texture_ref<float, 3> const*               volumes;
+    cuda_texture_ref<vec4, 1> const*                transfuncs;
+    cuda_texture_ref<vector<4, unorm<8>>, 3> const* gradients;
 #else
-    texture_ref<float, 3> const*        volumes;
-    texture_ref<vec4, 1> const*         transfuncs;
+    texture_ref<float, 3> const*                    volumes;
+    texture_ref<vec4, 1> const*                     transfuncs;
+    texture_ref<vector<4, unorm<8>>, 3> const*      gradients;
 #endif
 
+    index_bvh<volume_bounds>::bvh_ref   bvh;
     matrix<4, 4, S> const*              transforms_inv;
-    aabb const*                         bboxes;
     plastic<S> const*                   materials;
     point_light<float>                  light;
 };
@@ -607,16 +579,13 @@ void renderer::on_display()
 
 #ifdef __CUDACC__
     thrust::device_vector<matrix<4, 4, S>>  param_transforms_inv;
-    thrust::device_vector<aabb>             param_bboxes;
     thrust::device_vector<plastic<S>>       param_materials;
 #else
     aligned_vector<matrix<4, 4, S>>         param_transforms_inv;
-    aligned_vector<aabb>                    param_bboxes;
     aligned_vector<plastic<S>>              param_materials;
 #endif
 
     param_transforms_inv.resize(transforms.size());
-    param_bboxes.resize(bboxes.size());
     param_materials.resize(transforms.size());
 
     for (size_t i = 0; i < transforms.size(); ++i)
@@ -624,11 +593,19 @@ void renderer::on_display()
         param_transforms_inv[i] = inverse(transforms[i]);
     }
 
+
+    // BVH over the world space bounds of the volumes, rebuilt
+    // every frame as the transforms may change interactively
+
+    aligned_vector<volume_bounds> bounds(bboxes.size());
+
     for (size_t i = 0; i < bboxes.size(); ++i)
     {
-        param_bboxes[i] = bboxes[i];
+        bounds[i] = make_volume_bounds(static_cast<unsigned>(i), bboxes[i], transforms[i]);
     }
 
+    auto host_bvh = build<index_bvh<volume_bounds>>(bounds.data(), bounds.size());
+
     for (size_t i = 0; i < transforms.size(); ++i)
     {
         plastic<S> mat;
@@ -669,22 +646,34 @@ void renderer::on_display()
         device_transfuncs[i] = transfunc_ref(device_transfuncs_storage[i]);
     }
 
+    thrust::device_vector<cuda_texture_ref<vector<4, unorm<8>>, 3>> device_gradients;
+    device_gradients.resize(device_gradients_storage.size());
+
+    using gradient_ref = thrust::device_vector<cuda_texture_ref<vector<4, unorm<8>>, 3>>::value_type;
+
+    for (size_t i = 0; i < device_gradients.size(); ++i)
+    {
+        device_gradients[i] = gradient_ref(device_gradients_storage[i]);
+    }
+
+
+    cuda_index_bvh<volume_bounds> device_bvh(host_bvh);
 
-    kern.num_volumes    = device_volumes.size();
     kern.volumes        = thrust::raw_pointer_cast(device_volumes.data());
     kern.transfuncs     = thrust::raw_pointer_cast(device_transfuncs.data());
+    kern.gradients      = thrust::raw_pointer_cast(device_gradients.data());
+    kern.bvh            = device_bvh.ref();
     kern.transforms_inv = thrust::raw_pointer_cast(param_transforms_inv.data());
-    kern.bboxes         = thrust::raw_pointer_cast(param_bboxes.data());
     kern.materials      = thrust::raw_pointer_cast(param_materials.data());
 #else
 
     // Nothing to copy with x86, just pass along some pointers
 
-    kern.num_volumes    = volumes.size();
     kern.volumes        = volumes.data();
     kern.transfuncs     = transfuncs.data();
+    kern.gradients      = gradient_refs.data();
+    kern.bvh            = host_bvh.ref();
     kern.transforms_inv = param_transforms_inv.data();
-    kern.bboxes         = param_bboxes.data();
     kern.materials      = param_materials.data();
 #endif
 
@@ -5,14 +5,19 @@
 #include <iostream>
 #include <memory>
 #include <ostream>
+#include <string>
 
 #include <GL/glew.h>
 
+#include <Support/CmdLine.h>
+#include <Support/CmdLineUtil.h>
+
 #include <visionaray/detail/platform.h>
 
 #include <visionaray/texture/texture.h>
 
 #include <visionaray/cpu_buffer_rt.h>
+#include <visionaray/kernels.h>
 #include <visionaray/pinhole_camera.h>
 #include <visionaray/scheduler.h>
 
@@ -34,8 +39,8 @@ using viewer_type   = viewer_glut;
 // Texture data
 //
 
-// volume data
-VSNRAY_ALIGN(32) static const float voldata[2 * 2 * 2] = {
+// volume data, if no raw file is given
+VSNRAY_ALIGN(32) static const unorm<8> voldata[2 * 2 * 2] = {
 
         // slice 1
         1.0f, 0.0f,
@@ -71,6 +76,30 @@ struct renderer : viewer_type
         , volume({2, 2, 2})
         , transfunc({4})
     {
+        using namespace support;
+
+        add_cmdline_option( cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "filename",
+            cl::Desc("Raw volume file with 8-bit voxels"),
+            cl::Positional,
+            cl::Optional,
+            cl::init(this->filename)
+            ) );
+
+        add_cmdline_option( cl::makeOption<vec3i&, cl::ScalarType>(
+            [&](StringRef name, StringRef /*arg*/, vec3i& value)
+            {
+                cl::Parser<>()(name + "-w", cmd_line_inst().bump(), value.x);
+                cl::Parser<>()(name + "-h", cmd_line_inst().bump(), value.y);
+                cl::Parser<>()(name + "-d", cmd_line_inst().bump(), value.z);
+            },
+            "dims",
+            cl::Desc("Size of the raw volume"),
+            cl::ArgDisallowed,
+            cl::init(this->dims)
+            ) );
+
         volume.reset(voldata);
         volume.set_filter_mode(Nearest);
         volume.set_address_mode(Clamp);
@@ -80,16 +109,32 @@ struct renderer : viewer_type
         transfunc.set_address_mode(Clamp);
     }
 
+    // Map the raw file, the texels are not copied
+    void load_volume()
+    {
+        mapped_volume = mapped_texture<unorm<8>, 3>(dims.x, dims.y, dims.z);
+        mapped_volume.map(filename);
+
+        volume = texture_ref<unorm<8>, 3>(mapped_volume);
+        volume.set_filter_mode(Linear);
+        volume.set_address_mode(Clamp);
+    }
+
     aabb                                        bbox;
     pinhole_camera                              cam;
     manipulators                                manips;
     cpu_buffer_rt<PF_RGBA8, PF_UNSPECIFIED>     host_rt;
     tiled_sched<host_ray_type>                  host_sched;
 
+    std::string                                 filename;
+    vec3i                                       dims            = vec3i(256, 256, 256);
+
+    mapped_texture<unorm<8>, 3>                 mapped_volume;
+
 
     // texture references
 
-    texture_ref<float, 3>                       volume;
+    texture_ref<unorm<8>, 3>                    volume;
     texture_ref<vec4, 1>                        transfunc;
 
 protected:
@@ -118,6 +163,11 @@ void renderer::on_display()
             );
 
 
+    // adaptive steps with opacity correction, terminated lanes are masked out
+
+    auto integrator = dvr::make_adaptive_integrator(volume, transfunc, 0.01f);
+
+
     // call kernel in schedulers' frame() method
 
     host_sched.frame([&](R ray) -> result_record<S>
@@ -125,42 +175,22 @@ void renderer::on_display()
         result_record<S> result;
 
         auto hit_rec = intersect(ray, bbox);
-        auto t = hit_rec.tnear;
-
-        result.color = C(0.0);
 
-        while ( any(t < hit_rec.tfar) )
-        {
-            auto pos = ray.ori + ray.dir * t;
-            auto tex_coord = vector<3, S>(
-                    ( pos.x + 1.0f ) / 2.0f,
-                    (-pos.y + 1.0f ) / 2.0f,
-                    (-pos.z + 1.0f ) / 2.0f
-                    );
-
-            // sample volume and do post-classification
-            auto voxel = tex3D(volume, tex_coord);
-            C color = tex1D(transfunc, voxel);
-
-            // premultiplied alpha
-            color.xyz() *= color.w;
-
-            // front-to-back alpha compositing
-            result.color += select(
-                    t < hit_rec.tfar,
-                    color * (1.0f - result.color.w),
-                    C(0.0)
-                    );
-
-            // early-ray termination - don't traverse w/o a contribution
-            if ( all(result.color.w >= 0.999) )
-            {
-                break;
-            }
+        // ray in texture coordinates, t is the same in both spaces
+        R tex_ray;
+        tex_ray.ori = vector<3, S>(
+                ( ray.ori.x + 1.0f ) / 2.0f,
+                (-ray.ori.y + 1.0f ) / 2.0f,
+                (-ray.ori.z + 1.0f ) / 2.0f
+                );
+        tex_ray.dir = vector<3, S>(
+                 ray.dir.x / 2.0f,
+                -ray.dir.y / 2.0f,
+                -ray.dir.z / 2.0f
+                );
 
-            // step on
-            t += 0.01f;
-        }
+        result.color = C(0.0);
+        integrator.integrate(tex_ray, hit_rec.tnear, hit_rec.tfar, hit_rec.hit, result.color);
 
         result.hit = hit_rec.hit;
         return result;
@@ -203,6 +233,11 @@ int main(int argc, char** argv)
     try
     {
         rend.init(argc, argv);
+
+        if (!rend.filename.empty())
+        {
+            rend.load_volume();
+        }
     }
     catch (std::exception& e)
     {
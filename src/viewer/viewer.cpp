@@ -1,9 +1,11 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <exception>
+#include <future>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -46,6 +48,8 @@
 #include <visionaray/gl/debug_callback.h>
 #include <visionaray/texture/texture.h>
 #include <visionaray/aligned_vector.h>
+#include <visionaray/aov_buffer_rt.h>
+#include <visionaray/atrous_denoiser.h>
 #include <visionaray/bvh.h>
 #include <visionaray/cpu_buffer_rt.h>
 #include <visionaray/generic_material.h>
@@ -113,6 +117,15 @@ struct renderer : viewer_type
 #endif
 
     using host_render_target_type   = cpu_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+    // Color and the guides for the denoiser, no ids and motion vectors
+    using host_aov_target_type      = aov_buffer_rt<
+            PF_RGBA32F,
+            PF_DEPTH32F,
+            PF_RGB32F,
+            PF_RGB32F,
+            PF_UNSPECIFIED,
+            PF_UNSPECIFIED
+            >;
     using host_bvh_type             = index_bvh<primitive_type>;
 #ifdef __CUDACC__
     using device_render_target_type = pixel_unpack_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
@@ -142,7 +155,17 @@ struct renderer : viewer_type
 
     renderer()
         : viewer_type(800, 800, "Visionaray Viewer")
+#if defined(__INTEL_COMPILER) || defined(__MINGW32__) || defined(__MINGW64__)
         , host_sched(std::thread::hardware_concurrency())
+        , denoiser(std::thread::hardware_concurrency())
+#else
+        // Pinned render threads, the pages of the framebuffer are placed on
+        // the NUMA nodes that render the respective tiles
+        , host_sched(std::make_shared<thread_pool>(std::thread::hardware_concurrency(), 4096, thread_pool::Compact))
+        , host_rt(host_sched.pool())
+        // Denoise on the threads of the scheduler, not on a second pool
+        , denoiser(host_sched.pool())
+#endif
 #ifdef __CUDACC__
         , device_sched(8, 8)
 #endif
@@ -223,6 +246,14 @@ struct renderer : viewer_type
             cl::init(this->col_space)
             ) );
 
+        add_cmdline_option( cl::makeOption<bool&>(
+            cl::Parser<>(),
+            "denoise",
+            cl::Desc("Denoise path traced images (CPU only)"),
+            cl::ArgDisallowed,
+            cl::init(this->denoise)
+            ) );
+
 #ifdef __CUDACC__
         add_cmdline_option( cl::makeOption<device_type&>({
                 { "cpu",                CPU,            "Rendering on the CPU" },
@@ -248,6 +279,7 @@ struct renderer : viewer_type
     bool                                        show_hud        = true;
     bool                                        show_hud_ext    = true;
     bool                                        show_bvh        = false;
+    bool                                        denoise         = false;
 
 
     std::string                                 filename;
@@ -273,12 +305,22 @@ struct renderer : viewer_type
     tiled_sched<ray_type_cpu>                   host_sched;
 #endif
     host_render_target_type                     host_rt;
+    host_aov_target_type                        host_aov_rt;
+    // Copy of host_rt that is displayed while the next frame is rendered
+    host_render_target_type                     host_display_rt;
+    // Progressive frame that is rendered while the last one is displayed
+    std::future<void>                           host_frame;
+    atrous_denoiser                             denoiser;
 #ifdef __CUDACC__
     cuda_sched<ray_type_gpu>                    device_sched;
     device_render_target_type                   device_rt;
 #endif
     pinhole_camera                              cam;
 
+    // Referenced by the kernel parameters of host_frame
+    aligned_vector<point_light<float>>          host_lights;
+    aligned_vector<host_bvh_type::bvh_ref>      host_primitives;
+
     mouse::pos                                  mouse_pos;
 
     visionaray::frame_counter                   counter;
@@ -298,6 +340,15 @@ private:
     void clear_frame();
     void render_hud();
 
+    // Cancel the frame in flight, if any, and wait until the workers are done
+    void cancel_frame();
+
+    // Color buffer of the last frame that was completed
+    host_render_target_type const& host_display_target() const;
+
+    // Only path traced images on the CPU are denoised
+    bool denoising() const;
+
 };
 
 
@@ -374,11 +425,14 @@ std::ostream& operator<<(std::ostream& out, pinhole_camera const& cam)
 
 void renderer::clear_frame()
 {
+    cancel_frame();
+
     frame_num = 0;
 
     if (algo == Pathtracing)
     {
         host_rt.clear_color_buffer();
+        host_aov_rt.clear_color_buffer();
 #ifdef __CUDACC__
         device_rt.clear_color_buffer();
 #endif
@@ -386,6 +440,37 @@ void renderer::clear_frame()
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Asynchronous host frames
+//
+
+void renderer::cancel_frame()
+{
+    if (host_frame.valid())
+    {
+#if !defined(__INTEL_COMPILER) && !defined(__MINGW32__) && !defined(__MINGW64__)
+        host_sched.cancel();
+#endif
+        host_frame.get();
+    }
+}
+
+renderer::host_render_target_type const& renderer::host_display_target() const
+{
+    return host_frame.valid() ? host_display_rt : host_rt;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Denoise if enabled and if the algorithm and device support it
+//
+
+bool renderer::denoising() const
+{
+    return denoise && algo == Pathtracing && dev_type == renderer::CPU;
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // HUD
 //
@@ -399,7 +484,7 @@ void renderer::render_hud()
 
     int x = visionaray::clamp( mouse_pos.x, 0, w - 1 );
     int y = visionaray::clamp( mouse_pos.y, 0, h - 1 );
-    auto color = host_rt.color();
+    auto color = host_display_target().color();
     auto rgba = color[(h - 1 - y) * w + x];
 
     int num_nodes = 0;
@@ -483,6 +568,13 @@ void renderer::render_hud()
     hud.print_buffer(300, h * 2 - 136);
     hud.clear_buffer();
 
+    if (denoising())
+    {
+        hud.buffer() << "Denoiser: " << denoiser.last_frame_time() << " ms";
+        hud.print_buffer(300, h * 2 - 170);
+        hud.clear_buffer();
+    }
+
 
     glPopMatrix();
     glMatrixMode(GL_PROJECTION);
@@ -492,6 +584,7 @@ void renderer::render_hud()
 
 void renderer::on_close()
 {
+    cancel_frame();
     outlines.destroy();
 }
 
@@ -499,7 +592,16 @@ void renderer::on_display()
 {
     using light_type = point_light<float>;
 
-    aligned_vector<light_type> host_lights;
+    // The frame submitted during the last call was rendered while that one was
+    // displayed, finish it before its kernel parameters are updated
+    bool have_host_frame = host_frame.valid();
+
+    if (have_host_frame)
+    {
+        host_frame.get();
+    }
+
+    host_lights.clear();
 
     light_type light;
     light.set_cl( vec3(1.0, 1.0, 1.0) );
@@ -542,14 +644,16 @@ void renderer::on_display()
                 amb
                 );
 
+        // Long paths are terminated early when their contribution is low
+        kparams.russian_roulette = true;
+
         call_kernel( algo, device_sched, kparams, frame_num, ssaa_samples, cam, device_rt );
 #endif
     }
     else if (dev_type == renderer::CPU)
     {
 #ifndef __CUDA_ARCH__
-        aligned_vector<renderer::host_bvh_type::bvh_ref> host_primitives;
-
+        host_primitives.clear();
         host_primitives.push_back(host_bvh.ref());
 
         auto kparams = make_kernel_params(
@@ -568,7 +672,54 @@ void renderer::on_display()
                 amb
                 );
 
-        call_kernel( algo, host_sched, kparams, frame_num, ssaa_samples, cam, host_rt );
+        // Long paths are terminated early when their contribution is low
+        kparams.russian_roulette = true;
+
+        if (denoising())
+        {
+            // Render color and guides, display the filtered image, the
+            // color buffer keeps accumulating the noisy samples
+            host_sched.frame(
+                    pathtracing::kernel<decltype(kparams)>({kparams}),
+                    make_sched_params(pixel_sampler::jittered_blend_type{}, cam, host_aov_rt),
+                    ++frame_num
+                    );
+
+            denoiser.frame(host_aov_rt);
+
+            std::copy(
+                    denoiser.color(),
+                    denoiser.color() + denoiser.width() * denoiser.height(),
+                    host_rt.color()
+                    );
+        }
+#if !defined(__INTEL_COMPILER) && !defined(__MINGW32__) && !defined(__MINGW64__)
+        else if (algo == Pathtracing)
+        {
+            // Progressive rendering: display frame N while frame N+1 is rendered.
+            // After a restart (e.g. camera motion), frame N is rendered right away
+            if (!have_host_frame)
+            {
+                call_kernel( algo, host_sched, kparams, frame_num, ssaa_samples, cam, host_rt );
+            }
+
+            std::copy(
+                    host_rt.color(),
+                    host_rt.color() + host_rt.width() * host_rt.height(),
+                    host_display_rt.color()
+                    );
+
+            host_frame = host_sched.frame_async(
+                    pathtracing::kernel<decltype(kparams)>({kparams}),
+                    make_sched_params(pixel_sampler::jittered_blend_type{}, cam, host_rt),
+                    ++frame_num
+                    );
+        }
+#endif
+        else
+        {
+            call_kernel( algo, host_sched, kparams, frame_num, ssaa_samples, cam, host_rt );
+        }
 #endif
     }
 
@@ -598,7 +749,7 @@ void renderer::on_display()
     }
     else
     {
-        host_rt.display_color_buffer();
+        host_display_target().display_color_buffer();
     }
 
 
@@ -652,6 +803,13 @@ void renderer::on_key_press(key_event const& event)
 
         break;
 
+    case 'd':
+        denoise = !denoise;
+        std::cout << "Denoiser " << (denoise ? "on" : "off") << '\n';
+        counter.reset();
+        clear_frame();
+        break;
+
     case 'c':
         if (col_space == renderer::RGB)
         {
@@ -740,7 +898,10 @@ void renderer::on_resize(int w, int h)
     cam.set_viewport(0, 0, w, h);
     float aspect = w / static_cast<float>(h);
     cam.perspective(45.0f * constants::degrees_to_radians<float>(), aspect, 0.001f, 1000.0f);
+    cancel_frame();
     host_rt.resize(w, h);
+    host_aov_rt.resize(w, h);
+    host_display_rt.resize(w, h);
 #ifdef __CUDACC__
     device_rt.resize(w, h);
 #endif
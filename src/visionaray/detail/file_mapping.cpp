@@ -0,0 +1,153 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <stdexcept>
+
+#include <visionaray/detail/file_mapping.h>
+#include <visionaray/detail/platform.h>
+
+#if defined(VSNRAY_OS_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace visionaray
+{
+namespace detail
+{
+
+#if defined(VSNRAY_OS_WIN32)
+
+file_mapping::file_mapping(std::string const& filename)
+{
+    file_ = CreateFileA(
+            filename.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+            );
+
+    if (file_ == INVALID_HANDLE_VALUE)
+    {
+        file_ = nullptr;
+        throw std::runtime_error("file_mapping: cannot open " + filename);
+    }
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(file_, &size))
+    {
+        CloseHandle(file_);
+        throw std::runtime_error("file_mapping: cannot determine size of " + filename);
+    }
+
+    size_ = static_cast<size_t>(size.QuadPart);
+
+    // Empty files cannot be mapped
+    if (size_ == 0)
+    {
+        return;
+    }
+
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mapping_ == nullptr)
+    {
+        CloseHandle(file_);
+        throw std::runtime_error("file_mapping: cannot map " + filename);
+    }
+
+    data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+
+    if (data_ == nullptr)
+    {
+        CloseHandle(mapping_);
+        CloseHandle(file_);
+        throw std::runtime_error("file_mapping: cannot map " + filename);
+    }
+}
+
+file_mapping::~file_mapping()
+{
+    if (data_ != nullptr)
+    {
+        UnmapViewOfFile(data_);
+    }
+
+    if (mapping_ != nullptr)
+    {
+        CloseHandle(mapping_);
+    }
+
+    if (file_ != nullptr)
+    {
+        CloseHandle(file_);
+    }
+}
+
+#else
+
+file_mapping::file_mapping(std::string const& filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+
+    if (fd == -1)
+    {
+        throw std::runtime_error("file_mapping: cannot open " + filename);
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) == -1)
+    {
+        close(fd);
+        throw std::runtime_error("file_mapping: cannot determine size of " + filename);
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+
+    // Empty files cannot be mapped
+    if (size_ > 0)
+    {
+        data_ = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    }
+
+    // The mapping stays valid when the file is closed
+    close(fd);
+
+    if (data_ == MAP_FAILED)
+    {
+        data_ = nullptr;
+        throw std::runtime_error("file_mapping: cannot map " + filename);
+    }
+}
+
+file_mapping::~file_mapping()
+{
+    if (data_ != nullptr)
+    {
+        munmap(data_, size_);
+    }
+}
+
+#endif
+
+char const* file_mapping::data() const
+{
+    return static_cast<char const*>(data_);
+}
+
+size_t file_mapping::size() const
+{
+    return size_;
+}
+
+} // detail
+} // visionaray
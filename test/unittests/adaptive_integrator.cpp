@@ -0,0 +1,240 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/kernels.h>
+#include <visionaray/macrocell_grid.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+using float_type = simd::float8;
+#else
+using float_type = simd::float4;
+#endif
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+template <typename R, typename KParams>
+static std::vector<vec4> render_adaptive(KParams const& kparams, int w, int h)
+{
+    pinhole_camera cam;
+    cam.perspective(0.8f, 1.0f, 0.01f, 100.0f);
+    cam.look_at(vec3(1.5f, 2.0f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    cam.set_viewport(0, 0, w, h);
+
+    simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED> rt;
+    rt.resize(w, h);
+
+    tiled_sched<R> sched(2);
+    sched.frame(dvr::kernel<KParams>({kparams}), make_sched_params(cam, rt));
+
+    return std::vector<vec4>(rt.color(), rt.color() + w * h);
+}
+
+static float max_difference(std::vector<vec4> const& a, std::vector<vec4> const& b)
+{
+    float result = 0.0f;
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            result = std::max(result, std::abs(a[i][c] - b[i][c]));
+        }
+    }
+
+    return result;
+}
+
+static float rms_difference(std::vector<vec4> const& a, std::vector<vec4> const& b)
+{
+    double sum = 0.0;
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        vec4 d = a[i] - b[i];
+        sum += dot(d, d);
+    }
+
+    return static_cast<float>(std::sqrt(sum / a.size()));
+}
+
+template <typename S>
+static vec4 first_lane(vector<4, S> const& v)
+{
+    simd::aligned_array_t<S> x;
+    simd::aligned_array_t<S> y;
+    simd::aligned_array_t<S> z;
+    simd::aligned_array_t<S> w;
+
+    store(x, v.x);
+    store(y, v.y);
+    store(z, v.z);
+    store(w, v.w);
+
+    return vec4(x[0], y[0], z[0], w[0]);
+}
+
+static vec4 first_lane(vec4 const& v)
+{
+    return v;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that the opacity of a homogeneous slab does not depend on the step lengths
+//
+
+template <typename S>
+static void test_opacity_correction()
+{
+    std::vector<float> voxels(4 * 4 * 4, 0.5f);
+    vec4 tfdata[2] = { vec4(1.0f, 0.5f, 0.25f, 0.05f), vec4(1.0f, 0.5f, 0.25f, 0.05f) };
+
+    texture_ref<float, 3> volume(4, 4, 4);
+    volume.reset(voxels.data());
+    volume.set_filter_mode(Linear);
+    volume.set_address_mode(Clamp);
+
+    texture_ref<vec4, 1> transfunc(2);
+    transfunc.reset(tfdata);
+    transfunc.set_filter_mode(Linear);
+    transfunc.set_address_mode(Clamp);
+
+    float delta_ref = 0.01f;
+
+    basic_ray<S> ray(vector<3, S>(0.0f, 0.5f, 0.5f), vector<3, S>(1.0f, 0.0f, 0.0f));
+
+    vec2 ranges[] = { vec2(1.0f, 1.0f), vec2(0.1f, 0.1f), vec2(0.25f, 8.0f), vec2(3.3f, 3.3f) };
+
+    for (auto range : ranges)
+    {
+        for (float length : { 0.3f, 0.5f, 1.0f })
+        {
+            auto integrator = dvr::make_adaptive_integrator(volume, transfunc, delta_ref);
+            integrator.min_delta = delta_ref * range.x;
+            integrator.max_delta = delta_ref * range.y;
+
+            vector<4, S> dst(0.0f);
+            integrator.integrate(ray, S(0.0f), S(length), true, dst);
+
+            float alpha = 1.0f - std::pow(0.95f, length / delta_ref);
+            vec4 result = first_lane(dst);
+
+            EXPECT_NEAR(result.w, alpha, 1E-4f);
+            EXPECT_NEAR(result.x, alpha, 1E-4f);
+            EXPECT_NEAR(result.y, 0.5f * alpha, 1E-4f);
+            EXPECT_NEAR(result.z, 0.25f * alpha, 1E-4f);
+        }
+    }
+}
+
+TEST(AdaptiveIntegrator, OpacityCorrection)
+{
+    test_opacity_correction<float>();
+    test_opacity_correction<float_type>();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test adaptive steps against small constant steps and against constant steps of
+// length delta, with and without empty space skipping
+//
+
+TEST(AdaptiveIntegrator, DVR)
+{
+    enum { size = 32 };
+
+    std::vector<float> voxels(size * size * size);
+
+    for (int z = 0; z < size; ++z)
+    {
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                float d = length(vec3(x + 0.5f, y + 0.5f, z + 0.5f) - vec3(14.0f, 16.0f, 15.0f)) / 14.0f;
+                voxels[(z * size + y) * size + x] = d < 1.0f ? 1.0f - d : 0.0f;
+            }
+        }
+    }
+
+    // Thin shells, the center is transparent
+    std::vector<vec4> tfdata(64, vec4(0.0f));
+    tfdata[24] = vec4(1.0f, 0.5f, 0.2f, 0.3f);
+    tfdata[40] = vec4(0.2f, 0.4f, 1.0f, 0.5f);
+
+    texture_ref<float, 3> volume(size, size, size);
+    volume.reset(voxels.data());
+    volume.set_filter_mode(Linear);
+    volume.set_address_mode(Clamp);
+
+    texture_ref<vec4, 1> transfunc(tfdata.size());
+    transfunc.reset(tfdata.data());
+    transfunc.set_filter_mode(Linear);
+    transfunc.set_address_mode(Clamp);
+
+    auto kparams = make_volume_kernel_params(
+            volume,
+            transfunc,
+            aabb(vec3(-1.0f), vec3(1.0f)),
+            0.02f
+            );
+
+    kparams.adaptive = true;
+
+    int w = 48;
+    int h = 48;
+
+    // Reference: small constant steps
+    kparams.adaptive_range = vec2(0.1f, 0.1f);
+    auto ref = render_adaptive<basic_ray<float>>(kparams, w, h);
+
+    float sum = 0.0f;
+
+    for (auto const& c : ref)
+    {
+        sum += c.w;
+    }
+
+    EXPECT_GT(sum, 100.0f);
+
+    kparams.adaptive = false;
+    auto fixed = render_adaptive<basic_ray<float>>(kparams, w, h);
+
+    kparams.adaptive = true;
+    kparams.adaptive_range = vec2(0.25f, 8.0f);
+    auto adaptive1 = render_adaptive<basic_ray<float>>(kparams, w, h);
+    auto adaptive_simd = render_adaptive<basic_ray<float_type>>(kparams, w, h);
+
+    EXPECT_LT(rms_difference(adaptive1, ref), 0.5f * rms_difference(fixed, ref));
+    EXPECT_LT(max_difference(adaptive1, ref), 0.08f);
+    EXPECT_LT(max_difference(adaptive_simd, adaptive1), 0.01f);
+
+    macrocell_grid grid;
+    grid.build(volume, 4);
+    grid.classify(transfunc);
+    ASSERT_GT(grid.num_empty_cells(), size_t(0));
+
+    kparams.grid = grid.ref();
+
+    auto skip1 = render_adaptive<basic_ray<float>>(kparams, w, h);
+    auto skip_simd = render_adaptive<basic_ray<float_type>>(kparams, w, h);
+
+    EXPECT_LT(max_difference(skip1, ref), 0.08f);
+    EXPECT_LT(max_difference(skip_simd, skip1), 0.01f);
+}
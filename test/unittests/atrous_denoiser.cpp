@@ -0,0 +1,169 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/atrous_denoiser.h>
+#include <visionaray/random_sampler.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Test image: noisy plane, the left and right halves face different directions
+// and have different albedos. The top rows are background (no hit)
+//
+
+struct test_image
+{
+    enum { width = 61, height = 37, background_rows = 4 };
+
+    std::vector<vec4>  color;
+    std::vector<vec3>  normal;
+    std::vector<float> depth;
+    std::vector<vec3>  albedo;
+
+    test_image()
+        : color(width * height)
+        , normal(width * height)
+        , depth(width * height)
+        , albedo(width * height)
+    {
+        random_sampler<float> rs(0U);
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                int i = y * width + x;
+
+                if (y < background_rows)
+                {
+                    color[i]  = vec4(0.2f, 0.3f, 0.4f, 1.0f);
+                    normal[i] = vec3(0.0f);
+                    depth[i]  = 1.0f;
+                    albedo[i] = vec3(0.0f);
+                }
+                else
+                {
+                    bool left = x < width / 2;
+                    float irradiance = left ? 1.0f : 0.25f;
+
+                    normal[i] = left ? vec3(0.0f, 0.0f, 1.0f) : vec3(1.0f, 0.0f, 0.0f);
+                    depth[i]  = 0.5f;
+                    albedo[i] = left ? vec3(0.8f, 0.4f, 0.2f) : vec3(0.2f, 0.9f, 0.5f);
+
+                    // Noise with mean 0
+                    float noise = (rs.next() - 0.5f) * irradiance;
+                    color[i] = vec4(albedo[i] * (irradiance + noise), 1.0f);
+                }
+            }
+        }
+    }
+
+    vec3 expected(int x) const
+    {
+        return x < width / 2 ? vec3(0.8f, 0.4f, 0.2f) : vec3(0.2f, 0.9f, 0.5f) * 0.25f;
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Mean squared error w.r.t. the noise-free image
+//
+
+static float mean_squared_error(test_image const& img, vec4 const* color)
+{
+    float sum = 0.0f;
+    int count = 0;
+
+    for (int y = test_image::background_rows; y < test_image::height; ++y)
+    {
+        for (int x = 0; x < test_image::width; ++x)
+        {
+            vec3 diff = color[y * test_image::width + x].xyz() - img.expected(x);
+            sum += dot(diff, diff);
+            ++count;
+        }
+    }
+
+    return sum / count;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test if noise is reduced, edges are preserved and background pixels are copied
+//
+
+TEST(AtrousDenoiser, Filter)
+{
+    test_image img;
+
+    atrous_denoiser denoiser(2);
+
+    denoiser.frame(
+            img.color.data(),
+            img.normal.data(),
+            img.depth.data(),
+            img.albedo.data(),
+            test_image::width,
+            test_image::height
+            );
+
+    ASSERT_EQ(denoiser.width(), static_cast<int>(test_image::width));
+    ASSERT_EQ(denoiser.height(), static_cast<int>(test_image::height));
+    EXPECT_GE(denoiser.last_frame_time(), 0.0);
+
+    vec4 const* result = denoiser.color();
+
+    // Noise is reduced
+    EXPECT_LT(mean_squared_error(img, result), mean_squared_error(img, img.color.data()) * 0.25f);
+
+    for (int y = 0; y < test_image::height; ++y)
+    {
+        for (int x = 0; x < test_image::width; ++x)
+        {
+            int i = y * test_image::width + x;
+
+            if (y < test_image::background_rows)
+            {
+                // Background is copied
+                EXPECT_FLOAT_EQ(result[i].x, img.color[i].x);
+                EXPECT_FLOAT_EQ(result[i].y, img.color[i].y);
+                EXPECT_FLOAT_EQ(result[i].z, img.color[i].z);
+            }
+            else
+            {
+                // The halves don't bleed into each other
+                vec3 diff = result[i].xyz() - img.expected(x);
+                EXPECT_LT(length(diff), 0.2f) << "x: " << x << ", y: " << y;
+            }
+
+            EXPECT_FLOAT_EQ(result[i].w, 1.0f);
+        }
+    }
+
+
+    // No iterations: demodulation and remodulation only
+    denoiser.set_iterations(0);
+
+    denoiser.frame(
+            img.color.data(),
+            img.normal.data(),
+            img.depth.data(),
+            img.albedo.data(),
+            test_image::width,
+            test_image::height
+            );
+
+    for (size_t i = 0; i < img.color.size(); ++i)
+    {
+        EXPECT_NEAR(result[i].x, img.color[i].x, 1E-5f);
+        EXPECT_NEAR(result[i].y, img.color[i].y, 1E-5f);
+        EXPECT_NEAR(result[i].z, img.color[i].z, 1E-5f);
+    }
+}
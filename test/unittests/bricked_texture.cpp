@@ -0,0 +1,153 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/random_sampler.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+using float_type = simd::float8;
+#else
+using float_type = simd::float4;
+#endif
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+// Size is not a multiple of the brick size, so that bricks at the borders are padded
+static const int W = 13;
+static const int H = 9;
+static const int D = 20;
+
+template <typename T>
+static aligned_vector<T> make_texels(random_sampler<float>& rs)
+{
+    aligned_vector<T> texels(W * H * D);
+
+    for (auto& t : texels)
+    {
+        t = T(rs.next());
+    }
+
+    return texels;
+}
+
+// Compare tex3D() of a linear and a bricked texture for all filter and address modes,
+// with coordinates inside and outside of [0..1]
+template <typename T>
+static void test_sampling(aligned_vector<T> const& texels)
+{
+    texture_ref<T, 3> linear_tex(W, H, D);
+    linear_tex.reset(texels.data());
+    linear_tex.set_filter_mode(Nearest);
+    linear_tex.set_address_mode(Clamp);
+
+    bricked_texture<T, 3> bricked_tex(linear_tex);
+    bricked_texture_ref<T, 3> bricked_ref(bricked_tex);
+
+    random_sampler<float> rs(0U);
+
+    for (auto filter_mode : { Nearest, Linear, BSpline, CardinalSpline })
+    {
+        for (auto address_mode : { Clamp, Wrap, Mirror })
+        {
+            linear_tex.set_filter_mode(filter_mode);
+            linear_tex.set_address_mode(address_mode);
+            bricked_ref.set_filter_mode(filter_mode);
+            bricked_ref.set_address_mode(address_mode);
+
+            for (int i = 0; i < 100; ++i)
+            {
+                simd::aligned_array_t<float_type> xs;
+                simd::aligned_array_t<float_type> ys;
+                simd::aligned_array_t<float_type> zs;
+
+                for (size_t l = 0; l < simd::num_elements<float_type>::value; ++l)
+                {
+                    xs[l] = rs.next() * 1.4f - 0.2f;
+                    ys[l] = rs.next() * 1.4f - 0.2f;
+                    zs[l] = rs.next() * 1.4f - 0.2f;
+
+                    vec3 coord(xs[l], ys[l], zs[l]);
+
+                    ASSERT_EQ(tex3D(bricked_ref, coord), tex3D(linear_tex, coord));
+                }
+
+                vector<3, float_type> coord = { float_type(xs), float_type(ys), float_type(zs) };
+
+                ASSERT_TRUE( all(tex3D(bricked_ref, coord) == tex3D(linear_tex, coord)) );
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that bricked textures and references address the same texels as linear textures
+//
+
+TEST(BrickedTexture, Texels)
+{
+    random_sampler<float> rs(0U);
+    auto texels = make_texels<float>(rs);
+
+    EXPECT_EQ(detail::brick_storage_size(W, H, D), size_t(16 * 16 * 24));
+
+    texture<float, 3> linear_tex(W, H, D);
+    linear_tex.reset(texels.data());
+
+    bricked_texture<float, 3> bricked_tex(W, H, D);
+    bricked_tex.reset(texels.data());
+
+    bricked_texture<float, 3> converted_tex(linear_tex);
+
+    bricked_texture<float, 3>::ref_type bricked_ref(bricked_tex);
+
+    EXPECT_EQ(bricked_ref.size(), linear_tex.size());
+
+    // Texel access is read-only
+    auto const& lt = linear_tex;
+    auto const& bt = bricked_tex;
+    auto const& ct = converted_tex;
+    auto const& br = bricked_ref;
+
+    for (int z = 0; z < D; ++z)
+    {
+        for (int y = 0; y < H; ++y)
+        {
+            for (int x = 0; x < W; ++x)
+            {
+                ASSERT_EQ(bt(x, y, z), lt(x, y, z));
+                ASSERT_EQ(ct(x, y, z), lt(x, y, z));
+                ASSERT_EQ(br(x, y, z), lt(x, y, z));
+            }
+        }
+    }
+
+    // Neighbors along z are in the same brick
+    EXPECT_EQ(&br(3, 4, 6) - &br(3, 4, 5), 8 * 8);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that the filter functions produce the same results with both layouts,
+// for single coordinates and SIMD vectors
+//
+
+TEST(BrickedTexture, Sampling)
+{
+    random_sampler<float> rs(1U);
+
+    test_sampling(make_texels<float>(rs));
+    test_sampling(make_texels<unorm<8>>(rs));
+}
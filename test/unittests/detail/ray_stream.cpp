@@ -0,0 +1,89 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+
+#include <visionaray/detail/ray_stream.h>
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/random_sampler.h>
+#include <visionaray/traverse.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that ray_stream::any_hit() reports the same occlusion as any_hit() for single rays
+//
+
+TEST(RayStream, AnyHit)
+{
+    using triangle_type = basic_triangle<3, float>;
+
+    random_sampler<float> rs(0U);
+
+    aligned_vector<triangle_type> triangles;
+
+    for (int i = 0; i < 500; ++i)
+    {
+        vec3 v1 = vec3(rs.next(), rs.next(), rs.next()) * 10.0f;
+        vec3 e1 = vec3(rs.next(), rs.next(), rs.next()) - vec3(0.5f);
+        vec3 e2 = vec3(rs.next(), rs.next(), rs.next()) - vec3(0.5f);
+
+        triangle_type t(v1, e1, e2);
+        t.prim_id = i;
+        t.geom_id = 0;
+        triangles.push_back(t);
+    }
+
+    auto tree = build<index_bvh<triangle_type>>(triangles.data(), triangles.size());
+    aligned_vector<index_bvh<triangle_type>::bvh_ref> refs(1, tree.ref());
+
+    default_intersector isect;
+
+    // Stream sizes that are not multiples of the SIMD width
+    for (size_t num_rays : { 1, 13, 1000 })
+    {
+        detail::ray_stream stream;
+        aligned_vector<basic_ray<float>> rays;
+        aligned_vector<float> max_ts;
+
+        for (size_t i = 0; i < num_rays; ++i)
+        {
+            vec3 ori = vec3(rs.next(), rs.next(), rs.next()) * 10.0f;
+            vec3 dst = vec3(rs.next(), rs.next(), rs.next()) * 10.0f;
+
+            basic_ray<float> ray(ori, normalize(dst - ori));
+            float max_t = length(dst - ori);
+
+            stream.push_back(ray, max_t);
+            rays.push_back(ray);
+            max_ts.push_back(max_t);
+        }
+
+        stream.any_hit(refs.begin(), refs.end(), isect);
+
+        ASSERT_EQ(stream.size(), num_rays);
+
+        size_t num_occluded = 0;
+
+        for (size_t i = 0; i < num_rays; ++i)
+        {
+            auto hr = any_hit(rays[i], refs.begin(), refs.end(), max_ts[i], isect);
+
+            EXPECT_EQ(stream.occluded(i), static_cast<bool>(hr.hit));
+
+            num_occluded += stream.occluded(i) ? 1 : 0;
+        }
+
+        // Make sure the test covers both cases
+        if (num_rays >= 1000)
+        {
+            EXPECT_GT(num_occluded, 0U);
+            EXPECT_LT(num_occluded, num_rays);
+        }
+    }
+}
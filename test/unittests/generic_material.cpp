@@ -3,8 +3,11 @@
 
 #include <vector>
 
+#include <visionaray/math/math.h>
 #include <visionaray/array.h>
 #include <visionaray/generic_material.h>
+#include <visionaray/point_light.h>
+#include <visionaray/shade_record.h>
 
 #include <gtest/gtest.h>
 
@@ -120,3 +123,113 @@ TEST(GenericMaterial, SIMD)
     }
     EXPECT_FLOAT_EQ( m4.ls(), em.ls() );
 }
+
+
+//-------------------------------------------------------------------------------------------------
+// Test if SIMD shade() and pdf() with mixed material types match the scalar results
+//
+
+TEST(GenericMaterial, SIMDMixedTypes)
+{
+    using material_type = generic_material<
+        plastic<float>,
+        matte<float>,
+        emissive<float>
+        >;
+
+    plastic<float> pl;
+    pl.ca() = from_rgb(vec3(0.0f));
+    pl.cd() = from_rgb(vec3(0.8f, 0.4f, 0.2f));
+    pl.cs() = from_rgb(vec3(0.5f));
+    pl.ka() = 0.0f;
+    pl.kd() = 1.0f;
+    pl.ks() = 0.5f;
+    pl.specular_exp() = 16.0f;
+
+    matte<float> ma;
+    ma.ca() = from_rgb(vec3(0.0f));
+    ma.cd() = from_rgb(vec3(0.2f, 0.9f, 0.5f));
+    ma.ka() = 0.0f;
+    ma.kd() = 1.0f;
+
+    emissive<float> em;
+    em.ce() = from_rgb(vec3(3.0f, 3.0f, 3.0f));
+    em.ls() = 5.0f;
+
+    // Lanes 0 and 2 have the same type, lane 2 has different parameters
+    matte<float> ma2 = ma;
+    ma2.cd() = from_rgb(vec3(1.0f, 0.0f, 0.0f));
+
+    // No type covers three quarters of the packet, all lanes are evaluated one by one
+    array<material_type, 4> mixed{{
+            material_type(ma),
+            material_type(pl),
+            material_type(ma2),
+            material_type(em)
+            }};
+
+    // Three matte lanes are evaluated vectorized, the plastic lane on its own
+    array<material_type, 4> grouped{{
+            material_type(ma),
+            material_type(pl),
+            material_type(ma2),
+            material_type(ma)
+            }};
+
+    point_light<float> light;
+    light.set_cl(vec3(1.0f));
+    light.set_kl(1.0f);
+    light.set_position(vec3(0.0f, 10.0f, 0.0f));
+    light.set_constant_attenuation(1.0f);
+    light.set_linear_attenuation(0.0f);
+    light.set_quadratic_attenuation(0.0f);
+
+    shade_record<point_light<float>, simd::float4> sr;
+    sr.isect_pos = vector<3, simd::float4>(0.0f);
+    sr.normal    = vector<3, simd::float4>(0.0f, 1.0f, 0.0f);
+    sr.view_dir  = normalize(vector<3, simd::float4>(
+            simd::float4(0.1f, 0.2f, -0.3f, 0.0f),
+            simd::float4(1.0f),
+            simd::float4(0.0f, 0.3f, 0.1f, 0.2f)
+            ));
+    sr.light_dir = normalize(vector<3, simd::float4>(
+            simd::float4(-0.1f, -0.2f, 0.3f, 0.1f),
+            simd::float4(1.0f),
+            simd::float4(0.1f, -0.3f, 0.0f, 0.2f)
+            ));
+    sr.light     = light;
+
+    for (auto const& mats : { mixed, grouped })
+    {
+        auto simd_material = simd::pack(mats);
+
+        auto shaded = simd_material.shade(sr);
+        auto pdf    = simd_material.pdf(sr);
+
+        auto srs = simd::unpack(sr);
+
+        simd::aligned_array_t<simd::float4> pdfs;
+        simd::store(pdfs, pdf);
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            shade_record<point_light<float>, float> ref_sr;
+            ref_sr.isect_pos = srs[i].isect_pos;
+            ref_sr.normal    = srs[i].normal;
+            ref_sr.view_dir  = srs[i].view_dir;
+            ref_sr.light_dir = srs[i].light_dir;
+            ref_sr.light     = light;
+
+            auto ref = mats[i].shade(ref_sr);
+
+            for (int j = 0; j < spectrum<float>::num_samples; ++j)
+            {
+                simd::aligned_array_t<simd::float4> arr;
+                simd::store(arr, shaded[j]);
+                EXPECT_NEAR(arr[i], ref[j], 1E-5f) << "lane: " << i;
+            }
+
+            EXPECT_NEAR(pdfs[i], mats[i].pdf(ref_sr), 1E-5f) << "lane: " << i;
+        }
+    }
+}
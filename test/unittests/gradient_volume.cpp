@@ -0,0 +1,161 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/gradient_volume.h>
+#include <visionaray/random_sampler.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+using float_type = simd::float8;
+#else
+using float_type = simd::float4;
+#endif
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+// Voxels sampled from a function of the texture coordinates at the voxel centers
+struct gradient_test_volume
+{
+    template <typename Func>
+    gradient_test_volume(int w, int h, int d, Func func)
+        : voxels(w * h * d)
+        , volume(w, h, d)
+    {
+        for (int z = 0; z < d; ++z)
+        {
+            for (int y = 0; y < h; ++y)
+            {
+                for (int x = 0; x < w; ++x)
+                {
+                    vec3 p = (vec3(x, y, z) + vec3(0.5f)) / vec3(w, h, d);
+                    voxels[(z * h + y) * w + x] = func(p);
+                }
+            }
+        }
+
+        volume.reset(voxels.data());
+        volume.set_filter_mode(Linear);
+        volume.set_address_mode(Clamp);
+    }
+
+    std::vector<float>      voxels;
+    texture_ref<float, 3>   volume;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that the gradients of a linear function are reconstructed exactly (up to
+// quantization), including the voxels at the borders
+//
+
+TEST(GradientVolume, Linear)
+{
+    vec3 g(0.5f, -2.0f, 1.0f);
+
+    gradient_test_volume tv(16, 8, 12, [&](vec3 p) { return dot(p, g); });
+
+    gradient_volume gv(2);
+    gv.build(tv.volume);
+
+    EXPECT_EQ(gv.size(), vec3i(16, 8, 12));
+    EXPECT_NEAR(gv.max_magnitude(), length(g), 1E-4f);
+
+    for (int z = 0; z < 12; ++z)
+    {
+        for (int y = 0; y < 8; ++y)
+        {
+            for (int x = 0; x < 16; ++x)
+            {
+                vec4 texel(gv(x, y, z));
+                vec3 grad = decode_gradient(texel, gv.max_magnitude());
+
+                // 8 bits per component
+                ASSERT_LT(length(grad - g), length(g) * 0.01f);
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that filtered lookups of the gradient volume agree with central differences
+// of the volume, for single rays and ray packets
+//
+
+TEST(GradientVolume, Sphere)
+{
+    int size = 32;
+
+    gradient_test_volume tv(size, size, size, [](vec3 p) { return length(p - vec3(0.5f)); });
+
+    auto pool = std::make_shared<thread_pool>(2);
+
+    gradient_volume gv(pool);
+    gv.build(tv.volume);
+
+    EXPECT_GE(gv.last_build_time(), 0.0);
+
+    auto ref = gv.ref();
+
+    float delta = 1.0f / size;
+
+    random_sampler<float> rs(0U);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        simd::aligned_array_t<float_type> xs;
+        simd::aligned_array_t<float_type> ys;
+        simd::aligned_array_t<float_type> zs;
+
+        for (size_t l = 0; l < simd::num_elements<float_type>::value; ++l)
+        {
+            // Stay away from the center, where the field has a kink
+            vec3 p;
+
+            do
+            {
+                p = vec3(rs.next(), rs.next(), rs.next()) * 0.8f + vec3(0.1f);
+            }
+            while (length(p - vec3(0.5f)) < 0.2f);
+
+            xs[l] = p.x;
+            ys[l] = p.y;
+            zs[l] = p.z;
+        }
+
+        vector<3, float_type> packet_coord = { float_type(xs), float_type(ys), float_type(zs) };
+        vector<4, float_type> packet_texel = tex3D(ref, packet_coord);
+        auto packet_normal = simd::unpack(decode_normal(packet_texel));
+
+        for (size_t l = 0; l < simd::num_elements<float_type>::value; ++l)
+        {
+            vec3 p(xs[l], ys[l], zs[l]);
+
+            vec3 expected(
+                    tex3D(tv.volume, p + vec3(delta, 0.0f, 0.0f)) - tex3D(tv.volume, p - vec3(delta, 0.0f, 0.0f)),
+                    tex3D(tv.volume, p + vec3(0.0f, delta, 0.0f)) - tex3D(tv.volume, p - vec3(0.0f, delta, 0.0f)),
+                    tex3D(tv.volume, p + vec3(0.0f, 0.0f, delta)) - tex3D(tv.volume, p - vec3(0.0f, 0.0f, delta))
+                    );
+
+            vec4 texel(tex3D(ref, p));
+            vec3 grad = decode_gradient(texel, gv.max_magnitude());
+
+            EXPECT_GT(dot(normalize(grad), normalize(expected)), 0.99f);
+            EXPECT_NEAR(length(grad), length(expected) / (2.0f * delta), 0.05f);
+
+            EXPECT_LT(length(packet_normal[l] - normalize(grad)), 1E-4f);
+        }
+    }
+}
@@ -0,0 +1,336 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+
+#include <visionaray/math/math.h>
+#include <visionaray/detail/spd/blackbody.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/hero_wavelengths.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/point_light.h>
+#include <visionaray/random_sampler.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/shade_record.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Average color of to_rgb() over stratified hero wavelengths
+//
+
+static vec3 average_rgb(vec3 const& rgb)
+{
+    int const n = 1000;
+
+    vec3 result(0.0f);
+
+    for (int i = 0; i < n; ++i)
+    {
+        hero_wavelengths<float> wl((i + 0.5f) / n);
+        result += to_rgb(from_rgb(rgb, wl), wl);
+    }
+
+    return result / static_cast<float>(n);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that the wavelengths are stratified over [lambda_min..lambda_max)
+//
+
+TEST(HeroWavelengths, Sampling)
+{
+    float lmin = hero_wavelengths<float>::lambda_min;
+    float lmax = hero_wavelengths<float>::lambda_max;
+    float step = (lmax - lmin) / 4;
+
+    for (float u : { 0.0f, 0.1f, 0.5f, 0.9f, 0.999f })
+    {
+        hero_wavelengths<float> wl(u);
+
+        EXPECT_FLOAT_EQ(wl[0], lmin + u * (lmax - lmin));
+        EXPECT_FLOAT_EQ(wl.pdf(), 1.0f / (lmax - lmin));
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            EXPECT_GE(wl[i], lmin);
+            EXPECT_LT(wl[i], lmax);
+
+            // Rotations of the hero wavelength
+            float d = wl[i] - wl[0];
+            d = d < 0.0f ? d + (lmax - lmin) : d;
+            EXPECT_NEAR(d, i * step, 1E-3f);
+        }
+    }
+
+    // SIMD: lanes have their own hero wavelength
+    simd::float4 u(0.0f, 0.25f, 0.5f, 0.75f);
+    hero_wavelengths<simd::float4, 8> wl(u);
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        simd::aligned_array_t<simd::float4> lambdas;
+        store(lambdas, wl[i]);
+
+        for (size_t j = 0; j < 4; ++j)
+        {
+            hero_wavelengths<float, 8> ref(j * 0.25f);
+            EXPECT_FLOAT_EQ(lambdas[j], ref[i]);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test conversions
+//
+
+TEST(HeroWavelengths, Conversions)
+{
+    // White is a constant spectrum and converts back to white
+    hero_wavelengths<float> wl(0.37f);
+    auto white = from_rgb(vec3(1.0f), wl);
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        EXPECT_FLOAT_EQ(white[i], 1.0f);
+    }
+
+    vec3 avg = average_rgb(vec3(1.0f));
+    EXPECT_NEAR(avg.x, 1.0f, 1E-3f);
+    EXPECT_NEAR(avg.y, 1.0f, 1E-3f);
+    EXPECT_NEAR(avg.z, 1.0f, 1E-3f);
+
+    // Primaries
+    for (vec3 rgb : { vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), vec3(0.8f, 0.4f, 0.1f) })
+    {
+        avg = average_rgb(rgb);
+        EXPECT_NEAR(avg.x, rgb.x, 0.05f);
+        EXPECT_NEAR(avg.y, rgb.y, 0.05f);
+        EXPECT_NEAR(avg.z, rgb.z, 0.05f);
+    }
+
+    // SPDs are evaluated per lane
+    blackbody bb(3000.0f);
+    simd::float4 u(0.1f, 0.3f, 0.6f, 0.95f);
+    hero_wavelengths<simd::float4> wl4(u);
+
+    auto samples = from_spd(bb, wl4);
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        simd::aligned_array_t<simd::float4> lambdas;
+        simd::aligned_array_t<simd::float4> values;
+        store(lambdas, wl4[i]);
+        store(values, samples[i]);
+
+        for (size_t j = 0; j < 4; ++j)
+        {
+            EXPECT_FLOAT_EQ(values[j], bb(lambdas[j]));
+        }
+    }
+
+    // SIMD and scalar conversions match
+    auto rgb4 = to_rgb(from_rgb(vector<3, simd::float4>(vec3(0.8f, 0.4f, 0.1f)), wl4), wl4);
+    auto rgbs = simd::unpack(rgb4);
+    float us[] = { 0.1f, 0.3f, 0.6f, 0.95f };
+
+    for (size_t j = 0; j < 4; ++j)
+    {
+        hero_wavelengths<float> ref(us[j]);
+        vec3 expected = to_rgb(from_rgb(vec3(0.8f, 0.4f, 0.1f), ref), ref);
+        EXPECT_NEAR(rgbs[j].x, expected.x, 1E-4f);
+        EXPECT_NEAR(rgbs[j].y, expected.y, 1E-4f);
+        EXPECT_NEAR(rgbs[j].z, expected.z, 1E-4f);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that materials evaluate their spectra at the wavelengths of spectral shade records.
+// Under white light, the samples are the spectra that shade() and sample() return for
+// plain shade records, evaluated at the wavelengths
+//
+
+TEST(HeroWavelengths, Materials)
+{
+    using material_type = generic_material<emissive<float>, matte<float>, mirror<float>, plastic<float>>;
+
+    emissive<float> em;
+    em.ce() = from_rgb(vec3(1.0f, 0.5f, 0.2f));
+    em.ls() = 2.0f;
+
+    matte<float> ma;
+    ma.cd() = from_rgb(vec3(0.8f, 0.4f, 0.1f));
+    ma.kd() = 0.9f;
+
+    mirror<float> mi;
+    mi.cr() = from_rgb(vec3(0.2f, 0.9f, 0.6f));
+    mi.kr() = 0.8f;
+    mi.ior() = spectrum<float>(1.5f);
+    mi.absorption() = spectrum<float>(0.2f);
+
+    plastic<float> pl;
+    pl.cd() = from_rgb(vec3(0.1f, 0.5f, 0.9f));
+    pl.cs() = from_rgb(vec3(0.9f, 0.7f, 0.5f));
+    pl.kd() = 0.8f;
+    pl.ks() = 0.4f;
+    pl.specular_exp() = 16.0f;
+
+    array<material_type, 4> mats{{ em, ma, mi, pl }};
+
+    point_light<float> light;
+    light.set_cl(vec3(1.0f));
+    light.set_kl(1.0f);
+    light.set_position(vec3(0.0f, 10.0f, 0.0f));
+    light.set_constant_attenuation(1.0f);
+    light.set_linear_attenuation(0.0f);
+    light.set_quadratic_attenuation(0.0f);
+
+    simd::float4 u(0.1f, 0.3f, 0.6f, 0.95f);
+    float us[] = { 0.1f, 0.3f, 0.6f, 0.95f };
+
+    spectral_shade_record<shade_record<point_light<float>, simd::float4>, 4> sr;
+    sr.isect_pos   = vector<3, simd::float4>(vec3(0.0f));
+    sr.normal      = vector<3, simd::float4>(vec3(0.0f, 1.0f, 0.0f));
+    sr.view_dir    = vector<3, simd::float4>(normalize(vec3(1.0f, 1.0f, 0.0f)));
+    sr.light_dir   = vector<3, simd::float4>(normalize(vec3(-1.0f, 1.0f, 0.2f)));
+    sr.light       = light;
+    sr.wavelengths = hero_wavelengths<simd::float4>(u);
+
+    // One material type per lane, the lanes are evaluated with scalar shade records
+    auto simd_material = simd::pack(mats);
+
+    auto shaded = simd_material.shade(sr);
+
+    vector<3, simd::float4> refl_dir;
+    simd::float4 pdf;
+    random_sampler<simd::float4> samp(7);
+    auto sampled = simd_material.sample(sr, refl_dir, pdf, samp);
+
+    auto shadeds  = simd::unpack(shaded);
+    auto sampleds = simd::unpack(sampled);
+    auto srs      = simd::unpack(sr);
+
+    random_sampler<float> ref_samp(7);
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        shade_record<point_light<float>, float> ref_sr = srs[i];
+        hero_wavelengths<float> wl(us[i]);
+
+        auto expected = from_spectrum(mats[i].shade(ref_sr), wl);
+
+        vec3 rd;
+        float p;
+        auto expected_sample = from_spectrum(mats[i].sample(ref_sr, rd, p, ref_samp), wl);
+
+        for (size_t j = 0; j < 4; ++j)
+        {
+            EXPECT_FLOAT_EQ(srs[i].wavelengths[j], wl[j]);
+            EXPECT_NEAR(shadeds[i][j], expected[j], 1E-4f) << "lane: " << i;
+            EXPECT_NEAR(sampleds[i][j], expected_sample[j], 1E-4f) << "lane: " << i;
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that spectral path tracing converges to the RGB result for gray materials
+//
+
+TEST(HeroWavelengths, Pathtracing)
+{
+    using triangle_type = basic_triangle<3, float>;
+    using material_type = generic_material<emissive<float>, mirror<float>>;
+
+    aligned_vector<triangle_type> triangles;
+    triangles.push_back(triangle_type(vec3(-3.0f, -1.0f, -3.0f), vec3(6.0f, 0.0f, 0.0f), vec3(6.0f, 0.0f, 6.0f)));
+    triangles.push_back(triangle_type(vec3(-3.0f, -1.0f, -3.0f), vec3(6.0f, 0.0f, 6.0f), vec3(0.0f, 0.0f, 6.0f)));
+    triangles.push_back(triangle_type(vec3(-1.0f, 1.5f, -1.0f), vec3(2.0f, 0.0f, 0.0f), vec3(2.0f, 0.0f, 2.0f)));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        triangles[i].prim_id = i;
+        triangles[i].geom_id = i / 2;
+    }
+
+    aligned_vector<material_type> materials;
+
+    mirror<float> m;
+    m.cr() = from_rgb(vec3(0.5f));
+    m.kr() = 1.0f;
+    m.ior() = spectrum<float>(0.0f);
+    m.absorption() = spectrum<float>(0.0f);
+    materials.push_back(m);
+
+    emissive<float> e;
+    e.ce() = from_rgb(vec3(1.0f));
+    e.ls() = 2.0f;
+    materials.push_back(e);
+
+    aligned_vector<point_light<float>> lights;
+
+    auto kparams = make_kernel_params(
+            triangles.data(),
+            triangles.data() + triangles.size(),
+            materials.data(),
+            lights.data(),
+            lights.data(),
+            5,
+            1E-3f,
+            vec4(0.0f),
+            vec4(0.5f)
+            );
+
+    int w = 256;
+    int h = 256;
+
+    pinhole_camera cam;
+    cam.perspective(0.8f, 1.0f, 0.01f, 100.0f);
+    cam.look_at(vec3(0.0f, 1.0f, 5.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    cam.set_viewport(0, 0, w, h);
+
+    tiled_sched<basic_ray<simd::float4>> sched(2);
+
+    vec3 mean[2];
+
+    for (int spectral = 0; spectral < 2; ++spectral)
+    {
+        kparams.spectral = spectral != 0;
+
+        simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED> rt;
+        rt.resize(w, h);
+
+        sched.frame(
+                pathtracing::kernel<decltype(kparams)>({kparams}),
+                make_sched_params(pixel_sampler::uniform_type{}, cam, rt)
+                );
+
+        mean[spectral] = vec3(0.0f);
+
+        for (int i = 0; i < w * h; ++i)
+        {
+            mean[spectral] += rt.color()[i].xyz();
+        }
+
+        mean[spectral] /= static_cast<float>(w * h);
+    }
+
+    // With sampled spectra, to_rgb() is not white balanced like the hero wavelength
+    // transport, a constant spectrum of 1 is not (1,1,1)
+    mean[0] /= to_rgb(spectrum<float>(1.0f));
+
+    EXPECT_GT(mean[0].x, 0.05f);
+    EXPECT_NEAR(mean[1].x, mean[0].x, mean[0].x * 0.03f);
+    EXPECT_NEAR(mean[1].y, mean[0].y, mean[0].y * 0.03f);
+    EXPECT_NEAR(mean[1].z, mean[0].z, mean[0].z * 0.03f);
+}
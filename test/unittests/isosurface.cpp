@@ -0,0 +1,210 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/array.h>
+#include <visionaray/kernels.h>
+#include <visionaray/macrocell_grid.h>
+#include <visionaray/random_sampler.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+using float_type = simd::float8;
+#else
+using float_type = simd::float4;
+#endif
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+// Decreases with the distance to the center of the volume (texture coordinates),
+// the isosurface with value 1 - r is a sphere
+struct distance_volume
+{
+    explicit distance_volume(int size)
+        : voxels(size * size * size)
+        , volume(size, size, size)
+    {
+        for (int z = 0; z < size; ++z)
+        {
+            for (int y = 0; y < size; ++y)
+            {
+                for (int x = 0; x < size; ++x)
+                {
+                    vec3 p = (vec3(x, y, z) + vec3(0.5f)) / static_cast<float>(size);
+                    voxels[(z * size + y) * size + x] = 1.0f - length(p - vec3(0.5f));
+                }
+            }
+        }
+
+        volume.reset(voxels.data());
+        volume.set_filter_mode(Linear);
+        volume.set_address_mode(Clamp);
+    }
+
+    std::vector<float>      voxels;
+    texture_ref<float, 3>   volume;
+};
+
+// Rays from outside the bounding box [-1..1]^3, aimed at points around the sphere
+static basic_ray<float> make_ray(random_sampler<float>& rs)
+{
+    vec3 dir = normalize(vec3(rs.next(), rs.next(), rs.next()) * 2.0f - vec3(1.0f));
+    vec3 ori = dir * 3.0f;
+    vec3 dst = (vec3(rs.next(), rs.next(), rs.next()) * 2.0f - vec3(1.0f)) * 0.8f;
+    return basic_ray<float>(ori, normalize(dst - ori));
+}
+
+// Intersection with the sphere at the origin
+static bool intersect_sphere(basic_ray<float> const& ray, float radius, float& t)
+{
+    float b = dot(ray.ori, ray.dir);
+    float c = dot(ray.ori, ray.ori) - radius * radius;
+    float disc = b * b - c;
+
+    if (disc < 0.0f)
+    {
+        return false;
+    }
+
+    t = -b - sqrt(disc);
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that the kernel finds the analytic intersections and normals of a sphere,
+// with and without empty space skipping and with ray packets
+//
+
+TEST(Isosurface, Sphere)
+{
+    distance_volume dv(64);
+
+    // World space radius is 0.6
+    float isovalue = 0.7f;
+
+    auto params = make_isosurface_kernel_params(dv.volume, isovalue, aabb(vec3(-1.0f), vec3(1.0f)), 0.05f);
+
+    macrocell_grid grid;
+    grid.build(dv.volume, 8);
+    grid.classify_isosurface(isovalue);
+
+    // Only cells near the surface are visited
+    EXPECT_GT(grid.num_empty_cells(), size_t(0));
+    EXPECT_FALSE(grid.is_empty(1, 4, 4));
+    EXPECT_TRUE(grid.is_empty(4, 4, 4));
+    EXPECT_TRUE(grid.is_empty(0, 0, 0));
+
+    using kernel_type = isosurface::kernel<decltype(params)>;
+
+    kernel_type kernel = { params };
+
+    params.grid = grid.ref();
+    kernel_type skip_kernel = { params };
+
+    random_sampler<float> rs(0U);
+
+    int num_hits = 0;
+
+    for (int r = 0; r < 100; ++r)
+    {
+        array<basic_ray<float>, simd::num_elements<float_type>::value> rays;
+
+        for (auto& ray : rays)
+        {
+            ray = make_ray(rs);
+        }
+
+        auto packet_result = kernel(simd::pack(rays));
+        auto packet_pos = simd::unpack(packet_result.isect_pos);
+
+        simd::aligned_array_t<float_type> packet_hit;
+        store(packet_hit, select(packet_result.hit, float_type(1.0f), float_type(0.0f)));
+
+        for (size_t l = 0; l < rays.size(); ++l)
+        {
+            auto const& ray = rays[l];
+
+            float t = 0.0f;
+            bool hit = intersect_sphere(ray, 0.6f, t);
+
+            auto result = kernel(ray);
+            auto skip_result = skip_kernel(ray);
+
+            // Rays that graze the sphere may miss between two samples
+            vec3 closest = ray.ori - ray.dir * dot(ray.ori, ray.dir);
+
+            if (std::abs(length(closest) - 0.6f) < 0.02f)
+            {
+                continue;
+            }
+
+            ASSERT_EQ(result.hit, hit);
+            ASSERT_EQ(skip_result.hit, hit);
+            ASSERT_EQ(packet_hit[l] != 0.0f, hit);
+
+            if (!hit)
+            {
+                continue;
+            }
+
+            ++num_hits;
+
+            vec3 expected = ray.ori + ray.dir * t;
+
+            // Trilinear interpolation of the field deviates slightly from the sphere
+            EXPECT_LT(length(result.isect_pos - expected), 2E-3f);
+            EXPECT_LT(length(skip_result.isect_pos - expected), 2E-3f);
+            EXPECT_LT(length(packet_pos[l] - result.isect_pos), 1E-4f);
+
+            EXPECT_GT(dot(result.normal, normalize(expected)), 0.999f);
+            EXPECT_GT(dot(skip_result.normal, normalize(expected)), 0.999f);
+        }
+    }
+
+    EXPECT_GT(num_hits, 100);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that secant refinement converges on the surface, independent of the step size
+//
+
+TEST(Isosurface, Refinement)
+{
+    distance_volume dv(64);
+
+    auto params = make_isosurface_kernel_params(dv.volume, 0.7f, aabb(vec3(-1.0f), vec3(1.0f)), 0.2f);
+
+    basic_ray<float> ray(vec3(-3.0f, 0.1f, 0.2f), vec3(1.0f, 0.0f, 0.0f));
+
+    float t = 0.0f;
+    ASSERT_TRUE(intersect_sphere(ray, 0.6f, t));
+
+    float prev_error = 1.0f;
+
+    for (int steps : { 0, 1, 2, 4 })
+    {
+        params.refinement_steps = steps;
+        isosurface::kernel<decltype(params)> kernel = { params };
+
+        auto result = kernel(ray);
+        ASSERT_TRUE(result.hit);
+
+        float error = std::abs(result.isect_pos.x - (ray.ori.x + t));
+        EXPECT_LE(error, prev_error);
+        prev_error = error;
+    }
+
+    EXPECT_LT(prev_error, 1E-3f);
+}
@@ -0,0 +1,125 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/light_tree.h>
+#include <visionaray/point_light.h>
+#include <visionaray/random_sampler.h>
+#include <visionaray/spot_light.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+static std::vector<spot_light<float>> make_lights(size_t num_lights, random_sampler<float>& rs)
+{
+    std::vector<spot_light<float>> lights(num_lights);
+
+    for (auto& l : lights)
+    {
+        l.set_cl(vec3(rs.next(), rs.next(), rs.next()));
+        l.set_kl(1.0f);
+        l.set_position(vec3(rs.next(), rs.next(), rs.next()) * 10.0f);
+        l.set_spot_direction(normalize(vec3(rs.next(), rs.next(), rs.next()) - vec3(0.5f)));
+        l.set_spot_cutoff(0.2f + rs.next());
+        l.set_spot_exponent(1.0f);
+        l.set_quadratic_attenuation(1.0f);
+    }
+
+    return lights;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that sample() and pmf() are consistent and that the pmf is normalized
+//
+
+TEST(LightTree, Sample)
+{
+    random_sampler<float> rs(0U);
+
+    for (size_t num_lights : { 1, 2, 3, 100 })
+    {
+        auto lights = make_lights(num_lights, rs);
+
+        light_tree tree(lights.begin(), lights.end());
+        auto ref = tree.ref();
+
+        EXPECT_EQ(tree.num_lights(), num_lights);
+        EXPECT_EQ(tree.num_nodes(), 2 * num_lights - 1);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            vec3 p = vec3(rs.next(), rs.next(), rs.next()) * 10.0f;
+
+            float sum = 0.0f;
+
+            for (size_t l = 0; l < num_lights; ++l)
+            {
+                sum += ref.pmf(p, static_cast<unsigned>(l));
+            }
+
+            float pmf = 0.0f;
+            int index = ref.sample(p, rs.next(), pmf);
+
+            // Less than 1 if sample() may end in a subtree without lights that illuminate p
+            EXPECT_LE(sum, 1.0f + 1E-4f);
+
+            if (index < 0)
+            {
+                EXPECT_LT(sum, 1.0f);
+                continue;
+            }
+
+            EXPECT_GT(pmf, 0.0f);
+            EXPECT_FLOAT_EQ(pmf, ref.pmf(p, static_cast<unsigned>(index)));
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that cut() only skips lights that cannot contribute if threshold is 0
+//
+
+TEST(LightTree, Cut)
+{
+    random_sampler<float> rs(1U);
+
+    auto lights = make_lights(200, rs);
+
+    light_tree tree(lights.begin(), lights.end());
+
+    for (int i = 0; i < 100; ++i)
+    {
+        vec3 p = vec3(rs.next(), rs.next(), rs.next()) * 10.0f;
+        vec3 n = normalize(vec3(rs.next(), rs.next(), rs.next()) - vec3(0.5f));
+
+        std::vector<bool> visited(lights.size(), false);
+
+        tree.ref().cut(p, n, true, 0.0f, [&](unsigned l, float scale)
+        {
+            EXPECT_FLOAT_EQ(scale, 1.0f);
+            visited[l] = true;
+        });
+
+        for (size_t l = 0; l < lights.size(); ++l)
+        {
+            auto light_dir = normalize(lights[l].position() - p);
+            auto intensity = lights[l].intensity(p);
+
+            if (dot(n, light_dir) > 0.0f && intensity.x + intensity.y + intensity.z > 0.0f)
+            {
+                EXPECT_TRUE(visited[l]);
+            }
+        }
+    }
+}
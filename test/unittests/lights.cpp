@@ -0,0 +1,133 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+
+#include <visionaray/math/math.h>
+#include <visionaray/array.h>
+#include <visionaray/point_light.h>
+#include <visionaray/random_sampler.h>
+#include <visionaray/spot_light.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+template <size_t N>
+static void make_lights(
+        array<point_light<float>, N>&   point_lights,
+        array<spot_light<float>, N>&    spot_lights,
+        random_sampler<float>&          rs
+        )
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        vec3 cl(rs.next(), rs.next(), rs.next());
+        vec3 pos = vec3(rs.next(), rs.next(), rs.next()) * 10.0f;
+
+        point_lights[i].set_cl(cl);
+        point_lights[i].set_kl(1.0f + rs.next());
+        point_lights[i].set_position(pos);
+        point_lights[i].set_linear_attenuation(rs.next());
+        point_lights[i].set_quadratic_attenuation(rs.next());
+
+        spot_lights[i].set_cl(cl);
+        spot_lights[i].set_kl(1.0f + rs.next());
+        spot_lights[i].set_position(pos);
+        spot_lights[i].set_spot_direction(normalize(vec3(rs.next(), rs.next(), rs.next()) - vec3(0.5f)));
+        spot_lights[i].set_spot_cutoff(0.2f + rs.next());
+        spot_lights[i].set_spot_exponent(1.0f + rs.next());
+        spot_lights[i].set_quadratic_attenuation(1.0f);
+    }
+}
+
+template <typename L1, typename L2>
+static void expect_equal_lights(L1 const& a, L2 const& b)
+{
+    EXPECT_FLOAT_EQ(a.cl().x, b.cl().x);
+    EXPECT_FLOAT_EQ(a.cl().y, b.cl().y);
+    EXPECT_FLOAT_EQ(a.cl().z, b.cl().z);
+    EXPECT_FLOAT_EQ(a.kl(), b.kl());
+    EXPECT_FLOAT_EQ(a.position().x, b.position().x);
+    EXPECT_FLOAT_EQ(a.position().y, b.position().y);
+    EXPECT_FLOAT_EQ(a.position().z, b.position().z);
+    EXPECT_FLOAT_EQ(a.constant_attenuation(), b.constant_attenuation());
+    EXPECT_FLOAT_EQ(a.linear_attenuation(), b.linear_attenuation());
+    EXPECT_FLOAT_EQ(a.quadratic_attenuation(), b.quadratic_attenuation());
+}
+
+template <typename T>
+static void test_pack()
+{
+    enum { N = simd::num_elements<T>::value };
+
+    random_sampler<float> rs(0U);
+
+    array<point_light<float>, N> point_lights;
+    array<spot_light<float>, N> spot_lights;
+    make_lights(point_lights, spot_lights, rs);
+
+    auto point_packed = simd::pack(point_lights);
+    auto spot_packed  = simd::pack(spot_lights);
+
+    auto point_unpacked = simd::unpack(point_packed);
+    auto spot_unpacked  = simd::unpack(spot_packed);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        vec3 pos = vec3(rs.next(), rs.next(), rs.next()) * 10.0f;
+
+        auto point_intensity = simd::unpack(point_packed.intensity(vector<3, T>(pos)));
+        auto spot_intensity  = simd::unpack(spot_packed.intensity(vector<3, T>(pos)));
+
+        for (size_t l = 0; l < N; ++l)
+        {
+            auto pi = point_lights[l].intensity(pos);
+            auto si = spot_lights[l].intensity(pos);
+
+            EXPECT_NEAR(pi.x, point_intensity[l].x, 1E-5f * (1.0f + pi.x));
+            EXPECT_NEAR(pi.y, point_intensity[l].y, 1E-5f * (1.0f + pi.y));
+            EXPECT_NEAR(pi.z, point_intensity[l].z, 1E-5f * (1.0f + pi.z));
+
+            EXPECT_NEAR(si.x, spot_intensity[l].x, 1E-5f * (1.0f + si.x));
+            EXPECT_NEAR(si.y, spot_intensity[l].y, 1E-5f * (1.0f + si.y));
+            EXPECT_NEAR(si.z, spot_intensity[l].z, 1E-5f * (1.0f + si.z));
+        }
+    }
+
+    for (size_t l = 0; l < N; ++l)
+    {
+        expect_equal_lights(point_lights[l], point_unpacked[l]);
+        expect_equal_lights(spot_lights[l], spot_unpacked[l]);
+
+        EXPECT_FLOAT_EQ(spot_lights[l].spot_direction().x, spot_unpacked[l].spot_direction().x);
+        EXPECT_FLOAT_EQ(spot_lights[l].spot_direction().y, spot_unpacked[l].spot_direction().y);
+        EXPECT_FLOAT_EQ(spot_lights[l].spot_direction().z, spot_unpacked[l].spot_direction().z);
+        EXPECT_FLOAT_EQ(spot_lights[l].spot_cutoff(), spot_unpacked[l].spot_cutoff());
+        EXPECT_FLOAT_EQ(spot_lights[l].spot_exponent(), spot_unpacked[l].spot_exponent());
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that SIMD lights (structure of arrays) produced by simd::pack() evaluate
+// to the same intensities as the individual lights, and that unpack() restores them
+//
+
+TEST(Lights, SIMDPack)
+{
+    test_pack<simd::float4>();
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    test_pack<simd::float8>();
+#endif
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+    test_pack<simd::float16>();
+#endif
+}
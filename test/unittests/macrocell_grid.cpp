@@ -0,0 +1,268 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/kernels.h>
+#include <visionaray/macrocell_grid.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Sparse test volume: two blobs in an otherwise empty volume
+//
+
+struct test_volume
+{
+    enum { width = 40, height = 33, depth = 27 };
+
+    test_volume()
+        : voxels(width * height * depth)
+        , volume(width, height, depth)
+        , transfunc(4)
+    {
+        for (int z = 0; z < depth; ++z)
+        {
+            for (int y = 0; y < height; ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    vec3 p(x + 0.5f, y + 0.5f, z + 0.5f);
+                    float d1 = length(p - vec3(10.0f, 10.0f, 8.0f));
+                    float d2 = length(p - vec3(30.0f, 22.0f, 19.0f));
+
+                    float value = 0.0f;
+                    value = d1 < 5.0f ? 1.0f - d1 / 5.0f : value;
+                    value = d2 < 4.0f ? 0.5f : value;
+
+                    voxels[(z * height + y) * width + x] = value;
+                }
+            }
+        }
+
+        // Transparent for value 0
+        tfdata[0] = vec4(0.0f, 0.0f, 0.0f, 0.0f);
+        tfdata[1] = vec4(0.7f, 0.1f, 0.2f, 0.1f);
+        tfdata[2] = vec4(0.1f, 0.9f, 0.3f, 0.2f);
+        tfdata[3] = vec4(1.0f, 1.0f, 1.0f, 0.3f);
+
+        volume.reset(voxels.data());
+        volume.set_filter_mode(Linear);
+        volume.set_address_mode(Clamp);
+
+        transfunc.reset(tfdata);
+        transfunc.set_filter_mode(Linear);
+        transfunc.set_address_mode(Clamp);
+    }
+
+    std::vector<float>      voxels;
+    vec4                    tfdata[4];
+    texture_ref<float, 3>   volume;
+    texture_ref<vec4, 1>    transfunc;
+};
+
+template <typename R, typename KParams>
+static std::vector<vec4> render(KParams const& kparams, int w, int h)
+{
+    pinhole_camera cam;
+    cam.perspective(0.8f, 1.0f, 0.01f, 100.0f);
+    cam.look_at(vec3(1.5f, 2.0f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    cam.set_viewport(0, 0, w, h);
+
+    simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED> rt;
+    rt.resize(w, h);
+
+    tiled_sched<R> sched(2);
+    sched.frame(dvr::kernel<KParams>({kparams}), make_sched_params(cam, rt));
+
+    return std::vector<vec4>(rt.color(), rt.color() + w * h);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that cells are classified conservatively
+//
+
+TEST(MacrocellGrid, Classify)
+{
+    test_volume tv;
+
+    macrocell_grid grid;
+    grid.build(tv.volume, 8);
+    grid.classify(tv.transfunc);
+
+    ASSERT_EQ(grid.dims(), vec3i(5, 5, 4));
+    EXPECT_GT(grid.num_empty_cells(), size_t(60));
+
+    for (int z = 0; z < test_volume::depth; ++z)
+    {
+        for (int y = 0; y < test_volume::height; ++y)
+        {
+            for (int x = 0; x < test_volume::width; ++x)
+            {
+                if (tv.voxels[(z * test_volume::height + y) * test_volume::width + x] > 0.0f)
+                {
+                    // Cells around non-zero voxels are not empty
+                    for (int dz = -1; dz <= 1; ++dz)
+                    {
+                        for (int dy = -1; dy <= 1; ++dy)
+                        {
+                            for (int dx = -1; dx <= 1; ++dx)
+                            {
+                                int cx = std::min(std::max(x + dx, 0), test_volume::width - 1) / 8;
+                                int cy = std::min(std::max(y + dy, 0), test_volume::height - 1) / 8;
+                                int cz = std::min(std::max(z + dz, 0), test_volume::depth - 1) / 8;
+                                EXPECT_FALSE(grid.is_empty(cx, cy, cz));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Nothing is empty if the transfer function is opaque everywhere
+    tv.tfdata[0].w = 0.01f;
+    grid.classify(tv.transfunc);
+    EXPECT_EQ(grid.num_empty_cells(), size_t(0));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that the DDA finds the same intervals as a brute force search
+//
+
+TEST(MacrocellGrid, NextInterval)
+{
+    test_volume tv;
+
+    macrocell_grid grid;
+    grid.build(tv.volume, 8);
+    grid.classify(tv.transfunc);
+
+    auto ref = grid.ref();
+
+    // Grid cells in texture coordinates
+    vec3 cell_extent(
+            8.0f / test_volume::width,
+            8.0f / test_volume::height,
+            8.0f / test_volume::depth
+            );
+
+    auto empty_at = [&](vec3 const& p)
+    {
+        vec3i c(p / cell_extent);
+        c = vec3i(
+                std::min(std::max(c.x, 0), grid.dims().x - 1),
+                std::min(std::max(c.y, 0), grid.dims().y - 1),
+                std::min(std::max(c.z, 0), grid.dims().z - 1)
+                );
+        return grid.is_empty(c.x, c.y, c.z);
+    };
+
+    basic_ray<float> rays[] = {
+        basic_ray<float>(vec3(-0.5f, 0.3f, 0.25f), normalize(vec3(1.0f, 0.0f, 0.0f))),
+        basic_ray<float>(vec3(1.3f, 0.9f, -0.2f), normalize(vec3(-0.6f, -0.4f, 0.7f))),
+        basic_ray<float>(vec3(0.8f, 0.7f, 0.75f), normalize(vec3(0.0f, 0.0f, -1.0f))),
+        basic_ray<float>(vec3(0.2f, -0.3f, 0.3f), normalize(vec3(0.05f, 1.0f, 0.01f)))
+    };
+
+    for (auto const& r : rays)
+    {
+        auto hr = intersect(r, aabb(vec3(0.0f), vec3(1.0f)));
+        ASSERT_TRUE(hr.hit);
+
+        float t = std::max(hr.tnear, 0.0f);
+
+        while (t < hr.tfar)
+        {
+            float t0 = 0.0f;
+            float t1 = 0.0f;
+            ref.next_interval(r, t, hr.tfar, t0, t1);
+
+            ASSERT_GE(t0, t);
+            ASSERT_LE(t0, t1);
+            ASSERT_LE(t1, hr.tfar);
+
+            // Positions before the interval are empty, positions inside are not
+            for (float s = t + 1E-3f; s < t0 - 1E-3f; s += 1E-3f)
+            {
+                EXPECT_TRUE(empty_at(r.ori + r.dir * s));
+            }
+
+            for (float s = t0 + 1E-3f; s < t1 - 1E-3f; s += 1E-3f)
+            {
+                EXPECT_FALSE(empty_at(r.ori + r.dir * s));
+            }
+
+            if (t1 <= t)
+            {
+                break;
+            }
+
+            t = t1;
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that empty space skipping does not change the image
+//
+
+TEST(MacrocellGrid, DVR)
+{
+    test_volume tv;
+
+    macrocell_grid grid;
+    grid.build(tv.volume, 8);
+    grid.classify(tv.transfunc);
+
+    auto kparams = make_volume_kernel_params(
+            tv.volume,
+            tv.transfunc,
+            aabb(vec3(-1.0f), vec3(1.0f)),
+            0.01f
+            );
+
+    int w = 67;
+    int h = 45;
+
+    auto ref = render<basic_ray<float>>(kparams, w, h);
+
+    float sum = 0.0f;
+
+    for (auto const& c : ref)
+    {
+        sum += c.w;
+    }
+
+    EXPECT_GT(sum, 10.0f);
+
+    kparams.grid = grid.ref();
+
+    auto skip1 = render<basic_ray<float>>(kparams, w, h);
+    auto skip4 = render<basic_ray<simd::float4>>(kparams, w, h);
+
+    for (size_t i = 0; i < ref.size(); ++i)
+    {
+        EXPECT_NEAR(skip1[i].x, ref[i].x, 1E-5f);
+        EXPECT_NEAR(skip1[i].y, ref[i].y, 1E-5f);
+        EXPECT_NEAR(skip1[i].z, ref[i].z, 1E-5f);
+        EXPECT_NEAR(skip1[i].w, ref[i].w, 1E-5f);
+
+        EXPECT_NEAR(skip4[i].x, ref[i].x, 1E-5f);
+        EXPECT_NEAR(skip4[i].y, ref[i].y, 1E-5f);
+        EXPECT_NEAR(skip4[i].z, ref[i].z, 1E-5f);
+        EXPECT_NEAR(skip4[i].w, ref[i].w, 1E-5f);
+    }
+}
@@ -0,0 +1,202 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/random_sampler.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+using float_type = simd::float8;
+#else
+using float_type = simd::float4;
+#endif
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+// Raw file with a header of header_size bytes, followed by the texels. Removed afterwards
+struct raw_test_file
+{
+    template <typename T>
+    raw_test_file(std::vector<T> const& texels, size_t header_size)
+        : filename("mapped_texture_test.raw")
+    {
+        std::ofstream file(filename, std::ios::binary);
+
+        std::vector<char> header(header_size, 'h');
+        file.write(header.data(), header.size());
+        file.write(reinterpret_cast<char const*>(texels.data()), texels.size() * sizeof(T));
+    }
+
+   ~raw_test_file()
+    {
+        std::remove(filename.c_str());
+    }
+
+    std::string filename;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that a mapped 3D texture addresses and samples the same texels as a texture with a
+// copy of the data, for single coordinates and SIMD vectors
+//
+
+TEST(MappedTexture, Texture3D)
+{
+    int w = 13;
+    int h = 9;
+    int d = 7;
+
+    random_sampler<float> rs(0U);
+
+    std::vector<float> texels(w * h * d);
+
+    for (auto& t : texels)
+    {
+        t = rs.next();
+    }
+
+    raw_test_file file(texels, 64);
+
+    texture<float, 3> tex(w, h, d);
+    tex.reset(texels.data());
+
+    mapped_texture<float, 3> mapped(w, h, d);
+    mapped.map(file.filename, 64);
+
+    // Copies and references share the mapping
+    mapped_texture<float, 3> copy(mapped);
+    texture_ref<float, 3> ref(copy);
+
+    mapped = mapped_texture<float, 3>();
+
+    EXPECT_EQ(ref.size(), tex.size());
+
+    // Texel access is read-only
+    auto const& t = tex;
+    auto const& c = copy;
+
+    for (int z = 0; z < d; ++z)
+    {
+        for (int y = 0; y < h; ++y)
+        {
+            for (int x = 0; x < w; ++x)
+            {
+                ASSERT_EQ(c(x, y, z), t(x, y, z));
+            }
+        }
+    }
+
+    for (auto filter_mode : { Nearest, Linear, CardinalSpline })
+    {
+        tex.set_filter_mode(filter_mode);
+        tex.set_address_mode(Clamp);
+        ref.set_filter_mode(filter_mode);
+        ref.set_address_mode(Clamp);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            simd::aligned_array_t<float_type> xs;
+            simd::aligned_array_t<float_type> ys;
+            simd::aligned_array_t<float_type> zs;
+
+            for (size_t l = 0; l < simd::num_elements<float_type>::value; ++l)
+            {
+                xs[l] = rs.next();
+                ys[l] = rs.next();
+                zs[l] = rs.next();
+
+                vec3 coord(xs[l], ys[l], zs[l]);
+
+                ASSERT_EQ(tex3D(ref, coord), tex3D(tex, coord));
+            }
+
+            vector<3, float_type> coord = { float_type(xs), float_type(ys), float_type(zs) };
+
+            ASSERT_TRUE( all(tex3D(ref, coord) == tex3D(tex, coord)) );
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test a mapped 2D texture with RGBA8 texels, as used for uncompressed images
+//
+
+TEST(MappedTexture, Texture2D)
+{
+    using texel_type = vector<4, unorm<8>>;
+
+    int w = 5;
+    int h = 3;
+
+    std::vector<texel_type> texels(w * h);
+
+    for (size_t i = 0; i < texels.size(); ++i)
+    {
+        texels[i] = texel_type(vec4(i / 15.0f, 0.5f, 1.0f - i / 15.0f, 1.0f));
+    }
+
+    raw_test_file file(texels, 0);
+
+    mapped_texture<texel_type, 2> mapped(w, h);
+    mapped.map(file.filename);
+    mapped.set_filter_mode(Nearest);
+    mapped.set_address_mode(Clamp);
+
+    texture<texel_type, 2> tex(w, h);
+    tex.reset(texels.data());
+    tex.set_filter_mode(Nearest);
+    tex.set_address_mode(Clamp);
+
+    for (int y = 0; y < h; ++y)
+    {
+        for (int x = 0; x < w; ++x)
+        {
+            vec2 coord((x + 0.5f) / w, (y + 0.5f) / h);
+
+            EXPECT_EQ(tex2D(mapped, coord), tex2D(tex, coord));
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test error handling
+//
+
+TEST(MappedTexture, Errors)
+{
+    mapped_texture<float, 3> mapped(4, 4, 4);
+
+    EXPECT_THROW(mapped.map("does_not_exist.raw"), std::runtime_error);
+
+    raw_test_file file(std::vector<float>(4 * 4 * 4), 8);
+
+    // Too small
+    EXPECT_THROW(mapped.map(file.filename, 12), std::runtime_error);
+    EXPECT_THROW(mapped.map(file.filename, 1 << 20), std::runtime_error);
+
+    // Not aligned
+    EXPECT_THROW(mapped.map(file.filename, 2), std::runtime_error);
+
+    EXPECT_NO_THROW(mapped.map(file.filename, 8));
+
+    auto const& m = mapped;
+    EXPECT_EQ(m(3, 3, 3), 0.0f);
+}
@@ -0,0 +1,311 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/paged_volume.h>
+#include <visionaray/random_sampler.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+using float_type = simd::float8;
+#else
+using float_type = simd::float4;
+#endif
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+// Size is not a multiple of the page size, so that pages at the borders are padded
+static const int W = 21;
+static const int H = 10;
+static const int D = 17;
+
+static const int page_bits = 3;
+static const size_t page_bytes = 8 * 8 * 8 * sizeof(float);
+
+// Synthetic volume that is written to a paged volume file and removed afterwards
+struct paged_test_file
+{
+    template <typename Func>
+    explicit paged_test_file(Func func)
+        : filename("paged_volume_test.vpv")
+        , voxels(W * H * D)
+    {
+        for (size_t i = 0; i < voxels.size(); ++i)
+        {
+            voxels[i] = func(i);
+        }
+
+        paged_volume_writer<float> writer(filename, vec3i(W, H, D), page_bits);
+
+        for (int z = 0; z < D; ++z)
+        {
+            writer.add_slice(voxels.data() + z * W * H);
+        }
+
+        writer.close();
+    }
+
+   ~paged_test_file()
+    {
+        std::remove(filename.c_str());
+    }
+
+    std::string         filename;
+    std::vector<float>  voxels;
+};
+
+// Access all voxels once
+template <typename Ref>
+static void touch_all(Ref const& ref)
+{
+    for (int z = 0; z < D; ++z)
+    {
+        for (int y = 0; y < H; ++y)
+        {
+            for (int x = 0; x < W; ++x)
+            {
+                tex3D(ref, (vec3(x, y, z) + vec3(0.5f)) / vec3(W, H, D));
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that a resident paged volume samples the same as a texture (up to round-off), for
+// all filter and address modes and for single coordinates and SIMD vectors
+//
+
+TEST(PagedVolume, Sampling)
+{
+    random_sampler<float> rs(0U);
+    paged_test_file file([&](size_t) { return rs.next(); });
+
+    paged_volume<float> volume(file.filename, 1 << 20);
+
+    EXPECT_EQ(volume.size(), vec3i(W, H, D));
+    EXPECT_EQ(volume.num_pages(), vec3i(3, 2, 3));
+    EXPECT_EQ(volume.resident_pages(), size_t(0));
+
+    auto ref = volume.ref();
+
+    touch_all(ref);
+
+    EXPECT_EQ(volume.update(), size_t(18));
+    EXPECT_EQ(volume.resident_pages(), size_t(18));
+
+    texture_ref<float, 3> tex(W, H, D);
+    tex.reset(file.voxels.data());
+
+    for (auto filter_mode : { Nearest, Linear, BSpline, CardinalSpline })
+    {
+        for (auto address_mode : { Clamp, Wrap, Mirror })
+        {
+            tex.set_filter_mode(filter_mode);
+            tex.set_address_mode(address_mode);
+            ref.set_filter_mode(filter_mode);
+            ref.set_address_mode(address_mode);
+
+            for (int i = 0; i < 100; ++i)
+            {
+                simd::aligned_array_t<float_type> xs;
+                simd::aligned_array_t<float_type> ys;
+                simd::aligned_array_t<float_type> zs;
+
+                for (size_t l = 0; l < simd::num_elements<float_type>::value; ++l)
+                {
+                    xs[l] = rs.next() * 1.4f - 0.2f;
+                    ys[l] = rs.next() * 1.4f - 0.2f;
+                    zs[l] = rs.next() * 1.4f - 0.2f;
+
+                    vec3 coord(xs[l], ys[l], zs[l]);
+
+                    ASSERT_NEAR(tex3D(ref, coord), tex3D(tex, coord), 1e-5f);
+                }
+
+                vector<3, float_type> coord = { float_type(xs), float_type(ys), float_type(zs) };
+
+                simd::aligned_array_t<float_type> paged;
+                simd::aligned_array_t<float_type> expected;
+
+                store(paged, tex3D(ref, coord));
+                store(expected, tex3D(tex, coord));
+
+                for (size_t l = 0; l < simd::num_elements<float_type>::value; ++l)
+                {
+                    ASSERT_NEAR(paged[l], expected[l], 1e-5f);
+                }
+            }
+        }
+    }
+
+    // Nothing left to load
+    EXPECT_EQ(volume.update(), size_t(0));
+    EXPECT_EQ(volume.pages_loaded(), size_t(18));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that voxels of pages that are not resident are taken from the coarse level
+//
+
+TEST(PagedVolume, CoarseFallback)
+{
+    // Constant per z-row of pages: 0 in the first, 1 in the second, 2 in the third
+    paged_test_file file([](size_t i) { return static_cast<float>(i / (W * H * 8)); });
+
+    paged_volume<float> volume(file.filename, 0);
+
+    EXPECT_EQ(volume.max_resident_pages(), size_t(0));
+
+    auto ref = volume.ref();
+    ref.set_filter_mode(Nearest);
+
+    // The coarse level is interpolated between the page averages at the page centers (z = 4, 12, 20)
+    EXPECT_FLOAT_EQ(tex3D(ref, vec3(0.5f, 0.5f, 1.5f / D)), 0.0f);
+    EXPECT_FLOAT_EQ(tex3D(ref, vec3(0.5f, 0.5f, 7.5f / D)), 0.4375f);
+    EXPECT_FLOAT_EQ(tex3D(ref, vec3(0.5f, 0.5f, 15.5f / D)), 1.4375f);
+    EXPECT_FLOAT_EQ(tex3D(ref, vec3(0.5f, 0.5f, 16.5f / D)), 1.5625f);
+
+    // No budget, the pages are requested but never loaded
+    EXPECT_EQ(volume.update(), size_t(0));
+    EXPECT_EQ(volume.resident_pages(), size_t(0));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that the least recently used pages are evicted when the budget is exhausted
+//
+
+TEST(PagedVolume, LRU)
+{
+    paged_test_file file([](size_t i) { return static_cast<float>(i); });
+
+    paged_volume<float> volume(file.filename, 4 * page_bytes);
+
+    EXPECT_EQ(volume.max_resident_pages(), size_t(4));
+
+    auto ref = volume.ref();
+    ref.set_filter_mode(Nearest);
+
+    // Coordinates inside page (px,py,pz)
+    auto page = [](int px, int py, int pz)
+    {
+        return (vec3(px, py, pz) * 8.0f + vec3(0.5f)) / vec3(W, H, D);
+    };
+
+    // Frame 1: more requests than slots, the pages are loaded in file order
+    tex3D(ref, page(0, 0, 0));
+    tex3D(ref, page(1, 0, 0));
+    tex3D(ref, page(2, 0, 0));
+    tex3D(ref, page(0, 1, 0));
+    tex3D(ref, page(1, 1, 0));
+
+    EXPECT_EQ(volume.update(), size_t(4));
+    EXPECT_TRUE(volume.is_resident(0, 0, 0));
+    EXPECT_TRUE(volume.is_resident(1, 1, 0) == false);
+
+    // Frame 2: page (0,0,0) is used again
+    EXPECT_EQ(tex3D(ref, page(0, 0, 0)), file.voxels[0]);
+
+    // Frame 3: the pages not used in frame 2 are evicted first
+    EXPECT_EQ(volume.update(), size_t(0));
+
+    tex3D(ref, page(1, 1, 0));
+    tex3D(ref, page(2, 1, 0));
+    tex3D(ref, page(0, 0, 1));
+
+    EXPECT_EQ(volume.update(), size_t(3));
+    EXPECT_EQ(volume.resident_pages(), size_t(4));
+    EXPECT_TRUE(volume.is_resident(0, 0, 0));
+    EXPECT_TRUE(volume.is_resident(1, 1, 0));
+    EXPECT_TRUE(volume.is_resident(2, 1, 0));
+    EXPECT_TRUE(volume.is_resident(0, 0, 1));
+
+    // Load limit per update
+    tex3D(ref, page(1, 0, 1));
+    tex3D(ref, page(2, 0, 1));
+
+    EXPECT_EQ(volume.update(1), size_t(1));
+    EXPECT_EQ(volume.pages_loaded(), size_t(8));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that prefetching loads the pages along a ray in texture coordinates
+//
+
+TEST(PagedVolume, Prefetch)
+{
+    paged_test_file file([](size_t i) { return static_cast<float>(i); });
+
+    paged_volume<float> volume(file.filename, 1 << 20);
+
+    // Along x through the pages with py = 1, pz = 1
+    basic_ray<float> ray(vec3(-1.0f, 9.0f / H, 12.0f / D), vec3(1.0f, 0.0f, 0.0f));
+
+    volume.prefetch(ray);
+
+    EXPECT_EQ(volume.update(), size_t(3));
+
+    for (int pz = 0; pz < 3; ++pz)
+    {
+        for (int py = 0; py < 2; ++py)
+        {
+            for (int px = 0; px < 3; ++px)
+            {
+                EXPECT_EQ(volume.is_resident(px, py, pz), py == 1 && pz == 1);
+            }
+        }
+    }
+
+    // Resident voxels along the ray are exact
+    auto ref = volume.ref();
+    ref.set_filter_mode(Nearest);
+
+    EXPECT_EQ(tex3D(ref, vec3(15.5f / W, 9.5f / H, 12.5f / D)), file.voxels[(12 * H + 9) * W + 15]);
+
+    // Diagonal ray that ends inside the volume
+    basic_ray<float> diag(vec3(0.0f), normalize(vec3(1.0f)));
+
+    volume.prefetch(diag, 0.1f);
+
+    EXPECT_EQ(volume.update(), size_t(1));
+    EXPECT_TRUE(volume.is_resident(0, 0, 0));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test error handling
+//
+
+TEST(PagedVolume, Errors)
+{
+    EXPECT_THROW(paged_volume<float>("does_not_exist.vpv", 1 << 20), std::runtime_error);
+
+    paged_test_file file([](size_t i) { return static_cast<float>(i); });
+
+    // Wrong voxel type
+    EXPECT_THROW(paged_volume<unorm<8>>(file.filename, 1 << 20), std::runtime_error);
+
+    // Missing slices
+    paged_volume_writer<float> writer("paged_volume_incomplete.vpv", vec3i(W, H, D), page_bits);
+    writer.add_slice(file.voxels.data());
+
+    EXPECT_THROW(writer.close(), std::runtime_error);
+
+    std::remove("paged_volume_incomplete.vpv");
+}
@@ -0,0 +1,228 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/kernels.h>
+#include <visionaray/macrocell_grid.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/preintegration_table.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Smooth test volume (a blob) and a transfer function with thin, opaque features
+// that post-classification misses with large steps
+//
+
+struct smooth_volume
+{
+    enum { width = 32, height = 32, depth = 32, tf_size = 256 };
+
+    smooth_volume()
+        : voxels(width * height * depth)
+        , tfdata(tf_size, vec4(0.0f))
+        , volume(width, height, depth)
+        , transfunc(tf_size)
+    {
+        for (int z = 0; z < depth; ++z)
+        {
+            for (int y = 0; y < height; ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    vec3 p(x + 0.5f, y + 0.5f, z + 0.5f);
+                    float d = length(p - vec3(14.0f, 16.0f, 15.0f)) / 14.0f;
+                    float value = d < 1.0f ? 1.0f - d : 0.0f;
+
+                    voxels[(z * height + y) * width + x] = value;
+                }
+            }
+        }
+
+        // Thin shells around 0.5 and 0.78
+        tfdata[128] = vec4(1.0f, 0.5f, 0.2f, 0.8f);
+        tfdata[200] = vec4(0.2f, 0.4f, 1.0f, 0.8f);
+
+        volume.reset(voxels.data());
+        volume.set_filter_mode(Linear);
+        volume.set_address_mode(Clamp);
+
+        transfunc.reset(tfdata.data());
+        transfunc.set_filter_mode(Linear);
+        transfunc.set_address_mode(Clamp);
+    }
+
+    std::vector<float>      voxels;
+    std::vector<vec4>       tfdata;
+    texture_ref<float, 3>   volume;
+    texture_ref<vec4, 1>    transfunc;
+};
+
+template <typename R, typename KParams>
+static std::vector<vec4> render(KParams const& kparams, int w, int h)
+{
+    pinhole_camera cam;
+    cam.perspective(0.8f, 1.0f, 0.01f, 100.0f);
+    cam.look_at(vec3(1.5f, 2.0f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    cam.set_viewport(0, 0, w, h);
+
+    simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED> rt;
+    rt.resize(w, h);
+
+    tiled_sched<R> sched(2);
+    sched.frame(dvr::kernel<KParams>({kparams}), make_sched_params(cam, rt));
+
+    return std::vector<vec4>(rt.color(), rt.color() + w * h);
+}
+
+static float rms_error(std::vector<vec4> const& a, std::vector<vec4> const& b)
+{
+    double sum = 0.0;
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        vec4 d = a[i] - b[i];
+        sum += dot(d, d);
+    }
+
+    return static_cast<float>(std::sqrt(sum / a.size()));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test the table entries
+//
+
+TEST(PreintegrationTable, Build)
+{
+    smooth_volume tv;
+
+    float delta_ref = 0.01f;
+
+    preintegration_table table(2);
+    table.build(tv.transfunc, 4.0f * delta_ref, delta_ref, 128);
+
+    ASSERT_EQ(table.size(), 128);
+
+    for (int i = 0; i < table.size(); ++i)
+    {
+        // Constant segments: post-classification with opacity correction
+        float s = (i + 0.5f) / table.size();
+        vec4 c = tex1D(tv.transfunc, s);
+        float alpha = 1.0f - std::pow(1.0f - c.w, 4.0f);
+
+        EXPECT_NEAR(table(i, i).x, c.x * alpha, 1E-5f);
+        EXPECT_NEAR(table(i, i).y, c.y * alpha, 1E-5f);
+        EXPECT_NEAR(table(i, i).z, c.z * alpha, 1E-5f);
+        EXPECT_NEAR(table(i, i).w, alpha, 1E-5f);
+
+        for (int j = 0; j < table.size(); ++j)
+        {
+            EXPECT_GE(table(i, j).w, 0.0f);
+            EXPECT_LE(table(i, j).w, 1.0f);
+        }
+    }
+
+    // Segments that cross the thin shell are not transparent,
+    // although the transfer function is 0 at both ends
+    EXPECT_GT(table(20, 90).w, 0.02f);
+    EXPECT_GT(table(90, 20).w, 0.02f);
+    EXPECT_EQ(table(10, 20).w, 0.0f);
+
+    // The back shell is occluded by the front shell
+    EXPECT_NEAR(table(20, 127).w, table(127, 20).w, 1E-5f);
+    EXPECT_GT(table(20, 127).x, table(127, 20).x);
+    EXPECT_LT(table(20, 127).z, table(127, 20).z);
+
+    // Same result with a single thread
+    preintegration_table table1(1);
+    table1.build(tv.transfunc, 4.0f * delta_ref, delta_ref, 128);
+
+    for (int j = 0; j < table.size(); ++j)
+    {
+        for (int i = 0; i < table.size(); ++i)
+        {
+            EXPECT_EQ(table1(i, j), table(i, j));
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that pre-integration with 4x larger steps is closer to the reference than
+// post-classification, with and without empty space skipping
+//
+
+TEST(PreintegrationTable, DVR)
+{
+    smooth_volume tv;
+
+    float delta_ref = 0.02f;
+
+    auto kparams = make_volume_kernel_params(
+            tv.volume,
+            tv.transfunc,
+            aabb(vec3(-1.0f), vec3(1.0f)),
+            delta_ref
+            );
+
+    int w = 64;
+    int h = 64;
+
+    auto post = render<basic_ray<float>>(kparams, w, h);
+
+    // Reference: pre-integration with small steps
+    preintegration_table table(2);
+    table.build(tv.transfunc, delta_ref / 8.0f, delta_ref);
+
+    kparams.delta = delta_ref / 8.0f;
+    kparams.preintegrated = true;
+    kparams.preintegration_table = table.ref();
+
+    auto ref = render<basic_ray<float>>(kparams, w, h);
+
+    float sum = 0.0f;
+
+    for (auto const& c : ref)
+    {
+        sum += c.w;
+    }
+
+    EXPECT_GT(sum, 100.0f);
+
+    table.build(tv.transfunc, delta_ref * 4.0f, delta_ref);
+    kparams.delta = delta_ref * 4.0f;
+
+    auto pre1 = render<basic_ray<float>>(kparams, w, h);
+    auto pre4 = render<basic_ray<simd::float4>>(kparams, w, h);
+
+    float post_error = rms_error(post, ref);
+    float pre_error  = rms_error(pre1, ref);
+
+    EXPECT_LT(pre_error, post_error * 0.6f);
+    EXPECT_LT(rms_error(pre4, pre1), 1E-5f);
+
+    // Skipping
+    macrocell_grid grid;
+    grid.build(tv.volume, 4);
+    grid.classify(tv.transfunc);
+    ASSERT_GT(grid.num_empty_cells(), size_t(0));
+
+    kparams.grid = grid.ref();
+
+    auto skip1 = render<basic_ray<float>>(kparams, w, h);
+    auto skip4 = render<basic_ray<simd::float4>>(kparams, w, h);
+
+    EXPECT_LT(rms_error(skip1, pre1), 1E-3f);
+    EXPECT_LT(rms_error(skip4, pre1), 1E-3f);
+}
@@ -2,6 +2,7 @@
 // See the LICENSE file for details
 
 #include <visionaray/math/math.h>
+#include <visionaray/aov_buffer_rt.h>
 #include <visionaray/result_record.h>
 #include <visionaray/simple_buffer_rt.h>
 #include <visionaray/scheduler.h>
@@ -110,3 +111,70 @@ TEST(RenderTarget, PixelFormats)
     EXPECT_FLOAT_EQ(rt_RGBA32F.color()[0].y, 0.4f);
     EXPECT_FLOAT_EQ(rt_RGBA32F.color()[0].z, 0.4f);
 }
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that AOVs are stored in the same pass as color, with format conversion
+//
+
+template <typename R>
+void test_aovs(R /* */)
+{
+    using S = typename R::scalar_type;
+    using I = typename result_record<S>::int_type;
+    using V = typename result_record<S>::vec_type;
+
+    // Not a multiple of the packet size
+    int width  = 5;
+    int height = 3;
+
+    aov_buffer_rt<PF_RGBA32F, PF_DEPTH32F, PF_RGB8, PF_RGB32F, PF_R32UI, PF_RG32F> rt;
+    rt.resize(width, height);
+    rt.set_prev_camera(mat4::identity(), mat4::identity());
+
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    auto sparams = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt);
+
+    simple_sched<R> sched;
+
+    sched.frame([&](R) -> result_record<S>
+    {
+        result_record<S> result;
+        result.hit       = true;
+        result.color     = typename result_record<S>::color_type(0.4f);
+        result.isect_pos = V(0.0f, 0.0f, 0.5f);
+        result.normal    = V(1.0f, 0.0f, 0.0f);
+        result.albedo    = V(0.25f, 0.5f, 0.75f);
+        result.prim_id   = I(7);
+        result.geom_id   = I(3);
+        return result;
+    }, sparams);
+
+    for (int i = 0; i < width * height; ++i)
+    {
+        EXPECT_FLOAT_EQ(rt.color()[i].x, 0.4f);
+        EXPECT_FLOAT_EQ(rt.depth()[i], 0.75f);
+
+        EXPECT_FLOAT_EQ(static_cast<float>(rt.normal()[i].x), 1.0f);
+        EXPECT_FLOAT_EQ(static_cast<float>(rt.normal()[i].y), 0.0f);
+
+        EXPECT_FLOAT_EQ(rt.albedo()[i].x, 0.25f);
+        EXPECT_FLOAT_EQ(rt.albedo()[i].y, 0.5f);
+        EXPECT_FLOAT_EQ(rt.albedo()[i].z, 0.75f);
+
+        EXPECT_EQ(rt.prim_id()[i], 7U);
+        EXPECT_EQ(rt.geom_id()[i], 3U);
+
+        // Same camera as in the previous frame
+        EXPECT_FLOAT_EQ(rt.motion()[i].x, 0.0f);
+        EXPECT_FLOAT_EQ(rt.motion()[i].y, 0.0f);
+    }
+}
+
+TEST(RenderTarget, AOVs)
+{
+    test_aovs(basic_ray<float>{});
+    test_aovs(basic_ray<simd::float4>{});
+}
@@ -0,0 +1,452 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/simple_buffer_rt.h>
+#include <visionaray/scheduler.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+using rt_type = simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+
+// Render target that checks that begin_frame() and end_frame() alternate
+struct frame_counting_rt : rt_type
+{
+    void begin_frame()
+    {
+        EXPECT_FALSE(in_frame);
+        in_frame = true;
+        ++num_begin_frame;
+    }
+
+    void end_frame()
+    {
+        EXPECT_TRUE(in_frame);
+        in_frame = false;
+        ++num_end_frame;
+    }
+
+    bool in_frame = false;
+    int  num_begin_frame = 0;
+    int  num_end_frame = 0;
+};
+
+static bool all_pixels_equal(rt_type const& rt, vec4 const& value)
+{
+    for (int i = 0; i < rt.width() * rt.height(); ++i)
+    {
+        if (rt.color()[i] != value)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test tiled_sched::frame()
+//
+
+TEST(TiledSched, Frame)
+{
+    // dummies
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    rt_type rt;
+    rt.resize(100, 67); // not a multiple of the tile size
+
+    tiled_sched<basic_ray<float>> sched(4);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        rt.clear_color_buffer();
+
+        auto sparams = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt);
+
+        sched.frame([](basic_ray<float>) -> vec4 { return vec4(1.0f); }, sparams);
+
+        EXPECT_TRUE(all_pixels_equal(rt, vec4(1.0f)));
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test tiled_sched::frame_async() and tiled_sched::cancel()
+//
+
+TEST(TiledSched, FrameAsync)
+{
+    // dummies
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    rt_type rt;
+    rt.resize(256, 256);
+
+    tiled_sched<basic_ray<float>> sched(4);
+
+
+    // Async frames that are not cancelled are complete
+
+    for (int i = 0; i < 20; ++i)
+    {
+        rt.clear_color_buffer();
+
+        auto sparams = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt);
+
+        auto f = sched.frame_async([](basic_ray<float>) -> vec4 { return vec4(1.0f); }, sparams);
+        f.wait();
+
+        EXPECT_TRUE(all_pixels_equal(rt, vec4(1.0f)));
+    }
+
+
+    // Cancelled frames complete and don't render all pixels
+
+    std::atomic<int> num_calls(0);
+    std::promise<void> go;
+    auto go_future = go.get_future().share();
+
+    rt.clear_color_buffer();
+
+    auto sparams = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt);
+
+    auto f = sched.frame_async([&](basic_ray<float>) -> vec4
+    {
+        // Stall the workers until the frame was cancelled
+        go_future.wait();
+        ++num_calls;
+        return vec4(1.0f);
+    }, sparams);
+
+    sched.cancel();
+    go.set_value();
+    f.wait();
+
+    EXPECT_LT(num_calls, rt.width() * rt.height());
+    EXPECT_FALSE(all_pixels_equal(rt, vec4(1.0f)));
+
+
+    // Scheduler is usable after cancel
+
+    sched.frame([](basic_ray<float>) -> vec4 { return vec4(0.5f); }, sparams);
+    EXPECT_TRUE(all_pixels_equal(rt, vec4(0.5f)));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test tiled_sched::cancel() right after and concurrently with tiled_sched::frame_async()
+//
+
+TEST(TiledSched, CancelAfterFrameAsync)
+{
+    // dummies
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    rt_type rt;
+    rt.resize(128, 128);
+
+    tiled_sched<basic_ray<float>> sched(4);
+
+    auto sparams = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt);
+
+
+    // Frames complete, cancelled frames don't render more pixels than there are
+
+    for (int i = 0; i < 100; ++i)
+    {
+        std::atomic<int> num_calls(0);
+
+        auto f = sched.frame_async([&](basic_ray<float>) -> vec4
+        {
+            ++num_calls;
+            return vec4(1.0f);
+        }, sparams);
+
+        sched.cancel();
+        f.wait();
+
+        EXPECT_LE(num_calls, rt.width() * rt.height());
+    }
+
+
+    // Cancel from another thread while frames are submitted
+
+    std::atomic<bool> stop(false);
+
+    std::thread canceller([&]()
+    {
+        while (!stop)
+        {
+            sched.cancel();
+        }
+    });
+
+    for (int i = 0; i < 100; ++i)
+    {
+        sched.frame_async([](basic_ray<float>) -> vec4 { return vec4(1.0f); }, sparams).wait();
+    }
+
+    stop = true;
+    canceller.join();
+
+
+    // Jobs that are cancelled before they are submitted complete right away
+
+    thread_pool pool(2);
+
+    auto j = std::make_shared<thread_pool::job>(100);
+
+    std::atomic<int> num_items(0);
+    j->process_item = [&](long) { ++num_items; };
+
+    auto done = j->done.get_future();
+
+    pool.cancel(j);
+    pool.submit(j);
+    done.wait();
+
+    EXPECT_EQ(num_items, 0);
+
+
+    // Scheduler is usable after cancel
+
+    rt.clear_color_buffer();
+    sched.frame([](basic_ray<float>) -> vec4 { return vec4(0.5f); }, sparams);
+    EXPECT_TRUE(all_pixels_equal(rt, vec4(0.5f)));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that end_frame() of async frames whose futures were dropped is called before the
+// next frame begins
+//
+
+TEST(TiledSched, DroppedFrameAsync)
+{
+    // dummies
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    frame_counting_rt rt;
+    rt.resize(64, 64);
+
+    tiled_sched<basic_ray<float>> sched(4);
+
+    auto sparams = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt);
+
+    for (int i = 0; i < 20; ++i)
+    {
+        // Dropped, cancelled and waited on
+        sched.frame_async([](basic_ray<float>) -> vec4 { return vec4(1.0f); }, sparams);
+
+        sched.frame_async([](basic_ray<float>) -> vec4 { return vec4(1.0f); }, sparams);
+        sched.cancel();
+
+        auto f = sched.frame_async([](basic_ray<float>) -> vec4 { return vec4(1.0f); }, sparams);
+        f.wait();
+
+        EXPECT_FALSE(rt.in_frame);
+        EXPECT_EQ(rt.num_begin_frame, rt.num_end_frame);
+    }
+
+    // end_frame() is called once, also when the future is waited on after the next frame began
+    auto f = sched.frame_async([](basic_ray<float>) -> vec4 { return vec4(1.0f); }, sparams);
+    sched.frame([](basic_ray<float>) -> vec4 { return vec4(0.5f); }, sparams);
+    f.wait();
+
+    EXPECT_FALSE(rt.in_frame);
+    EXPECT_EQ(rt.num_begin_frame, 62);
+    EXPECT_EQ(rt.num_end_frame, 62);
+    EXPECT_TRUE(all_pixels_equal(rt, vec4(0.5f)));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test multiple schedulers sharing a thread pool
+//
+
+TEST(TiledSched, SharedPool)
+{
+    // dummies
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    auto pool = std::make_shared<thread_pool>(4);
+
+    rt_type rt1;
+    rt_type rt2;
+    rt1.resize(200, 100);
+    rt2.resize(73, 211);
+
+    tiled_sched<basic_ray<float>> sched1(pool, thread_pool::Interactive);
+    tiled_sched<basic_ray<float>> sched2(pool, thread_pool::Background);
+
+    EXPECT_EQ(sched1.pool(), sched2.pool());
+
+    for (int i = 0; i < 20; ++i)
+    {
+        rt1.clear_color_buffer();
+        rt2.clear_color_buffer();
+
+        auto sparams1 = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt1);
+        auto sparams2 = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt2);
+
+        auto f1 = sched1.frame_async([](basic_ray<float>) -> vec4 { return vec4(1.0f); }, sparams1);
+        auto f2 = sched2.frame_async([](basic_ray<float>) -> vec4 { return vec4(0.5f); }, sparams2);
+
+        f2.wait();
+        f1.wait();
+
+        EXPECT_TRUE(all_pixels_equal(rt1, vec4(1.0f)));
+        EXPECT_TRUE(all_pixels_equal(rt2, vec4(0.5f)));
+    }
+
+
+    // Cancelling one frame does not affect the other
+
+    rt1.clear_color_buffer();
+    rt2.clear_color_buffer();
+
+    std::promise<void> go;
+    auto go_future = go.get_future().share();
+
+    auto sparams1 = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt1);
+    auto sparams2 = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt2);
+
+    auto f1 = sched1.frame_async([&](basic_ray<float>) -> vec4
+    {
+        go_future.wait();
+        return vec4(1.0f);
+    }, sparams1);
+    auto f2 = sched2.frame_async([](basic_ray<float>) -> vec4 { return vec4(0.5f); }, sparams2);
+
+    sched1.cancel();
+    go.set_value();
+
+    f1.wait();
+    f2.wait();
+
+    EXPECT_FALSE(all_pixels_equal(rt1, vec4(1.0f)));
+    EXPECT_TRUE(all_pixels_equal(rt2, vec4(0.5f)));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that jobs with low priority are not starved by jobs with higher priority
+//
+
+TEST(TiledSched, PoolFairness)
+{
+    thread_pool pool(1, 0);
+
+    // Keep the worker busy until all jobs were submitted
+    std::promise<void> go;
+    auto go_future = go.get_future().share();
+
+    auto gate = std::make_shared<thread_pool::job>(1);
+    gate->process_item = [&](long) { go_future.wait(); };
+
+    std::atomic<long> interactive_items(0);
+    long interactive_items_before_background = -1;
+
+    auto interactive = std::make_shared<thread_pool::job>(1000, thread_pool::Interactive);
+    interactive->process_item = [&](long) { ++interactive_items; };
+
+    auto background = std::make_shared<thread_pool::job>(1, thread_pool::Background);
+    background->process_item = [&](long) { interactive_items_before_background = interactive_items; };
+
+    auto interactive_done = interactive->done.get_future();
+    auto background_done = background->done.get_future();
+
+    pool.submit(gate);
+    pool.submit(interactive);
+    pool.submit(background);
+    go.set_value();
+
+    interactive_done.wait();
+    background_done.wait();
+
+    EXPECT_EQ(interactive_items, 1000);
+    EXPECT_GE(interactive_items_before_background, 0);
+    EXPECT_LT(interactive_items_before_background, 100);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test thread pools with pinned worker threads
+//
+
+TEST(TiledSched, Affinity)
+{
+    // dummies
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    for (auto aff : { thread_pool::Compact, thread_pool::Scatter })
+    {
+        auto pool = std::make_shared<thread_pool>(4, 0, aff);
+
+        EXPECT_GE(pool->num_nodes(), 1U);
+        EXPECT_EQ(thread_pool::this_thread_node(), 0U);
+
+        std::vector<int> data(10000);
+        pool->first_touch(data.data(), data.size(), 23);
+
+        for (auto d : data)
+        {
+            EXPECT_EQ(d, 23);
+        }
+
+        // Each item is touched once, by the node whose range of items contains it
+        long num_items = 1000;
+        std::vector<std::atomic<int>> touched(num_items);
+        std::vector<unsigned> nodes(num_items);
+
+        pool->first_touch(num_items, [&](long item_idx)
+        {
+            ++touched[item_idx];
+            nodes[item_idx] = thread_pool::this_thread_node();
+        });
+
+        long num_ranges = std::min(static_cast<long>(pool->num_nodes()), num_items);
+
+        for (long r = 0; r < num_ranges; ++r)
+        {
+            for (long i = num_items * r / num_ranges; i < num_items * (r + 1) / num_ranges; ++i)
+            {
+                EXPECT_EQ(touched[i], 1);
+                EXPECT_EQ(nodes[i], static_cast<unsigned>(r));
+            }
+        }
+
+        rt_type rt;
+        rt.resize(190, 93);
+
+        tiled_sched<basic_ray<float>> sched(pool);
+
+        auto sparams = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt);
+
+        sched.frame([](basic_ray<float>) -> vec4 { return vec4(1.0f); }, sparams);
+
+        EXPECT_TRUE(all_pixels_equal(rt, vec4(1.0f)));
+    }
+}
@@ -0,0 +1,395 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/array.h>
+#include <visionaray/random_sampler.h>
+#include <visionaray/volume_bvh.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+using float_type = simd::float8;
+#else
+using float_type = simd::float4;
+#endif
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+// Grid of rotated, overlapping bricks
+static std::vector<volume_bounds> make_bricks(int n, random_sampler<float>& rs)
+{
+    std::vector<volume_bounds> result;
+
+    for (int z = 0; z < n; ++z)
+    {
+        for (int y = 0; y < n; ++y)
+        {
+            for (int x = 0; x < n; ++x)
+            {
+                vec3 axis = normalize(vec3(rs.next(), rs.next(), rs.next()) + vec3(0.1f));
+
+                auto r = rotate(mat4::identity(), axis, rs.next());
+                auto t = translate(mat4::identity(), vec3(x, y, z) + vec3(rs.next(), rs.next(), rs.next()) * 0.3f);
+
+                result.push_back(make_volume_bounds(
+                        static_cast<unsigned>(result.size()),
+                        aabb(vec3(-0.6f), vec3(0.6f)),
+                        t * r
+                        ));
+            }
+        }
+    }
+
+    return result;
+}
+
+static basic_ray<float> make_ray(random_sampler<float>& rs, int n)
+{
+    vec3 ori = vec3(rs.next(), rs.next(), rs.next()) * float(n + 4) - vec3(2.0f);
+    vec3 dst = vec3(rs.next(), rs.next(), rs.next()) * float(n);
+    return basic_ray<float>(ori, normalize(dst - ori));
+}
+
+// Intervals of all volumes, sorted by tnear
+template <size_t N>
+static size_t brute_force_intervals(
+        basic_ray<float> const&             ray,
+        std::vector<volume_bounds> const&   bricks,
+        volume_interval<float>              (&intervals)[N]
+        )
+{
+    size_t count = 0;
+
+    for (auto const& b : bricks)
+    {
+        auto hr = intersect(ray, b);
+
+        if (hr.hit && hr.tfar > 0.0f)
+        {
+            volume_interval<float> iv = { max(hr.tnear, 0.0f), hr.tfar, b.prim_id };
+
+            size_t j = count++;
+
+            while (j > 0 && intervals[j - 1].tnear > iv.tnear)
+            {
+                intervals[j] = intervals[j - 1];
+                --j;
+            }
+
+            intervals[j] = iv;
+        }
+    }
+
+    return count;
+}
+
+// Emission and absorption that differ per volume
+template <typename T>
+struct brick_sampler
+{
+    basic_ray<T> ray;
+
+    vector<4, T> operator()(unsigned id, T const& t) const
+    {
+        auto p = ray.ori + ray.dir * t;
+        T x = p.x * 1.7f + T(float(id) * 0.13f);
+        T density = x - floor(x);
+        return vector<4, T>(T(float(id % 3) / 2.0f), T(float(id % 5) / 4.0f), density, density * 0.05f);
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that multi-hit traversal finds the same intervals as a brute force search
+//
+
+TEST(VolumeBVH, IntersectVolumes)
+{
+    random_sampler<float> rs(0U);
+
+    int n = 6;
+    auto bricks = make_bricks(n, rs);
+
+    auto bvh = build<index_bvh<volume_bounds>>(bricks.data(), bricks.size());
+    auto ref = bvh.ref();
+
+    // The union of the intervals of all lanes is stored for ray packets
+    static const size_t N = 256;
+
+    for (int r = 0; r < 200; ++r)
+    {
+        auto ray = make_ray(rs, n);
+
+        volume_interval<float> expected[N];
+        volume_interval<float> intervals[N];
+
+        size_t expected_count = brute_force_intervals(ray, bricks, expected);
+        size_t count = intersect_volumes(ray, ref, intervals);
+
+        ASSERT_EQ(count, expected_count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            // Order of intervals with the same tnear is unspecified
+            bool found = false;
+
+            for (size_t j = 0; j < expected_count; ++j)
+            {
+                found |= expected[j].id == intervals[i].id
+                      && expected[j].tnear == intervals[i].tnear
+                      && expected[j].tfar == intervals[i].tfar;
+            }
+
+            EXPECT_TRUE(found);
+            EXPECT_FLOAT_EQ(intervals[i].tnear, expected[i].tnear);
+
+            if (i > 0)
+            {
+                EXPECT_LE(intervals[i - 1].tnear, intervals[i].tnear);
+            }
+        }
+    }
+
+    // Ray packets: the valid intervals of each lane are the ones of the single ray
+    for (int r = 0; r < 50; ++r)
+    {
+        array<basic_ray<float>, simd::num_elements<float_type>::value> rays;
+
+        for (auto& ray : rays)
+        {
+            ray = make_ray(rs, n);
+        }
+
+        auto packet = simd::pack(rays);
+
+        volume_interval<float_type> intervals[N];
+        size_t count = intersect_volumes(packet, ref, intervals);
+
+        for (size_t l = 0; l < simd::num_elements<float_type>::value; ++l)
+        {
+            volume_interval<float> expected[N];
+            size_t expected_count = brute_force_intervals(rays[l], bricks, expected);
+
+            size_t num_valid = 0;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                simd::aligned_array_t<float_type> tnears;
+                simd::aligned_array_t<float_type> tfars;
+                store(tnears, intervals[i].tnear);
+                store(tfars, intervals[i].tfar);
+
+                float tnear = tnears[l];
+                float tfar  = tfars[l];
+
+                if (tnear > tfar)
+                {
+                    continue;
+                }
+
+                ++num_valid;
+
+                bool found = false;
+
+                for (size_t j = 0; j < expected_count; ++j)
+                {
+                    found |= expected[j].id == intervals[i].id
+                          && std::abs(expected[j].tnear - tnear) < 1E-4f
+                          && std::abs(expected[j].tfar - tfar) < 1E-4f;
+                }
+
+                EXPECT_TRUE(found);
+            }
+
+            EXPECT_EQ(num_valid, expected_count);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that multi-hit traversal reports the number of overlapping volumes if the interval
+// array is too small and keeps the nearest intervals
+//
+
+TEST(VolumeBVH, IntersectVolumesOverflow)
+{
+    random_sampler<float> rs(2U);
+
+    int n = 6;
+    auto bricks = make_bricks(n, rs);
+
+    auto bvh = build<index_bvh<volume_bounds>>(bricks.data(), bricks.size());
+    auto ref = bvh.ref();
+
+    static const size_t N = 256;
+    static const size_t M = 4;
+
+    int num_overflows = 0;
+
+    for (int r = 0; r < 200; ++r)
+    {
+        auto ray = make_ray(rs, n);
+
+        volume_interval<float> expected[N];
+        volume_interval<float> intervals[M];
+
+        size_t expected_count = brute_force_intervals(ray, bricks, expected);
+        size_t count = intersect_volumes(ray, ref, intervals);
+
+        ASSERT_EQ(count, expected_count);
+
+        num_overflows += count > M;
+
+        for (size_t i = 0; i < count && i < M; ++i)
+        {
+            EXPECT_FLOAT_EQ(intervals[i].tnear, expected[i].tnear);
+        }
+    }
+
+    EXPECT_GT(num_overflows, 0);
+
+    // Ray packets
+    for (int r = 0; r < 50; ++r)
+    {
+        array<basic_ray<float>, simd::num_elements<float_type>::value> rays;
+
+        for (auto& ray : rays)
+        {
+            ray = make_ray(rs, n);
+        }
+
+        auto packet = simd::pack(rays);
+
+        volume_interval<float_type> expected[N];
+        volume_interval<float_type> intervals[M];
+
+        size_t expected_count = intersect_volumes(packet, ref, expected);
+        size_t count = intersect_volumes(packet, ref, intervals);
+
+        ASSERT_EQ(count, expected_count);
+
+        for (size_t i = 0; i < count && i < M; ++i)
+        {
+            EXPECT_FLOAT_EQ(
+                    detail::reduce_min(intervals[i].tnear),
+                    detail::reduce_min(expected[i].tnear)
+                    );
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that interval-merged marching matches sampling all volumes at every step
+//
+
+TEST(VolumeBVH, IntegrateVolumes)
+{
+    random_sampler<float> rs(1U);
+
+    int n = 5;
+    auto bricks = make_bricks(n, rs);
+
+    auto bvh = build<index_bvh<volume_bounds>>(bricks.data(), bricks.size());
+    auto ref = bvh.ref();
+
+    // The union of the intervals of all lanes is stored for ray packets
+    static const size_t N = 256;
+    float delta = 0.05f;
+
+    for (int r = 0; r < 50; ++r)
+    {
+        array<basic_ray<float>, simd::num_elements<float_type>::value> rays;
+
+        for (auto& ray : rays)
+        {
+            ray = make_ray(rs, n);
+        }
+
+        auto packet = simd::pack(rays);
+        brick_sampler<float_type> packet_sampler = { packet };
+
+        volume_interval<float_type> packet_intervals[N];
+        size_t packet_count = intersect_volumes(packet, ref, packet_intervals);
+        auto packet_result = simd::unpack(integrate_volumes(packet_intervals, packet_count, delta, packet_sampler));
+
+        for (size_t l = 0; l < simd::num_elements<float_type>::value; ++l)
+        {
+            auto const& ray = rays[l];
+            brick_sampler<float> sampler = { ray };
+
+            // Reference: sample every volume at every step
+            vec4 expected(0.0f);
+
+            float t0   = numeric_limits<float>::max();
+            float tmax = 0.0f;
+
+            for (auto const& b : bricks)
+            {
+                auto hr = intersect(ray, b);
+
+                if (hr.hit && hr.tfar > 0.0f)
+                {
+                    t0   = min(t0, max(hr.tnear, 0.0f));
+                    tmax = max(tmax, hr.tfar);
+                }
+            }
+
+            for (int k = 0; t0 + k * delta < tmax && expected.w < 0.999f; ++k)
+            {
+                float t = t0 + k * delta;
+
+                vec4 color(0.0f);
+
+                for (auto const& b : bricks)
+                {
+                    auto hr = intersect(ray, b);
+
+                    if (hr.hit && t >= hr.tnear && t < hr.tfar)
+                    {
+                        vec4 c = sampler(b.prim_id, t);
+                        color += vec4(c.xyz() * c.w, c.w);
+                    }
+                }
+
+                color = color.w > 1.0f ? color / color.w : color;
+                expected += color * (1.0f - expected.w);
+            }
+
+            volume_interval<float> intervals[N];
+            size_t count = intersect_volumes(ray, ref, intervals);
+            vec4 result = integrate_volumes(intervals, count, delta, sampler);
+
+            EXPECT_NEAR(result.x, expected.x, 1E-4f);
+            EXPECT_NEAR(result.y, expected.y, 1E-4f);
+            EXPECT_NEAR(result.z, expected.z, 1E-4f);
+            EXPECT_NEAR(result.w, expected.w, 1E-4f);
+
+            EXPECT_NEAR(packet_result[l].x, result.x, 1E-4f);
+            EXPECT_NEAR(packet_result[l].y, result.y, 1E-4f);
+            EXPECT_NEAR(packet_result[l].z, result.z, 1E-4f);
+            EXPECT_NEAR(packet_result[l].w, result.w, 1E-4f);
+        }
+    }
+
+    // Rays that miss all volumes
+    basic_ray<float> ray(vec3(-2.0f, 0.1f, 0.2f), normalize(vec3(1.0f, 0.05f, 0.0f)));
+    brick_sampler<float> sampler = { ray };
+
+    volume_interval<float> intervals[N];
+    EXPECT_EQ(intersect_volumes(ray, ref, intervals, 0.0f, 0.5f), size_t(0));
+
+    vec4 empty = integrate_volumes(intervals, 0, delta, sampler);
+    EXPECT_FLOAT_EQ(empty.w, 0.0f);
+}
@@ -0,0 +1,286 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/area_light.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/kernels.h>
+#include <visionaray/macrocell_grid.h>
+#include <visionaray/material.h>
+#include <visionaray/participating_medium.h>
+#include <visionaray/random_sampler.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+using float_type = simd::float8;
+#else
+using float_type = simd::float4;
+#endif
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+// Unit cube, the density is 0.25 for x < 0.5 and 1 for x >= 0.5
+struct test_medium
+{
+    test_medium()
+        : voxels(8 * 8 * 8)
+        , density(8, 8, 8)
+    {
+        for (int z = 0; z < 8; ++z)
+        {
+            for (int y = 0; y < 8; ++y)
+            {
+                for (int x = 0; x < 8; ++x)
+                {
+                    voxels[(z * 8 + y) * 8 + x] = x < 4 ? 0.25f : 1.0f;
+                }
+            }
+        }
+
+        density.reset(voxels.data());
+        density.set_filter_mode(Nearest);
+        density.set_address_mode(Clamp);
+
+        grid.build(density, 2);
+    }
+
+    participating_medium<texture_ref<float, 3>> make(float sigma_t, vec3 albedo = vec3(1.0f), float g = 0.0f) const
+    {
+        return make_participating_medium(density, aabb(vec3(0.0f), vec3(1.0f)), grid.majorants(), sigma_t, albedo, g);
+    }
+
+    std::vector<float>      voxels;
+    texture_ref<float, 3>   density;
+    macrocell_grid          grid;
+};
+
+using triangle_type = basic_triangle<3, float>;
+using material_type = generic_material<emissive<float>, matte<float>>;
+using light_type    = area_light<triangle_type>;
+
+template <typename T>
+static T lane_mean(T const& x)
+{
+    return x;
+}
+
+static float lane_mean(float_type const& x)
+{
+    simd::aligned_array_t<float_type> values;
+    store(values, x);
+
+    float result = 0.0f;
+
+    for (size_t i = 0; i < simd::num_elements<float_type>::value; ++i)
+    {
+        result += values[i];
+    }
+
+    return result / simd::num_elements<float_type>::value;
+}
+
+template <typename S>
+static void test_tracking(participating_medium<texture_ref<float, 3>> const& medium, float expected)
+{
+    random_sampler<S> samp(0U);
+
+    basic_ray<S> ray(vector<3, S>(-1.0f, 0.4f, 0.6f), vector<3, S>(1.0f, 0.0f, 0.0f));
+
+    static const int NumSamples = 20000;
+
+    float transmittance = 0.0f;
+    float escaped = 0.0f;
+
+    for (int i = 0; i < NumSamples; ++i)
+    {
+        auto active = simd::mask_type_t<S>(true);
+
+        transmittance += lane_mean(ratio_tracking(medium, ray, S(1.0f), S(2.0f), active, samp));
+
+        S t = delta_tracking(medium, ray, S(1.0f), S(2.0f), active, samp);
+        escaped += lane_mean(select(t >= S(2.0f), S(1.0f), S(0.0f)));
+
+        // Collisions can only occur inside the medium
+        EXPECT_TRUE(all(t >= S(1.0f) && t <= S(2.0f)));
+    }
+
+    EXPECT_NEAR(transmittance / NumSamples, expected, 0.01f);
+    EXPECT_NEAR(escaped / NumSamples, expected, 0.01f);
+}
+
+template <typename S, typename Kernel>
+static vec3 estimate(Kernel const& kernel, basic_ray<float> const& ray, int num_samples, unsigned seed)
+{
+    random_sampler<S> samp(seed);
+
+    basic_ray<S> r(vector<3, S>(ray.ori), vector<3, S>(ray.dir));
+
+    vec3 result(0.0f);
+
+    for (int i = 0; i < num_samples; ++i)
+    {
+        auto color = kernel(r, samp).color;
+        result += vec3(lane_mean(color.x), lane_mean(color.y), lane_mean(color.z));
+    }
+
+    return result / static_cast<float>(num_samples);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that delta and ratio tracking reproduce the transmittance of a piecewise
+// constant medium, majorant cells with different densities are traversed
+//
+
+TEST(VolumePathtracing, Tracking)
+{
+    test_medium tm;
+
+    float sigma_t = 4.0f;
+    auto medium = tm.make(sigma_t);
+
+    // Optical depth along the ray: half in density 0.25, half in density 1
+    float expected = std::exp(-sigma_t * (0.5f * 0.25f + 0.5f * 1.0f));
+
+    test_tracking<float>(medium, expected);
+    test_tracking<float_type>(medium, expected);
+
+    // Rays that miss the medium
+    random_sampler<float> samp(1U);
+    basic_ray<float> ray(vec3(-1.0f, 0.5f, 0.5f), vec3(1.0f, 0.0f, 0.0f));
+    EXPECT_FLOAT_EQ(ratio_tracking(medium, ray, 3.0f, 2.0f, true, samp), 1.0f);
+    EXPECT_FLOAT_EQ(delta_tracking(medium, ray, 1.0f, 2.0f, false, samp), 2.0f);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Furnace test: a medium that does not absorb, in front of a white background and lit
+// by white ambient light, has no visible structure. Each path must return exactly white
+//
+
+TEST(VolumePathtracing, Furnace)
+{
+    test_medium tm;
+
+    aligned_vector<triangle_type> triangles;
+    aligned_vector<material_type> materials;
+    aligned_vector<light_type>    lights;
+
+    auto params = make_kernel_params(
+            triangles.data(),
+            triangles.data(),
+            materials.data(),
+            lights.data(),
+            lights.data(),
+            256,
+            1E-4f,
+            vec4(1.0f),
+            vec4(1.0f)
+            );
+
+    float gs[] = { 0.0f, 0.7f, -0.5f };
+
+    for (float g : gs)
+    {
+        auto medium = tm.make(8.0f, vec3(1.0f), g);
+
+        using kernel_type = volume_pathtracing::kernel<decltype(params), decltype(medium)>;
+        kernel_type kernel = { params, medium };
+
+        basic_ray<float> ray(vec3(0.3f, 0.5f, -1.0f), normalize(vec3(0.2f, 0.0f, 1.0f)));
+
+        vec3 color = estimate<float>(kernel, ray, 200, 2U);
+        EXPECT_FLOAT_EQ(color.x, 1.0f);
+        EXPECT_FLOAT_EQ(color.y, 1.0f);
+        EXPECT_FLOAT_EQ(color.z, 1.0f);
+
+        vec3 packet_color = estimate<float_type>(kernel, ray, 50, 3U);
+        EXPECT_FLOAT_EQ(packet_color.x, 1.0f);
+        EXPECT_FLOAT_EQ(packet_color.y, 1.0f);
+        EXPECT_FLOAT_EQ(packet_color.z, 1.0f);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that light sampling at scattering events (shadow rays attenuated by ratio
+// tracking) converges to the same image as phase function sampling alone
+//
+
+TEST(VolumePathtracing, SampleLights)
+{
+    test_medium tm;
+
+    aligned_vector<triangle_type> triangles;
+    aligned_vector<material_type> materials;
+    aligned_vector<light_type>    lights;
+
+    // Emitter above the medium, facing down
+    vec3 v1(-0.5f, 1.5f, -0.5f);
+    vec3 v2( 1.5f, 1.5f, -0.5f);
+    vec3 v3( 1.5f, 1.5f,  1.5f);
+    vec3 v4(-0.5f, 1.5f,  1.5f);
+
+    triangles.push_back(triangle_type(v1, v3 - v1, v2 - v1));
+    triangles.push_back(triangle_type(v1, v4 - v1, v3 - v1));
+
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        triangles[i].prim_id = static_cast<int>(i);
+        triangles[i].geom_id = 0;
+
+        light_type light(triangles[i]);
+        light.set_cl(vec3(1.0f, 0.8f, 0.6f));
+        light.set_kl(2.0f);
+        lights.push_back(light);
+    }
+
+    emissive<float> e;
+    e.ce() = from_rgb(vec3(1.0f, 0.8f, 0.6f));
+    e.ls() = 2.0f;
+    materials.push_back(e);
+
+    auto params = make_kernel_params(
+            triangles.data(),
+            triangles.data() + triangles.size(),
+            materials.data(),
+            lights.data(),
+            lights.data() + lights.size(),
+            16,
+            1E-4f
+            );
+
+    auto medium = tm.make(3.0f, vec3(0.8f), 0.4f);
+
+    using kernel_type = volume_pathtracing::kernel<decltype(params), decltype(medium)>;
+    kernel_type kernel = { params, medium };
+
+    basic_ray<float> ray(vec3(0.5f, 0.4f, -1.0f), vec3(0.0f, 0.0f, 1.0f));
+
+    kernel.params.sample_lights = false;
+    vec3 expected = estimate<float>(kernel, ray, 100000, 4U);
+
+    kernel.params.sample_lights = true;
+    vec3 color = estimate<float>(kernel, ray, 20000, 5U);
+    vec3 packet_color = estimate<float_type>(kernel, ray, 20000 / simd::num_elements<float_type>::value, 6U);
+
+    EXPECT_GT(expected.x, 0.05f);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_NEAR(color[i], expected[i], expected[i] * 0.05f);
+        EXPECT_NEAR(packet_color[i], expected[i], expected[i] * 0.05f);
+    }
+}
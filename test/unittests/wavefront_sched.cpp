@@ -0,0 +1,263 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/point_light.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+using rt_type       = simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+using triangle_type = basic_triangle<3, float>;
+using material_type = generic_material<emissive<float>, mirror<float>>;
+
+static void add_quad(
+        aligned_vector<triangle_type>&  triangles,
+        vec3 const&                     v1,
+        vec3 const&                     v2,
+        vec3 const&                     v3,
+        vec3 const&                     v4,
+        int                             geom_id
+        )
+{
+    triangle_type t1(v1, v2 - v1, v3 - v1);
+    triangle_type t2(v1, v3 - v1, v4 - v1);
+
+    t1.prim_id = static_cast<int>(triangles.size());
+    t1.geom_id = geom_id;
+    triangles.push_back(t1);
+
+    t2.prim_id = static_cast<int>(triangles.size());
+    t2.geom_id = geom_id;
+    triangles.push_back(t2);
+}
+
+// Mirrors and an area light, so that all paths are deterministic
+struct test_scene
+{
+    test_scene()
+    {
+        add_quad(triangles, vec3(-3.0f, -1.0f, -3.0f), vec3(3.0f, -1.0f, -3.0f), vec3(3.0f, -1.0f, 3.0f), vec3(-3.0f, -1.0f, 3.0f), 0);
+        add_quad(triangles, vec3(-2.0f, -1.0f, -2.0f), vec3(0.0f, -1.0f, -2.0f), vec3(0.0f, 2.0f, -1.0f), vec3(-2.0f, 2.0f, -1.0f), 1);
+        add_quad(triangles, vec3(0.0f, 1.5f, -1.0f), vec3(1.0f, 1.5f, -1.0f), vec3(1.0f, 1.5f, 0.0f), vec3(0.0f, 1.5f, 0.0f), 2);
+
+        mirror<float> m;
+        m.cr() = from_rgb(vec3(0.9f, 0.5f, 0.2f));
+        m.kr() = 1.0f;
+        m.ior() = spectrum<float>(0.0f);
+        m.absorption() = spectrum<float>(0.0f);
+
+        emissive<float> e;
+        e.ce() = from_rgb(vec3(1.0f, 1.0f, 0.5f));
+        e.ls() = 2.0f;
+
+        materials.push_back(m);
+        materials.push_back(m);
+        materials.push_back(e);
+
+        cam.perspective(0.8f, 1.0f, 0.01f, 100.0f);
+        cam.look_at(vec3(0.0f, 0.0f, 5.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    aligned_vector<triangle_type>       triangles;
+    aligned_vector<material_type>       materials;
+    aligned_vector<point_light<float>>  lights;
+    pinhole_camera                      cam;
+};
+
+// Matte floor, lit by a point light and partially shadowed by an occluder. Ambient light is
+// black and paths end after the first diffuse bounce, so that only the (deterministic) direct
+// light at the primary hit contributes
+struct shadow_test_scene
+{
+    using material_type = generic_material<emissive<float>, matte<float>>;
+
+    shadow_test_scene()
+    {
+        add_quad(triangles, vec3(-3.0f, -1.0f, -3.0f), vec3(3.0f, -1.0f, -3.0f), vec3(3.0f, -1.0f, 3.0f), vec3(-3.0f, -1.0f, 3.0f), 0);
+        add_quad(triangles, vec3(-1.0f, 0.5f, -1.0f), vec3(0.5f, 0.5f, -1.0f), vec3(0.5f, 0.5f, 0.5f), vec3(-1.0f, 0.5f, 0.5f), 0);
+
+        matte<float> m;
+        m.ca() = from_rgb(vec3(0.0f));
+        m.ka() = 0.0f;
+        m.cd() = from_rgb(vec3(0.8f, 0.6f, 0.4f));
+        m.kd() = 1.0f;
+
+        materials.push_back(m);
+
+        point_light<float> l;
+        l.set_cl(vec3(1.0f, 1.0f, 0.8f));
+        l.set_kl(5.0f);
+        l.set_position(vec3(0.5f, 2.0f, 0.5f));
+        l.set_constant_attenuation(1.0f);
+        l.set_linear_attenuation(0.0f);
+        l.set_quadratic_attenuation(0.0f);
+
+        lights.push_back(l);
+
+        cam.perspective(0.8f, 1.0f, 0.01f, 100.0f);
+        cam.look_at(vec3(0.0f, 2.0f, 5.0f), vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    aligned_vector<triangle_type>       triangles;
+    aligned_vector<material_type>       materials;
+    aligned_vector<point_light<float>>  lights;
+    pinhole_camera                      cam;
+};
+
+template <typename KParams>
+static std::vector<vec4> render_reference(KParams const& kparams, pinhole_camera& cam, int w, int h)
+{
+    rt_type rt;
+    rt.resize(w, h);
+    cam.set_viewport(0, 0, w, h);
+
+    tiled_sched<basic_ray<float>> sched(2);
+    sched.frame(pathtracing::kernel<KParams>({kparams}), make_sched_params(pixel_sampler::uniform_type{}, cam, rt));
+
+    return std::vector<vec4>(rt.color(), rt.color() + w * h);
+}
+
+template <typename R, typename KParams>
+static std::vector<vec4> render_wavefront(KParams const& kparams, pinhole_camera& cam, int w, int h, size_t capacity)
+{
+    rt_type rt;
+    rt.resize(w, h);
+    cam.set_viewport(0, 0, w, h);
+
+    wavefront_sched<R> sched(2);
+    sched.set_queue_capacity(capacity);
+    sched.frame(pathtracing::wavefront_kernel<KParams>({kparams}), make_sched_params(pixel_sampler::uniform_type{}, cam, rt));
+
+    return std::vector<vec4>(rt.color(), rt.color() + w * h);
+}
+
+static void expect_images_near(std::vector<vec4> const& a, std::vector<vec4> const& b)
+{
+    ASSERT_EQ(a.size(), b.size());
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        EXPECT_NEAR(a[i].x, b[i].x, 1e-5f);
+        EXPECT_NEAR(a[i].y, b[i].y, 1e-5f);
+        EXPECT_NEAR(a[i].z, b[i].z, 1e-5f);
+        EXPECT_NEAR(a[i].w, b[i].w, 1e-5f);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that wavefront path tracing produces the same image as pathtracing::kernel
+//
+
+TEST(WavefrontSched, Pathtracing)
+{
+    test_scene scene;
+
+    auto kparams = make_kernel_params(
+            scene.triangles.data(),
+            scene.triangles.data() + scene.triangles.size(),
+            scene.materials.data(),
+            scene.lights.data(),
+            scene.lights.data(),
+            5,
+            1E-3f,
+            vec4(0.1f, 0.2f, 0.3f, 1.0f),
+            vec4(0.5f)
+            );
+
+    int w = 100; // not a multiple of the tile size
+    int h = 67;
+
+    // Light sampling must not change the result for specular paths
+    for (bool sample_lights : { false, true })
+    {
+        kparams.sample_lights = sample_lights;
+
+        auto ref = render_reference(kparams, scene.cam, w, h);
+
+        // Queue capacities that are not a multiple of the SIMD width
+        for (size_t capacity : { 1, 7, 1000 })
+        {
+            expect_images_near(ref, render_wavefront<basic_ray<float>>(kparams, scene.cam, w, h, capacity));
+            expect_images_near(ref, render_wavefront<basic_ray<simd::float4>>(kparams, scene.cam, w, h, capacity));
+        }
+    }
+
+    // Spectral transport is not supported
+    kparams.spectral = true;
+    EXPECT_THROW(render_wavefront<basic_ray<float>>(kparams, scene.cam, w, h, 1000), std::runtime_error);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that the shadow rays of next event estimation, which are traced in a separate stage,
+// are occluded like the shadow rays of pathtracing::kernel
+//
+
+TEST(WavefrontSched, ShadowRays)
+{
+    shadow_test_scene scene;
+
+    auto kparams = make_kernel_params(
+            scene.triangles.data(),
+            scene.triangles.data() + scene.triangles.size(),
+            scene.materials.data(),
+            scene.lights.data(),
+            scene.lights.data() + scene.lights.size(),
+            2,
+            1E-3f,
+            vec4(0.1f, 0.2f, 0.3f, 1.0f),
+            vec4(0.0f)
+            );
+
+    kparams.sample_lights = true;
+    kparams.russian_roulette = false;
+
+    int w = 100;
+    int h = 67;
+
+    auto ref = render_reference(kparams, scene.cam, w, h);
+
+    // Both lit and shadowed floor pixels
+    size_t lit = 0;
+    size_t shadowed = 0;
+
+    for (auto const& c : ref)
+    {
+        if (c.x > 0.0f)
+        {
+            ++lit;
+        }
+        else if (c.z != 0.3f)
+        {
+            ++shadowed;
+        }
+    }
+
+    EXPECT_GT(lit, size_t(0));
+    EXPECT_GT(shadowed, size_t(0));
+
+    for (size_t capacity : { 1, 7, 1000 })
+    {
+        expect_images_near(ref, render_wavefront<basic_ray<float>>(kparams, scene.cam, w, h, capacity));
+        expect_images_near(ref, render_wavefront<basic_ray<simd::float4>>(kparams, scene.cam, w, h, capacity));
+    }
+}
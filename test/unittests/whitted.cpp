@@ -0,0 +1,224 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/kernels.h>
+#include <visionaray/light_groups.h>
+#include <visionaray/material.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/point_light.h>
+#include <visionaray/random_sampler.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+#include <visionaray/spot_light.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+using rt_type       = simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+using triangle_type = basic_triangle<3, float>;
+using material_type = generic_material<matte<float>, plastic<float>, mirror<float>>;
+
+static void add_quad(
+        aligned_vector<triangle_type>&  triangles,
+        vec3 const&                     v1,
+        vec3 const&                     v2,
+        vec3 const&                     v3,
+        vec3 const&                     v4,
+        int                             geom_id
+        )
+{
+    triangle_type t1(v1, v2 - v1, v3 - v1);
+    triangle_type t2(v1, v3 - v1, v4 - v1);
+
+    t1.prim_id = static_cast<int>(triangles.size());
+    t1.geom_id = geom_id;
+    triangles.push_back(t1);
+
+    t2.prim_id = static_cast<int>(triangles.size());
+    t2.geom_id = geom_id;
+    triangles.push_back(t2);
+}
+
+// Matte floor, a plastic occluder and a mirror that reflects both
+struct light_group_scene
+{
+    light_group_scene()
+    {
+        add_quad(triangles, vec3(-3.0f, -1.0f, -3.0f), vec3(3.0f, -1.0f, -3.0f), vec3(3.0f, -1.0f, 3.0f), vec3(-3.0f, -1.0f, 3.0f), 0);
+        add_quad(triangles, vec3(-1.0f, 0.0f, -1.0f), vec3(0.5f, 0.0f, -1.0f), vec3(0.5f, 0.0f, 0.5f), vec3(-1.0f, 0.0f, 0.5f), 1);
+        add_quad(triangles, vec3(-3.0f, -1.0f, -2.5f), vec3(3.0f, -1.0f, -2.5f), vec3(3.0f, 2.0f, -3.0f), vec3(-3.0f, 2.0f, -3.0f), 2);
+
+        matte<float> mt;
+        mt.ca() = from_rgb(vec3(0.0f));
+        mt.ka() = 0.0f;
+        mt.cd() = from_rgb(vec3(0.8f, 0.6f, 0.4f));
+        mt.kd() = 1.0f;
+
+        plastic<float> pl;
+        pl.ca() = from_rgb(vec3(0.0f));
+        pl.ka() = 0.0f;
+        pl.cd() = from_rgb(vec3(0.2f, 0.4f, 0.8f));
+        pl.kd() = 1.0f;
+        pl.cs() = from_rgb(vec3(1.0f));
+        pl.ks() = 0.5f;
+        pl.specular_exp() = 16.0f;
+
+        mirror<float> mr;
+        mr.cr() = from_rgb(vec3(0.9f));
+        mr.kr() = 0.5f;
+        mr.ior() = spectrum<float>(0.0f);
+        mr.absorption() = spectrum<float>(0.0f);
+
+        materials.push_back(mt);
+        materials.push_back(pl);
+        materials.push_back(mr);
+
+        cam.perspective(0.8f, 1.0f, 0.01f, 100.0f);
+        cam.look_at(vec3(0.0f, 2.0f, 5.0f), vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    aligned_vector<triangle_type>       triangles;
+    aligned_vector<material_type>       materials;
+    pinhole_camera                      cam;
+};
+
+// Lights above the floor, the number of lights is not a multiple of the group size
+template <typename Light>
+static aligned_vector<Light> make_lights(size_t count);
+
+template <>
+aligned_vector<point_light<float>> make_lights(size_t count)
+{
+    random_sampler<float> rs(0U);
+
+    aligned_vector<point_light<float>> result(count);
+
+    for (auto& l : result)
+    {
+        l.set_cl(vec3(rs.next(), rs.next(), rs.next()));
+        l.set_kl(0.2f);
+        l.set_position(vec3(rs.next() * 4.0f - 2.0f, 1.0f + rs.next(), rs.next() * 4.0f - 2.0f));
+        l.set_linear_attenuation(0.5f);
+    }
+
+    return result;
+}
+
+template <>
+aligned_vector<spot_light<float>> make_lights(size_t count)
+{
+    random_sampler<float> rs(1U);
+
+    aligned_vector<spot_light<float>> result(count);
+
+    for (auto& l : result)
+    {
+        l.set_cl(vec3(rs.next(), rs.next(), rs.next()));
+        l.set_kl(0.5f);
+        l.set_position(vec3(rs.next() * 4.0f - 2.0f, 1.0f + rs.next(), rs.next() * 4.0f - 2.0f));
+        l.set_spot_direction(normalize(vec3(rs.next() - 0.5f, -1.0f, rs.next() - 0.5f)));
+        l.set_spot_cutoff(0.6f);
+        l.set_spot_exponent(2.0f);
+    }
+
+    return result;
+}
+
+template <typename R, typename KParams>
+static std::vector<vec4> render(KParams const& kparams, pinhole_camera& cam, int w, int h)
+{
+    rt_type rt;
+    rt.resize(w, h);
+    cam.set_viewport(0, 0, w, h);
+
+    tiled_sched<R> sched(2);
+    sched.frame(whitted::kernel<KParams>({kparams}), make_sched_params(cam, rt));
+
+    return std::vector<vec4>(rt.color(), rt.color() + w * h);
+}
+
+static void expect_images_near(std::vector<vec4> const& a, std::vector<vec4> const& b)
+{
+    ASSERT_EQ(a.size(), b.size());
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            EXPECT_NEAR(a[i][c], b[i][c], 1e-5f * std::max(1.0f, std::abs(b[i][c])));
+        }
+    }
+}
+
+template <typename Light>
+static void test_light_groups()
+{
+    light_group_scene scene;
+
+    int w = 50;
+    int h = 33;
+
+    for (size_t num_lights : { 1, 7, 37 })
+    {
+        auto lights = make_lights<Light>(num_lights);
+
+        auto kparams = make_kernel_params(
+                scene.triangles.data(),
+                scene.triangles.data() + scene.triangles.size(),
+                scene.materials.data(),
+                lights.data(),
+                lights.data() + lights.size(),
+                3,
+                1E-3f,
+                vec4(0.1f, 0.2f, 0.3f, 1.0f),
+                vec4(0.0f)
+                );
+
+        // Ray packets shade one light at a time
+        auto ref = render<basic_ray<simd::float4>>(kparams, scene.cam, w, h);
+
+        // Single rays pack the lights per hit point
+        auto packed = render<basic_ray<float>>(kparams, scene.cam, w, h);
+
+        expect_images_near(packed, ref);
+
+        // Prebuilt groups
+        light_groups<Light> groups(lights.begin(), lights.end());
+
+        EXPECT_EQ(groups.num_lights(), num_lights);
+        EXPECT_EQ(groups.num_groups(), (num_lights + light_groups<Light>::group_size - 1) / light_groups<Light>::group_size);
+
+        kparams.light_groups = groups.ref();
+
+        EXPECT_EQ(render<basic_ray<float>>(kparams, scene.cam, w, h), packed);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that single rays, which shade the lights in SIMD groups, produce the same image as
+// ray packets, with and without prebuilt light groups
+//
+
+TEST(Whitted, PointLightGroups)
+{
+    test_light_groups<point_light<float>>();
+}
+
+TEST(Whitted, SpotLightGroups)
+{
+    test_light_groups<spot_light<float>>();
+}